@@ -12,7 +12,7 @@ void frameBufferWriteAudioDebug(GameState *gameState, GameFrameBuffer *buffer, G
         uint16 height = 100;
         uint16 width = (uint16)((float32)audioBuffer->platformBufferSizeInBytes * coefficient);
         uint32 yOffset = 100;
-        writeRectangleInt(buffer, 0x3333ff, height, width, yOffset, 0);
+        writeRectangleInt(buffer, 0, yOffset, width, height, { 0.2f, 0.2f, 1.0f });
     }
 
     // Play cursor (green)
@@ -21,7 +21,7 @@ void frameBufferWriteAudioDebug(GameState *gameState, GameFrameBuffer *buffer, G
         uint16 width = 10;
         uint32 yOffset = 100;
         uint32 xOffset = (uint32)((float32)audioBuffer->playCursorPosition * coefficient);
-        writeRectangleInt(buffer, 0x669900, height, width, yOffset, xOffset);
+        writeRectangleInt(buffer, xOffset, yOffset, width, height, { 0.4f, 0.6f, 0.0f });
     }
 
     // Write cursor + lock size (amount written) (red)
@@ -30,54 +30,8 @@ void frameBufferWriteAudioDebug(GameState *gameState, GameFrameBuffer *buffer, G
         uint32 width = (uint32)((float32)audioBuffer->lockSizeInBytes * coefficient);
         uint32 yOffset = 100;
         uint32 xOffset = (uint32)((float32)audioBuffer->writeCursorPosition * coefficient);
-        writeRectangleInt(buffer, 0xcc0000, height, width, yOffset, xOffset);
+        writeRectangleInt(buffer, xOffset, yOffset, width, height, { 0.8f, 0.0f, 0.0f });
     }
 }
 
 #endif
-
-void audioBufferWriteSineWave(GameState* gameState, GameAudioBuffer* audioBuffer)
-{
-    gameState->sineWave.hertz = 100;
-    gameState->sineWave.sizeOfWave = 1000; // Volume
-
-    // Calculate the total number of 4-byte audio sample groups that we will have per complete cycle.
-    uint64 audioSampleGroupsPerCycle = ((audioBuffer->platformBufferSizeInBytes / audioBuffer->bytesPerSample) / gameState->sineWave.hertz);
-
-    // At the start of which 4 byte group index we are starting our write from?
-    // @TODO(JM) assert that this is a 4 byte boundry
-    uint32 byteGroupIndex = 0;
-
-    float32 percentageOfAngle = 0.0f;
-    float32 angle = 0.0f;
-    float32 radians = 0.0f;
-    float64 sine = 0.0f;
-
-    uint16 *audioSample = (uint16*)audioBuffer->memory;
-
-    // Iterate over each 2 - bytes and write the same data for both...
-    for (uint32 i = 0; i < audioBuffer->noOfSamplesToWrite; i++) {
-
-        percentageOfAngle = percentageOfAnotherf((float32)byteGroupIndex, (float32)audioSampleGroupsPerCycle);
-        angle = (360.0f * percentageOfAngle);
-        radians = (angle * ((float32)GAME_PI / 180.0f));
-        sine = intrin_sin(radians);
-
-        int16 audioSampleValue = (int16)(sine * gameState->sineWave.sizeOfWave);
-
-        // Left channel (16-bits)
-        *audioSample = audioSampleValue;
-
-        // Move to the right sample (16-bits)
-        audioSample++;
-
-        // Right channel (16-bits)
-        *audioSample = audioSampleValue;
-
-        // Move cursor to the start of the next sample grouping.
-        audioSample++;
-
-        // Write another 4 to the running byte group index.
-        byteGroupIndex = (uint32)((byteGroupIndex + audioBuffer->bytesPerSample) % (uint32)audioSampleGroupsPerCycle);
-    }
-}
\ No newline at end of file
@@ -8,8 +8,6 @@ typedef struct GameState GameState;
 typedef struct GameFrameBuffer GameFrameBuffer;
 typedef struct GameAudioBuffer GameAudioBuffer;
 
-void audioBufferWriteSineWave(GameState *gameState, GameAudioBuffer *audioBuffer);
-
 void frameBufferWriteAudioDebug(GameState *gameState,
                                 GameFrameBuffer *buffer,
                                 GameAudioBuffer *audioBuffer);
@@ -0,0 +1,97 @@
+#include <string.h> // memcpy, memset
+
+#include "audio_ring_buffer.h"
+
+void audioRingBufferInit(AudioRingBuffer *ring, void *memory, uint32 capacityFrames)
+{
+    // The indexes are masked into the buffer
+    assert(capacityFrames && (0 == (capacityFrames & (capacityFrames - 1))));
+
+    ring->frames = (uint32 *)memory;
+    ring->capacityFrames = capacityFrames;
+    ring->writeIndex = 0;
+    ring->readIndex = 0;
+    ring->droppedFrames = 0;
+    ring->underruns = 0;
+    ring->underrunFrames = 0;
+    ring->primed = false;
+}
+
+uint32 audioRingBufferFramesQueued(AudioRingBuffer *ring)
+{
+    // Unsigned, so still correct once the indexes wrap
+    return (audioRingBufferLoad(&ring->writeIndex) - audioRingBufferLoad(&ring->readIndex));
+}
+
+uint32 audioRingBufferWrite(AudioRingBuffer *ring, const void *frames, uint32 frameCount)
+{
+    uint32 writeIndex = ring->writeIndex;
+    uint32 framesFree = (ring->capacityFrames - (writeIndex - audioRingBufferLoad(&ring->readIndex)));
+
+    if (frameCount > framesFree) {
+        ring->droppedFrames += (frameCount - framesFree);
+        frameCount = framesFree;
+    }
+
+    // The write may wrap around the end of the buffer
+    uint32 start = (writeIndex & (ring->capacityFrames - 1));
+    uint32 firstPart = (ring->capacityFrames - start);
+
+    if (firstPart > frameCount) {
+        firstPart = frameCount;
+    }
+
+    memcpy((ring->frames + start), frames, (firstPart * AUDIO_RING_BUFFER_BYTES_PER_FRAME));
+    memcpy(ring->frames, ((const uint32 *)frames + firstPart), ((frameCount - firstPart) * AUDIO_RING_BUFFER_BYTES_PER_FRAME));
+
+    // Publish the frames only once they've been copied in
+    audioRingBufferStore(&ring->writeIndex, (writeIndex + frameCount));
+
+    return frameCount;
+}
+
+uint32 audioRingBufferRead(AudioRingBuffer *ring, void *frames, uint32 frameCount)
+{
+    uint32 readIndex = ring->readIndex;
+    uint32 framesQueued = (audioRingBufferLoad(&ring->writeIndex) - readIndex);
+
+    if (frameCount > framesQueued) {
+        frameCount = framesQueued;
+    }
+
+    uint32 start = (readIndex & (ring->capacityFrames - 1));
+    uint32 firstPart = (ring->capacityFrames - start);
+
+    if (firstPart > frameCount) {
+        firstPart = frameCount;
+    }
+
+    memcpy(frames, (ring->frames + start), (firstPart * AUDIO_RING_BUFFER_BYTES_PER_FRAME));
+    memcpy(((uint32 *)frames + firstPart), ring->frames, ((frameCount - firstPart) * AUDIO_RING_BUFFER_BYTES_PER_FRAME));
+
+    // Hand the space back to the producer only once we've copied out of it
+    audioRingBufferStore(&ring->readIndex, (readIndex + frameCount));
+
+    if (frameCount) {
+        ring->primed = true;
+    }
+
+    return frameCount;
+}
+
+uint32 audioRingBufferReadPadded(AudioRingBuffer *ring, void *frames, uint32 frameCount)
+{
+    uint32 framesRead = audioRingBufferRead(ring, frames, frameCount);
+
+    if (framesRead < frameCount) {
+
+        memset(((uint32 *)frames + framesRead), 0, ((frameCount - framesRead) * AUDIO_RING_BUFFER_BYTES_PER_FRAME));
+
+        if (ring->primed) {
+            ring->underruns++;
+            ring->underrunFrames += (frameCount - framesRead);
+        }
+    }
+
+    return framesRead;
+}
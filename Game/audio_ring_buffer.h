@@ -0,0 +1,90 @@
+#ifndef HEADER_HH_AUDIO_RING_BUFFER
+#define HEADER_HH_AUDIO_RING_BUFFER
+
+//
+// Audio ring buffer. Shared by the platform layers
+// ============================================================================
+//
+// Hands the game's samples from the main loop (the only producer) to the
+// platform's audio thread (the only consumer) without either side taking a
+// lock. The producer only ever moves writeIndex and the consumer only ever
+// moves readIndex. Both are free running frame counters that are masked into
+// the buffer, so the capacity must be a power of two.
+//
+// A frame is one 16-bit left + right sample pair (4 bytes). The same grouping
+// the platform layers call a "sample".
+
+#include "global.h"
+
+#define AUDIO_RING_BUFFER_BYTES_PER_FRAME 4
+
+#if COMPILER_MSVC
+#define audioRingBufferLoad(ptr)            ((uint32)_InterlockedOr((volatile long *)(ptr), 0))
+#define audioRingBufferStore(ptr, value)    _InterlockedExchange((volatile long *)(ptr), (long)(value))
+#else
+#define audioRingBufferLoad(ptr)            __atomic_load_n((ptr), __ATOMIC_ACQUIRE)
+#define audioRingBufferStore(ptr, value)    __atomic_store_n((ptr), (value), __ATOMIC_RELEASE)
+#endif
+
+typedef struct AudioRingBuffer
+{
+    uint32 *frames;
+
+    // Power of two
+    uint32 capacityFrames;
+
+    // Frames written by the producer / read by the consumer since the start
+    volatile uint32 writeIndex;
+    volatile uint32 readIndex;
+
+    // Producer side. Frames thrown away because the ring was full.
+    uint64 droppedFrames;
+
+    // Consumer side. Times the consumer wanted more frames than were queued,
+    // and how many frames of silence it had to play in their place.
+    uint64 underruns;
+    uint64 underrunFrames;
+
+    // Consumer side. Set once the first frame has been read, so that the
+    // silence played before the game has produced anything isn't counted as
+    // an underrun.
+    bool32 primed;
+
+} AudioRingBuffer;
+
+/**
+ * @brief Readies the ring buffer to use memory, which must hold
+ * capacityFrames * AUDIO_RING_BUFFER_BYTES_PER_FRAME bytes
+ */
+void audioRingBufferInit(AudioRingBuffer *ring, void *memory, uint32 capacityFrames);
+
+/**
+ * @brief How many frames are waiting to be read. Safe to call from either side.
+ */
+uint32 audioRingBufferFramesQueued(AudioRingBuffer *ring);
+
+/**
+ * @brief Copies frames into the ring. Producer only. Anything that doesn't fit
+ * is dropped (and counted).
+ *
+ * @return The number of frames written
+ */
+uint32 audioRingBufferWrite(AudioRingBuffer *ring, const void *frames, uint32 frameCount);
+
+/**
+ * @brief Copies up to frameCount frames out of the ring. Consumer only.
+ *
+ * @return The number of frames read
+ */
+uint32 audioRingBufferRead(AudioRingBuffer *ring, void *frames, uint32 frameCount);
+
+/**
+ * @brief Reads exactly frameCount frames, filling whatever the ring couldn't
+ * provide with silence and counting it as an underrun. Consumer only. For
+ * audio threads that must hand the device a full period every time.
+ *
+ * @return The number of frames read from the ring (the rest are silence)
+ */
+uint32 audioRingBufferReadPadded(AudioRingBuffer *ring, void *frames, uint32 frameCount);
+
+#endif
@@ -164,10 +164,10 @@ if %CopyAssets% == true (
 )
 
 REM Compile the source code
-cl %CompilerFlags% %~dp0game.cpp  %~dp0intrinsics.cpp %~dp0global_utility.cpp %~dp0utility.cpp %~dp0memory.cpp %~dp0player.cpp %~dp0world.cpp %~dp0tilemap.cpp %~dp0graphics.cpp %~dp0audio.cpp %~dp0filesystem.cpp %~dp0math.cpp
+cl %CompilerFlags% %~dp0game.cpp  %~dp0intrinsics.cpp %~dp0global_utility.cpp %~dp0utility.cpp %~dp0memory.cpp %~dp0player.cpp %~dp0world.cpp %~dp0tilemap.cpp %~dp0graphics.cpp %~dp0audio.cpp %~dp0oscillator.cpp %~dp0mixer.cpp %~dp0renderer.cpp %~dp0tile_chunk_cache.cpp %~dp0tile_chunk_store.cpp %~dp0resolution.cpp %~dp0filesystem.cpp %~dp0math.cpp
 
 REM Run the linker
-link %LinkerFlags% %icf%game.obj %icf%intrinsics.obj %icf%global_utility.obj %icf%utility.obj %icf%memory.obj %icf%player.obj %icf%world.obj %icf%tilemap.obj %icf%graphics.obj %icf%audio.obj %icf%filesystem.obj %icf%math.obj
+link %LinkerFlags% %icf%game.obj %icf%intrinsics.obj %icf%global_utility.obj %icf%utility.obj %icf%memory.obj %icf%player.obj %icf%world.obj %icf%tilemap.obj %icf%graphics.obj %icf%audio.obj %icf%oscillator.obj %icf%mixer.obj %icf%renderer.obj %icf%tile_chunk_cache.obj %icf%tile_chunk_store.obj %icf%resolution.obj %icf%filesystem.obj %icf%math.obj
 
 GOTO :eof
 
@@ -1,9 +1,127 @@
 #include "filesystem.h"
+#include "intrinsics.h"
+
+bool32 readBMPFromMemory(MemoryRegion *memoryRegion,
+                            MemoryBlock *memoryBlock,
+                            void *fileMemory,
+                            uint32 fileSizeInBytes,
+                            BitmapFile *bitmapFile)
+{
+    if (fileSizeInBytes < (sizeof(bitmapFileHeader) + sizeof(bitmapInfoHeaderV5))) {
+        assert(!"Invalid BMP file format");
+        return false;
+    }
+
+    bitmapFileHeader *fileHeader = (bitmapFileHeader *)fileMemory;
+
+    if (fileHeader->bfType != BITMAP_FILE_ID) {
+        assert(!"Invalid BMP file format");
+        return false;
+    }
+
+    bitmapInfoHeader *fileInfo = (bitmapInfoHeader *)((uint8 *)fileMemory + sizeof(bitmapFileHeader));
+
+    if (fileInfo->biSize != BITMAP_INFO_HEADER_V5_SIZE) {
+        assert(!"Unsupported bitmap version. Can only load BITMAPV5HEADER BMP files");
+        return false;
+    }
+
+    bitmapInfoHeaderV5 *fileInfoV5 = (bitmapInfoHeaderV5 *)fileInfo;
+
+    if (fileInfo->biBitCount != 32) {
+        assert(!"Unsupported bitmap bit depth. Can only load 32-bit BMP files");
+        return false;
+    }
+
+    uint32 *filePixels = (uint32 *)((uint8 *)fileMemory + fileHeader->bfOffBits);
+
+    // Fetch the RGBA shifts from the bitmap's masks...
+    bitScanResult redShift = intrin_bitScanForward(fileInfoV5->bV5RedMask);
+    bitScanResult greenShift = intrin_bitScanForward(fileInfoV5->bV5GreenMask);
+    bitScanResult blueShift = intrin_bitScanForward(fileInfoV5->bV5BlueMask);
+    bitScanResult alphaShift = intrin_bitScanForward(fileInfoV5->bV5AlphaMask);
+
+    if (!redShift.found || !greenShift.found || !blueShift.found || !alphaShift.found) {
+        assert(!"Error finding bitmap mask bit shifts");
+        return false;
+    }
+
+    uint32 widthPx = fileInfo->biWidth;
+    uint32 heightPx = fileInfo->biHeight;
+
+    if (((uint64)fileHeader->bfOffBits + ((uint64)widthPx * heightPx * sizeof(uint32))) > fileSizeInBytes) {
+        assert(!"BMP file is too short for its pixels");
+        return false;
+    }
+
+    uint32 pixelsPerAlignment = (BITMAP_ROW_ALIGNMENT / sizeof(uint32));
+    uint32 pitchPx = ((widthPx + (pixelsPerAlignment - 1)) & ~(pixelsPerAlignment - 1));
+
+    // Reserve enough to move the start up to the alignment
+    uint8 *reserved = memoryBlockReserveArray(memoryRegion,
+                                                memoryBlock,
+                                                uint8,
+                                                (((sizet)pitchPx * heightPx * sizeof(uint32)) + (BITMAP_ROW_ALIGNMENT - 1)));
+
+    uint32 *pixels = (uint32 *)(((sizet)reserved + (BITMAP_ROW_ALIGNMENT - 1)) & ~(sizet)(BITMAP_ROW_ALIGNMENT - 1));
+
+    uint32 opaqueCount = 0;
+    uint32 transparentCount = 0;
+
+    for (uint32 y = 0; y < heightPx; y++) {
+
+        uint32 *source = (filePixels + (y * widthPx));
+        uint32 *dest = (pixels + (y * pitchPx));
+
+        for (uint32 x = 0; x < widthPx; x++) {
+
+            uint32 red = ((source[x] >> redShift.index) & 0xFF);
+            uint32 green = ((source[x] >> greenShift.index) & 0xFF);
+            uint32 blue = ((source[x] >> blueShift.index) & 0xFF);
+            uint32 alpha = ((source[x] >> alphaShift.index) & 0xFF);
+
+            // Premultiply, rounded
+            red = (((red * alpha) + 127) / 255);
+            green = (((green * alpha) + 127) / 255);
+            blue = (((blue * alpha) + 127) / 255);
+
+            dest[x] = ((alpha << 24) | (red << 16) | (green << 8) | blue);
+
+            opaqueCount += (255 == alpha);
+            transparentCount += (0 == alpha);
+        }
+
+        // Keep the padding fully transparent
+        for (uint32 x = widthPx; x < pitchPx; x++) {
+            dest[x] = 0;
+        }
+    }
+
+    bitmapFile->heightPx = heightPx;
+    bitmapFile->widthPx = widthPx;
+    bitmapFile->pitchPx = pitchPx;
+    bitmapFile->fileSize = fileInfo->biSizeImage;
+    bitmapFile->flags = 0;
+    bitmapFile->memory = pixels;
+
+    if (opaqueCount == (widthPx * heightPx)) {
+        bitmapFile->flags |= BITMAP_FLAG_OPAQUE;
+    }
+
+    if (transparentCount == (widthPx * heightPx)) {
+        bitmapFile->flags |= BITMAP_FLAG_TRANSPARENT;
+    }
+
+    return true;
+}
 
 #if HANDMADE_LOCAL_BUILD
 
 void DEBUGReadBMP(PlatformThreadContext *thread,
                     DEBUGPlatformReadEntireFile *playformreadFile,
+                    DEBUGPlatformFreeFileMemory *platformFreeFile,
+                    MemoryRegion *memoryRegion,
+                    MemoryBlock *memoryBlock,
                     const char *abspath,
                     const char *filename,
                     BitmapFile *bitmapFIle)
@@ -16,31 +134,9 @@ void DEBUGReadBMP(PlatformThreadContext *thread,
         return;
     }
 
-    bitmapFileHeader *fileHeader = (bitmapFileHeader *)file.memory;
-
-    if (fileHeader->bfType != BITMAP_FILE_ID) {
-        assert(!"Invalid BMP file format");
-        return;
-    }
-
-    bitmapInfoHeader *fileInfo = (bitmapInfoHeader *)((uint8 *)file.memory + sizeof(bitmapFileHeader));
-
-    if (fileInfo->biSize != BITMAP_INFO_HEADER_V5_SIZE) {
-        assert(!"Unsupported bitmap version. Can only load BITMAPV5HEADER BMP files");
-    }
-
-    bitmapInfoHeaderV5 *fileInfoV5 = (bitmapInfoHeaderV5 *)fileInfo;
-
-    void *memory = (void *)((uint8 *)file.memory + fileHeader->bfOffBits);
+    readBMPFromMemory(memoryRegion, memoryBlock, file.memory, file.sizeinBytes, bitmapFIle);
 
-    bitmapFIle->heightPx = fileInfo->biHeight;
-    bitmapFIle->widthPx = fileInfo->biWidth;
-    bitmapFIle->fileSize = fileInfo->biSizeImage;
-    bitmapFIle->redMask = fileInfoV5->bV5RedMask;
-    bitmapFIle->greenMask = fileInfoV5->bV5GreenMask;
-    bitmapFIle->blueMask = fileInfoV5->bV5BlueMask;
-    bitmapFIle->alphaMask = fileInfoV5->bV5AlphaMask;
-    bitmapFIle->memory = memory;
+    platformFreeFile(thread, &file);
 
     return;
 }
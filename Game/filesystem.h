@@ -3,10 +3,19 @@
 
 #include "global_macros.h"
 #include "types.h"
+#include "memory.h"
 
 #define BITMAP_FILE_ID 0x4D42
 #define BITMAP_INFO_HEADER_V5_SIZE 124
 
+// Loaded bitmaps' rows start on a cache line, so every row's SIMD loads are
+// aligned the same way
+#define BITMAP_ROW_ALIGNMENT 64
+
+// Bitmap flags. Worked out once at load time.
+#define BITMAP_FLAG_OPAQUE      0x1 // Every pixel's alpha is 255
+#define BITMAP_FLAG_TRANSPARENT 0x2 // Every pixel's alpha is 0
+
 #pragma pack(push, 1)
 typedef struct bitmapFileHeader
 {
@@ -85,21 +94,43 @@ typedef struct bitmapInfoHeaderV5
 } bitmapInfoHeaderV5;
 #pragma pack(pop)
 
+/**
+ * A bitmap as the renderer wants it, whatever the file's channel layout.
+ * Pixels are 0xAARRGGBB (B, G, R, A in memory), the same as the frame
+ * buffer, with the colour channels premultiplied by alpha. Rows are
+ * bottom-up, as in the file.
+ */
 typedef struct BitmapFile
 {
     uint32 heightPx;
     uint32 widthPx;
+
+    // Pixels from the start of one row to the next. At least widthPx, padded
+    // so that each row is BITMAP_ROW_ALIGNMENT aligned.
+    uint32 pitchPx;
+
     uint32 fileSize;
-    uint32 redMask;
-    uint32 greenMask;
-    uint32 blueMask;
-    uint32 alphaMask;
+
+    // BITMAP_FLAG_*
+    uint32 flags;
+
     void *memory;
 } BitmapFile;
 
 typedef struct PlatformThreadContext PlatformThreadContext;
 typedef struct GameMemory GameMemory;
 
+/**
+ * Converts a BMP file already in memory into memoryBlock: premultiplied
+ * 0xAARRGGBB with aligned rows. Returns false if the file isn't a 32-bit
+ * BITMAPV5HEADER BMP.
+ */
+bool32 readBMPFromMemory(MemoryRegion *memoryRegion,
+                            MemoryBlock *memoryBlock,
+                            void *fileMemory,
+                            uint32 fileSizeInBytes,
+                            BitmapFile *bitmapFile);
+
 #if HANDMADE_LOCAL_BUILD
 
 typedef struct DEBUG_file
@@ -130,8 +161,15 @@ typedef DEBUG_PLATFORM_FREE_FILE_MEMORY(DEBUGPlatformFreeFileMemory);
 typedef DEBUG_PLATFORM_WRITE_ENTIRE_FILE(DEBUGPlatformWriteEntireFile);
 
 
+/**
+ * Reads a BMP file and converts it with readBMPFromMemory. The file's memory
+ * is freed once converted.
+ */
 void DEBUGReadBMP(PlatformThreadContext *thread,
                     DEBUGPlatformReadEntireFile *playformreadFile,
+                    DEBUGPlatformFreeFileMemory *platformFreeFile,
+                    MemoryRegion *memoryRegion,
+                    MemoryBlock *memoryBlock,
                     const char *absPath,
                     const char *filename,
                     BitmapFile *bitmapFIle);
@@ -18,7 +18,11 @@ EXTERN_DLL_EXPORT GAME_UPDATE(gameUpdate)
         memory->permanentStorage.bytesUsed = sizeof(GameState);
         memory->permanentStorage.bytesFree = (memory->permanentStorage.sizeInBytes - sizeof(GameState));
 
-        // Reserve a block of the memory region for the tile chunks
+        // The GameState lives directly in the region rather than in a block
+        memoryRegionCommit(&memory->permanentStorage, gameState, sizeof(GameState));
+
+        // Reserve a block of the memory region for the tile chunks, and the
+        // hash table that finds them. Only used as chunks are written to.
         memoryRegionReserveBlock(memory->permanentStorage,
                                     &gameState->tileChunksMemoryBlock,
                                     (uint8 *)(gameState + 1),
@@ -30,18 +34,98 @@ EXTERN_DLL_EXPORT GAME_UPDATE(gameUpdate)
                                     (gameState->tileChunksMemoryBlock.endingAddress +1),
                                     (sizet)utilMebibytesToBytes(10));
 
+        // Reserve a block of the memory region for audio (E.g. the mixer and wavetables)
+        memoryRegionReserveBlock(memory->permanentStorage,
+                                    &gameState->audioMemoryBlock,
+                                    (gameState->tilesMemoryBlock.endingAddress +1),
+                                    (sizet)utilMebibytesToBytes(1));
+
+        // Reserve a block of the memory region for the bitmaps, converted
+        // from their files for drawing
+        memoryRegionReserveBlock(memory->permanentStorage,
+                                    &gameState->bitmapsMemoryBlock,
+                                    (gameState->audioMemoryBlock.endingAddress +1),
+                                    (sizet)utilMebibytesToBytes(4));
+
+        // Reserve a block of the transient memory region for the render
+        // group. It's refilled every frame so nothing in it needs to persist.
+        memoryRegionReserveBlock(memory->transientStorage,
+                                    &gameState->renderGroupMemoryBlock,
+                                    (uint8 *)memory->transientStorage.bytes,
+                                    (sizet)utilMebibytesToBytes(2));
+
+        renderGroupInit(&gameState->renderGroup,
+                        &memory->transientStorage,
+                        &gameState->renderGroupMemoryBlock,
+                        GAME_RENDER_PUSH_BUFFER_SIZE,
+                        GAME_RENDER_MAX_COMMANDS,
+                        renderTileCount(FRAME_BUFFER_PIXEL_WIDTH, FRAME_BUFFER_PIXEL_HEIGHT));
+
+        gameState->mixer = memoryBlockReserveStruct(&memory->permanentStorage,
+                                                        &gameState->audioMemoryBlock,
+                                                        Mixer);
+
+        mixerInit(gameState->mixer);
+
+        gameState->wavetables = memoryBlockReserveStruct(&memory->permanentStorage,
+                                                            &gameState->audioMemoryBlock,
+                                                            OscillatorWavetables);
+
+        gameState->debugToneSound.samples = memoryBlockReserveArray(&memory->permanentStorage,
+                                                                    &gameState->audioMemoryBlock,
+                                                                    float32,
+                                                                    GAME_DEBUG_TONE_MAX_SAMPLES);
+        gameState->debugToneVoice = MIXER_VOICE_NONE;
+
+        // The tile blocks are read every frame. Back them with large pages
+        // where the platform can.
+        gameState->tileChunksMemoryBlock.largePages = true;
+        gameState->tilesMemoryBlock.largePages = true;
+
         // Init the World's Tilemap
         initTilemap(&memory->permanentStorage,
                     gameState,
                     &gameState->tileChunksMemoryBlock,
                     WORLD_PIXELS_PER_METER,
                     TILE_DIMENSIONS_BIT_SHIFT,
-                    TILE_CHUNK_DIMENSIONS_BIT_SHIFT,
                     TILEMAP_Z_PLANES,
                     TILE_CHUNK_TILE_DIMENSIONS_BIT_SHIFT,
                     TILE_DIMENSIONS_METERS,
                     frameBuffer);
 
+        // Reserve a block of the transient memory region for the tile chunk
+        // cache, after the render group
+        memoryRegionReserveBlock(memory->transientStorage,
+                                    &gameState->tileChunkCacheMemoryBlock,
+                                    (gameState->renderGroupMemoryBlock.endingAddress +1),
+                                    tileChunkCacheSizeInBytes(&gameState->world.tilemap));
+
+        tileChunkCacheInit(&gameState->tileChunkCache,
+                            &memory->transientStorage,
+                            &gameState->tileChunkCacheMemoryBlock,
+                            &gameState->world.tilemap);
+
+        // Reserve a block of the transient memory region for frames drawn at
+        // a lower resolution, after the tile chunk cache
+        sizet renderTargetPixels = ((sizet)FRAME_BUFFER_PIXEL_WIDTH * FRAME_BUFFER_PIXEL_HEIGHT);
+
+        memoryRegionReserveBlock(memory->transientStorage,
+                                    &gameState->renderTargetMemoryBlock,
+                                    (gameState->tileChunkCacheMemoryBlock.endingAddress +1),
+                                    ((renderTargetPixels + FRAME_BUFFER_PIXEL_WIDTH) * sizeof(uint32)));
+
+        gameState->renderTargetPixels = memoryBlockReserveArray(&memory->transientStorage,
+                                                                &gameState->renderTargetMemoryBlock,
+                                                                uint32,
+                                                                renderTargetPixels);
+
+        gameState->upscaleScratchRow = memoryBlockReserveArray(&memory->transientStorage,
+                                                                &gameState->renderTargetMemoryBlock,
+                                                                uint32,
+                                                                FRAME_BUFFER_PIXEL_WIDTH);
+
+        resolutionControllerInit(&gameState->resolution);
+
         // Init the World
         gameState->world.pixelsPerMeter  = (uint16)WORLD_PIXELS_PER_METER;
         gameState->world.worldHeightPx   = (gameState->world.tilemap.tileHeightPx * gameState->world.tilemap.tileDimensions);
@@ -69,6 +153,9 @@ EXTERN_DLL_EXPORT GAME_UPDATE(gameUpdate)
         // of screen
         setPlayerPosition(41, 41, 0, gameState, frameBuffer);
 
+        gameState->player1.previousAbsolutePosition = gameState->player1.absolutePosition;
+        gameState->player1.previousZIndex = gameState->player1.zIndex;
+
         // Calculate the currently active tile based on player1's position and
         // write it to the World Position data
         setWorldPosition(gameState, frameBuffer);
@@ -83,18 +170,27 @@ EXTERN_DLL_EXPORT GAME_UPDATE(gameUpdate)
         // Back
         DEBUGReadBMP(thread,
                         memory->DEBUG_platformReadEntireFile,
+                        memory->DEBUG_platformFreeFileMemory,
+                        &memory->permanentStorage,
+                        &gameState->bitmapsMemoryBlock,
                         memory->platformAbsPath,
                         "data\\test\\test_hero_back_head.bmp",
                         &gameState->player1.bitmaps[0].head);
 
         DEBUGReadBMP(thread,
                         memory->DEBUG_platformReadEntireFile,
+                        memory->DEBUG_platformFreeFileMemory,
+                        &memory->permanentStorage,
+                        &gameState->bitmapsMemoryBlock,
                         memory->platformAbsPath,
                         "data\\test\\test_hero_back_cape.bmp",
                         &gameState->player1.bitmaps[0].cape);
 
         DEBUGReadBMP(thread,
                         memory->DEBUG_platformReadEntireFile,
+                        memory->DEBUG_platformFreeFileMemory,
+                        &memory->permanentStorage,
+                        &gameState->bitmapsMemoryBlock,
                         memory->platformAbsPath,
                         "data\\test\\test_hero_front_torso.bmp",
                         &gameState->player1.bitmaps[0].torso);
@@ -102,18 +198,27 @@ EXTERN_DLL_EXPORT GAME_UPDATE(gameUpdate)
         // Right
         DEBUGReadBMP(thread,
                         memory->DEBUG_platformReadEntireFile,
+                        memory->DEBUG_platformFreeFileMemory,
+                        &memory->permanentStorage,
+                        &gameState->bitmapsMemoryBlock,
                         memory->platformAbsPath,
                         "data\\test\\test_hero_right_head.bmp",
                         &gameState->player1.bitmaps[1].head);
 
         DEBUGReadBMP(thread,
                         memory->DEBUG_platformReadEntireFile,
+                        memory->DEBUG_platformFreeFileMemory,
+                        &memory->permanentStorage,
+                        &gameState->bitmapsMemoryBlock,
                         memory->platformAbsPath,
                         "data\\test\\test_hero_right_cape.bmp",
                         &gameState->player1.bitmaps[1].cape);
 
         DEBUGReadBMP(thread,
                         memory->DEBUG_platformReadEntireFile,
+                        memory->DEBUG_platformFreeFileMemory,
+                        &memory->permanentStorage,
+                        &gameState->bitmapsMemoryBlock,
                         memory->platformAbsPath,
                         "data\\test\\test_hero_right_torso.bmp",
                         &gameState->player1.bitmaps[1].torso);
@@ -121,18 +226,27 @@ EXTERN_DLL_EXPORT GAME_UPDATE(gameUpdate)
         // Front
         DEBUGReadBMP(thread,
                         memory->DEBUG_platformReadEntireFile,
+                        memory->DEBUG_platformFreeFileMemory,
+                        &memory->permanentStorage,
+                        &gameState->bitmapsMemoryBlock,
                         memory->platformAbsPath,
                         "data\\test\\test_hero_front_head.bmp",
                         &gameState->player1.bitmaps[2].head);
 
         DEBUGReadBMP(thread,
                         memory->DEBUG_platformReadEntireFile,
+                        memory->DEBUG_platformFreeFileMemory,
+                        &memory->permanentStorage,
+                        &gameState->bitmapsMemoryBlock,
                         memory->platformAbsPath,
                         "data\\test\\test_hero_front_cape.bmp",
                         &gameState->player1.bitmaps[2].cape);
 
         DEBUGReadBMP(thread,
                         memory->DEBUG_platformReadEntireFile,
+                        memory->DEBUG_platformFreeFileMemory,
+                        &memory->permanentStorage,
+                        &gameState->bitmapsMemoryBlock,
                         memory->platformAbsPath,
                         "data\\test\\test_hero_front_torso.bmp",
                         &gameState->player1.bitmaps[2].torso);
@@ -140,18 +254,27 @@ EXTERN_DLL_EXPORT GAME_UPDATE(gameUpdate)
         // Left
         DEBUGReadBMP(thread,
                         memory->DEBUG_platformReadEntireFile,
+                        memory->DEBUG_platformFreeFileMemory,
+                        &memory->permanentStorage,
+                        &gameState->bitmapsMemoryBlock,
                         memory->platformAbsPath,
                         "data\\test\\test_hero_left_head.bmp",
                         &gameState->player1.bitmaps[3].head);
 
         DEBUGReadBMP(thread,
                         memory->DEBUG_platformReadEntireFile,
+                        memory->DEBUG_platformFreeFileMemory,
+                        &memory->permanentStorage,
+                        &gameState->bitmapsMemoryBlock,
                         memory->platformAbsPath,
                         "data\\test\\test_hero_left_cape.bmp",
                         &gameState->player1.bitmaps[3].cape);
 
         DEBUGReadBMP(thread,
                         memory->DEBUG_platformReadEntireFile,
+                        memory->DEBUG_platformFreeFileMemory,
+                        &memory->permanentStorage,
+                        &gameState->bitmapsMemoryBlock,
                         memory->platformAbsPath,
                         "data\\test\\test_hero_left_torso.bmp",
                         &gameState->player1.bitmaps[3].torso);
@@ -384,6 +507,27 @@ EXTERN_DLL_EXPORT GAME_UPDATE(gameUpdate)
             randomNumberIndex++;
         }        
 
+#if defined(HANDMADE_DEBUG_MEMORY)
+        // How compactly the rooms' tiles are stored, against a uint32 a tile
+        TileChunkStoreMemory tileMemory = tileChunkStoreGetMemory(tilemap.tileChunkStore);
+
+        char tileMemoryLog[512] = {};
+        memory->DEBUG_platformLog(tileMemoryLog,
+                                    sizeof(tileMemoryLog),
+                                    "Tile chunks: %u uniform (%llu bytes), %u runs (%llu bytes), %u packed (%llu bytes), %u values (%llu bytes). "
+                                    "%llu bytes reserved from the tiles block, against %llu as a uint32 a tile\n",
+                                    tileMemory.chunks[TILE_CHUNK_ENCODING_UNIFORM],
+                                    (unsigned long long)tileMemory.bytes[TILE_CHUNK_ENCODING_UNIFORM],
+                                    tileMemory.chunks[TILE_CHUNK_ENCODING_RUNS],
+                                    (unsigned long long)tileMemory.bytes[TILE_CHUNK_ENCODING_RUNS],
+                                    tileMemory.chunks[TILE_CHUNK_ENCODING_PACKED],
+                                    (unsigned long long)tileMemory.bytes[TILE_CHUNK_ENCODING_PACKED],
+                                    tileMemory.chunks[TILE_CHUNK_ENCODING_VALUES],
+                                    (unsigned long long)tileMemory.bytes[TILE_CHUNK_ENCODING_VALUES],
+                                    (unsigned long long)tileMemory.reservedBytes,
+                                    (unsigned long long)tileMemory.unencodedBytes);
+#endif
+
         memory->initialised = true;
     } // initialisation
 
@@ -406,12 +550,39 @@ EXTERN_DLL_EXPORT GAME_UPDATE(gameUpdate)
     // 0 = keyboard, 1 = first controller
     uint8 userSelectedMainController = 0; // @TODO(JM) make this selectable through a UI
 
-    playerHandleMovement(gameState,
-                            memory,
-                            frameBuffer,
-                            audioBuffer,
-                            &inputInstances[0],
-                            userSelectedMainController);
+    /**
+     * Fixed step simulation. Bank the time the last frame took and run as
+     * many whole steps as it covers. Anything left over carries into the
+     * next frame and decides how far between the last two steps we draw.
+     */
+    float64 simStepSeconds = (1.0 / (float64)GAME_SIM_HZ);
+    float64 frameSeconds = ((float64)inputInstances[0].msPerFrame / 1000.0);
+
+    if (frameSeconds < 0.0) {
+        frameSeconds = 0.0;
+    } else if (frameSeconds > GAME_SIM_MAX_SECONDS_PER_FRAME) {
+        frameSeconds = GAME_SIM_MAX_SECONDS_PER_FRAME;
+    }
+
+    gameState->simAccumulatorSeconds += frameSeconds;
+
+    while (gameState->simAccumulatorSeconds >= simStepSeconds) {
+
+        gameState->player1.previousAbsolutePosition = gameState->player1.absolutePosition;
+        gameState->player1.previousZIndex = gameState->player1.zIndex;
+
+        playerHandleMovement(gameState,
+                                memory,
+                                frameBuffer,
+                                audioBuffer,
+                                &inputInstances[0],
+                                userSelectedMainController,
+                                (float32)simStepSeconds);
+
+        gameState->simAccumulatorSeconds -= simStepSeconds;
+    }
+
+    gameState->simInterpolationAlpha = (float32)(gameState->simAccumulatorSeconds / simStepSeconds);
 
     GameControllerInput controller = inputInstances[0].controllers[userSelectedMainController];
 
@@ -426,20 +597,122 @@ EXTERN_DLL_EXPORT GAME_UPDATE(gameUpdate)
      */
 
 #ifdef HANDMADE_DEBUG_AUDIO
-    audioBufferWriteSineWave(gameState, audioBuffer);
+
+    // (Re)build the wavetables and the test tone if the platform's sample
+    // rate has changed
+    if (audioBuffer->samplesPerSecond && (gameState->wavetables->samplesPerSecond != audioBuffer->samplesPerSecond)) {
+
+        oscillatorBuildWavetables(gameState->wavetables, audioBuffer->samplesPerSecond);
+
+        oscillatorSet(&gameState->debugOscillator,
+                        gameState->wavetables,
+                        OSCILLATOR_WAVEFORM_SINE,
+                        (float32)GAME_DEBUG_TONE_HZ,
+                        1000.0f);
+
+        // One cycle, so that it loops seamlessly. Exact for any sample rate
+        // that's a multiple of GAME_DEBUG_TONE_HZ.
+        uint32 toneSampleCount = (audioBuffer->samplesPerSecond / GAME_DEBUG_TONE_HZ);
+        assert(toneSampleCount <= GAME_DEBUG_TONE_MAX_SAMPLES);
+
+        gameState->debugOscillator.phase = 0;
+
+        oscillatorWriteFloat(&gameState->debugOscillator,
+                                gameState->wavetables,
+                                gameState->debugToneSound.samples,
+                                toneSampleCount);
+
+        mixerStop(gameState->mixer, gameState->debugToneVoice);
+
+        gameState->debugToneSound.sampleCount = toneSampleCount;
+        gameState->debugToneVoice = mixerPlay(gameState->mixer, &gameState->debugToneSound, 1.0f, 0.0f, true);
+    }
+
 #endif // HANDMADE_DEBUG_AUDIO
 
+    mixerMix(gameState->mixer, (int16 *)audioBuffer->memory, audioBuffer->noOfSamplesToWrite);
+
     /**
      * Write the frame buffer...
      * 
+     * Everything is pushed to the render group first and drawn in one go
+     * at the end
      */
+    RenderGroup *renderGroup = &gameState->renderGroup;
+    renderGroupClear(renderGroup);
+
+    // The resolution to draw at, in eighths of the frame buffer's. Everything
+    // is still laid out for the frame buffer's size; the render group scales
+    // it as it's drawn.
+    uint32 resolutionScale = memory->fixedResolutionScale;
+
+    if (resolutionScale) {
+        resolutionScale = ((resolutionScale < RESOLUTION_SCALE_MIN) ? RESOLUTION_SCALE_MIN : resolutionScale);
+        resolutionScale = ((resolutionScale > RESOLUTION_SCALE_MAX) ? RESOLUTION_SCALE_MAX : resolutionScale);
+    } else {
+        resolutionScale = resolutionControllerUpdate(&gameState->resolution,
+                                                        inputInstances[0].msWorkPerFrame,
+                                                        inputInstances[0].targetFPS);
+    }
+
+    GameFrameBuffer renderTarget = {};
+    GameFrameBuffer *drawBuffer = frameBuffer;
+
+    if ((resolutionScale < RESOLUTION_SCALE_MAX)
+            && (frameBuffer->widthPx <= FRAME_BUFFER_PIXEL_WIDTH)
+            && (frameBuffer->heightPx <= FRAME_BUFFER_PIXEL_HEIGHT)) {
+
+        renderTarget.widthPx = resolutionScaleSize(frameBuffer->widthPx, resolutionScale);
+        renderTarget.heightPx = resolutionScaleSize(frameBuffer->heightPx, resolutionScale);
+        renderTarget.bytesPerPixel = frameBuffer->bytesPerPixel;
+        renderTarget.byteWidthPerRow = (renderTarget.widthPx * sizeof(uint32));
+        renderTarget.memory = gameState->renderTargetPixels;
+
+        renderGroup->scaleX = ((float32)renderTarget.widthPx / (float32)frameBuffer->widthPx);
+        renderGroup->scaleY = ((float32)renderTarget.heightPx / (float32)frameBuffer->heightPx);
+
+        drawBuffer = &renderTarget;
+    }
+
+    frameBuffer->drawnWidthPx = drawBuffer->widthPx;
+    frameBuffer->drawnHeightPx = drawBuffer->heightPx;
+
+    // Scaled up frames cover the whole frame buffer, and a change of
+    // resolution changes every pixel
+    bool32 redrawAll = ((drawBuffer != frameBuffer) || (gameState->lastResolutionScale != resolutionScale));
+    gameState->lastResolutionScale = resolutionScale;
+
+    // What's changed on screen since the last frame. The platform layer only
+    // needs to present this.
+    FrameBufferDirtyRegion *dirtyRegion = &frameBuffer->dirtyRegion;
+    renderDirtyRegionClear(dirtyRegion);
+
+    // The frame buffer has changed size (E.g. gone full screen), so a
+    // different number of tiles fit on it
+    if ((gameState->world.tilemap.screenWidthPx != frameBuffer->widthPx)
+            || (gameState->world.tilemap.screenHeightPx != frameBuffer->heightPx)) {
+        setTilemapScreenSize(&gameState->world.tilemap, frameBuffer->widthPx, frameBuffer->heightPx);
+    }
+
     Tilemap tilemap = gameState->world.tilemap;
 
     uint32 absTileIndexZ = gameState->player1.zIndex;
 
+    // Where the player is drawn this frame, between the last two sim steps
+    struct Vector2 playerDrawPosition = getPlayerInterpolatedPosition(gameState);
+
 #if SCROLL_TYPE_SMOOTH
-    xyzuint centerTileIndex = gameState->worldPosition.tileIndex;
-    xyuint tileRelPos = gameState->worldPosition.tileRelativePixelPos;
+    // The world scrolls with the player so centre it on the interpolated
+    // game position rather than the last simulated one
+    TilemapPosition drawPosition = {};
+    setTilemapPositionData(&drawPosition,
+                            intrin_roundF32ToUI32(playerDrawPosition.x + (gameState->player1.gamePosition.x - gameState->player1.absolutePosition.x)),
+                            intrin_roundF32ToUI32(playerDrawPosition.y + (gameState->player1.gamePosition.y - gameState->player1.absolutePosition.y)),
+                            absTileIndexZ,
+                            tilemap);
+
+    xyzuint centerTileIndex = drawPosition.tileIndex;
+    xyuint tileRelPos = drawPosition.tileRelativePixelPos;
 #elif SCROLL_TYPE_SCREEN
     xyzuint centerTileIndex = gameState->cameraPosition.tileIndex;
     xyuint tileRelPos = gameState->cameraPosition.tileRelativePixelPos;
@@ -450,124 +723,171 @@ EXTERN_DLL_EXPORT GAME_UPDATE(gameUpdate)
     centerTileStart.x = ((frameBuffer->widthPx / 2) - tileRelPos.x);
     centerTileStart.y = ((frameBuffer->heightPx / 2) - tileRelPos.y);
 
-    // Draw the tile map...
-    for (int32 row = ((int32)gameState->world.tilemap.tilesPerHalfScreenY * -1); row <= (int32)gameState->world.tilemap.tilesPerHalfScreenY; row++) {
-        for (int32 column = ((int32)gameState->world.tilemap.tilesPerHalfScreenX *-1); column <= (int32)gameState->world.tilemap.tilesPerHalfScreenX; column++){
-
-            xyuint tileIndex = {
-                (centerTileIndex.x + column),
-                (centerTileIndex.y + row)
-            };
-
-            xyint startPixelPos = {
-                ((int32)centerTileStart.x + (column * (int32)tilemap.tileWidthPx)),
-                ((int32)centerTileStart.y + (row * (int32)tilemap.tileHeightPx))
-            };
-
-            // Get the tile chunk index based off of the absolute tile indexes
-            xyzuint tileChunkIndex = getTileChunkIndexForAbsTile(tileIndex.x,
-                                                                    tileIndex.y,
-                                                                    absTileIndexZ,
-                                                                    tilemap);
-
-            // Is this tile chunk out of the sparse storage memory bounds?
-            if ((tileChunkIndex.x > (tilemap.tileChunkDimensions - 1))
-                    || (tileChunkIndex.y > (tilemap.tileChunkDimensions - 1))) {
-                writeRectangleInt(frameBuffer,
-                            startPixelPos.x,
-                            startPixelPos.y,
-                            tilemap.tileWidthPx,
-                            tilemap.tileHeightPx,
-                            getOutOfTileChunkMemoryBoundsColour()); // blue
+    // Colours that don't depend on the tile chunk, packed once
+    uint32 outOfTileChunkMemoryBoundsColour = packColour(getOutOfTileChunkMemoryBoundsColour());
+    uint32 uninitialisedTileChunkTilesColour = packColour(getUninitialisedTileChunkTilesColour());
+
+    // Draw the tile map, a tile chunk at a time. Covers every tile within
+    // tilesPerHalfScreenX/Y of the centre tile.
+    TileChunkCache *tileChunkCache = &gameState->tileChunkCache;
+    tileChunkCacheBeginFrame(tileChunkCache);
+
+    int64 chunkTiles = (int64)tilemap.tileChunkTileDimensions;
+    int64 chunkWidthPx = (chunkTiles * tilemap.tileWidthPx);
+    int64 chunkHeightPx = (chunkTiles * tilemap.tileHeightPx);
+
+    int64 minTileX = ((int64)centerTileIndex.x - tilemap.tilesPerHalfScreenX);
+    int64 maxTileX = ((int64)centerTileIndex.x + tilemap.tilesPerHalfScreenX);
+    int64 minTileY = ((int64)centerTileIndex.y - tilemap.tilesPerHalfScreenY);
+    int64 maxTileY = ((int64)centerTileIndex.y + tilemap.tilesPerHalfScreenY);
+
+    // Rounded down, including for tiles off the bottom/left of the tilemap
+    int64 minChunkX = ((minTileX >= 0) ? (minTileX / chunkTiles) : (((minTileX + 1) / chunkTiles) - 1));
+    int64 maxChunkX = ((maxTileX >= 0) ? (maxTileX / chunkTiles) : (((maxTileX + 1) / chunkTiles) - 1));
+    int64 minChunkY = ((minTileY >= 0) ? (minTileY / chunkTiles) : (((minTileY + 1) / chunkTiles) - 1));
+    int64 maxChunkY = ((maxTileY >= 0) ? (maxTileY / chunkTiles) : (((maxTileY + 1) / chunkTiles) - 1));
+
+    for (int64 chunkY = minChunkY; chunkY <= maxChunkY; chunkY++) {
+        for (int64 chunkX = minChunkX; chunkX <= maxChunkX; chunkX++) {
+
+            // Where the chunk's bottom left tile starts on screen
+            int64 startPixelX = ((int64)centerTileStart.x + (((chunkX * chunkTiles) - (int64)centerTileIndex.x) * tilemap.tileWidthPx));
+            int64 startPixelY = ((int64)centerTileStart.y + (((chunkY * chunkTiles) - (int64)centerTileIndex.y) * tilemap.tileHeightPx));
+
+            // Is this tile chunk outside of the tilemap?
+            if ((chunkX < 0)
+                    || (chunkY < 0)
+                    || (chunkX > (int64)(tilemap.tileChunkDimensions - 1))
+                    || (chunkY > (int64)(tilemap.tileChunkDimensions - 1))) {
+                renderGroupPushRectangle(renderGroup,
+                            GAME_RENDER_LAYER_TILES,
+                            (float32)startPixelX,
+                            (float32)startPixelY,
+                            (uint32)chunkWidthPx,
+                            (uint32)chunkHeightPx,
+                            outOfTileChunkMemoryBoundsColour); // blue
                 continue;
             }
 
-            // Get the relevant tile chunk
-            TileChunk *tileChunk = getTileChunkFromTileChunkIndex(tileChunkIndex,
-                                                                tilemap);
-
-            // Calculate the tile chunk relative tile indexes
-            xyuint chunkRelTileIndex = getChunkRelativeTileIndex(tileIndex.x,
-                                                                    tileIndex.y,
-                                                                    tilemap);
-
-            // Get the individual tile
-            uint32 *tileValue = (tileChunk->tiles + ((chunkRelTileIndex.y * tilemap.tileChunkTileDimensions) + chunkRelTileIndex.x));
-
-            // Is this tile out of the sparse storage memory bounds?
-            if ((gameState->tilesMemoryBlock.bytesUsed <= 0) ||
-                    ((uint8*)tileValue > gameState->tilesMemoryBlock.lastAddressReserved
-                        || (uint8*)tileValue < gameState->tilesMemoryBlock.startingAddress)) {
-                writeRectangleInt(frameBuffer,
-                            startPixelPos.x,
-                            startPixelPos.y,
-                            tilemap.tileWidthPx,
-                            tilemap.tileHeightPx,
-                            getUninitialisedTileChunkTilesColour()); // red
+            xyzuint tileChunkIndex = {(uint32)chunkX, (uint32)chunkY, absTileIndexZ};
+
+            TileChunk *tileChunk = getTileChunkFromTileChunkIndex(tileChunkIndex, tilemap);
+
+            // Have the tiles within this tile chunk been initialised?
+            if (!tileChunk || (TILE_CHUNK_ENCODING_NONE == tileChunk->encoding)) {
+                renderGroupPushRectangle(renderGroup,
+                            GAME_RENDER_LAYER_TILES,
+                            (float32)startPixelX,
+                            (float32)startPixelY,
+                            (uint32)chunkWidthPx,
+                            (uint32)chunkHeightPx,
+                            uninitialisedTileChunkTilesColour); // red
                 continue;
             }
 
-            // Null pointer check
-            if (!tileValue) {
-                continue;
+            TileChunkCacheSlot *cachedChunk = tileChunkCacheGet(tileChunkCache, tileChunk, &tilemap);
+
+#if SCROLL_TYPE_SCREEN
+            // Its tiles may have changed since it was last drawn
+            if (cachedChunk->builtFrame == tileChunkCache->frame) {
+                renderDirtyRegionAddRect(dirtyRegion,
+                                            frameBuffer,
+                                            startPixelX,
+                                            startPixelY,
+                                            (startPixelX + chunkWidthPx),
+                                            (startPixelY + chunkHeightPx));
             }
+#endif
 
-            Colour pixelColour = {};
-            setTileColour(&pixelColour, *tileValue);
+            for (uint32 i = 0; i < cachedChunk->rectangleCount; i++) {
 
-#ifdef HANDMADE_DEBUG_TILE_POS
-            if (tileIndex.x == gameState->worldPosition.tileIndex.x
-                && tileIndex.y == gameState->worldPosition.tileIndex.y) {
-                pixelColour.r = 0.0f;
-                pixelColour.g = 1.0f;
-                pixelColour.b = 0.0f;
+                TileChunkCacheRectangle *rectangle = &cachedChunk->rectangles[i];
+
+                int64 minX = (startPixelX + ((int64)rectangle->minX * tilemap.tileWidthPx));
+                int64 minY = (startPixelY + ((int64)rectangle->minY * tilemap.tileHeightPx));
+                int64 maxX = (startPixelX + ((int64)rectangle->maxX * tilemap.tileWidthPx));
+                int64 maxY = (startPixelY + ((int64)rectangle->maxY * tilemap.tileHeightPx));
+
+                // Off screen
+                if ((maxX <= 0)
+                        || (maxY <= 0)
+                        || (minX >= (int64)frameBuffer->widthPx)
+                        || (minY >= (int64)frameBuffer->heightPx)) {
+                    continue;
+                }
+
+                renderGroupPushRectangle(renderGroup,
+                            GAME_RENDER_LAYER_TILES,
+                            (float32)minX,
+                            (float32)minY,
+                            (uint32)(maxX - minX),
+                            (uint32)(maxY - minY),
+                            rectangle->colour);
             }
-#endif
+        }
+    }
 
-            writeRectangleInt(frameBuffer,
-                            startPixelPos.x,
-                            startPixelPos.y,
+#ifdef HANDMADE_DEBUG_TILE_POS
+    // Over the top of the cached tiles
+    {
+        Colour tilePosColour = {0.0f, 1.0f, 0.0f};
+
+        renderGroupPushRectangle(renderGroup,
+                            GAME_RENDER_LAYER_TILES,
+                            (float32)((int64)centerTileStart.x + (((int64)gameState->worldPosition.tileIndex.x - (int64)centerTileIndex.x) * tilemap.tileWidthPx)),
+                            (float32)((int64)centerTileStart.y + (((int64)gameState->worldPosition.tileIndex.y - (int64)centerTileIndex.y) * tilemap.tileHeightPx)),
                             tilemap.tileWidthPx,
                             tilemap.tileHeightPx,
-                            pixelColour);
-        }
+                            packColour(tilePosColour));
     }
+#endif
 
     // Draw player
-    PlayerBitmap playerBitmap = gameState->player1.bitmaps[gameState->player1.currentBitmapIndex];
+    PlayerBitmap *playerBitmap = &gameState->player1.bitmaps[gameState->player1.currentBitmapIndex];
 
 #if SCROLL_TYPE_SMOOTH
     struct Vector2 playerPositionData = gameState->player1.fixedPosition;
 #elif SCROLL_TYPE_SCREEN
-    struct Vector2 playerPositionData = gameState->player1.canonicalAbsolutePosition;
+    // Relative to the screen the camera is showing
+    struct Vector2 playerPositionData = {0};
+    playerPositionData.x = (playerDrawPosition.x - (float32)(gameState->cameraPosition.absPixelPos.x - (frameBuffer->widthPx / 2)));
+    playerPositionData.y = (playerDrawPosition.y - (float32)(gameState->cameraPosition.absPixelPos.y - (frameBuffer->heightPx / 2)));
 #endif
 
-    writeBitmap(frameBuffer,
-                playerPositionData.x,
-                playerPositionData.y,
-                (float32)playerBitmap.torso.widthPx,
-                (float32)playerBitmap.torso.heightPx,
-                -62.0f,
-                -34.0f,
-                playerBitmap.torso);
-
-    writeBitmap(frameBuffer,
-                playerPositionData.x,
-                playerPositionData.y,
-                (float32)playerBitmap.cape.widthPx,
-                (float32)playerBitmap.cape.heightPx,
-                -62.0f,
-                -34.0f,
-                playerBitmap.cape);
-
-    writeBitmap(frameBuffer,
-                playerPositionData.x,
-                playerPositionData.y,
-                (float32)playerBitmap.head.widthPx,
-                (float32)playerBitmap.head.heightPx,
-                -62.0f,
-                -34.0f,
-                playerBitmap.head);
+    // Where the bitmaps' bottom left corner sits relative to the player's
+    // position
+    float32 playerAlignX = -62.0f;
+    float32 playerAlignY = -34.0f;
+
+    renderGroupPushBitmap(renderGroup,
+                          GAME_RENDER_LAYER_PLAYER,
+                          playerPositionData.x,
+                          playerPositionData.y,
+                          (float32)playerBitmap->torso.widthPx,
+                          (float32)playerBitmap->torso.heightPx,
+                          playerAlignX,
+                          playerAlignY,
+                          &playerBitmap->torso);
+
+    renderGroupPushBitmap(renderGroup,
+                          GAME_RENDER_LAYER_PLAYER,
+                          playerPositionData.x,
+                          playerPositionData.y,
+                          (float32)playerBitmap->cape.widthPx,
+                          (float32)playerBitmap->cape.heightPx,
+                          playerAlignX,
+                          playerAlignY,
+                          &playerBitmap->cape);
+
+    renderGroupPushBitmap(renderGroup,
+                          GAME_RENDER_LAYER_PLAYER,
+                          playerPositionData.x,
+                          playerPositionData.y,
+                          (float32)playerBitmap->head.widthPx,
+                          (float32)playerBitmap->head.heightPx,
+                          playerAlignX,
+                          playerAlignY,
+                          &playerBitmap->head);
 
     // Vector stuff...
 
@@ -579,59 +899,55 @@ EXTERN_DLL_EXPORT GAME_UPDATE(gameUpdate)
     float32 pixelsPerPoint = 10.0f;
 
     // Y axis
-    writeRectangle(frameBuffer,
+    renderGroupPushRectangle(renderGroup,
+        GAME_RENDER_LAYER_DEBUG,
         (FRAME_BUFFER_PIXEL_WIDTH / 2),
         (FRAME_BUFFER_PIXEL_HEIGHT / 2) - 500,
         1,
         1000,
-        { 1.0f, 1.0f, 1.0f });
+        packColour({ 1.0f, 1.0f, 1.0f }));
 
     // X axis
-    writeRectangle(frameBuffer,
+    renderGroupPushRectangle(renderGroup,
+        GAME_RENDER_LAYER_DEBUG,
         (FRAME_BUFFER_PIXEL_WIDTH / 2) - 500,
         (FRAME_BUFFER_PIXEL_HEIGHT / 2),
         1000,
         1,
-        {1.0f, 1.0f, 1.0f});
+        packColour({1.0f, 1.0f, 1.0f}));
+
+    // Each vector is drawn from the origin as an arrow
+    Vector2 vectorOrigin = {(float32)vox, (float32)voy};
+    float32 arrowHeadLengthPx = 6.0f;
 
     // Vector 1
     {
         Vector2 v1 = {5.0f, 10.0f}; // "points"
-        float32 v1mag = getVectorMagnitude(v1);
-
-        float32 xfract = (v1.x / v1mag);
-        float32 yfract = (v1.y / v1mag);
-
-        for (size_t i = 0; i < ((size_t)((float64)v1mag * (float64)pixelsPerPoint)); i++) {
-            float32 x = ((float32)vox + ((float32)i*xfract));
-            float32 y = ((float32)voy + ((float32)i*yfract));
-            writeRectangle(frameBuffer,
-                x,
-                y,
-                1,
-                1,
-                {1.0f, 0.0f, 0.0f});
-        }
+        v1 *= pixelsPerPoint;
+        v1 += vectorOrigin;
+
+        renderGroupPushArrow(renderGroup,
+            GAME_RENDER_LAYER_DEBUG,
+            vectorOrigin,
+            v1,
+            arrowHeadLengthPx,
+            packColour({1.0f, 0.0f, 0.0f}),
+            true);
     }
 
     // Vector 2
     {
         Vector2 v1 = {15.0f, 6.0f}; // "points"
-        float32 v1mag = getVectorMagnitude(v1);
-
-        float32 xfract = (v1.x / v1mag);
-        float32 yfract = (v1.y / v1mag);
-
-        for (size_t i = 0; i < ((size_t)(v1mag * pixelsPerPoint)); i++) {
-            float32 x = ((float32)vox + ((float32)i*xfract));
-            float32 y = ((float32)voy + ((float32)i*yfract));
-            writeRectangle(frameBuffer,
-                x,
-                y,
-                1,
-                1,
-                {0.0f, 1.0f, 0.0f});
-        }
+        v1 *= pixelsPerPoint;
+        v1 += vectorOrigin;
+
+        renderGroupPushArrow(renderGroup,
+            GAME_RENDER_LAYER_DEBUG,
+            vectorOrigin,
+            v1,
+            arrowHeadLengthPx,
+            packColour({0.0f, 1.0f, 0.0f}),
+            true);
     }
 
     // Vector 3
@@ -642,55 +958,167 @@ EXTERN_DLL_EXPORT GAME_UPDATE(gameUpdate)
         Vector2 v1 = {0.0f, 0.0f}; // "points"
         v1 += v2;
         v1 += v3;
-        float32 v1mag = getVectorMagnitude(v1);
-
-        float32 xfract = (v1.x / v1mag);
-        float32 yfract = (v1.y / v1mag);
-
-        for (size_t i = 0; i < ((size_t)(v1mag * pixelsPerPoint)); i++) {
-            float32 x = ((float32)vox + ((float32)i*xfract));
-            float32 y = ((float32)voy + ((float32)i*yfract));
-            writeRectangle(frameBuffer,
-                x,
-                y,
-                1,
-                1,
-                {0.0f, 0.0f, 1.0f});
-        }
+        v1 *= pixelsPerPoint;
+        v1 += vectorOrigin;
+
+        renderGroupPushArrow(renderGroup,
+            GAME_RENDER_LAYER_DEBUG,
+            vectorOrigin,
+            v1,
+            arrowHeadLengthPx,
+            packColour({0.0f, 0.0f, 1.0f}),
+            true);
     }
 
     // Vector 4
     {
         Vector2 v1 = {-8.0f, -16.0f}; // "points"
-        float32 v1mag = getVectorMagnitude(v1);
-
-        float32 xfract = (v1.x / v1mag);
-        float32 yfract = (v1.y / v1mag);
-
-        for (size_t i = 0; i < ((size_t)(v1mag * pixelsPerPoint)); i++) {
-            float32 x = ((float32)vox + ((float32)i*xfract));
-            float32 y = ((float32)voy + ((float32)i*yfract));
-            writeRectangle(frameBuffer,
-                x,
-                y,
-                1,
-                1,
-                {0.0f, 1.0f, 0.0f});
-        }
+        v1 *= pixelsPerPoint;
+        v1 += vectorOrigin;
+
+        renderGroupPushArrow(renderGroup,
+            GAME_RENDER_LAYER_DEBUG,
+            vectorOrigin,
+            v1,
+            arrowHeadLengthPx,
+            packColour({0.0f, 1.0f, 0.0f}),
+            true);
     }
 
 #if 0
     // Mouse input testing
     if (inputInstances->mouse.leftClick.endedDown) {
-        writeRectangleInt(frameBuffer,
+        renderGroupPushRectangle(renderGroup,
+                        GAME_RENDER_LAYER_DEBUG,
                         inputInstances->mouse.position.x,
                         inputInstances->mouse.position.y,
                         50,
                         50,
-                        { 0.5f, 0.0f, 0.5f });
+                        packColour({ 0.5f, 0.0f, 0.5f }));
     }
 #endif
 
+    // Only the parts of the frame buffer that are out of date are drawn
+    FrameBufferDirtyRegion *redrawRegion = NULL;
+
+#if SCROLL_TYPE_SCREEN
+    FrameBufferDirtyRegion screenRedrawRegion;
+
+    {
+        // Covers all three bitmaps, rounded the same way as when pushed
+        uint32 playerWidthPx = playerBitmap->torso.widthPx;
+        uint32 playerHeightPx = playerBitmap->torso.heightPx;
+
+        if (playerBitmap->cape.widthPx > playerWidthPx) {
+            playerWidthPx = playerBitmap->cape.widthPx;
+        }
+
+        if (playerBitmap->head.widthPx > playerWidthPx) {
+            playerWidthPx = playerBitmap->head.widthPx;
+        }
+
+        if (playerBitmap->cape.heightPx > playerHeightPx) {
+            playerHeightPx = playerBitmap->cape.heightPx;
+        }
+
+        if (playerBitmap->head.heightPx > playerHeightPx) {
+            playerHeightPx = playerBitmap->head.heightPx;
+        }
+
+        FrameBufferRect playerRect = {};
+        playerRect.minX = (intrin_roundF32ToI32(playerPositionData.x) + intrin_roundF32ToI32(playerAlignX));
+        playerRect.minY = (intrin_roundF32ToI32(playerPositionData.y) + intrin_roundF32ToI32(playerAlignY));
+        playerRect.maxX = (playerRect.minX + (int32)playerWidthPx);
+        playerRect.maxY = (playerRect.minY + (int32)playerHeightPx);
+
+        // Where the player is now, and where they were drawn last frame
+        renderDirtyRegionAddRect(dirtyRegion,
+                                    frameBuffer,
+                                    playerRect.minX,
+                                    playerRect.minY,
+                                    playerRect.maxX,
+                                    playerRect.maxY);
+
+        FrameBufferRect *lastPlayerRect = &gameState->lastPlayerRect;
+
+        renderDirtyRegionAddRect(dirtyRegion,
+                                    frameBuffer,
+                                    lastPlayerRect->minX,
+                                    lastPlayerRect->minY,
+                                    lastPlayerRect->maxX,
+                                    lastPlayerRect->maxY);
+
+        // The camera has moved to another screen, the player has changed
+        // plane, the resolution's changed, or this is the first frame
+        if (redrawAll
+                || (gameState->dirtyFramesRecorded == 0)
+                || (gameState->lastCameraAbsPixelPos.x != gameState->cameraPosition.absPixelPos.x)
+                || (gameState->lastCameraAbsPixelPos.y != gameState->cameraPosition.absPixelPos.y)
+                || (gameState->lastZIndex != absTileIndexZ)
+                || (gameState->lastFrameBufferWidthPx != frameBuffer->widthPx)
+                || (gameState->lastFrameBufferHeightPx != frameBuffer->heightPx)) {
+            renderDirtyRegionAddAll(dirtyRegion);
+        }
+
+#if defined(HANDMADE_DEBUG_AUDIO) || defined(HANDMADE_DEBUG_TILE_POS)
+        // Drawn with everything else each frame, without being tracked
+        renderDirtyRegionAddAll(dirtyRegion);
+#endif
+
+        gameState->lastPlayerRect = playerRect;
+        gameState->lastCameraAbsPixelPos = gameState->cameraPosition.absPixelPos;
+        gameState->lastZIndex = absTileIndexZ;
+        gameState->lastFrameBufferWidthPx = frameBuffer->widthPx;
+        gameState->lastFrameBufferHeightPx = frameBuffer->heightPx;
+
+        gameState->dirtyHistory[gameState->dirtyHistoryNext] = *dirtyRegion;
+        gameState->dirtyHistoryNext = ((gameState->dirtyHistoryNext + 1) % GAME_DIRTY_HISTORY);
+
+        if (gameState->dirtyFramesRecorded < GAME_DIRTY_HISTORY) {
+            gameState->dirtyFramesRecorded++;
+        }
+
+        // The frame buffer is missing everything that's changed in the frames
+        // since it was last drawn into, this one included
+        renderDirtyRegionClear(&screenRedrawRegion);
+
+        if ((frameBuffer->age == 0) || (frameBuffer->age > gameState->dirtyFramesRecorded)) {
+
+            renderDirtyRegionAddAll(&screenRedrawRegion);
+
+        } else {
+
+            for (uint32 i = 1; i <= frameBuffer->age; i++) {
+                uint32 historyIndex = (((gameState->dirtyHistoryNext + GAME_DIRTY_HISTORY) - i) % GAME_DIRTY_HISTORY);
+                renderDirtyRegionAddRegion(&screenRedrawRegion, frameBuffer, &gameState->dirtyHistory[historyIndex]);
+            }
+        }
+
+        // Frames drawn at a lower resolution are drawn in full
+        if (drawBuffer == frameBuffer) {
+            redrawRegion = &screenRedrawRegion;
+        }
+    }
+#else
+    // The world scrolls under the player, so all of it changes every frame
+    renderDirtyRegionAddAll(dirtyRegion);
+#endif
+
+    renderGroupExecute(thread,
+                        renderGroup,
+                        drawBuffer,
+                        redrawRegion,
+                        memory->renderQueue,
+                        memory->platformAddWorkQueueEntry,
+                        memory->platformCompleteAllWork);
+
+    if (drawBuffer != frameBuffer) {
+        upscaleFrameBuffer(frameBuffer,
+                            drawBuffer,
+                            (memory->upscaleNearest ? UPSCALE_FILTER_NEAREST : UPSCALE_FILTER_BILINEAR),
+                            gameState->upscaleScratchRow);
+    }
+
 #if defined(HANDMADE_DEBUG_AUDIO)
     frameBufferWriteAudioDebug(gameState, frameBuffer, audioBuffer);
 #endif
@@ -723,29 +1151,48 @@ EXTERN_DLL_EXPORT GAME_INIT_FRAME_BUFFER(gameInitFrameBuffer)
     frameBuffer->byteWidthPerRow = byteWidthPerRow;
     frameBuffer->memory = memory;
 
+    // Nothing known about what's already in it until the platform layer says
+    frameBuffer->age = 0;
+    renderDirtyRegionAddAll(&frameBuffer->dirtyRegion);
+
     return frameBuffer;
 }
 
 EXTERN_DLL_EXPORT GAME_INIT_AUDIO_BUFFER(gameInitAudioBuffer)
 {
-    if ((noOfBytesToWrite <= 0) || (bytesPerSample <= 0)) {
+    if (bytesPerSample <= 0) {
+        return audioBuffer;
+    }
+
+    audioBuffer->samplesPerSecond = (uint32)(platformBufferSizeInBytes / bytesPerSample);
+
+    // The platform's audio thread may already have enough queued, in which
+    // case there's nothing to write this frame.
+    if (noOfBytesToWrite <= 0) {
+        audioBuffer->noOfSamplesToWrite = 0;
+        audioBuffer->noOfBytesToWrite = 0;
         return audioBuffer;
     }
 
     uint32 noOfSamplesToWrite = (noOfBytesToWrite / bytesPerSample);
 
-    if (audioBuffer->noOfSamplesToWrite != noOfSamplesToWrite) {
+    // The amount asked for varies from frame to frame now, so only go back to
+    // the platform when it's more than we've got
+    if (noOfBytesToWrite > audioBuffer->memorySizeInBytes) {
 
         // @TODO(JM) move the audio memory to the GameMemory object
         if (!audioBuffer->initialised) {
             audioBuffer->initialised = 1;
-            audioBuffer->memory = memory->platformAllocateMemory(thread, 0, noOfBytesToWrite);
         } else {
             memory->platformFreeMemory(thread, audioBuffer->memory);
-            audioBuffer->memory = memory->platformAllocateMemory(thread, 0, noOfBytesToWrite);
         }
+
+        audioBuffer->memory = memory->platformAllocateMemory(thread, 0, noOfBytesToWrite);
+        audioBuffer->memorySizeInBytes = noOfBytesToWrite;
     }
+
     audioBuffer->bytesPerSample = bytesPerSample;
+    audioBuffer->noOfBytesToWrite = noOfBytesToWrite;
     audioBuffer->noOfSamplesToWrite = noOfSamplesToWrite;
     audioBuffer->platformBufferSizeInBytes = platformBufferSizeInBytes;
 
@@ -31,6 +31,32 @@
     assert(!"Both scroll types cannot be enabled at the same time")
 #endif
 
+// The simulation runs in fixed steps of 1/GAME_SIM_HZ seconds regardless of
+// the platform layer's frame rate. Each frame runs however many steps the
+// elapsed time covers (possibly none) and draws between the last two steps.
+#define GAME_SIM_HZ 120
+
+// Cap on the time a single frame can hand to the simulation. Stops a long
+// stall (breakpoint, hot reload, window drag) from running hundreds of steps
+// in one go.
+#define GAME_SIM_MAX_SECONDS_PER_FRAME 0.25
+
+// HANDMADE_DEBUG_AUDIO test tone. Room is reserved for one cycle at up to
+// 192kHz.
+#define GAME_DEBUG_TONE_HZ 100
+#define GAME_DEBUG_TONE_MAX_SAMPLES (192000 / GAME_DEBUG_TONE_HZ)
+
+// Most commands pushed to the render group per frame, and the push buffer
+// they're packed into. A screen of tiles plus the debug drawing is around
+// 1500 commands of 24-32 bytes.
+#define GAME_RENDER_MAX_COMMANDS 8192
+#define GAME_RENDER_PUSH_BUFFER_SIZE (256 * 1024)
+
+// Frames of dirty regions kept (SCROLL_TYPE_SCREEN only). A frame buffer last
+// drawn into up to this many frames ago only has what's changed since redrawn.
+// Triple buffering needs 3.
+#define GAME_DIRTY_HISTORY 4
+
 #include "global_macros.h"
 #include "types.h"
 #include "math.h"
@@ -43,8 +69,13 @@
 #include "memory.h"
 #include "graphics.h"
 #include "audio.h"
+#include "oscillator.h"
+#include "mixer.h"
+#include "renderer.h"
 #include "world.h"
 #include "tilemap.h"
+#include "tile_chunk_cache.h"
+#include "resolution.h"
 #include "player.h"
 
 #ifdef HANDMADE_DEBUG_TILE_POS
@@ -56,20 +87,13 @@
 
 #endif
 
-typedef struct SineWave
+// Render group layers, drawn bottom up
+typedef enum GameRenderLayer
 {
-    // Hertz is the same as "cycles per second".
-    // The number of cycles that occur in one second is equal to the
-    // frequency of the signal in hertz (abbreviated Hz).
-    // Hertz set the tone. E.g. 256 = middle C.
-    // @link https://bit.ly/2PCUzdH
-    // @link https://en.wikipedia.org/wiki/Scientific_pitch
-    uint16 hertz;
-
-    // The taller the wave, the louder the sound.
-    uint16 sizeOfWave;
-
-} SineWave;
+    GAME_RENDER_LAYER_TILES,
+    GAME_RENDER_LAYER_PLAYER,
+    GAME_RENDER_LAYER_DEBUG,
+} GameRenderLayer;
 
 /**
  * The GameState essentially sits inside (overlays) the memory's permanent storage
@@ -82,6 +106,8 @@ typedef struct GameState
 
     MemoryBlock tileChunksMemoryBlock;
     MemoryBlock tilesMemoryBlock;
+    MemoryBlock audioMemoryBlock;
+    MemoryBlock bitmapsMemoryBlock;
 
     // The currently active world position based off of the player's
     // absolute position
@@ -89,7 +115,60 @@ typedef struct GameState
 
     TilemapPosition cameraPosition;
 
-    SineWave sineWave;
+    // Everything drawn in a frame is pushed here, then sorted and drawn a
+    // tile at a time. Lives in transient storage.
+    MemoryBlock renderGroupMemoryBlock;
+    RenderGroup renderGroup;
+
+    // The background's tile chunks, turned into rectangles once and pushed
+    // each frame. Lives in transient storage.
+    MemoryBlock tileChunkCacheMemoryBlock;
+    TileChunkCache tileChunkCache;
+
+    // Frames drawn at a lower resolution are drawn here, then scaled up into
+    // the frame buffer. Room for a whole FRAME_BUFFER_PIXEL_WIDTH x
+    // FRAME_BUFFER_PIXEL_HEIGHT frame, plus a row of it for the bilinear
+    // filter. Lives in transient storage.
+    MemoryBlock renderTargetMemoryBlock;
+    uint32 *renderTargetPixels;
+    uint32 *upscaleScratchRow;
+
+    // Picks the resolution each frame is drawn at
+    ResolutionController resolution;
+
+    // SCROLL_TYPE_SCREEN only. What changed on screen in each of the last
+    // dirtyFramesRecorded frames, the newest just before dirtyHistoryNext.
+    FrameBufferDirtyRegion dirtyHistory[GAME_DIRTY_HISTORY];
+    uint32 dirtyHistoryNext;
+    uint32 dirtyFramesRecorded;
+
+    // What the last frame was drawn with. Any change to these and the whole
+    // screen has changed.
+    FrameBufferRect lastPlayerRect;
+    xyuint lastCameraAbsPixelPos;
+    uint32 lastZIndex;
+    uint32 lastFrameBufferWidthPx;
+    uint32 lastFrameBufferHeightPx;
+    uint32 lastResolutionScale;
+
+    // Every sound the game plays goes through the mixer
+    Mixer *mixer;
+
+    // Built the first time audio is written, for the platform's sample rate
+    OscillatorWavetables *wavetables;
+
+    // Test tone. Played when HANDMADE_DEBUG_AUDIO is defined: one cycle of
+    // the oscillator, baked into a sound and looped by the mixer.
+    Oscillator debugOscillator;
+    MixerSound debugToneSound;
+    uint32 debugToneVoice;
+
+    // Elapsed time not yet consumed by a fixed simulation step
+    float64 simAccumulatorSeconds;
+
+    // How far (0-1) the frame being drawn is between the previous and the
+    // current simulation step
+    float32 simInterpolationAlpha;
 
 } GameState;
 
@@ -28,9 +28,15 @@ typedef DEBUG_PLATFORM_LOG(DEBUGPlatformLog);
 //====================================================
 //====================================================
 
+/**
+ * One per thread that runs game code: the thread that calls into the game and
+ * each of the platform's worker threads. Handed to everything that runs on
+ * that thread.
+ */
 typedef struct PlatformThreadContext
 {
-    uint8 placeholder;
+    // 0 for the thread that calls into the game. 1 onwards for the workers.
+    uint32 threadIndex;
 } PlatformThreadContext;
 
 /**
@@ -75,6 +81,36 @@ typedef PLATFORM_CONTROLLER_VIBRATE(PlarformControllerVibrate);
 #define PLATFORM_TOGGLE_FULLSCREEN(name) void name(void *platformStateWindows, void *platformStateMacOS, void *platformStateLinux)
 typedef PLATFORM_TOGGLE_FULLSCREEN(PlatformToggleFullscreen);
 
+/**
+ * A pool of worker threads. Only the thread that calls into the game may add
+ * entries or wait on them. Defined by each platform layer.
+ */
+typedef struct PlatformWorkQueue PlatformWorkQueue;
+
+/**
+ * A piece of work for the queue. May run on any of the workers, or on the
+ * thread waiting for the queue to finish.
+ *
+ * @param thread    The context of the thread running it
+ * @param data      Whatever was passed with the entry
+ */
+#define PLATFORM_WORK_QUEUE_CALLBACK(name) void name(PlatformThreadContext *thread, void *data)
+typedef PLATFORM_WORK_QUEUE_CALLBACK(PlatformWorkQueueCallback);
+
+/**
+ * Adds an entry to the queue and wakes a worker to run it. Entries may start
+ * as soon as they're added, in any order.
+ */
+#define PLATFORM_ADD_WORK_QUEUE_ENTRY(name) void name(PlatformWorkQueue *queue, PlatformWorkQueueCallback *callback, void *data)
+typedef PLATFORM_ADD_WORK_QUEUE_ENTRY(PlatformAddWorkQueueEntry);
+
+/**
+ * Runs entries on the calling thread alongside the workers until every entry
+ * added so far has finished.
+ */
+#define PLATFORM_COMPLETE_ALL_WORK(name) void name(PlatformThreadContext *thread, PlatformWorkQueue *queue)
+typedef PLATFORM_COMPLETE_ALL_WORK(PlatformCompleteAllWork);
+
 //====================================================
 //====================================================
 // End platform layer services
@@ -85,6 +121,30 @@ typedef PLATFORM_TOGGLE_FULLSCREEN(PlatformToggleFullscreen);
 // Graphics
 //====================================================
 
+// Most separate rectangles a dirty region holds. Past this, rectangles are
+// merged together.
+#define FRAME_BUFFER_MAX_DIRTY_RECTS 16
+
+// In pixels from the bottom left of the frame buffer. max is exclusive.
+typedef struct FrameBufferRect
+{
+    int32 minX;
+    int32 minY;
+    int32 maxX;
+    int32 maxY;
+} FrameBufferRect;
+
+// The parts of a frame buffer that changed between two frames
+typedef struct FrameBufferDirtyRegion
+{
+    // The whole buffer, whatever's in rects
+    bool32 all;
+
+    uint32 rectCount;
+    FrameBufferRect rects[FRAME_BUFFER_MAX_DIRTY_RECTS];
+
+} FrameBufferDirtyRegion;
+
 /*
  * Struct for the screen buffer
  *
@@ -97,6 +157,7 @@ typedef PLATFORM_TOGGLE_FULLSCREEN(PlatformToggleFullscreen);
  * B    G   R   Padding
  * 00   00  00  00
  */
+
 typedef struct GameFrameBuffer
 {
     // The width in pixels of the buffer.
@@ -116,6 +177,23 @@ typedef struct GameFrameBuffer
     // Pointer to an allocated block of heap memory to hold the data of the buffer.
     void* memory;
 
+    // Set by the platform layer after gameInitFrameBuffer. How many frames
+    // ago this buffer was last drawn into: 1 for a single buffer, up to 3 when
+    // frames are triple buffered. 0 if what's in it can't be relied on (E.g.
+    // it's never been drawn into, or a loop restart has put back older game
+    // memory), in which case the game draws all of it.
+    uint32 age;
+
+    // Set by the game. What changed since the previous frame, so the platform
+    // layer only needs to present those parts.
+    FrameBufferDirtyRegion dirtyRegion;
+
+    // Set by the game. The resolution the frame was drawn at before it was
+    // scaled up to fill the buffer. The same as widthPx and heightPx when it
+    // was drawn at full resolution.
+    uint32 drawnWidthPx;
+    uint32 drawnHeightPx;
+
 } GameFrameBuffer;
 
 //
@@ -151,9 +229,16 @@ typedef struct GameAudioBuffer
     // Pointer to an allocated block of heap memory to hold the data of the buffer.
     void* memory;
 
+    // Byte count of memory. At least noOfBytesToWrite.
+    uint32 memorySizeInBytes;
+
     // Byte count of the platform's buffer memory
     uint64 platformBufferSizeInBytes;
 
+    // The platform's buffer holds one second of audio, so this is also the
+    // number of samples in it
+    uint32 samplesPerSecond;
+
 #if defined(HANDMADE_DEBUG_AUDIO)
 
     unsigned long playCursorPosition;
@@ -244,6 +329,7 @@ typedef struct GameInput
     float32 msPerFrame; // How many miliseconds are we taking per frame? E.g. 16.6 or 33.3
     uint8 targetFPS; // Our target FPS
     float32 fps; // What is our actual FPS
+    float32 msWorkPerFrame; // How many miliseconds did the last frame spend working, before waiting for the next? 0 if unknown
 } GameInput;
 
 //
@@ -260,7 +346,6 @@ typedef struct GameMemory
 
 #ifdef HANDMADE_LIVE_LOOP_EDITING
     void *recordingStorageGameState;
-    void *recordingStorageInput;
 #endif
 
     // Flag to set whether or not our game memory has had its initial fill of data.
@@ -275,6 +360,21 @@ typedef struct GameMemory
 
     PlatformToggleFullscreen *platformToggleFullscreen;
 
+    // Draw every frame at this many eighths of the frame buffer's resolution
+    // (RESOLUTION_SCALE_MIN to RESOLUTION_SCALE_MAX), E.g. to test a scale.
+    // 0 to let the game pick from how long frames are taking.
+    uint32 fixedResolutionScale;
+
+    // Scale frames drawn at a lower resolution up with the nearest filter,
+    // rather than bilinear
+    bool32 upscaleNearest;
+
+    // Worker threads for the renderer. NULL if the platform couldn't start
+    // any, in which case everything is drawn on the calling thread.
+    PlatformWorkQueue *renderQueue;
+    PlatformAddWorkQueueEntry *platformAddWorkQueueEntry;
+    PlatformCompleteAllWork *platformCompleteAllWork;
+
     // @NOTE(JM) Move this??
     PlarformControllerVibrate *platformControllerVibrate;
 
@@ -375,4 +475,4 @@ typedef struct GameCode {
 //====================================================
 //====================================================
 
-#endif;
+#endif
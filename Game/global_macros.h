@@ -1,18 +1,6 @@
 #ifndef HEADER_HH_GLOBAL_MARCOS
 #define HEADER_HH_GLOBAL_MARCOS
 
-#if HANDMADE_LOCAL_BUILD
-#define assert(expression) \
-    if (!(expression)) { \
-        __pragma(warning(push)) \
-        __pragma(warning(disable: 6011)) \
-        int *address = 0x0; \
-        *address = 0; \
-        __pragma(warning(pop)) \
-    }
-#else
-#define assert(expression)
-#endif
 
 /*
  * Which compiler is being used?
@@ -49,6 +37,26 @@ assert(!"only 1 target compiler can be specified")
 #pragma intrinsic(_BitScanForward)
 #endif
 
+#if HANDMADE_LOCAL_BUILD
+#if COMPILER_MSVC
+#define assert(expression) \
+    if (!(expression)) { \
+        __pragma(warning(push)) \
+        __pragma(warning(disable: 6011)) \
+        int *address = 0x0; \
+        *address = 0; \
+        __pragma(warning(pop)) \
+    }
+#else
+#define assert(expression) \
+    if (!(expression)) { \
+        __builtin_trap(); \
+    }
+#endif
+#else
+#define assert(expression)
+#endif
+
 #if HANDMADE_LOCAL_BUILD
 
 // Flags:
@@ -59,9 +67,23 @@ assert(!"only 1 target compiler can be specified")
 //#define HANDMADE_DEBUG_LIVE_LOOP_EDITING
 //#define HANDMADE_DEBUG_TILE_POS
 //#define HANDMADE_WALK_THROUGH_WALLS
+//#define HANDMADE_DEBUG_MEMORY
 
 #endif
 
+// Memory flags:
+// Reserve the game memory's address range up front and only commit pages as
+// the game's memory blocks grow into them.
+#define HANDMADE_COMMIT_MEMORY_ON_DEMAND
+// Back memory blocks flagged as hot (E.g. tile data) with 2MiB pages, where
+// the platform supports it.
+//#define HANDMADE_LARGE_PAGES
+
+// Platform flags:
+// Present each frame on a thread of its own whilst the main loop updates and
+// draws the next frame into another frame buffer.
+#define HANDMADE_PIPELINED_PRESENT
+
 // Global variables
 #define global_var static
 
@@ -72,7 +94,20 @@ assert(!"only 1 target compiler can be specified")
 // This helps the compiler out by knowing that there is no external linking to be done.
 #define internal_func static
 
+// Functions that use instructions beyond the build's baseline (SSE2). Only
+// call them once the CPU has been checked for support. MSVC allows any
+// instruction set's intrinsics in any function.
+#if COMPILER_MSVC
+#define target_avx2
+#else
+#define target_avx2 __attribute__((target("avx2")))
+#endif
+
+#if COMPILER_MSVC
 #define EXTERN_DLL_EXPORT extern "C" __declspec(dllexport)
+#else
+#define EXTERN_DLL_EXPORT extern "C" __attribute__((visibility("default")))
+#endif
 
 // Return the number of elements in a static array
 #define countArray(arr) (sizeof(arr) / sizeof((arr)[0]))
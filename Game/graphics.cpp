@@ -1,11 +1,43 @@
 #include "graphics.h"
 #include "game.h"
 
+#include <emmintrin.h> // SSE2
+#include <immintrin.h> // AVX2
+#include <string.h> // memcpy
+
 uint32 f32ToUint32(float32 val)
 {
     return (uint32)val;
 }
 
+/**
+ * Pixels from one row of the buffer to the next. More than widthPx when the
+ * buffer is a view onto part of a bigger one (E.g. a renderer tile).
+ */
+internal_func uint32 frameBufferPitchPx(GameFrameBuffer *buffer)
+{
+    return (buffer->byteWidthPerRow / sizeof(uint32));
+}
+
+/**
+ * The pixel x across and y up from the bottom left of the buffer. Rows are
+ * stored top down.
+ */
+internal_func uint32 *frameBufferPixel(GameFrameBuffer *buffer, uint32 x, uint32 y)
+{
+    return ((uint32 *)buffer->memory + (frameBufferPitchPx(buffer) * (buffer->heightPx - 1 - y)) + x);
+}
+
+uint32 packColour(Colour colour)
+{
+    uint32 alpha    = ((uint32)(255.0f * colour.a) << 24);
+    uint32 red      = ((uint32)(255.0f * colour.r) << 16);
+    uint32 green    = ((uint32)(255.0f * colour.g) << 8);
+    uint32 blue     = ((uint32)(255.0f * colour.b) << 0);
+
+    return (alpha | red | green | blue);
+}
+
 void writeRectangle(GameFrameBuffer *buffer,
                         float32 xOffsetf,
                         float32 yOffsetf,
@@ -13,109 +45,494 @@ void writeRectangle(GameFrameBuffer *buffer,
                         uint32 height,
                         Colour colour)
 {
-    assert(width >= 0.0f);
-    assert(height >= 0.0f);
+    writeRectangle(buffer, xOffsetf, yOffsetf, width, height, packColour(colour));
+}
+
+void writeRectangle(GameFrameBuffer *buffer,
+                        float32 xOffsetf,
+                        float32 yOffsetf,
+                        uint32 width,
+                        uint32 height,
+                        uint32 colour)
+{
+    int32 xOffset   = intrin_roundF32ToI32(xOffsetf);
+    int32 yOffset   = intrin_roundF32ToI32(yOffsetf);
+
+    writeRectangleIntRows(buffer, xOffset, yOffset, width, height, colour, NULL);
+}
 
-    int32 xOffset   = intrin_roundF32ToUI32(xOffsetf);
-    int32 yOffset   = intrin_roundF32ToUI32(yOffsetf);
+void writeRectangleIntRows(GameFrameBuffer *buffer,
+                            int32 xOffset,
+                            int32 yOffset,
+                            uint32 width,
+                            uint32 height,
+                            uint32 colour,
+                            WriteRectangleRows *writeRectangleRows)
+{
+    // Bounds checking. Done in signed 64-bit math so that a rectangle that
+    // starts further off the left or bottom than it is wide can't wrap around.
+    int64 minX = xOffset;
+    int64 minY = yOffset;
+    int64 maxX = ((int64)xOffset + width);
+    int64 maxY = ((int64)yOffset + height);
 
-    // Bounds checking
-    if (xOffset >= (int32)buffer->widthPx) {
+    if (minX < 0) {
+        minX = 0;
+    }
+
+    if (minY < 0) {
+        minY = 0;
+    }
+
+    if (maxX > (int64)buffer->widthPx) {
+        maxX = (int64)buffer->widthPx;
+    }
+
+    if (maxY > (int64)buffer->heightPx) {
+        maxY = (int64)buffer->heightPx;
+    }
+
+    if ((minX >= maxX) || (minY >= maxY)) {
         return;
     }
 
-    if (yOffset >= (int32)buffer->heightPx) {
+    width = (uint32)(maxX - minX);
+    height = (uint32)(maxY - minY);
+
+    // Write the memory, starting from the bottom left
+    uint32 *row = frameBufferPixel(buffer, (uint32)minX, (uint32)minY);
+
+    if (!writeRectangleRows) {
+
+        writeRectangleRows = (intrin_cpuSupportsAVX2() ? writeRectangleRowsAVX2 : writeRectangleRowsSSE2);
+
+        // A fill this big won't be read back before it's evicted anyway, so
+        // don't pull the frame buffer through the cache to write it
+        if (((uint64)width * height) >= WRITE_RECTANGLE_STREAM_MIN_PIXELS) {
+            writeRectangleRows = writeRectangleRowsStream;
+        }
+    }
+
+    // Rows go up the frame buffer
+    writeRectangleRows(row, ((int32)frameBufferPitchPx(buffer) * -1), width, height, colour);
+}
+
+void writeRectangleInt(GameFrameBuffer* buffer,
+                        int32 xOffset,
+                        int32 yOffset,
+                        uint32 width,
+                        uint32 height,
+                        Colour colour)
+{
+    writeRectangle(buffer, (float32)xOffset, (float32)yOffset, width, height, packColour(colour));
+}
+
+void writeRectangleInt(GameFrameBuffer* buffer,
+                        int32 xOffset,
+                        int32 yOffset,
+                        uint32 width,
+                        uint32 height,
+                        uint32 colour)
+{
+    writeRectangle(buffer, (float32)xOffset, (float32)yOffset, width, height, colour);
+}
+
+/**
+ * Rounded down and up, for a positive divisor
+ */
+internal_func int64 lineFloorDivide(int64 dividend, int64 divisor)
+{
+    return ((dividend >= 0) ? (dividend / divisor) : -(((-dividend) + divisor - 1) / divisor));
+}
+
+internal_func int64 lineCeilDivide(int64 dividend, int64 divisor)
+{
+    return -lineFloorDivide(-dividend, divisor);
+}
+
+/**
+ * A line is stepped one pixel at a time along its major axis (whichever of x
+ * or y it covers more of), from the lower end to the higher. These are the
+ * line's ends in those terms, and how to get around the buffer in them.
+ */
+typedef struct LineAxes
+{
+    int64 major0;
+    int64 minor0;
+    int64 major1;
+    int64 minor1;
+
+    // Pixels along each axis
+    int64 majorSizePx;
+    int64 minorSizePx;
+
+    // Pixels from one pixel to the next along each axis
+    int64 majorStridePx;
+    int64 minorStridePx;
+
+} LineAxes;
+
+internal_func LineAxes lineGetAxes(GameFrameBuffer *buffer, int64 x0, int64 y0, int64 x1, int64 y1)
+{
+    LineAxes axes = {};
+
+    int64 dx = ((x1 >= x0) ? (x1 - x0) : (x0 - x1));
+    int64 dy = ((y1 >= y0) ? (y1 - y0) : (y0 - y1));
+
+    // Rows are stored top down, so going up a row goes back a pitch
+    int64 pitchPx = (int64)frameBufferPitchPx(buffer);
+
+    if (dy > dx) {
+        axes.major0 = y0;
+        axes.minor0 = x0;
+        axes.major1 = y1;
+        axes.minor1 = x1;
+        axes.majorSizePx = (int64)buffer->heightPx;
+        axes.minorSizePx = (int64)buffer->widthPx;
+        axes.majorStridePx = -pitchPx;
+        axes.minorStridePx = 1;
+    } else {
+        axes.major0 = x0;
+        axes.minor0 = y0;
+        axes.major1 = x1;
+        axes.minor1 = y1;
+        axes.majorSizePx = (int64)buffer->widthPx;
+        axes.minorSizePx = (int64)buffer->heightPx;
+        axes.majorStridePx = 1;
+        axes.minorStridePx = -pitchPx;
+    }
+
+    if (axes.major0 > axes.major1) {
+        int64 swap = axes.major0;
+        axes.major0 = axes.major1;
+        axes.major1 = swap;
+
+        swap = axes.minor0;
+        axes.minor0 = axes.minor1;
+        axes.minor1 = swap;
+    }
+
+    return axes;
+}
+
+void writeLine(GameFrameBuffer *buffer,
+                int32 x0,
+                int32 y0,
+                int32 x1,
+                int32 y1,
+                uint32 colour)
+{
+    // Keeps the 64-bit sums below from overflowing
+    assert((x0 > -WRITE_LINE_MAX_COORDINATE) && (x0 < WRITE_LINE_MAX_COORDINATE));
+    assert((y0 > -WRITE_LINE_MAX_COORDINATE) && (y0 < WRITE_LINE_MAX_COORDINATE));
+    assert((x1 > -WRITE_LINE_MAX_COORDINATE) && (x1 < WRITE_LINE_MAX_COORDINATE));
+    assert((y1 > -WRITE_LINE_MAX_COORDINATE) && (y1 < WRITE_LINE_MAX_COORDINATE));
+
+    if ((buffer->widthPx == 0) || (buffer->heightPx == 0)) {
         return;
     }
 
-    // Min x
-    if (xOffset < 0) {
-        width = (width - (xOffset * -1));
-        if (width <= 0) {
-            return;
+    LineAxes axes = lineGetAxes(buffer, x0, y0, x1, y1);
+
+    int64 majorDelta = (axes.major1 - axes.major0);
+    int64 minorDelta = ((axes.minor1 >= axes.minor0) ? (axes.minor1 - axes.minor0) : (axes.minor0 - axes.minor1));
+    int64 minorStep = ((axes.minor1 >= axes.minor0) ? 1 : -1);
+
+    // Step k along the major axis moves floor(((2 * k * minorDelta) + majorDelta) / (2 * majorDelta))
+    // along the minor axis: the nearest pixel to the line, rounding halves
+    // away from the lower end. First clip the steps to the buffer along the
+    // major axis...
+    int64 firstStep = ((axes.major0 < 0) ? -axes.major0 : 0);
+    int64 lastStep = (((axes.major1 >= axes.majorSizePx) ? (axes.majorSizePx - 1) : axes.major1) - axes.major0);
+
+    // ...then along the minor axis, by the moves that stay on the buffer
+    int64 firstMove = ((minorStep > 0) ? -axes.minor0 : (axes.minor0 - (axes.minorSizePx - 1)));
+    int64 lastMove = ((minorStep > 0) ? ((axes.minorSizePx - 1) - axes.minor0) : axes.minor0);
+
+    if (firstMove < 0) {
+        firstMove = 0;
+    }
+
+    if (lastMove > minorDelta) {
+        lastMove = minorDelta;
+    }
+
+    if (firstMove > lastMove) {
+        return;
+    }
+
+    if (minorDelta > 0) {
+
+        int64 firstMoveStep = lineCeilDivide(((2 * majorDelta * firstMove) - majorDelta), (2 * minorDelta));
+        int64 pastLastMoveStep = lineCeilDivide(((2 * majorDelta * (lastMove + 1)) - majorDelta), (2 * minorDelta));
+
+        if (firstStep < firstMoveStep) {
+            firstStep = firstMoveStep;
+        }
+
+        if (lastStep > (pastLastMoveStep - 1)) {
+            lastStep = (pastLastMoveStep - 1);
         }
-        xOffset = 0;
     }
 
-    // Min y
-    if (yOffset < 0) {
-        height = (height - (yOffset * -1));
-        if (height <= 0) {
-            return;
+    if (firstStep > lastStep) {
+        return;
+    }
+
+    // A single point has nothing to divide by, and never moves
+    int64 errorRange = ((majorDelta > 0) ? (2 * majorDelta) : 1);
+    int64 errorStep = (2 * minorDelta);
+
+    int64 error = ((2 * firstStep * minorDelta) + majorDelta);
+    int64 moves = (error / errorRange);
+    error = (error - (moves * errorRange));
+
+    int64 major = (axes.major0 + firstStep);
+    int64 minor = (axes.minor0 + (moves * minorStep));
+
+    assert((major >= 0) && (major < axes.majorSizePx) && (minor >= 0) && (minor < axes.minorSizePx));
+
+    uint32 *pixel = ((uint32 *)frameBufferPixel(buffer, 0, 0) + (major * axes.majorStridePx) + (minor * axes.minorStridePx));
+    int64 minorStridePx = (axes.minorStridePx * minorStep);
+
+    for (int64 step = firstStep; ; step++) {
+
+        *pixel = colour;
+
+        if (step == lastStep) {
+            break;
+        }
+
+        pixel = (pixel + axes.majorStridePx);
+        error = (error + errorStep);
+
+        if (error >= errorRange) {
+            error = (error - errorRange);
+            pixel = (pixel + minorStridePx);
         }
-        yOffset = 0;
     }
+}
 
-    // Max x
-    uint32 maxX = (xOffset + width);
+/**
+ * Blends a colour into a pixel by weight (0 - 256), two channels at a time
+ */
+internal_func void lineBlendPixel(uint32 *pixel, uint32 colour, uint32 weight)
+{
+    uint32 dest = *pixel;
+    uint32 inverseWeight = (256 - weight);
 
-    if (maxX > buffer->widthPx) {
-        maxX = (buffer->widthPx - xOffset);
-        if (width > maxX) {
-            width = maxX;
+    uint32 redBlue = (((((dest & 0x00FF00FF) * inverseWeight) + ((colour & 0x00FF00FF) * weight)) >> 8) & 0x00FF00FF);
+    uint32 alphaGreen = ((((((dest >> 8) & 0x00FF00FF) * inverseWeight) + (((colour >> 8) & 0x00FF00FF) * weight)) >> 8) & 0x00FF00FF);
+
+    *pixel = (redBlue | (alphaGreen << 8));
+}
+
+void writeLineSmooth(GameFrameBuffer *buffer,
+                        int32 x0,
+                        int32 y0,
+                        int32 x1,
+                        int32 y1,
+                        uint32 colour)
+{
+    assert((x0 > -WRITE_LINE_MAX_COORDINATE) && (x0 < WRITE_LINE_MAX_COORDINATE));
+    assert((y0 > -WRITE_LINE_MAX_COORDINATE) && (y0 < WRITE_LINE_MAX_COORDINATE));
+    assert((x1 > -WRITE_LINE_MAX_COORDINATE) && (x1 < WRITE_LINE_MAX_COORDINATE));
+    assert((y1 > -WRITE_LINE_MAX_COORDINATE) && (y1 < WRITE_LINE_MAX_COORDINATE));
+
+    if ((buffer->widthPx == 0) || (buffer->heightPx == 0)) {
+        return;
+    }
+
+    // Worked in 16.16 fixed point
+    const int64 one = ((int64)1 << 16);
+    const int64 half = (one / 2);
+    const int32 shift = (16 - WRITE_LINE_SUBPIXEL_BITS);
+
+    LineAxes axes = lineGetAxes(buffer,
+                                ((int64)x0 * ((int64)1 << shift)),
+                                ((int64)y0 * ((int64)1 << shift)),
+                                ((int64)x1 * ((int64)1 << shift)),
+                                ((int64)y1 * ((int64)1 << shift)));
+
+    int64 majorDelta = (axes.major1 - axes.major0);
+    int64 gradient = ((majorDelta > 0) ? (((axes.minor1 - axes.minor0) * one) / majorDelta) : 0);
+
+    // The pixels the ends fall in, and the minor axis coordinate at the
+    // centre of the first
+    int64 firstPixel = ((axes.major0 + half) >> 16);
+    int64 lastPixel = ((axes.major1 + half) >> 16);
+    int64 firstMinor = (axes.minor0 + ((gradient * ((firstPixel * one) - axes.major0)) >> 16));
+
+    // How much of each end pixel the line covers along the major axis
+    int64 firstCoverage = (one - ((axes.major0 + half) & (one - 1)));
+    int64 lastCoverage = ((axes.major1 + half) & (one - 1));
+
+    if (firstPixel == lastPixel) {
+        firstCoverage = majorDelta;
+        lastCoverage = majorDelta;
+    }
+
+    // Clip to the buffer along the major axis...
+    int64 startPixel = ((firstPixel < 0) ? 0 : firstPixel);
+    int64 endPixel = ((lastPixel >= axes.majorSizePx) ? (axes.majorSizePx - 1) : lastPixel);
+
+    // ...and to where either of the two pixels stepped on are on it. At the
+    // edges only one of them is.
+    int64 lowestMinor = -one;
+    int64 highestMinor = ((axes.minorSizePx * one) - 1);
+
+    if (gradient > 0) {
+
+        int64 enters = (firstPixel + lineCeilDivide((lowestMinor - firstMinor), gradient));
+        int64 leaves = (firstPixel + lineFloorDivide((highestMinor - firstMinor), gradient));
+
+        startPixel = ((enters > startPixel) ? enters : startPixel);
+        endPixel = ((leaves < endPixel) ? leaves : endPixel);
+
+    } else if (gradient < 0) {
+
+        int64 enters = (firstPixel + lineCeilDivide((firstMinor - highestMinor), -gradient));
+        int64 leaves = (firstPixel + lineFloorDivide((firstMinor - lowestMinor), -gradient));
+
+        startPixel = ((enters > startPixel) ? enters : startPixel);
+        endPixel = ((leaves < endPixel) ? leaves : endPixel);
+
+    } else if ((firstMinor < lowestMinor) || (firstMinor > highestMinor)) {
+        return;
+    }
+
+    if (startPixel > endPixel) {
+        return;
+    }
+
+    uint32 *origin = (uint32 *)frameBufferPixel(buffer, 0, 0);
+    int64 minor = (firstMinor + (gradient * (startPixel - firstPixel)));
+
+    for (int64 major = startPixel; major <= endPixel; major++) {
+
+        int64 coverage = one;
+
+        if (major == firstPixel) {
+            coverage = firstCoverage;
+        } else if (major == lastPixel) {
+            coverage = lastCoverage;
+        }
+
+        int64 row = (minor >> 16);
+        int64 fraction = (minor & (one - 1));
+
+        // Down to 0 - 256, rounded
+        uint32 lowerWeight = (uint32)(((((one - fraction) * coverage) >> 16) + 128) >> 8);
+        uint32 upperWeight = (uint32)((((fraction * coverage) >> 16) + 128) >> 8);
+
+        uint32 *column = (origin + (major * axes.majorStridePx));
+
+        if ((row >= 0) && lowerWeight) {
+            lineBlendPixel((column + (row * axes.minorStridePx)), colour, lowerWeight);
+        }
+
+        if (((row + 1) < axes.minorSizePx) && upperWeight) {
+            lineBlendPixel((column + ((row + 1) * axes.minorStridePx)), colour, upperWeight);
         }
+
+        minor = (minor + gradient);
     }
+}
 
-    // Max y
-    uint32 maxY = (yOffset + height);
+WRITE_RECTANGLE_ROWS(writeRectangleRowsScalar)
+{
+    for (uint32 y = 0; y < height; y++) {
 
-    if (maxY > buffer->heightPx) {
-        maxY = (buffer->heightPx - yOffset);
-        if (height > maxY) {
-            height = maxY;
+        for (uint32 x = 0; x < width; x++) {
+            row[x] = colour;
         }
+
+        row = (row + rowStridePx);
     }
+}
 
-    // Set the colour
-    uint32 alpha    = ((uint32)(255.0f * colour.a) << 24);
-    uint32 red      = ((uint32)(255.0f * colour.r) << 16);
-    uint32 green    = ((uint32)(255.0f * colour.g) << 8);
-    uint32 blue     = ((uint32)(255.0f * colour.b) << 0);
+WRITE_RECTANGLE_ROWS(writeRectangleRowsSSE2)
+{
+    __m128i fill = _mm_set1_epi32((int32)colour);
 
-    uint32 hexColour = (alpha | red | green | blue);
+    uint32 wideWidth = (width & ~3u);
 
-    // Write the memory
-    uint32 *row = (uint32*)buffer->memory;
+    for (uint32 y = 0; y < height; y++) {
 
-    // Move to last row as starting position (bottom left of axis)
-    row = (row + ((buffer->widthPx * buffer->heightPx) - buffer->widthPx));
+        for (uint32 x = 0; x < wideWidth; x += 4) {
+            _mm_storeu_si128((__m128i *)(row + x), fill);
+        }
 
-    // Move up to starting row
-    row = (row - (buffer->widthPx * yOffset));
+        for (uint32 x = wideWidth; x < width; x++) {
+            row[x] = colour;
+        }
 
-    // Move in from left to starting absolutePosition
-    row = (row + xOffset);
+        row = (row + rowStridePx);
+    }
+}
 
-    // Up (rows) y
-    for (uint32 i = 0; i < height; i++) {
+target_avx2 WRITE_RECTANGLE_ROWS(writeRectangleRowsAVX2)
+{
+    __m256i fill = _mm256_set1_epi32((int32)colour);
 
-        // Accross (columns) x
-        uint32 *pixel = (uint32*)row;
-        for (uint32 x = 0; x < width; x++) {
+    uint32 wideWidth = (width & ~7u);
 
-            *pixel = hexColour;
-            pixel = (pixel + 1);
+    for (uint32 y = 0; y < height; y++) {
+
+        for (uint32 x = 0; x < wideWidth; x += 8) {
+            _mm256_storeu_si256((__m256i *)(row + x), fill);
         }
 
-        // Move up one entire row
-        row = (row - buffer->widthPx);
+        for (uint32 x = wideWidth; x < width; x++) {
+            row[x] = colour;
+        }
+
+        row = (row + rowStridePx);
     }
+
+    // See writeBitmapRowAVX2
+    _mm256_zeroupper();
 }
 
-void writeRectangleInt(GameFrameBuffer* buffer,
-                        int32 xOffset,
-                        int32 yOffset,
-                        uint32 width,
-                        uint32 height,
-                        Colour colour)
+WRITE_RECTANGLE_ROWS(writeRectangleRowsStream)
 {
-    writeRectangle(buffer, (float32)xOffset, (float32)yOffset, width, height, colour);
+    __m128i fill = _mm_set1_epi32((int32)colour);
+
+    for (uint32 y = 0; y < height; y++) {
+
+        uint32 *pixel = row;
+        uint32 *end = (row + width);
+
+        // Streaming stores have to be 16 byte aligned. Pixels are 4 byte
+        // aligned, so at most 3 need writing first.
+        while ((pixel < end) && ((sizet)pixel & 15)) {
+            *pixel = colour;
+            pixel++;
+        }
+
+        while ((end - pixel) >= 4) {
+            _mm_stream_si128((__m128i *)pixel, fill);
+            pixel = (pixel + 4);
+        }
+
+        while (pixel < end) {
+            *pixel = colour;
+            pixel++;
+        }
+
+        row = (row + rowStridePx);
+    }
+
+    // Streaming stores are weakly ordered. Make sure they've all landed
+    // before the frame buffer is handed to the platform layer.
+    _mm_sfence();
 }
 
 /**
  * Writes a bitmap into a frame buffer. Implements linear alpha blending by
  * blending with pixel data that exists directly below where the bitmap is
- * writting to.
+ * writting to. The bitmap's pixels are premultiplied at load time, so the
+ * blend is just dest * (1 - alpha) + source.
  * 
  * - Image rows are in bottom-up order
  *  -Only supports 32-bit aligned bytes
@@ -141,6 +558,10 @@ void writeBitmap(GameFrameBuffer *buffer,
     assert(widthf >= 1.0f);
     assert(heightf >= 1.0f);
 
+    if (bitmapFile.flags & BITMAP_FLAG_TRANSPARENT) {
+        return;
+    }
+
     int32 xOffset   = intrin_roundF32ToI32(xOffsetf);
     int32 yOffset   = intrin_roundF32ToI32(yOffsetf);
     int32 width     = intrin_roundF32ToI32(widthf);
@@ -162,9 +583,30 @@ void writeBitmap(GameFrameBuffer *buffer,
         yOffset = (yOffset + alignY);
     }
 
+    // The rows below copy the bitmap's pixels one for one
+    if ((width != (int32)bitmapFile.widthPx) || (height != (int32)bitmapFile.heightPx)) {
+        writeBitmapAffine(buffer,
+                            {(float32)xOffset, (float32)yOffset},
+                            {(float32)width, 0.0f},
+                            {0.0f, (float32)height},
+                            &bitmapFile);
+        return;
+    }
+
+    writeBitmapRows(buffer, xOffset, yOffset, &bitmapFile, NULL);
+}
+
+void writeBitmapRows(GameFrameBuffer *buffer,
+                        int32 xOffset,
+                        int32 yOffset,
+                        BitmapFile *bitmapFile,
+                        WriteBitmapRow *writeBitmapRow)
+{
+    int32 width     = (int32)bitmapFile->widthPx;
+    int32 height    = (int32)bitmapFile->heightPx;
+
     int32 originalXOffset = xOffset;
     int32 originalYOffset = yOffset;
-    int32 originalWidth = width;
 
     // Bounds checking
     if (xOffset >= (int32)buffer->widthPx) {
@@ -213,97 +655,1063 @@ void writeBitmap(GameFrameBuffer *buffer,
         }
     }
 
-    // Write the memory...
-    uint32 *row = (uint32*)buffer->memory;
-
-    // Move to last row as starting position (bottom left of axis)
-    row = (row + ((buffer->widthPx * buffer->heightPx) - buffer->widthPx));
-
-    // Move up to starting row
-    row = (row - (buffer->widthPx * yOffset));
-
-    // Move in from left to starting absolutePosition
-    row = (row + xOffset);
+    // Write the memory, starting from the bottom left
+    uint32 *row = frameBufferPixel(buffer, (uint32)xOffset, (uint32)yOffset);
+    uint32 pitchPx = frameBufferPitchPx(buffer);
 
-    uint32 *imagePixel = (uint32 *)bitmapFile.memory;
+    uint32 *imageRow = (uint32 *)bitmapFile->memory;
 
     if (originalXOffset < 0) {
-        imagePixel = (imagePixel + (originalXOffset*-1));
+        imageRow = (imageRow + (originalXOffset*-1));
     }
 
     if (originalYOffset < 0) {
-        imagePixel = (imagePixel + ((originalYOffset*-1) * originalWidth));
+        imageRow = (imageRow + ((originalYOffset*-1) * bitmapFile->pitchPx));
     }
 
-    // Fetch the RGBA shifts from the bitmap's masks...
-    bitScanResult redShift = intrin_bitScanForward(bitmapFile.redMask);
-    if (!redShift.found){
-        assert(!"Error finding red mask bit shift");
-    }
-
-    bitScanResult greenShift = intrin_bitScanForward(bitmapFile.greenMask);
-    if (!greenShift.found){
-        assert(!"Error finding green mask bit shift");
-    }
+    if (!writeBitmapRow) {
 
-    bitScanResult blueShift = intrin_bitScanForward(bitmapFile.blueMask);
-    if (!blueShift.found){
-        assert(!"Error finding blue mask bit shift");
-    }
+        writeBitmapRow = (intrin_cpuSupportsAVX2() ? writeBitmapRowAVX2 : writeBitmapRowSSE2);
 
-    bitScanResult alphaShift = intrin_bitScanForward(bitmapFile.alphaMask);
-    if (!alphaShift.found){
-        assert(!"Error finding alpha mask bit shift");
+        // Nothing to blend, so the rows can be copied
+        if (bitmapFile->flags & BITMAP_FLAG_OPAQUE) {
+            writeBitmapRow = writeBitmapRowOpaque;
+        }
     }
 
     // Up (rows) y
     for (int32 y = 0; y < height; y++) {
 
-        // Accross (columns) x
-        uint32 *pixel = (uint32*)row;
-        for (int32 x = 0; x < width; x++) {
+        writeBitmapRow(row, imageRow, (uint32)width);
 
-            // Extract RGBA values from bitmap.
-            uint8 red       = (((*imagePixel & bitmapFile.redMask) >> redShift.index) & 0xFF);
-            uint8 green     = (((*imagePixel & bitmapFile.greenMask) >> greenShift.index) & 0xFF);
-            uint8 blue      = (((*imagePixel & bitmapFile.blueMask) >> blueShift.index) & 0xFF);
-            uint8 alpha     = (((*imagePixel & bitmapFile.alphaMask) >> alphaShift.index) & 0xFF);
+        // Move up one entire row
+        row = (row - pitchPx);
+        imageRow = (imageRow + bitmapFile->pitchPx);
+    }
+}
 
-            // Extract RGB values from data that already exists at this location
-            uint8 origRed = ((*pixel >> 16) & 0xFF);
-            uint8 origGreen = ((*pixel >> 8) & 0xFF);
-            uint8 origBlue = ((*pixel >> 0) & 0xFF);
+/**
+ * (dest * (255 - alpha)) / 255, rounded. The division is
+ * (t + 128 + ((t + 128) >> 8)) >> 8, which is exact for every t up to
+ * 255 * 255 and is what the SIMD versions do 16 bits at a time.
+ */
+internal_func uint32 blendChannel(uint32 source, uint32 dest, uint32 alpha)
+{
+    uint32 t = ((dest * (255 - alpha)) + 128);
+    return (source + ((t + (t >> 8)) >> 8));
+}
 
-            // Do linear alpha blend
-            float32 alphaf = ((float32)alpha / 255.0f);
+WRITE_BITMAP_ROW(writeBitmapRowScalar)
+{
+    for (uint32 i = 0; i < count; i++) {
 
-            float32 blendedR = ((float32)origRed - ((float32)origRed * alphaf) +
-             ((float32)red * alphaf));
-            float32 blendedG = ((float32)origGreen - ((float32)origGreen * alphaf) +
-            ((float32)green * alphaf));
-            float32 blendedB = ((float32)origBlue - ((float32)origBlue * alphaf) +
-             ((float32)blue * alphaf));
+        uint32 source = bitmapPixels[i];
+        uint32 dest = pixels[i];
 
-            // Re order the bytes into order we need
-            uint32 packed = 0;
-            packed |= (uint32)blendedB;
-            packed |= (uint32)blendedG << 8;
-            packed |= (uint32)blendedR << 16;
-            //packed |= alpha << 24; // We're not actually using the alpha channel yet when we blit to screen
+        uint32 alpha = (source >> 24);
 
-            *pixel = packed;
+        // The bitmap's colour is premultiplied, so each channel can't exceed
+        // its alpha and the sum can't exceed 255
+        uint32 blendedA = blendChannel(((source >> 24) & 0xFF), ((dest >> 24) & 0xFF), alpha);
+        uint32 blendedR = blendChannel(((source >> 16) & 0xFF), ((dest >> 16) & 0xFF), alpha);
+        uint32 blendedG = blendChannel(((source >> 8) & 0xFF), ((dest >> 8) & 0xFF), alpha);
+        uint32 blendedB = blendChannel(((source >> 0) & 0xFF), ((dest >> 0) & 0xFF), alpha);
 
-            pixel++;
-            imagePixel++;
-        }
+        pixels[i] = ((blendedA << 24) | (blendedR << 16) | (blendedG << 8) | blendedB);
+    }
+}
 
-        // Move up one entire row
-        row = (row - buffer->widthPx);
+WRITE_BITMAP_ROW(writeBitmapRowOpaque)
+{
+    for (uint32 i = 0; i < count; i++) {
+        pixels[i] = bitmapPixels[i];
+    }
+}
+
+WRITE_BITMAP_ROW(writeBitmapRowSSE2)
+{
+    uint32 wideCount = (count & ~3u);
+
+    __m128i zero = _mm_setzero_si128();
+    __m128i half = _mm_set1_epi16(128);
+    __m128i max = _mm_set1_epi16(255);
+
+    for (uint32 i = 0; i < wideCount; i += 4) {
+
+        __m128i source = _mm_loadu_si128((__m128i *)(bitmapPixels + i));
+        __m128i dest = _mm_loadu_si128((__m128i *)(pixels + i));
+
+        // Widen the frame buffer's pixels to 16 bits per channel, 2 pixels
+        // per register, and copy each bitmap pixel's alpha into all 4 of its
+        // channels
+        __m128i destLow = _mm_unpacklo_epi8(dest, zero);
+        __m128i destHigh = _mm_unpackhi_epi8(dest, zero);
+
+        __m128i alphaLow = _mm_unpacklo_epi8(source, zero);
+        __m128i alphaHigh = _mm_unpackhi_epi8(source, zero);
+
+        alphaLow = _mm_shufflehi_epi16(_mm_shufflelo_epi16(alphaLow, 0xFF), 0xFF);
+        alphaHigh = _mm_shufflehi_epi16(_mm_shufflelo_epi16(alphaHigh, 0xFF), 0xFF);
+
+        // At most 255 * 255 + 128, so it fits in an unsigned 16 bits
+        __m128i low = _mm_add_epi16(_mm_mullo_epi16(destLow, _mm_sub_epi16(max, alphaLow)), half);
+        __m128i high = _mm_add_epi16(_mm_mullo_epi16(destHigh, _mm_sub_epi16(max, alphaHigh)), half);
+
+        low = _mm_srli_epi16(_mm_add_epi16(low, _mm_srli_epi16(low, 8)), 8);
+        high = _mm_srli_epi16(_mm_add_epi16(high, _mm_srli_epi16(high, 8)), 8);
+
+        __m128i blended = _mm_add_epi8(_mm_packus_epi16(low, high), source);
+
+        _mm_storeu_si128((__m128i *)(pixels + i), blended);
+    }
+
+    writeBitmapRowScalar((pixels + wideCount), (bitmapPixels + wideCount), (count - wideCount));
+}
+
+target_avx2 WRITE_BITMAP_ROW(writeBitmapRowAVX2)
+{
+    uint32 wideCount = (count & ~7u);
+
+    __m256i zero = _mm256_setzero_si256();
+    __m256i half = _mm256_set1_epi16(128);
+    __m256i max = _mm256_set1_epi16(255);
+
+    for (uint32 i = 0; i < wideCount; i += 8) {
+
+        __m256i source = _mm256_loadu_si256((__m256i *)(bitmapPixels + i));
+        __m256i dest = _mm256_loadu_si256((__m256i *)(pixels + i));
+
+        // Unpacking and packing both work within each 128-bit lane, so the
+        // pixels come back out in the order they went in
+        __m256i destLow = _mm256_unpacklo_epi8(dest, zero);
+        __m256i destHigh = _mm256_unpackhi_epi8(dest, zero);
+
+        __m256i alphaLow = _mm256_unpacklo_epi8(source, zero);
+        __m256i alphaHigh = _mm256_unpackhi_epi8(source, zero);
+
+        alphaLow = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(alphaLow, 0xFF), 0xFF);
+        alphaHigh = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(alphaHigh, 0xFF), 0xFF);
+
+        __m256i low = _mm256_add_epi16(_mm256_mullo_epi16(destLow, _mm256_sub_epi16(max, alphaLow)), half);
+        __m256i high = _mm256_add_epi16(_mm256_mullo_epi16(destHigh, _mm256_sub_epi16(max, alphaHigh)), half);
+
+        low = _mm256_srli_epi16(_mm256_add_epi16(low, _mm256_srli_epi16(low, 8)), 8);
+        high = _mm256_srli_epi16(_mm256_add_epi16(high, _mm256_srli_epi16(high, 8)), 8);
+
+        __m256i blended = _mm256_add_epi8(_mm256_packus_epi16(low, high), source);
+
+        _mm256_storeu_si256((__m256i *)(pixels + i), blended);
+    }
+
+    // The rest of the game is built for SSE2. Leaving the upper halves of
+    // the AVX registers dirty makes every SSE instruction after this slower.
+    _mm256_zeroupper();
+
+    writeBitmapRowScalar((pixels + wideCount), (bitmapPixels + wideCount), (count - wideCount));
+}
+
+/**
+ * Narrows [*minX, *maxX) to the pixels whose texel coordinate
+ * (texel + (x * step)) is within [low, high)
+ */
+internal_func void bitmapAffineClipSpan(float32 *minX,
+                                        float32 *maxX,
+                                        float32 texel,
+                                        float32 step,
+                                        float32 low,
+                                        float32 high)
+{
+    if (step == 0.0f) {
+        if ((texel < low) || (texel >= high)) {
+            *maxX = *minX;
+        }
+        return;
+    }
+
+    float32 lowX = ((low - texel) / step);
+    float32 highX = ((high - texel) / step);
+
+    if (step < 0.0f) {
+        float32 swap = lowX;
+        lowX = highX;
+        highX = swap;
+    }
+
+    *minX = ((lowX > *minX) ? lowX : *minX);
+    *maxX = ((highX < *maxX) ? highX : *maxX);
+}
+
+void writeBitmapAffine(GameFrameBuffer *buffer,
+                        Vector2 origin,
+                        Vector2 xAxis,
+                        Vector2 yAxis,
+                        BitmapFile *bitmapFile)
+{
+    WriteBitmapAffineRow *writeBitmapAffineRow = (intrin_cpuSupportsAVX2() ? writeBitmapAffineRowAVX2 : writeBitmapAffineRowSSE2);
+
+    writeBitmapAffineRows(buffer, origin, xAxis, yAxis, bitmapFile, writeBitmapAffineRow);
+}
+
+void writeBitmapAffineRows(GameFrameBuffer *buffer,
+                            Vector2 origin,
+                            Vector2 xAxis,
+                            Vector2 yAxis,
+                            BitmapFile *bitmapFile,
+                            WriteBitmapAffineRow *writeBitmapAffineRow)
+{
+    if (bitmapFile->flags & BITMAP_FLAG_TRANSPARENT) {
+        return;
+    }
+
+    // Zero if the axes are parallel, in which case the bitmap has no area
+    float32 determinant = ((xAxis.x * yAxis.y) - (xAxis.y * yAxis.x));
+
+    if (determinant == 0.0f) {
+        return;
+    }
+
+    float32 widthf = (float32)bitmapFile->widthPx;
+    float32 heightf = (float32)bitmapFile->heightPx;
+
+    // How far through the bitmap, in texels, one pixel along each of the
+    // buffer's axes moves (the inverse of the axes, scaled by the bitmap's
+    // size). Exactly 1 and 0 for a bitmap drawn at its own size.
+    float32 texelXPerX = ((yAxis.y * widthf) / determinant);
+    float32 texelXPerY = ((-yAxis.x * widthf) / determinant);
+    float32 texelYPerX = ((-xAxis.y * heightf) / determinant);
+    float32 texelYPerY = ((xAxis.x * heightf) / determinant);
+
+    // The texel the centre of the buffer's bottom left pixel lands on
+    float32 centreX = (0.5f - origin.x);
+    float32 centreY = (0.5f - origin.y);
+
+    float32 texelX = (((centreX * texelXPerX) + (centreY * texelXPerY)) - 0.5f);
+    float32 texelY = (((centreX * texelYPerX) + (centreY * texelYPerY)) - 0.5f);
+
+    // Bounding box of the corners, clipped to the buffer
+    float32 minXf = 0.0f;
+    float32 minYf = 0.0f;
+    float32 maxXf = (float32)buffer->widthPx;
+    float32 maxYf = (float32)buffer->heightPx;
+
+    float32 cornerMinX = origin.x;
+    float32 cornerMinY = origin.y;
+    float32 cornerMaxX = origin.x;
+    float32 cornerMaxY = origin.y;
+
+    Vector2 corners[3] = {xAxis, yAxis, {(xAxis.x + yAxis.x), (xAxis.y + yAxis.y)}};
+
+    for (uint32 i = 0; i < 3; i++) {
+        float32 cornerX = (origin.x + corners[i].x);
+        float32 cornerY = (origin.y + corners[i].y);
+        cornerMinX = ((cornerX < cornerMinX) ? cornerX : cornerMinX);
+        cornerMinY = ((cornerY < cornerMinY) ? cornerY : cornerMinY);
+        cornerMaxX = ((cornerX > cornerMaxX) ? cornerX : cornerMaxX);
+        cornerMaxY = ((cornerY > cornerMaxY) ? cornerY : cornerMaxY);
+    }
+
+    minXf = ((cornerMinX > minXf) ? cornerMinX : minXf);
+    minYf = ((cornerMinY > minYf) ? cornerMinY : minYf);
+    maxXf = ((cornerMaxX < maxXf) ? cornerMaxX : maxXf);
+    maxYf = ((cornerMaxY < maxYf) ? cornerMaxY : maxYf);
+
+    if ((minXf >= maxXf) || (minYf >= maxYf)) {
+        return;
+    }
+
+    int32 minY = intrin_floorF32ToI32(minYf);
+    int32 maxY = (intrin_floorF32ToI32(maxYf) + 1);
+
+    if (maxY > (int32)buffer->heightPx) {
+        maxY = (int32)buffer->heightPx;
+    }
+
+    for (int32 y = minY; y < maxY; y++) {
+
+        float32 rowTexelX = (texelX + ((float32)y * texelXPerY));
+        float32 rowTexelY = (texelY + ((float32)y * texelYPerY));
+
+        // The row's span of pixel centres inside the bitmap, rounded out a
+        // pixel each side. The row kernels test each pixel exactly.
+        float32 spanMinX = minXf;
+        float32 spanMaxX = maxXf;
+
+        bitmapAffineClipSpan(&spanMinX, &spanMaxX, rowTexelX, texelXPerX, -0.5f, (widthf - 0.5f));
+        bitmapAffineClipSpan(&spanMinX, &spanMaxX, rowTexelY, texelYPerX, -0.5f, (heightf - 0.5f));
+
+        if (spanMinX >= spanMaxX) {
+            continue;
+        }
+
+        int32 minX = (intrin_floorF32ToI32(spanMinX) - 1);
+        int32 maxX = (intrin_floorF32ToI32(spanMaxX) + 2);
+
+        minX = ((minX < 0) ? 0 : minX);
+        maxX = ((maxX > (int32)buffer->widthPx) ? (int32)buffer->widthPx : maxX);
+
+        if (minX >= maxX) {
+            continue;
+        }
 
-        if (originalXOffset < 0) {
-            imagePixel = (imagePixel + (originalXOffset*-1));
-        }else if ((originalXOffset + originalWidth) > (int32)buffer->widthPx) {
-            imagePixel = (imagePixel + ((originalWidth + originalXOffset) - buffer->widthPx));
+        writeBitmapAffineRow(frameBufferPixel(buffer, 0, (uint32)y),
+                                (uint32)minX,
+                                (uint32)maxX,
+                                rowTexelX,
+                                rowTexelY,
+                                texelXPerX,
+                                texelYPerX,
+                                bitmapFile);
+    }
+}
+
+/**
+ * The bitmap's texel, or transparent if it's past the bitmap's edges
+ */
+internal_func uint32 bitmapAffineTexel(BitmapFile *bitmapFile, int32 x, int32 y)
+{
+    if ((x < 0) || (x >= (int32)bitmapFile->widthPx) || (y < 0) || (y >= (int32)bitmapFile->heightPx)) {
+        return 0;
+    }
+
+    return ((uint32 *)bitmapFile->memory)[((sizet)y * bitmapFile->pitchPx) + (sizet)x];
+}
+
+/**
+ * Blends between two 8 bit channels by weight (0 to 256), rounded. Done in
+ * 16 bits per channel by the SIMD versions, where it can't overflow.
+ */
+internal_func uint32 bitmapAffineLerp(uint32 a, uint32 b, uint32 weight)
+{
+    return (((a * (256 - weight)) + (b * weight) + 128) >> 8);
+}
+
+WRITE_BITMAP_AFFINE_ROW(writeBitmapAffineRowScalar)
+{
+    // Clamped to a texel past the edges before converting to fixed point, so
+    // it fits and stays positive
+    float32 limitX = ((float32)bitmapFile->widthPx + 1.0f);
+    float32 limitY = ((float32)bitmapFile->heightPx + 1.0f);
+
+    int32 coverMaxX = (((int32)bitmapFile->widthPx * 256) + 128);
+    int32 coverMaxY = (((int32)bitmapFile->heightPx * 256) + 128);
+
+    for (uint32 x = minX; x < maxX; x++) {
+
+        float32 u = (texelX + ((float32)x * texelXStep));
+        float32 v = (texelY + ((float32)x * texelYStep));
+
+        u = ((u < -1.0f) ? -1.0f : u);
+        u = ((u > limitX) ? limitX : u);
+        v = ((v < -1.0f) ? -1.0f : v);
+        v = ((v > limitY) ? limitY : v);
+
+        // 1/256ths of a texel, a texel up so the bottom left texel's centre
+        // is at 256
+        int32 fixedX = (int32)((u + 1.0f) * 256.0f);
+        int32 fixedY = (int32)((v + 1.0f) * 256.0f);
+
+        // Centre outside the bitmap
+        if ((fixedX < 128) || (fixedX >= coverMaxX) || (fixedY < 128) || (fixedY >= coverMaxY)) {
+            continue;
         }
+
+        int32 sampleX = ((fixedX >> 8) - 1);
+        int32 sampleY = ((fixedY >> 8) - 1);
+        uint32 weightX = (uint32)(fixedX & 0xFF);
+        uint32 weightY = (uint32)(fixedY & 0xFF);
+
+        uint32 bottomLeft = bitmapAffineTexel(bitmapFile, sampleX, sampleY);
+        uint32 bottomRight = bitmapAffineTexel(bitmapFile, (sampleX + 1), sampleY);
+        uint32 topLeft = bitmapAffineTexel(bitmapFile, sampleX, (sampleY + 1));
+        uint32 topRight = bitmapAffineTexel(bitmapFile, (sampleX + 1), (sampleY + 1));
+
+        uint32 dest = row[x];
+
+        // The texels are premultiplied, and so is their blend, so it's
+        // blended over the frame buffer the same way as writeBitmap
+        uint32 sample[4];
+        uint32 blended = 0;
+
+        for (uint32 shift = 0; shift < 32; shift += 8) {
+            uint32 bottom = bitmapAffineLerp(((bottomLeft >> shift) & 0xFF), ((bottomRight >> shift) & 0xFF), weightX);
+            uint32 top = bitmapAffineLerp(((topLeft >> shift) & 0xFF), ((topRight >> shift) & 0xFF), weightX);
+            sample[shift / 8] = bitmapAffineLerp(bottom, top, weightY);
+        }
+
+        for (uint32 shift = 0; shift < 32; shift += 8) {
+            blended |= (blendChannel(sample[shift / 8], ((dest >> shift) & 0xFF), sample[3]) << shift);
+        }
+
+        row[x] = blended;
     }
-}
\ No newline at end of file
+}
+
+/**
+ * Bilinearly blends two pixels' worth of texels (16 bits per channel) by
+ * the pixels' weights, then blends the result over two frame buffer pixels.
+ * See writeBitmapAffineRowScalar.
+ */
+internal_func __m128i bitmapAffineBlendSSE2(__m128i bottomLeft,
+                                            __m128i bottomRight,
+                                            __m128i topLeft,
+                                            __m128i topRight,
+                                            __m128i weightX,
+                                            __m128i weightY,
+                                            __m128i dest)
+{
+    __m128i half = _mm_set1_epi16(128);
+    __m128i max = _mm_set1_epi16(255);
+    __m128i one = _mm_set1_epi16(256);
+
+    __m128i inverseX = _mm_sub_epi16(one, weightX);
+    __m128i inverseY = _mm_sub_epi16(one, weightY);
+
+    // At most 255 * 256 + 128, so it fits in an unsigned 16 bits
+    __m128i bottom = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(_mm_mullo_epi16(bottomLeft, inverseX), _mm_mullo_epi16(bottomRight, weightX)), half), 8);
+    __m128i top = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(_mm_mullo_epi16(topLeft, inverseX), _mm_mullo_epi16(topRight, weightX)), half), 8);
+    __m128i sample = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(_mm_mullo_epi16(bottom, inverseY), _mm_mullo_epi16(top, weightY)), half), 8);
+
+    __m128i alpha = _mm_shufflehi_epi16(_mm_shufflelo_epi16(sample, 0xFF), 0xFF);
+
+    __m128i blended = _mm_add_epi16(_mm_mullo_epi16(dest, _mm_sub_epi16(max, alpha)), half);
+    blended = _mm_srli_epi16(_mm_add_epi16(blended, _mm_srli_epi16(blended, 8)), 8);
+
+    return _mm_add_epi16(blended, sample);
+}
+
+WRITE_BITMAP_AFFINE_ROW(writeBitmapAffineRowSSE2)
+{
+    uint32 wideMaxX = (minX + ((maxX - minX) & ~3u));
+
+    __m128i zero = _mm_setzero_si128();
+    __m128i byteMask = _mm_set1_epi32(0xFF);
+    __m128i coverMin = _mm_set1_epi32(127);
+    __m128i coverMaxX = _mm_set1_epi32(((int32)bitmapFile->widthPx * 256) + 128);
+    __m128i coverMaxY = _mm_set1_epi32(((int32)bitmapFile->heightPx * 256) + 128);
+
+    __m128 minimum = _mm_set1_ps(-1.0f);
+    __m128 limitX = _mm_set1_ps((float32)bitmapFile->widthPx + 1.0f);
+    __m128 limitY = _mm_set1_ps((float32)bitmapFile->heightPx + 1.0f);
+    __m128 oneTexel = _mm_set1_ps(1.0f);
+    __m128 fixedScale = _mm_set1_ps(256.0f);
+    __m128 offsets = _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f);
+    __m128 startX = _mm_set1_ps(texelX);
+    __m128 startY = _mm_set1_ps(texelY);
+    __m128 stepX = _mm_set1_ps(texelXStep);
+    __m128 stepY = _mm_set1_ps(texelYStep);
+
+    for (uint32 x = minX; x < wideMaxX; x += 4) {
+
+        __m128 index = _mm_add_ps(_mm_set1_ps((float32)x), offsets);
+
+        __m128 u = _mm_add_ps(startX, _mm_mul_ps(index, stepX));
+        __m128 v = _mm_add_ps(startY, _mm_mul_ps(index, stepY));
+
+        u = _mm_min_ps(_mm_max_ps(u, minimum), limitX);
+        v = _mm_min_ps(_mm_max_ps(v, minimum), limitY);
+
+        __m128i fixedX = _mm_cvttps_epi32(_mm_mul_ps(_mm_add_ps(u, oneTexel), fixedScale));
+        __m128i fixedY = _mm_cvttps_epi32(_mm_mul_ps(_mm_add_ps(v, oneTexel), fixedScale));
+
+        __m128i covered = _mm_and_si128(_mm_and_si128(_mm_cmpgt_epi32(fixedX, coverMin), _mm_cmplt_epi32(fixedX, coverMaxX)),
+                                        _mm_and_si128(_mm_cmpgt_epi32(fixedY, coverMin), _mm_cmplt_epi32(fixedY, coverMaxY)));
+
+        if (_mm_movemask_epi8(covered) == 0) {
+            continue;
+        }
+
+        // SSE2 has no gather, so the texels are fetched one at a time
+        alignas(16) int32 sampleX[4];
+        alignas(16) int32 sampleY[4];
+        alignas(16) uint32 texels[4][4];
+
+        _mm_store_si128((__m128i *)sampleX, _mm_srai_epi32(fixedX, 8));
+        _mm_store_si128((__m128i *)sampleY, _mm_srai_epi32(fixedY, 8));
+
+        for (uint32 i = 0; i < 4; i++) {
+            texels[0][i] = bitmapAffineTexel(bitmapFile, (sampleX[i] - 1), (sampleY[i] - 1));
+            texels[1][i] = bitmapAffineTexel(bitmapFile, sampleX[i], (sampleY[i] - 1));
+            texels[2][i] = bitmapAffineTexel(bitmapFile, (sampleX[i] - 1), sampleY[i]);
+            texels[3][i] = bitmapAffineTexel(bitmapFile, sampleX[i], sampleY[i]);
+        }
+
+        __m128i bottomLeft = _mm_load_si128((__m128i *)texels[0]);
+        __m128i bottomRight = _mm_load_si128((__m128i *)texels[1]);
+        __m128i topLeft = _mm_load_si128((__m128i *)texels[2]);
+        __m128i topRight = _mm_load_si128((__m128i *)texels[3]);
+
+        // Each pixel's weights copied into all 4 of its 16 bit channels
+        __m128i weightX = _mm_and_si128(fixedX, byteMask);
+        __m128i weightY = _mm_and_si128(fixedY, byteMask);
+        weightX = _mm_or_si128(weightX, _mm_slli_epi32(weightX, 16));
+        weightY = _mm_or_si128(weightY, _mm_slli_epi32(weightY, 16));
+
+        __m128i dest = _mm_loadu_si128((__m128i *)(row + x));
+
+        __m128i low = bitmapAffineBlendSSE2(_mm_unpacklo_epi8(bottomLeft, zero),
+                                            _mm_unpacklo_epi8(bottomRight, zero),
+                                            _mm_unpacklo_epi8(topLeft, zero),
+                                            _mm_unpacklo_epi8(topRight, zero),
+                                            _mm_unpacklo_epi32(weightX, weightX),
+                                            _mm_unpacklo_epi32(weightY, weightY),
+                                            _mm_unpacklo_epi8(dest, zero));
+
+        __m128i high = bitmapAffineBlendSSE2(_mm_unpackhi_epi8(bottomLeft, zero),
+                                                _mm_unpackhi_epi8(bottomRight, zero),
+                                                _mm_unpackhi_epi8(topLeft, zero),
+                                                _mm_unpackhi_epi8(topRight, zero),
+                                                _mm_unpackhi_epi32(weightX, weightX),
+                                                _mm_unpackhi_epi32(weightY, weightY),
+                                                _mm_unpackhi_epi8(dest, zero));
+
+        __m128i blended = _mm_packus_epi16(low, high);
+
+        // Pixels whose centres are outside the bitmap are left as they were
+        blended = _mm_or_si128(_mm_and_si128(covered, blended), _mm_andnot_si128(covered, dest));
+
+        _mm_storeu_si128((__m128i *)(row + x), blended);
+    }
+
+    writeBitmapAffineRowScalar(row, wideMaxX, maxX, texelX, texelY, texelXStep, texelYStep, bitmapFile);
+}
+
+/**
+ * See bitmapAffineBlendSSE2
+ */
+target_avx2 internal_func __m256i bitmapAffineBlendAVX2(__m256i bottomLeft,
+                                                        __m256i bottomRight,
+                                                        __m256i topLeft,
+                                                        __m256i topRight,
+                                                        __m256i weightX,
+                                                        __m256i weightY,
+                                                        __m256i dest)
+{
+    __m256i half = _mm256_set1_epi16(128);
+    __m256i max = _mm256_set1_epi16(255);
+    __m256i one = _mm256_set1_epi16(256);
+
+    __m256i inverseX = _mm256_sub_epi16(one, weightX);
+    __m256i inverseY = _mm256_sub_epi16(one, weightY);
+
+    __m256i bottom = _mm256_srli_epi16(_mm256_add_epi16(_mm256_add_epi16(_mm256_mullo_epi16(bottomLeft, inverseX), _mm256_mullo_epi16(bottomRight, weightX)), half), 8);
+    __m256i top = _mm256_srli_epi16(_mm256_add_epi16(_mm256_add_epi16(_mm256_mullo_epi16(topLeft, inverseX), _mm256_mullo_epi16(topRight, weightX)), half), 8);
+    __m256i sample = _mm256_srli_epi16(_mm256_add_epi16(_mm256_add_epi16(_mm256_mullo_epi16(bottom, inverseY), _mm256_mullo_epi16(top, weightY)), half), 8);
+
+    __m256i alpha = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(sample, 0xFF), 0xFF);
+
+    __m256i blended = _mm256_add_epi16(_mm256_mullo_epi16(dest, _mm256_sub_epi16(max, alpha)), half);
+    blended = _mm256_srli_epi16(_mm256_add_epi16(blended, _mm256_srli_epi16(blended, 8)), 8);
+
+    return _mm256_add_epi16(blended, sample);
+}
+
+target_avx2 WRITE_BITMAP_AFFINE_ROW(writeBitmapAffineRowAVX2)
+{
+    uint32 wideMaxX = (minX + ((maxX - minX) & ~7u));
+
+    __m256i zero = _mm256_setzero_si256();
+    __m256i byteMask = _mm256_set1_epi32(0xFF);
+    __m256i coverMin = _mm256_set1_epi32(127);
+    __m256i coverMaxX = _mm256_set1_epi32(((int32)bitmapFile->widthPx * 256) + 128);
+    __m256i coverMaxY = _mm256_set1_epi32(((int32)bitmapFile->heightPx * 256) + 128);
+    __m256i textureWidth = _mm256_set1_epi32((int32)bitmapFile->widthPx);
+    __m256i textureHeight = _mm256_set1_epi32((int32)bitmapFile->heightPx);
+    __m256i pitch = _mm256_set1_epi32((int32)bitmapFile->pitchPx);
+    __m256i minusOne = _mm256_set1_epi32(-1);
+
+    __m256 minimum = _mm256_set1_ps(-1.0f);
+    __m256 limitX = _mm256_set1_ps((float32)bitmapFile->widthPx + 1.0f);
+    __m256 limitY = _mm256_set1_ps((float32)bitmapFile->heightPx + 1.0f);
+    __m256 oneTexel = _mm256_set1_ps(1.0f);
+    __m256 fixedScale = _mm256_set1_ps(256.0f);
+    __m256 offsets = _mm256_setr_ps(0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f);
+    __m256 startX = _mm256_set1_ps(texelX);
+    __m256 startY = _mm256_set1_ps(texelY);
+    __m256 stepX = _mm256_set1_ps(texelXStep);
+    __m256 stepY = _mm256_set1_ps(texelYStep);
+
+    const int32 *texels = (const int32 *)bitmapFile->memory;
+
+    for (uint32 x = minX; x < wideMaxX; x += 8) {
+
+        __m256 index = _mm256_add_ps(_mm256_set1_ps((float32)x), offsets);
+
+        // Multiplied then added separately, rather than fused, to round the
+        // same as the other versions
+        __m256 u = _mm256_add_ps(startX, _mm256_mul_ps(index, stepX));
+        __m256 v = _mm256_add_ps(startY, _mm256_mul_ps(index, stepY));
+
+        u = _mm256_min_ps(_mm256_max_ps(u, minimum), limitX);
+        v = _mm256_min_ps(_mm256_max_ps(v, minimum), limitY);
+
+        __m256i fixedX = _mm256_cvttps_epi32(_mm256_mul_ps(_mm256_add_ps(u, oneTexel), fixedScale));
+        __m256i fixedY = _mm256_cvttps_epi32(_mm256_mul_ps(_mm256_add_ps(v, oneTexel), fixedScale));
+
+        __m256i covered = _mm256_and_si256(_mm256_and_si256(_mm256_cmpgt_epi32(fixedX, coverMin), _mm256_cmpgt_epi32(coverMaxX, fixedX)),
+                                            _mm256_and_si256(_mm256_cmpgt_epi32(fixedY, coverMin), _mm256_cmpgt_epi32(coverMaxY, fixedY)));
+
+        if (_mm256_movemask_epi8(covered) == 0) {
+            continue;
+        }
+
+        __m256i left = _mm256_sub_epi32(_mm256_srai_epi32(fixedX, 8), _mm256_set1_epi32(1));
+        __m256i bottom = _mm256_sub_epi32(_mm256_srai_epi32(fixedY, 8), _mm256_set1_epi32(1));
+        __m256i right = _mm256_add_epi32(left, _mm256_set1_epi32(1));
+        __m256i top = _mm256_add_epi32(bottom, _mm256_set1_epi32(1));
+
+        // Texels past the bitmap's edges aren't fetched, and stay transparent
+        __m256i leftInside = _mm256_and_si256(_mm256_cmpgt_epi32(left, minusOne), _mm256_cmpgt_epi32(textureWidth, left));
+        __m256i rightInside = _mm256_and_si256(_mm256_cmpgt_epi32(right, minusOne), _mm256_cmpgt_epi32(textureWidth, right));
+        __m256i bottomInside = _mm256_and_si256(_mm256_cmpgt_epi32(bottom, minusOne), _mm256_cmpgt_epi32(textureHeight, bottom));
+        __m256i topInside = _mm256_and_si256(_mm256_cmpgt_epi32(top, minusOne), _mm256_cmpgt_epi32(textureHeight, top));
+
+        __m256i bottomRow = _mm256_mullo_epi32(bottom, pitch);
+        __m256i topRow = _mm256_mullo_epi32(top, pitch);
+
+        __m256i bottomLeft = _mm256_mask_i32gather_epi32(zero, texels, _mm256_add_epi32(bottomRow, left), _mm256_and_si256(bottomInside, leftInside), 4);
+        __m256i bottomRight = _mm256_mask_i32gather_epi32(zero, texels, _mm256_add_epi32(bottomRow, right), _mm256_and_si256(bottomInside, rightInside), 4);
+        __m256i topLeft = _mm256_mask_i32gather_epi32(zero, texels, _mm256_add_epi32(topRow, left), _mm256_and_si256(topInside, leftInside), 4);
+        __m256i topRight = _mm256_mask_i32gather_epi32(zero, texels, _mm256_add_epi32(topRow, right), _mm256_and_si256(topInside, rightInside), 4);
+
+        __m256i weightX = _mm256_and_si256(fixedX, byteMask);
+        __m256i weightY = _mm256_and_si256(fixedY, byteMask);
+        weightX = _mm256_or_si256(weightX, _mm256_slli_epi32(weightX, 16));
+        weightY = _mm256_or_si256(weightY, _mm256_slli_epi32(weightY, 16));
+
+        __m256i dest = _mm256_loadu_si256((__m256i *)(row + x));
+
+        // Unpacking and packing both work within each 128-bit lane, so the
+        // weights line up with their pixels and come back out in order
+        __m256i low = bitmapAffineBlendAVX2(_mm256_unpacklo_epi8(bottomLeft, zero),
+                                            _mm256_unpacklo_epi8(bottomRight, zero),
+                                            _mm256_unpacklo_epi8(topLeft, zero),
+                                            _mm256_unpacklo_epi8(topRight, zero),
+                                            _mm256_unpacklo_epi32(weightX, weightX),
+                                            _mm256_unpacklo_epi32(weightY, weightY),
+                                            _mm256_unpacklo_epi8(dest, zero));
+
+        __m256i high = bitmapAffineBlendAVX2(_mm256_unpackhi_epi8(bottomLeft, zero),
+                                                _mm256_unpackhi_epi8(bottomRight, zero),
+                                                _mm256_unpackhi_epi8(topLeft, zero),
+                                                _mm256_unpackhi_epi8(topRight, zero),
+                                                _mm256_unpackhi_epi32(weightX, weightX),
+                                                _mm256_unpackhi_epi32(weightY, weightY),
+                                                _mm256_unpackhi_epi8(dest, zero));
+
+        __m256i blended = _mm256_packus_epi16(low, high);
+
+        blended = _mm256_blendv_epi8(dest, blended, covered);
+
+        _mm256_storeu_si256((__m256i *)(row + x), blended);
+    }
+
+    // See writeBitmapRowAVX2
+    _mm256_zeroupper();
+
+    writeBitmapAffineRowScalar(row, wideMaxX, maxX, texelX, texelY, texelXStep, texelYStep, bitmapFile);
+}
+
+void upscaleFrameBuffer(GameFrameBuffer *dest,
+                        GameFrameBuffer *source,
+                        UpscaleFilter filter,
+                        uint32 *scratchRow)
+{
+    UpscaleRow *upscaleRow = NULL;
+    UpscaleBlendRows *blendRows = NULL;
+
+    if (intrin_cpuSupportsAVX2()) {
+        upscaleRow = ((UPSCALE_FILTER_NEAREST == filter) ? upscaleRowNearestAVX2 : upscaleRowBilinearAVX2);
+        blendRows = upscaleBlendRowsAVX2;
+    } else {
+        upscaleRow = ((UPSCALE_FILTER_NEAREST == filter) ? upscaleRowNearestSSE2 : upscaleRowBilinearSSE2);
+        blendRows = upscaleBlendRowsSSE2;
+    }
+
+    upscaleFrameBufferRows(dest, source, filter, scratchRow, upscaleRow, blendRows);
+}
+
+/**
+ * How far one destination pixel steps across the source, in 1/65536ths of a
+ * source pixel
+ */
+internal_func int32 upscaleStep(uint32 sourcePx, uint32 destPx)
+{
+    return (int32)(((uint64)sourcePx << 16) / destPx);
+}
+
+/**
+ * Where the first destination pixel's centre lands in the source, in
+ * 1/65536ths of a source pixel, with whole numbers at source pixel centres
+ */
+internal_func int32 upscaleStart(int32 step)
+{
+    return ((step / 2) - 32768);
+}
+
+internal_func int32 upscaleClampIndex(int32 index, int32 maxIndex)
+{
+    index = ((index < 0) ? 0 : index);
+    return ((index > maxIndex) ? maxIndex : index);
+}
+
+void upscaleFrameBufferRows(GameFrameBuffer *dest,
+                            GameFrameBuffer *source,
+                            UpscaleFilter filter,
+                            uint32 *scratchRow,
+                            UpscaleRow *upscaleRow,
+                            UpscaleBlendRows *blendRows)
+{
+    if ((0 == dest->widthPx) || (0 == dest->heightPx) || (0 == source->widthPx) || (0 == source->heightPx)) {
+        return;
+    }
+
+    int32 stepX = upscaleStep(source->widthPx, dest->widthPx);
+    int32 stepY = upscaleStep(source->heightPx, dest->heightPx);
+    int32 startX = upscaleStart(stepX);
+    int32 sourceY = upscaleStart(stepY);
+    int32 maxSourceRow = ((int32)source->heightPx - 1);
+
+    uint32 destPitchPx = frameBufferPitchPx(dest);
+    uint32 sourcePitchPx = frameBufferPitchPx(source);
+
+    // The rows (and weight) the previous destination row came from. Rows that
+    // would come out the same are copied rather than worked out again.
+    int32 lastRow0 = -1;
+    int32 lastRow1 = -1;
+    uint32 lastWeight = 0;
+
+    // Rows are stored top down in both buffers. Pixel centres line up either
+    // way, so working down gives the same result as working up.
+    for (uint32 y = 0; y < dest->heightPx; y++, sourceY += stepY) {
+
+        uint32 *destRow = ((uint32 *)dest->memory + (destPitchPx * y));
+
+        int32 row0 = 0;
+        int32 row1 = 0;
+        uint32 weight = 0;
+
+        if (UPSCALE_FILTER_NEAREST == filter) {
+            row0 = upscaleClampIndex(((sourceY + 32768) >> 16), maxSourceRow);
+            row1 = row0;
+        } else {
+            row0 = upscaleClampIndex((sourceY >> 16), maxSourceRow);
+            row1 = upscaleClampIndex(((sourceY >> 16) + 1), maxSourceRow);
+            weight = (uint32)((sourceY >> 8) & 0xFF);
+
+            // Blending a row with itself, or not at all, leaves it as it is
+            if ((row0 == row1) || (0 == weight)) {
+                row1 = row0;
+                weight = 0;
+            }
+        }
+
+        if ((y > 0) && (row0 == lastRow0) && (row1 == lastRow1) && (weight == lastWeight)) {
+            memcpy(destRow, (destRow - destPitchPx), (dest->widthPx * sizeof(uint32)));
+            continue;
+        }
+
+        const uint32 *sourceRow = ((uint32 *)source->memory + (sourcePitchPx * (uint32)row0));
+
+        if (row0 != row1) {
+            assert(scratchRow);
+            blendRows(scratchRow,
+                        sourceRow,
+                        ((uint32 *)source->memory + (sourcePitchPx * (uint32)row1)),
+                        source->widthPx,
+                        weight);
+            sourceRow = scratchRow;
+        }
+
+        upscaleRow(destRow, sourceRow, dest->widthPx, source->widthPx, startX, stepX);
+
+        lastRow0 = row0;
+        lastRow1 = row1;
+        lastWeight = weight;
+    }
+}
+
+UPSCALE_ROW(upscaleRowNearestScalar)
+{
+    int32 maxIndex = ((int32)sourceWidth - 1);
+
+    for (uint32 x = 0; x < destWidth; x++) {
+        int32 position = (sourceX + ((int32)x * sourceXStep));
+        destRow[x] = sourceRow[upscaleClampIndex(((position + 32768) >> 16), maxIndex)];
+    }
+}
+
+/**
+ * Clamps four indices to 0 to maxIndex. SSE2 has no 32-bit min or max.
+ */
+internal_func __m128i upscaleClampIndexSSE2(__m128i index, __m128i maxIndex)
+{
+    index = _mm_andnot_si128(_mm_srai_epi32(index, 31), index);
+
+    __m128i over = _mm_cmpgt_epi32(index, maxIndex);
+
+    return _mm_or_si128(_mm_and_si128(over, maxIndex), _mm_andnot_si128(over, index));
+}
+
+UPSCALE_ROW(upscaleRowNearestSSE2)
+{
+    uint32 wideWidth = (destWidth & ~3u);
+
+    __m128i maxIndex = _mm_set1_epi32((int32)sourceWidth - 1);
+    __m128i half = _mm_set1_epi32(32768);
+    __m128i position = _mm_setr_epi32(sourceX, (sourceX + sourceXStep), (sourceX + (2 * sourceXStep)), (sourceX + (3 * sourceXStep)));
+    __m128i positionStep = _mm_set1_epi32(4 * sourceXStep);
+
+    for (uint32 x = 0; x < wideWidth; x += 4, position = _mm_add_epi32(position, positionStep)) {
+
+        // No gather before AVX2, so the pixels are loaded one at a time
+        alignas(16) int32 index[4];
+        _mm_store_si128((__m128i *)index, upscaleClampIndexSSE2(_mm_srai_epi32(_mm_add_epi32(position, half), 16), maxIndex));
+
+        _mm_storeu_si128((__m128i *)(destRow + x), _mm_setr_epi32((int32)sourceRow[index[0]],
+                                                                    (int32)sourceRow[index[1]],
+                                                                    (int32)sourceRow[index[2]],
+                                                                    (int32)sourceRow[index[3]]));
+    }
+
+    upscaleRowNearestScalar((destRow + wideWidth),
+                            sourceRow,
+                            (destWidth - wideWidth),
+                            sourceWidth,
+                            (sourceX + ((int32)wideWidth * sourceXStep)),
+                            sourceXStep);
+}
+
+target_avx2 UPSCALE_ROW(upscaleRowNearestAVX2)
+{
+    uint32 wideWidth = (destWidth & ~7u);
+
+    __m256i zero = _mm256_setzero_si256();
+    __m256i maxIndex = _mm256_set1_epi32((int32)sourceWidth - 1);
+    __m256i half = _mm256_set1_epi32(32768);
+    __m256i position = _mm256_add_epi32(_mm256_set1_epi32(sourceX),
+                                        _mm256_mullo_epi32(_mm256_set1_epi32(sourceXStep), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7)));
+    __m256i positionStep = _mm256_set1_epi32(8 * sourceXStep);
+
+    for (uint32 x = 0; x < wideWidth; x += 8, position = _mm256_add_epi32(position, positionStep)) {
+
+        __m256i index = _mm256_srai_epi32(_mm256_add_epi32(position, half), 16);
+        index = _mm256_min_epi32(_mm256_max_epi32(index, zero), maxIndex);
+
+        _mm256_storeu_si256((__m256i *)(destRow + x), _mm256_i32gather_epi32((const int *)sourceRow, index, 4));
+    }
+
+    // See writeBitmapRowAVX2
+    _mm256_zeroupper();
+
+    upscaleRowNearestScalar((destRow + wideWidth),
+                            sourceRow,
+                            (destWidth - wideWidth),
+                            sourceWidth,
+                            (sourceX + ((int32)wideWidth * sourceXStep)),
+                            sourceXStep);
+}
+
+/**
+ * Both pixels' channels blended by weight (0 to 255), rounded as
+ * bitmapAffineLerp does
+ */
+internal_func uint32 upscaleLerpPixel(uint32 a, uint32 b, uint32 weight)
+{
+    uint32 result = 0;
+
+    for (uint32 shift = 0; shift < 32; shift += 8) {
+        result |= (bitmapAffineLerp(((a >> shift) & 0xFF), ((b >> shift) & 0xFF), weight) << shift);
+    }
+
+    return result;
+}
+
+UPSCALE_ROW(upscaleRowBilinearScalar)
+{
+    int32 maxIndex = ((int32)sourceWidth - 1);
+
+    for (uint32 x = 0; x < destWidth; x++) {
+
+        int32 position = (sourceX + ((int32)x * sourceXStep));
+
+        uint32 left = sourceRow[upscaleClampIndex((position >> 16), maxIndex)];
+        uint32 right = sourceRow[upscaleClampIndex(((position >> 16) + 1), maxIndex)];
+
+        destRow[x] = upscaleLerpPixel(left, right, (uint32)((position >> 8) & 0xFF));
+    }
+}
+
+/**
+ * Blends two pixels' worth of channels (16 bits each) by their weights. See
+ * bitmapAffineLerp.
+ */
+internal_func __m128i upscaleLerpSSE2(__m128i a, __m128i b, __m128i weight)
+{
+    __m128i half = _mm_set1_epi16(128);
+    __m128i inverse = _mm_sub_epi16(_mm_set1_epi16(256), weight);
+
+    // At most 255 * 256 + 128, so it fits in an unsigned 16 bits
+    return _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(_mm_mullo_epi16(a, inverse), _mm_mullo_epi16(b, weight)), half), 8);
+}
+
+/**
+ * Four pixels of a blended with b, weight (0 to 255) per pixel in each 32 bits
+ */
+internal_func __m128i upscaleLerpPixelsSSE2(__m128i a, __m128i b, __m128i weight)
+{
+    __m128i zero = _mm_setzero_si128();
+
+    // The weight in both 16 bits of its pixel's 32, then both 32 bits of the
+    // pixel's 64, so it lines up with the pixel's four channels once unpacked
+    weight = _mm_or_si128(weight, _mm_slli_epi32(weight, 16));
+
+    __m128i low = upscaleLerpSSE2(_mm_unpacklo_epi8(a, zero), _mm_unpacklo_epi8(b, zero), _mm_unpacklo_epi32(weight, weight));
+    __m128i high = upscaleLerpSSE2(_mm_unpackhi_epi8(a, zero), _mm_unpackhi_epi8(b, zero), _mm_unpackhi_epi32(weight, weight));
+
+    return _mm_packus_epi16(low, high);
+}
+
+UPSCALE_ROW(upscaleRowBilinearSSE2)
+{
+    uint32 wideWidth = (destWidth & ~3u);
+
+    __m128i one = _mm_set1_epi32(1);
+    __m128i byteMask = _mm_set1_epi32(0xFF);
+    __m128i maxIndex = _mm_set1_epi32((int32)sourceWidth - 1);
+    __m128i position = _mm_setr_epi32(sourceX, (sourceX + sourceXStep), (sourceX + (2 * sourceXStep)), (sourceX + (3 * sourceXStep)));
+    __m128i positionStep = _mm_set1_epi32(4 * sourceXStep);
+
+    for (uint32 x = 0; x < wideWidth; x += 4, position = _mm_add_epi32(position, positionStep)) {
+
+        __m128i index = _mm_srai_epi32(position, 16);
+
+        alignas(16) int32 leftIndex[4];
+        alignas(16) int32 rightIndex[4];
+        _mm_store_si128((__m128i *)leftIndex, upscaleClampIndexSSE2(index, maxIndex));
+        _mm_store_si128((__m128i *)rightIndex, upscaleClampIndexSSE2(_mm_add_epi32(index, one), maxIndex));
+
+        __m128i left = _mm_setr_epi32((int32)sourceRow[leftIndex[0]],
+                                        (int32)sourceRow[leftIndex[1]],
+                                        (int32)sourceRow[leftIndex[2]],
+                                        (int32)sourceRow[leftIndex[3]]);
+
+        __m128i right = _mm_setr_epi32((int32)sourceRow[rightIndex[0]],
+                                        (int32)sourceRow[rightIndex[1]],
+                                        (int32)sourceRow[rightIndex[2]],
+                                        (int32)sourceRow[rightIndex[3]]);
+
+        __m128i weight = _mm_and_si128(_mm_srai_epi32(position, 8), byteMask);
+
+        _mm_storeu_si128((__m128i *)(destRow + x), upscaleLerpPixelsSSE2(left, right, weight));
+    }
+
+    upscaleRowBilinearScalar((destRow + wideWidth),
+                                sourceRow,
+                                (destWidth - wideWidth),
+                                sourceWidth,
+                                (sourceX + ((int32)wideWidth * sourceXStep)),
+                                sourceXStep);
+}
+
+/**
+ * See upscaleLerpSSE2
+ */
+target_avx2 internal_func __m256i upscaleLerpAVX2(__m256i a, __m256i b, __m256i weight)
+{
+    __m256i half = _mm256_set1_epi16(128);
+    __m256i inverse = _mm256_sub_epi16(_mm256_set1_epi16(256), weight);
+
+    return _mm256_srli_epi16(_mm256_add_epi16(_mm256_add_epi16(_mm256_mullo_epi16(a, inverse), _mm256_mullo_epi16(b, weight)), half), 8);
+}
+
+/**
+ * See upscaleLerpPixelsSSE2. The unpacks and the pack work within each 128
+ * bits, so the pixels come back out in order.
+ */
+target_avx2 internal_func __m256i upscaleLerpPixelsAVX2(__m256i a, __m256i b, __m256i weight)
+{
+    __m256i zero = _mm256_setzero_si256();
+
+    weight = _mm256_or_si256(weight, _mm256_slli_epi32(weight, 16));
+
+    __m256i low = upscaleLerpAVX2(_mm256_unpacklo_epi8(a, zero), _mm256_unpacklo_epi8(b, zero), _mm256_unpacklo_epi32(weight, weight));
+    __m256i high = upscaleLerpAVX2(_mm256_unpackhi_epi8(a, zero), _mm256_unpackhi_epi8(b, zero), _mm256_unpackhi_epi32(weight, weight));
+
+    return _mm256_packus_epi16(low, high);
+}
+
+target_avx2 UPSCALE_ROW(upscaleRowBilinearAVX2)
+{
+    uint32 wideWidth = (destWidth & ~7u);
+
+    __m256i zero = _mm256_setzero_si256();
+    __m256i one = _mm256_set1_epi32(1);
+    __m256i byteMask = _mm256_set1_epi32(0xFF);
+    __m256i maxIndex = _mm256_set1_epi32((int32)sourceWidth - 1);
+    __m256i position = _mm256_add_epi32(_mm256_set1_epi32(sourceX),
+                                        _mm256_mullo_epi32(_mm256_set1_epi32(sourceXStep), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7)));
+    __m256i positionStep = _mm256_set1_epi32(8 * sourceXStep);
+
+    for (uint32 x = 0; x < wideWidth; x += 8, position = _mm256_add_epi32(position, positionStep)) {
+
+        __m256i index = _mm256_srai_epi32(position, 16);
+        __m256i leftIndex = _mm256_min_epi32(_mm256_max_epi32(index, zero), maxIndex);
+        __m256i rightIndex = _mm256_min_epi32(_mm256_max_epi32(_mm256_add_epi32(index, one), zero), maxIndex);
+
+        __m256i left = _mm256_i32gather_epi32((const int *)sourceRow, leftIndex, 4);
+        __m256i right = _mm256_i32gather_epi32((const int *)sourceRow, rightIndex, 4);
+        __m256i weight = _mm256_and_si256(_mm256_srai_epi32(position, 8), byteMask);
+
+        _mm256_storeu_si256((__m256i *)(destRow + x), upscaleLerpPixelsAVX2(left, right, weight));
+    }
+
+    // See writeBitmapRowAVX2
+    _mm256_zeroupper();
+
+    upscaleRowBilinearScalar((destRow + wideWidth),
+                                sourceRow,
+                                (destWidth - wideWidth),
+                                sourceWidth,
+                                (sourceX + ((int32)wideWidth * sourceXStep)),
+                                sourceXStep);
+}
+
+UPSCALE_BLEND_ROWS(upscaleBlendRowsScalar)
+{
+    for (uint32 x = 0; x < count; x++) {
+        destRow[x] = upscaleLerpPixel(row0[x], row1[x], weight);
+    }
+}
+
+UPSCALE_BLEND_ROWS(upscaleBlendRowsSSE2)
+{
+    uint32 wideCount = (count & ~3u);
+
+    __m128i weights = _mm_set1_epi32((int32)weight);
+
+    for (uint32 x = 0; x < wideCount; x += 4) {
+        __m128i a = _mm_loadu_si128((const __m128i *)(row0 + x));
+        __m128i b = _mm_loadu_si128((const __m128i *)(row1 + x));
+        _mm_storeu_si128((__m128i *)(destRow + x), upscaleLerpPixelsSSE2(a, b, weights));
+    }
+
+    upscaleBlendRowsScalar((destRow + wideCount), (row0 + wideCount), (row1 + wideCount), (count - wideCount), weight);
+}
+
+target_avx2 UPSCALE_BLEND_ROWS(upscaleBlendRowsAVX2)
+{
+    uint32 wideCount = (count & ~7u);
+
+    __m256i weights = _mm256_set1_epi32((int32)weight);
+
+    for (uint32 x = 0; x < wideCount; x += 8) {
+        __m256i a = _mm256_loadu_si256((const __m256i *)(row0 + x));
+        __m256i b = _mm256_loadu_si256((const __m256i *)(row1 + x));
+        _mm256_storeu_si256((__m256i *)(destRow + x), upscaleLerpPixelsAVX2(a, b, weights));
+    }
+
+    // See writeBitmapRowAVX2
+    _mm256_zeroupper();
+
+    upscaleBlendRowsScalar((destRow + wideCount), (row0 + wideCount), (row1 + wideCount), (count - wideCount), weight);
+}
@@ -3,6 +3,7 @@
 
 #include "types.h"
 #include "filesystem.h"
+#include "math.h"
 
 //
 // Graphics
@@ -15,6 +16,9 @@
 * @param yOffset   Offset, in pixels along the y axis to start drawing from
 * @param width     Width, in pixels, to draw
 * @param height    Height, in pixels, to draw
+* @param colour    Colour to fill with. Either a Colour or, for callers that
+*                  draw the same colour a lot, one already packed with
+*                  packColour.
 * @return void
 */
 typedef struct GameFrameBuffer GameFrameBuffer;
@@ -25,6 +29,13 @@ void writeRectangleInt(GameFrameBuffer *buffer,
                         uint32 height,
                         Colour colour);
 
+void writeRectangleInt(GameFrameBuffer *buffer,
+                        int32 xOffset,
+                        int32 yOffset,
+                        uint32 width,
+                        uint32 height,
+                        uint32 colour);
+
 void writeRectangle(GameFrameBuffer *buffer,
                     float32 xOffsetf,
                     float32 yOffsetf,
@@ -32,8 +43,101 @@ void writeRectangle(GameFrameBuffer *buffer,
                     uint32 height,
                     Colour colour);
 
+void writeRectangle(GameFrameBuffer *buffer,
+                    float32 xOffsetf,
+                    float32 yOffsetf,
+                    uint32 width,
+                    uint32 height,
+                    uint32 colour);
+
+// Line end points must be closer than this to the buffer's bottom left, in
+// pixels for writeLine and in subpixels for writeLineSmooth
+#define WRITE_LINE_MAX_COORDINATE (1 << 30)
+
+// writeLineSmooth's end points are in 1/256ths of a pixel
+#define WRITE_LINE_SUBPIXEL_BITS 8
+
+/**
+ * Writes a one pixel wide line into the frame buffer, both ends included
+ * (Bresenham). The line is clipped to the buffer before any pixels are
+ * stepped on, so only the pixels on the buffer cost anything. A line comes out
+ * the same whichever end it's drawn from, and moving both ends by whole pixels
+ * moves every pixel with them, so a buffer that's a view onto part of a bigger
+ * one (E.g. a renderer tile) gets exactly the pixels it covers.
+ *
+ * @param colour    Packed colour (0xAARRGGBB)
+ */
+void writeLine(GameFrameBuffer *buffer,
+                int32 x0,
+                int32 y0,
+                int32 x1,
+                int32 y1,
+                uint32 colour);
+
 /**
- * Writes a bitmap into a frame buffer. Supports alpha blending.
+ * Writes an anti-aliased line into the frame buffer (Xiaolin Wu). Each step
+ * along the line blends the colour into the two pixels either side of it, by
+ * how close it passes to each. Clipped up front like writeLine, and in fixed
+ * point throughout so it's just as repeatable.
+ *
+ * @param x0        End points, in 1/256ths of a pixel (WRITE_LINE_SUBPIXEL_BITS).
+ *                  Whole values are pixel centres.
+ * @param colour    Packed colour (0xAARRGGBB). The alpha is ignored, as it
+ *                  is for rectangles.
+ */
+void writeLineSmooth(GameFrameBuffer *buffer,
+                        int32 x0,
+                        int32 y0,
+                        int32 x1,
+                        int32 y1,
+                        uint32 colour);
+
+/**
+ * Packs a Colour into a frame buffer pixel (0xAARRGGBB)
+ */
+uint32 packColour(Colour colour);
+
+// Rectangles of at least this many pixels (half a frame) are written with
+// streaming stores, which go straight to memory rather than through the
+// cache. Anything smaller, such as a renderer tile, is better off cached.
+#define WRITE_RECTANGLE_STREAM_MIN_PIXELS ((FRAME_BUFFER_PIXEL_WIDTH * FRAME_BUFFER_PIXEL_HEIGHT) / 2)
+
+/**
+ * Fills height rows of width pixels with colour. writeRectangle picks the
+ * widest version the CPU supports, or the streaming version for big fills.
+ *
+ * @param row           First pixel of the first row
+ * @param rowStridePx   Pixels from one row to the next. Negative to go up the
+ *                      frame buffer.
+ * @param colour        Packed colour (0xAARRGGBB)
+ */
+#define WRITE_RECTANGLE_ROWS(name) void name(uint32 *row, int32 rowStridePx, uint32 width, uint32 height, uint32 colour)
+typedef WRITE_RECTANGLE_ROWS(WriteRectangleRows);
+
+WRITE_RECTANGLE_ROWS(writeRectangleRowsScalar);
+WRITE_RECTANGLE_ROWS(writeRectangleRowsSSE2);
+WRITE_RECTANGLE_ROWS(writeRectangleRowsAVX2);
+
+// SSE2 non-temporal stores
+WRITE_RECTANGLE_ROWS(writeRectangleRowsStream);
+
+/**
+ * writeRectangle at a whole pixel offset, clipped to the buffer and filled
+ * with a particular row version
+ *
+ * @param writeRectangleRows    NULL to pick as writeRectangle does
+ */
+void writeRectangleIntRows(GameFrameBuffer *buffer,
+                            int32 xOffset,
+                            int32 yOffset,
+                            uint32 width,
+                            uint32 height,
+                            uint32 colour,
+                            WriteRectangleRows *writeRectangleRows);
+
+/**
+ * Writes a bitmap into a frame buffer. Supports alpha blending. A bitmap
+ * drawn at a different size to its own is scaled with writeBitmapAffine.
  *
  * @param buffer        Frame back buffer
  * @param xOffset       x coordinate to start drawing the bitmap from
@@ -53,4 +157,167 @@ void writeBitmap(GameFrameBuffer* buffer,
                     float32 alignYf,
                     BitmapFile bitmapFile);
 
+/**
+ * Alpha blends count premultiplied bitmap pixels over count frame buffer
+ * pixels: source + (dest * (255 - alpha)) / 255 per channel, in integer math.
+ * writeBitmap picks the widest version the CPU supports for each blit. Every
+ * version gives exactly the same result as the scalar one.
+ *
+ * @param pixels        Frame buffer pixels (0xAARRGGBB) to blend over
+ * @param bitmapPixels  Premultiplied bitmap pixels (0xAARRGGBB)
+ * @param count         Number of pixels
+ */
+#define WRITE_BITMAP_ROW(name) void name(uint32 *pixels, const uint32 *bitmapPixels, uint32 count)
+typedef WRITE_BITMAP_ROW(WriteBitmapRow);
+
+WRITE_BITMAP_ROW(writeBitmapRowScalar);
+WRITE_BITMAP_ROW(writeBitmapRowSSE2);
+WRITE_BITMAP_ROW(writeBitmapRowAVX2);
+
+// For BITMAP_FLAG_OPAQUE bitmaps. Copies the pixels.
+WRITE_BITMAP_ROW(writeBitmapRowOpaque);
+
+/**
+ * writeBitmap at the bitmap's own size and a whole pixel offset (alignment
+ * already applied), clipped to the buffer and blended with a particular row
+ * version
+ *
+ * @param writeBitmapRow    NULL to pick as writeBitmap does
+ */
+void writeBitmapRows(GameFrameBuffer *buffer,
+                        int32 xOffset,
+                        int32 yOffset,
+                        BitmapFile *bitmapFile,
+                        WriteBitmapRow *writeBitmapRow);
+
+/**
+ * Writes a bitmap into the frame buffer along two axes, so that it can be
+ * scaled, rotated or sheared. Each pixel whose centre falls inside the bitmap
+ * samples the four texels around it (bilinear) and is alpha blended like
+ * writeBitmap. Texels past the bitmap's edges count as transparent, so the
+ * edges are smoothed too. Only the pixels along each row that the bitmap
+ * covers are visited.
+ *
+ * Drawn at its own size, unrotated and at a whole pixel origin, a bitmap
+ * comes out exactly as writeBitmap would draw it.
+ *
+ * @param origin        Where the bitmap's bottom left corner goes, in pixels
+ *                      from the buffer's bottom left
+ * @param xAxis         The bitmap's bottom edge, from origin. {widthPx, 0}
+ *                      to draw it at its own size.
+ * @param yAxis         The bitmap's left edge, from origin
+ */
+void writeBitmapAffine(GameFrameBuffer *buffer,
+                        Vector2 origin,
+                        Vector2 xAxis,
+                        Vector2 yAxis,
+                        BitmapFile *bitmapFile);
+
+/**
+ * Samples and blends the pixels minX to maxX (exclusive) of one frame buffer
+ * row for writeBitmapAffine. Pixel x samples the bitmap at
+ * (texelX + (x * texelXStep), texelY + (x * texelYStep)), in texels from the
+ * bitmap's bottom left with whole numbers at texel centres. Every version
+ * gives exactly the same result as the scalar one.
+ *
+ * @param row           The row's first pixel (x = 0)
+ */
+#define WRITE_BITMAP_AFFINE_ROW(name) void name(uint32 *row, \
+                                                uint32 minX, \
+                                                uint32 maxX, \
+                                                float32 texelX, \
+                                                float32 texelY, \
+                                                float32 texelXStep, \
+                                                float32 texelYStep, \
+                                                BitmapFile *bitmapFile)
+typedef WRITE_BITMAP_AFFINE_ROW(WriteBitmapAffineRow);
+
+WRITE_BITMAP_AFFINE_ROW(writeBitmapAffineRowScalar);
+WRITE_BITMAP_AFFINE_ROW(writeBitmapAffineRowSSE2);
+WRITE_BITMAP_AFFINE_ROW(writeBitmapAffineRowAVX2);
+
+/**
+ * writeBitmapAffine with a particular row version, rather than the widest the
+ * CPU supports
+ */
+void writeBitmapAffineRows(GameFrameBuffer *buffer,
+                            Vector2 origin,
+                            Vector2 xAxis,
+                            Vector2 yAxis,
+                            BitmapFile *bitmapFile,
+                            WriteBitmapAffineRow *writeBitmapAffineRow);
+
+typedef enum UpscaleFilter
+{
+    // Each pixel copies the source pixel its centre lands in
+    UPSCALE_FILTER_NEAREST,
+
+    // Each pixel blends the four source pixels around its centre
+    UPSCALE_FILTER_BILINEAR,
+} UpscaleFilter;
+
+/**
+ * Scales the whole of one frame buffer to fill another, E.g. to show a frame
+ * drawn at a lower resolution. Pixel centres line up, so the edges of the
+ * source land on the edges of dest. Every version of the row functions gives
+ * exactly the same result as the scalar ones.
+ *
+ * @param scratchRow    Room for one of source's rows. Bilinear only, NULL for
+ *                      nearest.
+ */
+void upscaleFrameBuffer(GameFrameBuffer *dest,
+                        GameFrameBuffer *source,
+                        UpscaleFilter filter,
+                        uint32 *scratchRow);
+
+/**
+ * Fills destWidth pixels from one source row. Pixel x samples the row at
+ * (sourceX + (x * sourceXStep)) / 65536, in source pixels with whole numbers
+ * at pixel centres.
+ */
+#define UPSCALE_ROW(name) void name(uint32 *destRow, \
+                                    const uint32 *sourceRow, \
+                                    uint32 destWidth, \
+                                    uint32 sourceWidth, \
+                                    int32 sourceX, \
+                                    int32 sourceXStep)
+typedef UPSCALE_ROW(UpscaleRow);
+
+UPSCALE_ROW(upscaleRowNearestScalar);
+UPSCALE_ROW(upscaleRowNearestSSE2);
+UPSCALE_ROW(upscaleRowNearestAVX2);
+
+UPSCALE_ROW(upscaleRowBilinearScalar);
+UPSCALE_ROW(upscaleRowBilinearSSE2);
+UPSCALE_ROW(upscaleRowBilinearAVX2);
+
+/**
+ * Blends count pixels of row0 towards row1 by weight (0 to 255), for the
+ * bilinear filter's vertical pass
+ */
+#define UPSCALE_BLEND_ROWS(name) void name(uint32 *destRow, \
+                                            const uint32 *row0, \
+                                            const uint32 *row1, \
+                                            uint32 count, \
+                                            uint32 weight)
+typedef UPSCALE_BLEND_ROWS(UpscaleBlendRows);
+
+UPSCALE_BLEND_ROWS(upscaleBlendRowsScalar);
+UPSCALE_BLEND_ROWS(upscaleBlendRowsSSE2);
+UPSCALE_BLEND_ROWS(upscaleBlendRowsAVX2);
+
+/**
+ * upscaleFrameBuffer with particular row versions, rather than the widest the
+ * CPU supports
+ *
+ * @param upscaleRow    A nearest or bilinear version, for the filter
+ * @param blendRows     Bilinear only, NULL for nearest
+ */
+void upscaleFrameBufferRows(GameFrameBuffer *dest,
+                            GameFrameBuffer *source,
+                            UpscaleFilter filter,
+                            uint32 *scratchRow,
+                            UpscaleRow *upscaleRow,
+                            UpscaleBlendRows *blendRows);
+
 #endif
\ No newline at end of file
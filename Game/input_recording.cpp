@@ -0,0 +1,383 @@
+#include <string.h> // memcpy
+
+#include "input_recording.h"
+
+// Index of the first field of each kind within an InputRecordingFrame
+#define INPUT_RECORDING_FIELD_MOUSE_BUTTONS         0
+#define INPUT_RECORDING_FIELD_CONTROLLER_BUTTONS    6
+
+static_assert(sizeof(InputRecordingFrame) == (INPUT_RECORDING_FIELD_COUNT * sizeof(uint32)),
+                "Every InputRecordingFrame field must be 32 bits wide");
+
+static_assert(INPUT_RECORDING_FIELD_COUNT <= 32,
+                "The changed fields must fit within a 32-bit mask");
+
+internal_func int32 inputRecordingRound(float32 value)
+{
+    return (int32)(value + ((value >= 0.0f) ? 0.5f : -0.5f));
+}
+
+internal_func int32 inputRecordingQuantiseThumbstick(float32 value)
+{
+    if (value > 1.0f) {
+        value = 1.0f;
+    } else if (value < -1.0f) {
+        value = -1.0f;
+    }
+
+    return inputRecordingRound(value * INPUT_RECORDING_THUMBSTICK_SCALE);
+}
+
+/**
+ * Packs endedDown and wasDown into two bits
+ */
+internal_func uint32 inputRecordingPackButton(GameControllerBtnState *button)
+{
+    return ((button->endedDown ? 1 : 0) | (button->wasDown ? 2 : 0));
+}
+
+internal_func void inputRecordingUnpackButton(GameControllerBtnState *button, uint32 bits)
+{
+    button->endedDown = ((bits & 1) != 0);
+    button->wasDown = ((bits & 2) != 0);
+}
+
+/**
+ * The d-pad and the buttons as one array. The buttons union only declares six
+ * elements but has eight named buttons.
+ */
+internal_func GameControllerBtnState *inputRecordingControllerButton(GameControllerInput *controller, uint32 index)
+{
+    if (index < 4) {
+        return &controller->dPadButtons[index];
+    }
+
+    return (&controller->up + (index - 4));
+}
+
+internal_func void inputRecordingFromGameInput(InputRecordingFrame *frame, GameInput *input)
+{
+    frame->mouseButtons = ((input->mouse.isConnected ? 1 : 0)
+                            | (inputRecordingPackButton(&input->mouse.leftClick) << 1)
+                            | (inputRecordingPackButton(&input->mouse.rightClick) << 3));
+    frame->mouseX = input->mouse.position.x;
+    frame->mouseY = input->mouse.position.y;
+
+    frame->msPerFrame = inputRecordingRound(input->msPerFrame * INPUT_RECORDING_TIME_SCALE);
+    frame->fps = inputRecordingRound(input->fps * INPUT_RECORDING_TIME_SCALE);
+    frame->targetFPS = input->targetFPS;
+
+    for (uint32 i = 0; i < MAX_CONTROLLERS; i++) {
+
+        GameControllerInput *controller = &input->controllers[i];
+
+        uint32 buttons = ((controller->isConnected ? 1 : 0) | (controller->isAnalog ? 2 : 0));
+
+        for (uint32 button = 0; button < 12; button++) {
+            buttons |= (inputRecordingPackButton(inputRecordingControllerButton(controller, button)) << (2 + (button * 2)));
+        }
+
+        frame->controllerButtons[i] = buttons;
+
+        frame->thumbsticks[i][0] = inputRecordingQuantiseThumbstick(controller->leftThumbstick.position.x);
+        frame->thumbsticks[i][1] = inputRecordingQuantiseThumbstick(controller->leftThumbstick.position.y);
+        frame->thumbsticks[i][2] = inputRecordingQuantiseThumbstick(controller->rightThumbstick.position.x);
+        frame->thumbsticks[i][3] = inputRecordingQuantiseThumbstick(controller->rightThumbstick.position.y);
+    }
+}
+
+internal_func void inputRecordingToGameInput(GameInput *input, InputRecordingFrame *frame)
+{
+    input->mouse.isConnected = ((frame->mouseButtons & 1) != 0);
+    inputRecordingUnpackButton(&input->mouse.leftClick, (frame->mouseButtons >> 1));
+    inputRecordingUnpackButton(&input->mouse.rightClick, (frame->mouseButtons >> 3));
+    input->mouse.position.x = frame->mouseX;
+    input->mouse.position.y = frame->mouseY;
+
+    input->msPerFrame = ((float32)frame->msPerFrame / INPUT_RECORDING_TIME_SCALE);
+    input->fps = ((float32)frame->fps / INPUT_RECORDING_TIME_SCALE);
+    input->targetFPS = (uint8)frame->targetFPS;
+
+    for (uint32 i = 0; i < MAX_CONTROLLERS; i++) {
+
+        GameControllerInput *controller = &input->controllers[i];
+        uint32 buttons = frame->controllerButtons[i];
+
+        controller->isConnected = ((buttons & 1) != 0);
+        controller->isAnalog = ((buttons & 2) != 0);
+
+        for (uint32 button = 0; button < 12; button++) {
+            inputRecordingUnpackButton(inputRecordingControllerButton(controller, button), (buttons >> (2 + (button * 2))));
+        }
+
+        controller->leftThumbstick.position.x = ((float32)frame->thumbsticks[i][0] / INPUT_RECORDING_THUMBSTICK_SCALE);
+        controller->leftThumbstick.position.y = ((float32)frame->thumbsticks[i][1] / INPUT_RECORDING_THUMBSTICK_SCALE);
+        controller->rightThumbstick.position.x = ((float32)frame->thumbsticks[i][2] / INPUT_RECORDING_THUMBSTICK_SCALE);
+        controller->rightThumbstick.position.y = ((float32)frame->thumbsticks[i][3] / INPUT_RECORDING_THUMBSTICK_SCALE);
+    }
+}
+
+/**
+ * Button fields are XORed with the previous frame. Everything else is stored
+ * as the difference from the previous frame.
+ */
+internal_func bool32 inputRecordingFieldIsBits(uint32 field)
+{
+    return ((INPUT_RECORDING_FIELD_MOUSE_BUTTONS == field)
+            || ((field >= INPUT_RECORDING_FIELD_CONTROLLER_BUTTONS)
+                && (field < (INPUT_RECORDING_FIELD_CONTROLLER_BUTTONS + MAX_CONTROLLERS))));
+}
+
+internal_func sizet inputRecordingWriteVarint(uint8 *out, uint32 value)
+{
+    sizet size = 0;
+
+    while (value >= 0x80) {
+        out[size++] = (uint8)(value | 0x80);
+        value >>= 7;
+    }
+
+    out[size++] = (uint8)value;
+
+    return size;
+}
+
+internal_func bool32 inputRecordingReadVarint(InputRecordingDecoder *decoder, uint32 *value)
+{
+    uint32 result = 0;
+
+    for (uint32 shift = 0; shift < 35; shift += 7) {
+
+        if (decoder->position >= decoder->sizeInBytes) {
+            return false;
+        }
+
+        uint8 byte = decoder->bytes[decoder->position++];
+        result |= ((uint32)(byte & 0x7F) << shift);
+
+        if (0 == (byte & 0x80)) {
+            *value = result;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+internal_func uint32 inputRecordingZigZag(int32 value)
+{
+    return (((uint32)value << 1) ^ (uint32)(value >> 31));
+}
+
+internal_func int32 inputRecordingUnZigZag(uint32 value)
+{
+    return (int32)((value >> 1) ^ (~(value & 1) + 1));
+}
+
+internal_func sizet inputRecordingWriteRepeat(InputRecordingEncoder *encoder, uint8 *out)
+{
+    if (0 == encoder->repeatCount) {
+        return 0;
+    }
+
+    sizet size = 0;
+    out[size++] = INPUT_RECORDING_RECORD_REPEAT;
+    size += inputRecordingWriteVarint((out + size), encoder->repeatCount);
+
+    encoder->repeatCount = 0;
+
+    return size;
+}
+
+void inputRecordingQuantise(GameInput *input)
+{
+    InputRecordingFrame frame = {0};
+    inputRecordingFromGameInput(&frame, input);
+    inputRecordingToGameInput(input, &frame);
+}
+
+sizet inputRecordingWriteHeader(InputRecordingEncoder *encoder, uint8 *out)
+{
+    InputRecordingHeader header = {0};
+    header.magic = INPUT_RECORDING_MAGIC;
+    header.version = INPUT_RECORDING_VERSION;
+    header.maxControllers = MAX_CONTROLLERS;
+
+    memcpy(out, &header, sizeof(header));
+
+    return sizeof(header);
+}
+
+sizet inputRecordingEncodeFrame(InputRecordingEncoder *encoder, GameInput *input, uint8 *out)
+{
+    InputRecordingFrame frame = {0};
+    inputRecordingFromGameInput(&frame, input);
+
+    uint32 *fields = (uint32 *)&frame;
+    uint32 *previousFields = (uint32 *)&encoder->previous;
+
+    uint32 changedMask = 0;
+
+    for (uint32 field = 0; field < INPUT_RECORDING_FIELD_COUNT; field++) {
+        if (fields[field] != previousFields[field]) {
+            changedMask |= (1u << field);
+        }
+    }
+
+    encoder->frameCount++;
+
+    if (0 == changedMask) {
+
+        encoder->repeatCount++;
+
+        if (encoder->repeatCount >= INPUT_RECORDING_MAX_REPEAT) {
+            return inputRecordingWriteRepeat(encoder, out);
+        }
+
+        return 0;
+    }
+
+    // The previous frame's repeats come first
+    sizet size = inputRecordingWriteRepeat(encoder, out);
+
+    out[size++] = INPUT_RECORDING_RECORD_FRAME;
+    size += inputRecordingWriteVarint((out + size), changedMask);
+
+    for (uint32 field = 0; field < INPUT_RECORDING_FIELD_COUNT; field++) {
+
+        if (0 == (changedMask & (1u << field))) {
+            continue;
+        }
+
+        uint32 value;
+
+        if (inputRecordingFieldIsBits(field)) {
+            value = (fields[field] ^ previousFields[field]);
+        } else {
+            value = inputRecordingZigZag((int32)(fields[field] - previousFields[field]));
+        }
+
+        size += inputRecordingWriteVarint((out + size), value);
+    }
+
+    encoder->previous = frame;
+
+    return size;
+}
+
+sizet inputRecordingEncodeFlush(InputRecordingEncoder *encoder, uint8 *out)
+{
+    return inputRecordingWriteRepeat(encoder, out);
+}
+
+bool32 inputRecordingDecoderInit(InputRecordingDecoder *decoder, const uint8 *bytes, sizet sizeInBytes)
+{
+    *decoder = {0};
+
+    if (sizeInBytes < sizeof(InputRecordingHeader)) {
+        return false;
+    }
+
+    InputRecordingHeader header;
+    memcpy(&header, bytes, sizeof(header));
+
+    if ((INPUT_RECORDING_MAGIC != header.magic)
+            || (INPUT_RECORDING_VERSION != header.version)
+            || (MAX_CONTROLLERS != header.maxControllers)) {
+        return false;
+    }
+
+    decoder->bytes = bytes;
+    decoder->sizeInBytes = sizeInBytes;
+    decoder->position = sizeof(InputRecordingHeader);
+
+    return true;
+}
+
+void inputRecordingDecoderRewind(InputRecordingDecoder *decoder)
+{
+    decoder->position = sizeof(InputRecordingHeader);
+    decoder->previous = {0};
+    decoder->repeatsLeft = 0;
+    decoder->frameIndex = 0;
+}
+
+bool32 inputRecordingDecodeFrame(InputRecordingDecoder *decoder, GameInput *input)
+{
+    if (decoder->repeatsLeft) {
+        decoder->repeatsLeft--;
+        decoder->frameIndex++;
+        inputRecordingToGameInput(input, &decoder->previous);
+        return true;
+    }
+
+    if (decoder->position >= decoder->sizeInBytes) {
+        return false;
+    }
+
+    uint8 type = decoder->bytes[decoder->position++];
+
+    if (INPUT_RECORDING_RECORD_REPEAT == type) {
+
+        uint32 repeatCount;
+
+        if (!inputRecordingReadVarint(decoder, &repeatCount) || (0 == repeatCount)) {
+            return false;
+        }
+
+        decoder->repeatsLeft = (repeatCount - 1);
+        decoder->frameIndex++;
+        inputRecordingToGameInput(input, &decoder->previous);
+
+        return true;
+    }
+
+    if (INPUT_RECORDING_RECORD_FRAME != type) {
+        return false;
+    }
+
+    uint32 changedMask;
+
+    if (!inputRecordingReadVarint(decoder, &changedMask)) {
+        return false;
+    }
+
+    uint32 *fields = (uint32 *)&decoder->previous;
+
+    for (uint32 field = 0; field < INPUT_RECORDING_FIELD_COUNT; field++) {
+
+        if (0 == (changedMask & (1u << field))) {
+            continue;
+        }
+
+        uint32 value;
+
+        if (!inputRecordingReadVarint(decoder, &value)) {
+            return false;
+        }
+
+        if (inputRecordingFieldIsBits(field)) {
+            fields[field] ^= value;
+        } else {
+            fields[field] = (uint32)((int32)fields[field] + inputRecordingUnZigZag(value));
+        }
+    }
+
+    decoder->frameIndex++;
+    inputRecordingToGameInput(input, &decoder->previous);
+
+    return true;
+}
+
+uint64 inputRecordingCountFrames(InputRecordingDecoder *decoder)
+{
+    InputRecordingDecoder counter = *decoder;
+    inputRecordingDecoderRewind(&counter);
+
+    GameInput input = {0};
+
+    while (inputRecordingDecodeFrame(&counter, &input)) {
+    }
+
+    return counter.frameIndex;
+}
@@ -0,0 +1,157 @@
+#ifndef HEADER_HH_INPUT_RECORDING
+#define HEADER_HH_INPUT_RECORDING
+
+//
+// Compressed input recordings. Shared by the platform layers
+// ============================================================================
+//
+// A recording is a header followed by a stream of records. Each frame's input
+// is quantised into an InputRecordingFrame and compared to the previous frame.
+// Frames that match the previous one are counted and written as a single
+// repeat record. Frames that don't are written as a bitmask of the fields
+// that changed followed by the changes: button bits XORed with the previous
+// frame's, everything else as a zig-zagged difference. All numbers are
+// variable length (7 bits per byte).
+
+#include "global.h"
+
+// "HMIR" in the first four bytes of the file
+#define INPUT_RECORDING_MAGIC   0x52494d48
+#define INPUT_RECORDING_VERSION 1
+
+#define INPUT_RECORDING_RECORD_FRAME    0x1
+#define INPUT_RECORDING_RECORD_REPEAT   0x2
+
+// Thumbstick positions are stored as signed 16-bit values
+#define INPUT_RECORDING_THUMBSTICK_SCALE 32767.0f
+
+// msPerFrame and fps are stored as fixed point with 10 fractional bits
+#define INPUT_RECORDING_TIME_SCALE 1024.0f
+
+// Flush a run of repeated frames at least this often so that a long idle
+// period isn't held back from the file
+#define INPUT_RECORDING_MAX_REPEAT 0xFFFF
+
+// Two thumbsticks with an X and Y each
+#define INPUT_RECORDING_THUMBSTICK_AXES 4
+
+// The number of fields within an InputRecordingFrame. One bit each in a
+// frame record's changed mask.
+#define INPUT_RECORDING_FIELD_COUNT (6 + MAX_CONTROLLERS + (MAX_CONTROLLERS * INPUT_RECORDING_THUMBSTICK_AXES))
+
+// The largest a single encoded record can be. A type byte, the changed mask
+// and up to 5 bytes per field.
+#define INPUT_RECORDING_MAX_RECORD_BYTES (1 + 5 + (INPUT_RECORDING_FIELD_COUNT * 5))
+
+typedef struct InputRecordingHeader
+{
+    uint32 magic;
+    uint32 version;
+
+    // Recordings are only valid for the same number of controllers
+    uint32 maxControllers;
+    uint32 reserved;
+} InputRecordingHeader;
+
+/**
+ * A GameInput flattened into whole numbers. Every field is 32 bits wide so
+ * that the fields can be encoded by index.
+ */
+typedef struct InputRecordingFrame
+{
+    // Bit 0 isConnected, then endedDown and wasDown for the left and right click
+    uint32 mouseButtons;
+    int32 mouseX;
+    int32 mouseY;
+
+    int32 msPerFrame;
+    int32 fps;
+    uint32 targetFPS;
+
+    // Bit 0 isConnected, bit 1 isAnalog, then endedDown and wasDown for the
+    // four d-pad buttons followed by the eight buttons
+    uint32 controllerButtons[MAX_CONTROLLERS];
+
+    // Left X, left Y, right X, right Y
+    int32 thumbsticks[MAX_CONTROLLERS][INPUT_RECORDING_THUMBSTICK_AXES];
+} InputRecordingFrame;
+
+typedef struct InputRecordingEncoder
+{
+    InputRecordingFrame previous;
+
+    // Frames that matched the previous one and haven't been written yet
+    uint32 repeatCount;
+
+    uint64 frameCount;
+} InputRecordingEncoder;
+
+typedef struct InputRecordingDecoder
+{
+    const uint8 *bytes;
+    sizet sizeInBytes;
+    sizet position;
+
+    InputRecordingFrame previous;
+
+    // Repeats of the previous frame still to be handed out
+    uint32 repeatsLeft;
+
+    uint64 frameIndex;
+} InputRecordingDecoder;
+
+/**
+ * @brief Rounds the parts of a GameInput that are stored with less precision
+ * (thumbsticks, msPerFrame and fps) to what will be read back. Called on the
+ * live input before the game sees it, so that playback is exact.
+ */
+void inputRecordingQuantise(GameInput *input);
+
+/**
+ * @brief Writes the file header. Returns the number of bytes written.
+ */
+sizet inputRecordingWriteHeader(InputRecordingEncoder *encoder, uint8 *out);
+
+/**
+ * @brief Encodes a frame of input. May write nothing if the frame matches the
+ * previous one. out must have room for INPUT_RECORDING_MAX_RECORD_BYTES * 2.
+ *
+ * @return The number of bytes written to out
+ */
+sizet inputRecordingEncodeFrame(InputRecordingEncoder *encoder, GameInput *input, uint8 *out);
+
+/**
+ * @brief Writes out any frames still being counted as repeats. Call before
+ * closing the recording. out must have room for INPUT_RECORDING_MAX_RECORD_BYTES.
+ *
+ * @return The number of bytes written to out
+ */
+sizet inputRecordingEncodeFlush(InputRecordingEncoder *encoder, uint8 *out);
+
+/**
+ * @brief Checks the header and readies the decoder to read the first frame
+ *
+ * @return false if the bytes aren't a recording made with this build
+ */
+bool32 inputRecordingDecoderInit(InputRecordingDecoder *decoder, const uint8 *bytes, sizet sizeInBytes);
+
+/**
+ * @brief Goes back to the first frame
+ */
+void inputRecordingDecoderRewind(InputRecordingDecoder *decoder);
+
+/**
+ * @brief Decodes the next frame into input. Fields that aren't recorded are
+ * left as they are.
+ *
+ * @return false once there are no frames left (or the data is truncated)
+ */
+bool32 inputRecordingDecodeFrame(InputRecordingDecoder *decoder, GameInput *input);
+
+/**
+ * @brief How many frames the recording holds. Decodes the whole recording
+ * without moving the decoder.
+ */
+uint64 inputRecordingCountFrames(InputRecordingDecoder *decoder);
+
+#endif
@@ -83,4 +83,39 @@ bitScanResult intrin_bitScanForward(uint32 mask)
     return result;
 
 #endif
-}
\ No newline at end of file
+}
+
+bool32 intrin_cpuSupportsAVX2()
+{
+    local_persist_var int32 supported = -1;
+
+    if (-1 != supported) {
+        return (bool32)supported;
+    }
+
+#if COMPILER_MSVC
+    int32 cpuInfo[4] = {0};
+
+    __cpuid(cpuInfo, 0);
+
+    supported = 0;
+
+    if (cpuInfo[0] >= 7) {
+
+        __cpuid(cpuInfo, 1);
+
+        // OSXSAVE and AVX. Then XCR0 says whether the OS saves the XMM and
+        // YMM registers on a context switch.
+        bool32 osSavesAVX = ((cpuInfo[2] & (1 << 27)) && (cpuInfo[2] & (1 << 28)) && (0x6 == (_xgetbv(0) & 0x6)));
+
+        __cpuidex(cpuInfo, 7, 0);
+
+        supported = (osSavesAVX && (cpuInfo[1] & (1 << 5))) ? 1 : 0;
+    }
+#else
+    __builtin_cpu_init();
+    supported = (__builtin_cpu_supports("avx2") ? 1 : 0);
+#endif
+
+    return (bool32)supported;
+}
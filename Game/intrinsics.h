@@ -25,4 +25,10 @@ int32 intrin_truncateF32ToI32(float32 val);
 
 bitScanResult intrin_bitScanForward(uint32 mask);
 
+/**
+ * @brief Can AVX2 instructions be used? Checks both the CPU and that the OS
+ * preserves the AVX registers. The answer is cached after the first call.
+ */
+bool32 intrin_cpuSupportsAVX2();
+
 #endif
\ No newline at end of file
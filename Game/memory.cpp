@@ -13,6 +13,22 @@ void memoryRegionReserveBlock(MemoryRegion memoryRegion,
     memoryBlock->totalSizeInBytes       = maximumSizeInBytes;
     memoryBlock->bytesUsed              = 0;
     memoryBlock->bytesFree              = maximumSizeInBytes;
+    memoryBlock->platformCommitMemory   = memoryRegion.platformCommitMemory;
+    memoryBlock->committedEndAddress    = startingAddress;
+    memoryBlock->largePages             = false;
+}
+
+void memoryRegionCommit(MemoryRegion *memoryRegion, void *address, sizet sizeInBytes)
+{
+    if (!memoryRegion->platformCommitMemory) {
+        return;
+    }
+
+    bool32 res = memoryRegion->platformCommitMemory(address, sizeInBytes, false);
+
+    if (!res) {
+        assert(!"Could not commit memory");
+    }
 }
 
 void *memoryBlockReserveType_(MemoryRegion *memoryRegion,
@@ -51,6 +67,22 @@ void *memoryBlockReserveType_(MemoryRegion *memoryRegion,
     // the total available.
     assert(memoryBlock->bytesUsed <= memoryBlock->totalSizeInBytes);
 
+    // Commit any pages the reservation has grown into.
+    uint8 *reservedEndAddress = (memoryBlock->lastAddressReserved + 1);
+
+    if (memoryBlock->platformCommitMemory && (reservedEndAddress > memoryBlock->committedEndAddress)) {
+
+        bool32 res = memoryBlock->platformCommitMemory(memoryBlock->committedEndAddress,
+                                                        (sizet)(reservedEndAddress - memoryBlock->committedEndAddress),
+                                                        memoryBlock->largePages);
+
+        if (!res) {
+            assert(!"Could not commit memory");
+        }
+
+        memoryBlock->committedEndAddress = reservedEndAddress;
+    }
+
     // Update our memory region's meta data
     memoryRegion->bytesUsed = (memoryRegion->bytesUsed + bytesToReserve);
     memoryRegion->bytesFree = (memoryRegion->bytesFree - bytesToReserve);
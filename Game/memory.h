@@ -9,6 +9,19 @@
  * Allocated memory contains Memory Regions. Memory Regions contain Memory Blocks
  */
 
+/**
+ * @brief Requests the platform layer commit (back with physical memory) a range
+ * of a memory region that was only reserved up front. Committing an already
+ * committed range is a no-op.
+ *
+ * @param address       Start of the range
+ * @param sizeInBytes   Size of the range
+ * @param largePages    Prefer 2MiB pages for the range, where the platform supports it
+ * @return false if the memory couldn't be committed
+*/
+#define PLATFORM_COMMIT_MEMORY(name) bool32 name(void *address, sizet sizeInBytes, bool32 largePages)
+typedef PLATFORM_COMMIT_MEMORY(PlatformCommitMemory);
+
 /**
  * Memory Regions are high-level logical sections of the platform layer's memory.
  * E.g. "permanent storage" or "transient storage"
@@ -25,6 +38,11 @@ typedef struct MemoryRegion
     sizet bytesUsed;
     sizet bytesFree;
 
+    // Set by the platform layer if the region's address range was only
+    // reserved. Memory blocks then commit pages as they grow. NULL if the
+    // whole region was committed up front.
+    PlatformCommitMemory *platformCommitMemory;
+
 } MemoryRegion;
 
 /**
@@ -55,6 +73,16 @@ typedef struct MemoryBlock
     // How many bytes used and how many are left free?
     sizet bytesUsed;
     sizet bytesFree;
+
+    // Copied from the memory region. NULL if the memory is already committed.
+    PlatformCommitMemory *platformCommitMemory;
+
+    // Everything below this address has been committed.
+    uint8 *committedEndAddress;
+
+    // Ask the platform to back this block with 2MiB pages. Set for hot blocks
+    // (E.g. tile data) straight after reserving the block.
+    bool8 largePages;
 } MemoryBlock;
 
 /**
@@ -70,6 +98,17 @@ void memoryRegionReserveBlock(MemoryRegion memoryRegion,
                                 uint8 *startingAddress,
                                 sizet maximumSizeInBytes);
 
+/**
+ * Commits a range of a memory region that's used directly rather than through
+ * a memory block. E.g. the GameState at the start of permanent storage.
+ * Does nothing if the region was committed up front.
+ *
+ * @param *memoryRegion     The region the range belongs to
+ * @param *address          Start of the range
+ * @param sizeInBytes       Size of the range
+ */
+void memoryRegionCommit(MemoryRegion *memoryRegion, void *address, sizet sizeInBytes);
+
 /**
  * "Reserves" a region of the MemoryBlock with enough space for a given type
  * by keeping track of the starting address and size of the data type within
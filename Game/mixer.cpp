@@ -0,0 +1,447 @@
+#include "mixer.h"
+#include "intrinsics.h"
+
+#include <emmintrin.h> // SSE2
+#include <immintrin.h> // AVX2
+
+// Adds frameCount mono samples to the stereo accumulator, scaled by each
+// channel's gain
+typedef void MixerSpanFunction(float32 *accumulator, const float32 *samples, uint32 frameCount, float32 gainLeft, float32 gainRight);
+
+// Scales, clamps and rounds frameCount frames of the accumulator to 16-bit
+typedef void MixerConvertFunction(const float32 *accumulator, int16 *samples, uint32 frameCount, float32 scale);
+
+void mixerInit(Mixer *mixer)
+{
+    mixer->masterVolume = 1.0f;
+    mixer->voiceBudget = MIXER_DEFAULT_VOICE_BUDGET;
+    mixer->voicesMixed = 0;
+    mixer->voicesVirtual = 0;
+
+    for (uint32 i = 0; i < MIXER_MAX_VOICES; i++) {
+        mixer->voices[i] = {};
+    }
+}
+
+internal_func MixerVoice *mixerGetVoice(Mixer *mixer, uint32 voiceID)
+{
+    if (MIXER_VOICE_NONE == voiceID) {
+        return NULL;
+    }
+
+    uint32 index = (voiceID & 0xFFFF);
+    uint32 generation = (voiceID >> 16);
+
+    if (index >= MIXER_MAX_VOICES) {
+        return NULL;
+    }
+
+    MixerVoice *voice = &mixer->voices[index];
+
+    // The voice has finished, or been reused for another sound since
+    if (!(voice->flags & MIXER_VOICE_PLAYING) || ((voice->generation & 0xFFFF) != generation)) {
+        return NULL;
+    }
+
+    return voice;
+}
+
+internal_func void mixerVoiceSetGains(MixerVoice *voice, float32 volume, float32 pan)
+{
+    if (pan < -1.0f) {
+        pan = -1.0f;
+    } else if (pan > 1.0f) {
+        pan = 1.0f;
+    }
+
+    voice->volume = volume;
+    voice->pan = pan;
+
+    // Constant power: 0 (hard left) to a quarter turn (hard right)
+    float64 angle = ((((float64)pan + 1.0) * GAME_PI) / 4.0);
+
+    voice->gainLeft = (volume * (float32)intrin_sin(angle + (GAME_PI / 2.0)));
+    voice->gainRight = (volume * (float32)intrin_sin(angle));
+}
+
+uint32 mixerPlay(Mixer *mixer, MixerSound *sound, float32 volume, float32 pan, bool32 looping)
+{
+    assert(sound->sampleCount > 0);
+
+    for (uint32 i = 0; i < MIXER_MAX_VOICES; i++) {
+
+        MixerVoice *voice = &mixer->voices[i];
+
+        if (voice->flags & MIXER_VOICE_PLAYING) {
+            continue;
+        }
+
+        voice->sound = sound;
+        voice->position = 0;
+        voice->flags = (MIXER_VOICE_PLAYING | (looping ? MIXER_VOICE_LOOPING : 0));
+        voice->generation++;
+
+        mixerVoiceSetGains(voice, volume, pan);
+
+        return (((voice->generation & 0xFFFF) << 16) | i);
+    }
+
+    return MIXER_VOICE_NONE;
+}
+
+void mixerStop(Mixer *mixer, uint32 voiceID)
+{
+    MixerVoice *voice = mixerGetVoice(mixer, voiceID);
+
+    if (voice) {
+        voice->flags = 0;
+    }
+}
+
+void mixerSetVolume(Mixer *mixer, uint32 voiceID, float32 volume, float32 pan)
+{
+    MixerVoice *voice = mixerGetVoice(mixer, voiceID);
+
+    if (voice) {
+        mixerVoiceSetGains(voice, volume, pan);
+    }
+}
+
+/**
+ * Moves a voice on without mixing it. Frees one-shot voices that reach the
+ * end of their sound.
+ */
+internal_func void mixerVoiceAdvance(MixerVoice *voice, uint32 frameCount)
+{
+    uint32 sampleCount = voice->sound->sampleCount;
+    uint64 position = ((uint64)voice->position + frameCount);
+
+    if (position < sampleCount) {
+        voice->position = (uint32)position;
+    } else if (voice->flags & MIXER_VOICE_LOOPING) {
+        voice->position = (uint32)(position % sampleCount);
+    } else {
+        voice->flags = 0;
+    }
+}
+
+/**
+ * Fills mixer->mixList with the voices to mix this call, loudest first if
+ * there are more than the budget allows, and advances the rest.
+ *
+ * @return How many voices to mix
+ */
+internal_func uint32 mixerSelectVoices(Mixer *mixer, uint32 sampleCount)
+{
+    uint32 playingCount = 0;
+
+    for (uint32 i = 0; i < MIXER_MAX_VOICES; i++) {
+
+        MixerVoice *voice = &mixer->voices[i];
+
+        if (voice->flags & MIXER_VOICE_PLAYING) {
+            mixer->mixList[playingCount] = i;
+            mixer->mixLoudness[playingCount] = ((voice->gainLeft > voice->gainRight) ? voice->gainLeft : voice->gainRight);
+            playingCount++;
+        }
+    }
+
+    uint32 mixCount = ((playingCount < mixer->voiceBudget) ? playingCount : mixer->voiceBudget);
+
+    if (mixCount < playingCount) {
+
+        // Partition (quickselect) so that the loudest mixCount voices come
+        // first. Their order amongst themselves doesn't matter.
+        uint32 *list = mixer->mixList;
+        float32 *loudness = mixer->mixLoudness;
+
+        uint32 low = 0;
+        uint32 high = (playingCount - 1);
+
+        while (low < high) {
+
+            float32 pivot = loudness[(low + high) / 2];
+            uint32 i = low;
+            uint32 j = high;
+
+            while (i <= j) {
+
+                while (loudness[i] > pivot) {
+                    i++;
+                }
+
+                while (loudness[j] < pivot) {
+                    j--;
+                }
+
+                if (i <= j) {
+
+                    float32 loudnessSwap = loudness[i];
+                    loudness[i] = loudness[j];
+                    loudness[j] = loudnessSwap;
+
+                    uint32 listSwap = list[i];
+                    list[i] = list[j];
+                    list[j] = listSwap;
+
+                    i++;
+
+                    if (0 == j) {
+                        break;
+                    }
+
+                    j--;
+                }
+            }
+
+            if (mixCount <= j) {
+                high = j;
+            } else if (mixCount >= i) {
+                low = i;
+            } else {
+                break;
+            }
+        }
+
+        for (uint32 i = mixCount; i < playingCount; i++) {
+            mixerVoiceAdvance(&mixer->voices[list[i]], sampleCount);
+        }
+    }
+
+    mixer->voicesMixed = mixCount;
+    mixer->voicesVirtual = (playingCount - mixCount);
+
+    return mixCount;
+}
+
+internal_func void mixerMix_(Mixer *mixer,
+                                int16 *samples,
+                                uint32 sampleCount,
+                                MixerSpanFunction *mixSpan,
+                                MixerConvertFunction *convert)
+{
+    uint32 mixCount = mixerSelectVoices(mixer, sampleCount);
+
+    float32 scale = (mixer->masterVolume * 32767.0f);
+
+    for (uint32 chunkStart = 0; chunkStart < sampleCount; chunkStart += MIXER_CHUNK_FRAMES) {
+
+        uint32 chunkFrames = (sampleCount - chunkStart);
+
+        if (chunkFrames > MIXER_CHUNK_FRAMES) {
+            chunkFrames = MIXER_CHUNK_FRAMES;
+        }
+
+        for (uint32 i = 0; i < (chunkFrames * 2); i++) {
+            mixer->accumulator[i] = 0.0f;
+        }
+
+        for (uint32 i = 0; i < mixCount; i++) {
+
+            MixerVoice *voice = &mixer->voices[mixer->mixList[i]];
+
+            // A one-shot that finished in an earlier chunk
+            if (!(voice->flags & MIXER_VOICE_PLAYING)) {
+                continue;
+            }
+
+            MixerSound *sound = voice->sound;
+            uint32 framesMixed = 0;
+
+            // A looping sound shorter than the chunk wraps more than once
+            while (framesMixed < chunkFrames) {
+
+                uint32 spanFrames = (sound->sampleCount - voice->position);
+
+                if (spanFrames > (chunkFrames - framesMixed)) {
+                    spanFrames = (chunkFrames - framesMixed);
+                }
+
+                mixSpan((mixer->accumulator + (framesMixed * 2)),
+                        (sound->samples + voice->position),
+                        spanFrames,
+                        voice->gainLeft,
+                        voice->gainRight);
+
+                framesMixed += spanFrames;
+                voice->position += spanFrames;
+
+                if (voice->position == sound->sampleCount) {
+                    if (voice->flags & MIXER_VOICE_LOOPING) {
+                        voice->position = 0;
+                    } else {
+                        voice->flags = 0;
+                        break;
+                    }
+                }
+            }
+        }
+
+        convert(mixer->accumulator, (samples + (chunkStart * 2)), chunkFrames, scale);
+    }
+}
+
+//
+// Scalar
+//====================================================
+
+internal_func void mixerMixSpanScalar(float32 *accumulator, const float32 *samples, uint32 frameCount, float32 gainLeft, float32 gainRight)
+{
+    for (uint32 i = 0; i < frameCount; i++) {
+        accumulator[(i * 2)] += (samples[i] * gainLeft);
+        accumulator[(i * 2) + 1] += (samples[i] * gainRight);
+    }
+}
+
+internal_func void mixerConvertScalar(const float32 *accumulator, int16 *samples, uint32 frameCount, float32 scale)
+{
+    for (uint32 i = 0; i < (frameCount * 2); i++) {
+
+        float32 value = (accumulator[i] * scale);
+
+        if (value > 32767.0f) {
+            value = 32767.0f;
+        } else if (value < -32768.0f) {
+            value = -32768.0f;
+        }
+
+        samples[i] = (int16)intrin_roundF32ToI32(value);
+    }
+}
+
+void mixerMixScalar(Mixer *mixer, int16 *samples, uint32 sampleCount)
+{
+    mixerMix_(mixer, samples, sampleCount, mixerMixSpanScalar, mixerConvertScalar);
+}
+
+//
+// SSE2
+//====================================================
+
+internal_func void mixerMixSpanSSE2(float32 *accumulator, const float32 *samples, uint32 frameCount, float32 gainLeft, float32 gainRight)
+{
+    uint32 wideCount = (frameCount & ~3u);
+
+    __m128 gains = _mm_setr_ps(gainLeft, gainRight, gainLeft, gainRight);
+
+    for (uint32 i = 0; i < wideCount; i += 4) {
+
+        // 4 mono samples to 2 x (left, right, left, right)
+        __m128 mono = _mm_loadu_ps(samples + i);
+        __m128 low = _mm_unpacklo_ps(mono, mono);
+        __m128 high = _mm_unpackhi_ps(mono, mono);
+
+        float32 *out = (accumulator + (i * 2));
+
+        _mm_storeu_ps(out, _mm_add_ps(_mm_loadu_ps(out), _mm_mul_ps(low, gains)));
+        _mm_storeu_ps((out + 4), _mm_add_ps(_mm_loadu_ps(out + 4), _mm_mul_ps(high, gains)));
+    }
+
+    mixerMixSpanScalar((accumulator + (wideCount * 2)), (samples + wideCount), (frameCount - wideCount), gainLeft, gainRight);
+}
+
+internal_func void mixerConvertSSE2(const float32 *accumulator, int16 *samples, uint32 frameCount, float32 scale)
+{
+    uint32 valueCount = (frameCount * 2);
+    uint32 wideCount = (valueCount & ~7u);
+
+    __m128 scaleWide = _mm_set1_ps(scale);
+    __m128 max = _mm_set1_ps(32767.0f);
+    __m128 min = _mm_set1_ps(-32768.0f);
+
+    for (uint32 i = 0; i < wideCount; i += 8) {
+
+        __m128 a = _mm_mul_ps(_mm_loadu_ps(accumulator + i), scaleWide);
+        __m128 b = _mm_mul_ps(_mm_loadu_ps(accumulator + i + 4), scaleWide);
+
+        // Clamping first keeps anything huge from converting to 0x80000000.
+        // The pack then saturates to 16-bit.
+        a = _mm_max_ps(_mm_min_ps(a, max), min);
+        b = _mm_max_ps(_mm_min_ps(b, max), min);
+
+        _mm_storeu_si128((__m128i *)(samples + i), _mm_packs_epi32(_mm_cvtps_epi32(a), _mm_cvtps_epi32(b)));
+    }
+
+    mixerConvertScalar((accumulator + wideCount), (samples + wideCount), ((valueCount - wideCount) / 2), scale);
+}
+
+void mixerMixSSE2(Mixer *mixer, int16 *samples, uint32 sampleCount)
+{
+    mixerMix_(mixer, samples, sampleCount, mixerMixSpanSSE2, mixerConvertSSE2);
+}
+
+//
+// AVX2
+//====================================================
+
+target_avx2 internal_func void mixerMixSpanAVX2(float32 *accumulator, const float32 *samples, uint32 frameCount, float32 gainLeft, float32 gainRight)
+{
+    uint32 wideCount = (frameCount & ~7u);
+
+    __m256 gains = _mm256_setr_ps(gainLeft, gainRight, gainLeft, gainRight, gainLeft, gainRight, gainLeft, gainRight);
+
+    for (uint32 i = 0; i < wideCount; i += 8) {
+
+        // Unpacking works within each 128-bit lane, giving samples 0, 1, 4, 5
+        // and 2, 3, 6, 7. Swapping the lanes around puts them back in order.
+        __m256 mono = _mm256_loadu_ps(samples + i);
+        __m256 low = _mm256_unpacklo_ps(mono, mono);
+        __m256 high = _mm256_unpackhi_ps(mono, mono);
+
+        __m256 first = _mm256_permute2f128_ps(low, high, 0x20);
+        __m256 second = _mm256_permute2f128_ps(low, high, 0x31);
+
+        float32 *out = (accumulator + (i * 2));
+
+        _mm256_storeu_ps(out, _mm256_add_ps(_mm256_loadu_ps(out), _mm256_mul_ps(first, gains)));
+        _mm256_storeu_ps((out + 8), _mm256_add_ps(_mm256_loadu_ps(out + 8), _mm256_mul_ps(second, gains)));
+    }
+
+    // The rest of the game is built for SSE2. Leaving the upper halves of
+    // the AVX registers dirty makes every SSE instruction after this slower.
+    _mm256_zeroupper();
+
+    mixerMixSpanScalar((accumulator + (wideCount * 2)), (samples + wideCount), (frameCount - wideCount), gainLeft, gainRight);
+}
+
+target_avx2 internal_func void mixerConvertAVX2(const float32 *accumulator, int16 *samples, uint32 frameCount, float32 scale)
+{
+    uint32 valueCount = (frameCount * 2);
+    uint32 wideCount = (valueCount & ~15u);
+
+    __m256 scaleWide = _mm256_set1_ps(scale);
+    __m256 max = _mm256_set1_ps(32767.0f);
+    __m256 min = _mm256_set1_ps(-32768.0f);
+
+    for (uint32 i = 0; i < wideCount; i += 16) {
+
+        __m256 a = _mm256_mul_ps(_mm256_loadu_ps(accumulator + i), scaleWide);
+        __m256 b = _mm256_mul_ps(_mm256_loadu_ps(accumulator + i + 8), scaleWide);
+
+        a = _mm256_max_ps(_mm256_min_ps(a, max), min);
+        b = _mm256_max_ps(_mm256_min_ps(b, max), min);
+
+        // Packing works within each 128-bit lane (a0-3, b0-3, a4-7, b4-7).
+        // Swap the middle two 64-bit quarters to put them back in order.
+        __m256i packed = _mm256_packs_epi32(_mm256_cvtps_epi32(a), _mm256_cvtps_epi32(b));
+        _mm256_storeu_si256((__m256i *)(samples + i), _mm256_permute4x64_epi64(packed, 0xD8));
+    }
+
+    _mm256_zeroupper();
+
+    mixerConvertScalar((accumulator + wideCount), (samples + wideCount), ((valueCount - wideCount) / 2), scale);
+}
+
+void mixerMixAVX2(Mixer *mixer, int16 *samples, uint32 sampleCount)
+{
+    mixerMix_(mixer, samples, sampleCount, mixerMixSpanAVX2, mixerConvertAVX2);
+}
+
+void mixerMix(Mixer *mixer, int16 *samples, uint32 sampleCount)
+{
+    if (intrin_cpuSupportsAVX2()) {
+        mixerMixAVX2(mixer, samples, sampleCount);
+    } else {
+        mixerMixSSE2(mixer, samples, sampleCount);
+    }
+}
@@ -0,0 +1,128 @@
+#ifndef HEADER_HH_MIXER
+#define HEADER_HH_MIXER
+
+#include "global_macros.h"
+#include "types.h"
+
+//
+// Mixer
+//====================================================
+// Plays sounds through a fixed pool of voices. Every voice is added into a
+// stereo float accumulator, which is then scaled, clamped and converted to the
+// platform's interleaved 16-bit samples in a single pass. The accumulator only
+// holds MIXER_CHUNK_FRAMES at a time, so it stays in the L1 cache whilst every
+// voice is added to it.
+//
+// Mixing cost is linear in the number of voices mixed. When more voices are
+// playing than Mixer.voiceBudget allows, only the loudest are mixed. The rest
+// are "virtual": their position moves on as if they were heard, so they come
+// back in the right place once there's room for them again.
+
+#define MIXER_MAX_VOICES 512
+
+// Voices mixed per call unless the game sets Mixer.voiceBudget. A voice costs
+// roughly 0.5us (AVX2) to 1us (SSE2) per 30fps frame of samples (see
+// handmade_benchmark), so a full budget is well under 1% of a 33ms frame.
+#define MIXER_DEFAULT_VOICE_BUDGET 256
+
+// Frames (left + right sample pairs) mixed into the accumulator at a time
+#define MIXER_CHUNK_FRAMES 1024
+
+// Returned by mixerPlay when every voice is in use
+#define MIXER_VOICE_NONE 0xFFFFFFFF
+
+// Voice flags
+#define MIXER_VOICE_PLAYING 0x1
+#define MIXER_VOICE_LOOPING 0x2
+
+/**
+ * Mono samples (-1 to 1) at the platform's sample rate. The mixer doesn't
+ * resample. The samples belong to the game and must outlive any voice
+ * playing them.
+ */
+typedef struct MixerSound
+{
+    float32 *samples;
+    uint32 sampleCount;
+} MixerSound;
+
+typedef struct MixerVoice
+{
+    MixerSound *sound;
+
+    // The next sample of the sound to play
+    uint32 position;
+
+    // MIXER_VOICE_*
+    uint32 flags;
+
+    // Bumped every time the voice is reused so that an old ID can't change
+    // whatever is playing on it now
+    uint32 generation;
+
+    // 0 to 1, and -1 (left) to 1 (right)
+    float32 volume;
+    float32 pan;
+
+    // Volume and pan as the gain for each channel
+    float32 gainLeft;
+    float32 gainRight;
+
+} MixerVoice;
+
+typedef struct Mixer
+{
+    // 0 to 1. Applied as the accumulator is converted.
+    float32 masterVolume;
+
+    // The most voices mixed per call. Any more are virtual.
+    uint32 voiceBudget;
+
+    // How many voices were mixed and how many were virtual, last call
+    uint32 voicesMixed;
+    uint32 voicesVirtual;
+
+    MixerVoice voices[MIXER_MAX_VOICES];
+
+    // Interleaved left + right
+    float32 accumulator[MIXER_CHUNK_FRAMES * 2];
+
+    // Which voices are mixed this call. Scratch for mixerMix.
+    uint32 mixList[MIXER_MAX_VOICES];
+    float32 mixLoudness[MIXER_MAX_VOICES];
+
+} Mixer;
+
+void mixerInit(Mixer *mixer);
+
+/**
+ * @brief Starts a sound playing on a free voice
+ *
+ * @param volume    0 to 1
+ * @param pan       -1 (left) to 1 (right). Constant power, so a centred
+ *                  sound is 3dB quieter in each channel.
+ * @param looping   Play from the start again when the end is reached, rather
+ *                  than freeing the voice
+ * @return          An ID for mixerStop/mixerSetVolume. MIXER_VOICE_NONE if
+ *                  every voice is in use.
+ */
+uint32 mixerPlay(Mixer *mixer, MixerSound *sound, float32 volume, float32 pan, bool32 looping);
+
+void mixerStop(Mixer *mixer, uint32 voiceID);
+
+void mixerSetVolume(Mixer *mixer, uint32 voiceID, float32 volume, float32 pan);
+
+/**
+ * @brief Mixes every playing voice into sampleCount stereo samples and
+ * advances them. Uses the widest instruction set the CPU supports.
+ *
+ * @param samples   Interleaved left + right 16-bit samples. sampleCount * 2 values.
+ */
+void mixerMix(Mixer *mixer, int16 *samples, uint32 sampleCount);
+
+// The implementations mixerMix picks between. Exposed for benchmarking.
+void mixerMixScalar(Mixer *mixer, int16 *samples, uint32 sampleCount);
+void mixerMixSSE2(Mixer *mixer, int16 *samples, uint32 sampleCount);
+void mixerMixAVX2(Mixer *mixer, int16 *samples, uint32 sampleCount);
+
+#endif
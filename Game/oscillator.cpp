@@ -0,0 +1,277 @@
+#include "oscillator.h"
+#include "intrinsics.h"
+
+#include <emmintrin.h> // SSE2
+#include <immintrin.h> // AVX2
+
+// The bits of the phase below the table index. Interpolated between entries.
+#define OSCILLATOR_PHASE_FRACTION_BITS (32 - OSCILLATOR_WAVETABLE_LENGTH_BIT_SHIFT)
+#define OSCILLATOR_PHASE_FRACTION_MASK ((1u << OSCILLATOR_PHASE_FRACTION_BITS) - 1)
+#define OSCILLATOR_PHASE_FRACTION_SCALE (1.0f / (float32)(1u << OSCILLATOR_PHASE_FRACTION_BITS))
+
+void oscillatorBuildWavetables(OscillatorWavetables *wavetables, uint32 samplesPerSecond)
+{
+    wavetables->samplesPerSecond = samplesPerSecond;
+
+    // Every harmonic's value at every entry is a lookup into the one sine
+    // table: sin(n * theta) is entry (n * i) of it.
+    float32 *sine = wavetables->samples[OSCILLATOR_WAVEFORM_SINE][0];
+
+    for (uint32 i = 0; i < OSCILLATOR_WAVETABLE_LENGTH; i++) {
+        sine[i] = (float32)intrin_sin(((2.0 * GAME_PI) * (float64)i) / (float64)OSCILLATOR_WAVETABLE_LENGTH);
+    }
+
+    sine[OSCILLATOR_WAVETABLE_LENGTH] = sine[0];
+
+    float32 nyquistHz = ((float32)samplesPerSecond / 2.0f);
+
+    for (uint32 level = 0; level < OSCILLATOR_WAVETABLE_LEVELS; level++) {
+
+        // A sine wave has no harmonics. Every level is the same table.
+        if (level > 0) {
+            float32 *sineLevel = wavetables->samples[OSCILLATOR_WAVEFORM_SINE][level];
+            for (uint32 i = 0; i <= OSCILLATOR_WAVETABLE_LENGTH; i++) {
+                sineLevel[i] = sine[i];
+            }
+        }
+
+        // The highest note this level plays and so how many harmonics fit
+        // beneath the Nyquist frequency. The table can hold at most half its
+        // length.
+        float32 highestHz = (OSCILLATOR_WAVETABLE_LOWEST_HZ * (float32)(2u << level));
+        uint32 harmonics = (uint32)(nyquistHz / highestHz);
+
+        if (harmonics > ((OSCILLATOR_WAVETABLE_LENGTH / 2) - 1)) {
+            harmonics = ((OSCILLATOR_WAVETABLE_LENGTH / 2) - 1);
+        }
+
+        if (harmonics < 1) {
+            harmonics = 1;
+        }
+
+        // Each harmonic's amplitude (1/n), tapered by the Lanczos sigma factor
+        // to tame the ringing (Gibbs) at the wave's edges
+        float64 harmonicWeights[OSCILLATOR_WAVETABLE_LENGTH / 2];
+
+        for (uint32 n = 1; n <= harmonics; n++) {
+            float64 x = ((GAME_PI * (float64)n) / (float64)(harmonics + 1));
+            harmonicWeights[n] = ((intrin_sin(x) / x) / (float64)n);
+        }
+
+        float32 *square = wavetables->samples[OSCILLATOR_WAVEFORM_SQUARE][level];
+        float32 *saw = wavetables->samples[OSCILLATOR_WAVEFORM_SAW][level];
+
+        float32 squarePeak = 0.0f;
+        float32 sawPeak = 0.0f;
+
+        for (uint32 i = 0; i < OSCILLATOR_WAVETABLE_LENGTH; i++) {
+
+            float64 squareSum = 0.0;
+            float64 sawSum = 0.0;
+
+            for (uint32 n = 1; n <= harmonics; n++) {
+
+                float64 harmonic = (harmonicWeights[n] * (float64)sine[(n * i) & (OSCILLATOR_WAVETABLE_LENGTH - 1)]);
+
+                // Square: odd harmonics only. Saw: every harmonic, alternating sign.
+                if (n & 1) {
+                    squareSum += harmonic;
+                    sawSum += harmonic;
+                } else {
+                    sawSum -= harmonic;
+                }
+            }
+
+            square[i] = (float32)squareSum;
+            saw[i] = (float32)sawSum;
+
+            float32 squareAbs = ((square[i] < 0.0f) ? -square[i] : square[i]);
+            float32 sawAbs = ((saw[i] < 0.0f) ? -saw[i] : saw[i]);
+
+            squarePeak = ((squareAbs > squarePeak) ? squareAbs : squarePeak);
+            sawPeak = ((sawAbs > sawPeak) ? sawAbs : sawPeak);
+        }
+
+        // Normalise to -1 to 1 so every waveform and level is as loud
+        for (uint32 i = 0; i < OSCILLATOR_WAVETABLE_LENGTH; i++) {
+            square[i] = (square[i] / squarePeak);
+            saw[i] = (saw[i] / sawPeak);
+        }
+
+        square[OSCILLATOR_WAVETABLE_LENGTH] = square[0];
+        saw[OSCILLATOR_WAVETABLE_LENGTH] = saw[0];
+    }
+}
+
+void oscillatorSet(Oscillator *oscillator,
+                    OscillatorWavetables *wavetables,
+                    uint32 waveform,
+                    float32 hertz,
+                    float32 volume)
+{
+    assert(waveform < OSCILLATOR_WAVEFORM_COUNT);
+    assert(wavetables->samplesPerSecond > 0);
+
+    if (volume > 32767.0f) {
+        volume = 32767.0f;
+    }
+
+    oscillator->waveform = waveform;
+    oscillator->hertz = hertz;
+    oscillator->volume = volume;
+
+    oscillator->phaseIncrement = (uint32)(((float64)hertz / (float64)wavetables->samplesPerSecond) * 4294967296.0);
+
+    // The lowest level whose highest note is at or above this one
+    uint32 level = 0;
+
+    while ((level < (OSCILLATOR_WAVETABLE_LEVELS - 1))
+            && (hertz > (OSCILLATOR_WAVETABLE_LOWEST_HZ * (float32)(2u << level)))) {
+        level++;
+    }
+
+    oscillator->level = level;
+}
+
+void oscillatorWrite(Oscillator *oscillator,
+                        OscillatorWavetables *wavetables,
+                        int16 *samples,
+                        uint32 sampleCount)
+{
+    if (intrin_cpuSupportsAVX2()) {
+        oscillatorWriteAVX2(oscillator, wavetables, samples, sampleCount);
+    } else {
+        oscillatorWriteSSE2(oscillator, wavetables, samples, sampleCount);
+    }
+}
+
+void oscillatorWriteFloat(Oscillator *oscillator,
+                            OscillatorWavetables *wavetables,
+                            float32 *samples,
+                            uint32 sampleCount)
+{
+    const float32 *table = wavetables->samples[oscillator->waveform][oscillator->level];
+
+    float32 volume = (oscillator->volume / 32767.0f);
+    uint32 phase = oscillator->phase;
+
+    for (uint32 i = 0; i < sampleCount; i++) {
+
+        uint32 index = (phase >> OSCILLATOR_PHASE_FRACTION_BITS);
+        float32 fraction = ((float32)(phase & OSCILLATOR_PHASE_FRACTION_MASK) * OSCILLATOR_PHASE_FRACTION_SCALE);
+
+        samples[i] = ((table[index] + ((table[index + 1] - table[index]) * fraction)) * volume);
+
+        phase += oscillator->phaseIncrement;
+    }
+
+    oscillator->phase = phase;
+}
+
+void oscillatorWriteScalar(Oscillator *oscillator, OscillatorWavetables *wavetables, int16 *samples, uint32 sampleCount)
+{
+    const float32 *table = wavetables->samples[oscillator->waveform][oscillator->level];
+
+    uint32 phase = oscillator->phase;
+
+    for (uint32 i = 0; i < sampleCount; i++) {
+
+        uint32 index = (phase >> OSCILLATOR_PHASE_FRACTION_BITS);
+        float32 fraction = ((float32)(phase & OSCILLATOR_PHASE_FRACTION_MASK) * OSCILLATOR_PHASE_FRACTION_SCALE);
+
+        float32 value = (table[index] + ((table[index + 1] - table[index]) * fraction));
+
+        int16 sample = (int16)intrin_roundF32ToI32(value * oscillator->volume);
+
+        // Left + right channel
+        *samples++ = sample;
+        *samples++ = sample;
+
+        phase += oscillator->phaseIncrement;
+    }
+
+    oscillator->phase = phase;
+}
+
+void oscillatorWriteSSE2(Oscillator *oscillator, OscillatorWavetables *wavetables, int16 *samples, uint32 sampleCount)
+{
+    const float32 *table = wavetables->samples[oscillator->waveform][oscillator->level];
+
+    uint32 phaseIncrement = oscillator->phaseIncrement;
+    uint32 wideCount = (sampleCount & ~3u);
+
+    __m128i phases = _mm_add_epi32(_mm_set1_epi32((int32)oscillator->phase),
+                                    _mm_set_epi32((int32)(phaseIncrement * 3), (int32)(phaseIncrement * 2), (int32)phaseIncrement, 0));
+    __m128i phaseStep = _mm_set1_epi32((int32)(phaseIncrement * 4));
+    __m128i fractionMask = _mm_set1_epi32((int32)OSCILLATOR_PHASE_FRACTION_MASK);
+    __m128 fractionScale = _mm_set1_ps(OSCILLATOR_PHASE_FRACTION_SCALE);
+    __m128 volume = _mm_set1_ps(oscillator->volume);
+
+    alignas(16) uint32 indexes[4];
+
+    for (uint32 i = 0; i < wideCount; i += 4) {
+
+        // SSE2 has no gather. Look each entry up separately.
+        _mm_store_si128((__m128i *)indexes, _mm_srli_epi32(phases, OSCILLATOR_PHASE_FRACTION_BITS));
+
+        __m128 a = _mm_set_ps(table[indexes[3]], table[indexes[2]], table[indexes[1]], table[indexes[0]]);
+        __m128 b = _mm_set_ps(table[indexes[3] + 1], table[indexes[2] + 1], table[indexes[1] + 1], table[indexes[0] + 1]);
+
+        __m128 fraction = _mm_mul_ps(_mm_cvtepi32_ps(_mm_and_si128(phases, fractionMask)), fractionScale);
+        __m128 value = _mm_mul_ps(_mm_add_ps(a, _mm_mul_ps(_mm_sub_ps(b, a), fraction)), volume);
+
+        // 4 x int16, then each one duplicated for the left and right channel
+        __m128i packed = _mm_packs_epi32(_mm_cvtps_epi32(value), _mm_cvtps_epi32(value));
+        _mm_storeu_si128((__m128i *)samples, _mm_unpacklo_epi16(packed, packed));
+
+        samples += 8;
+        phases = _mm_add_epi32(phases, phaseStep);
+    }
+
+    oscillator->phase += (wideCount * phaseIncrement);
+
+    oscillatorWriteScalar(oscillator, wavetables, samples, (sampleCount - wideCount));
+}
+
+target_avx2 void oscillatorWriteAVX2(Oscillator *oscillator, OscillatorWavetables *wavetables, int16 *samples, uint32 sampleCount)
+{
+    const float32 *table = wavetables->samples[oscillator->waveform][oscillator->level];
+
+    uint32 phaseIncrement = oscillator->phaseIncrement;
+    uint32 wideCount = (sampleCount & ~7u);
+
+    __m256i phases = _mm256_add_epi32(_mm256_set1_epi32((int32)oscillator->phase),
+                                        _mm256_mullo_epi32(_mm256_set1_epi32((int32)phaseIncrement), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7)));
+    __m256i phaseStep = _mm256_set1_epi32((int32)(phaseIncrement * 8));
+    __m256i fractionMask = _mm256_set1_epi32((int32)OSCILLATOR_PHASE_FRACTION_MASK);
+    __m256 fractionScale = _mm256_set1_ps(OSCILLATOR_PHASE_FRACTION_SCALE);
+    __m256 volume = _mm256_set1_ps(oscillator->volume);
+
+    for (uint32 i = 0; i < wideCount; i += 8) {
+
+        __m256i indexes = _mm256_srli_epi32(phases, OSCILLATOR_PHASE_FRACTION_BITS);
+
+        __m256 a = _mm256_i32gather_ps(table, indexes, 4);
+        __m256 b = _mm256_i32gather_ps((table + 1), indexes, 4);
+
+        __m256 fraction = _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_and_si256(phases, fractionMask)), fractionScale);
+        __m256 value = _mm256_mul_ps(_mm256_add_ps(a, _mm256_mul_ps(_mm256_sub_ps(b, a), fraction)), volume);
+
+        // Packing and unpacking work within each 128-bit lane, so samples
+        // 0-3 end up duplicated in the low lane and 4-7 in the high lane. Which
+        // is already the order they're stored in.
+        __m256i packed = _mm256_packs_epi32(_mm256_cvtps_epi32(value), _mm256_cvtps_epi32(value));
+        _mm256_storeu_si256((__m256i *)samples, _mm256_unpacklo_epi16(packed, packed));
+
+        samples += 16;
+        phases = _mm256_add_epi32(phases, phaseStep);
+    }
+
+    // The rest of the game is built for SSE2. Leaving the upper halves of
+    // the AVX registers dirty makes every SSE instruction after this slower.
+    _mm256_zeroupper();
+
+    oscillator->phase += (wideCount * phaseIncrement);
+
+    oscillatorWriteScalar(oscillator, wavetables, samples, (sampleCount - wideCount));
+}
@@ -0,0 +1,112 @@
+#ifndef HEADER_HH_OSCILLATOR
+#define HEADER_HH_OSCILLATOR
+
+#include "global_macros.h"
+#include "types.h"
+
+//
+// Oscillator
+//====================================================
+// A phase accumulator stepping through precomputed wavetables. The phase is
+// a 32-bit fraction of a cycle that simply wraps, so the wave carries on from
+// where it left off every frame. The top OSCILLATOR_WAVETABLE_LENGTH_BIT_SHIFT
+// bits of the phase index the table and the rest interpolate between entries.
+//
+// Square and saw waves are built from their harmonics (additive synthesis) so
+// that nothing is above the Nyquist frequency, which would otherwise alias.
+// Higher notes have room for fewer harmonics, so each waveform has a table
+// per octave (level) and an oscillator reads the level for its frequency.
+
+#define OSCILLATOR_WAVETABLE_LENGTH_BIT_SHIFT 11
+#define OSCILLATOR_WAVETABLE_LENGTH (1 << OSCILLATOR_WAVETABLE_LENGTH_BIT_SHIFT)
+
+// Level 0 holds fundamentals up to 2 * OSCILLATOR_WAVETABLE_LOWEST_HZ. Each
+// level above covers the next octave up, with half as many harmonics.
+#define OSCILLATOR_WAVETABLE_LEVELS 10
+#define OSCILLATOR_WAVETABLE_LOWEST_HZ 20.0f
+
+// Waveforms
+#define OSCILLATOR_WAVEFORM_SINE    0
+#define OSCILLATOR_WAVEFORM_SQUARE  1
+#define OSCILLATOR_WAVEFORM_SAW     2
+#define OSCILLATOR_WAVEFORM_COUNT   3
+
+typedef struct OscillatorWavetables
+{
+    // The sample rate the tables were band limited for. 0 until built.
+    uint32 samplesPerSecond;
+
+    // -1 to 1. One extra entry at the end of each table (a copy of the first)
+    // so interpolation never has to wrap.
+    float32 samples[OSCILLATOR_WAVEFORM_COUNT][OSCILLATOR_WAVETABLE_LEVELS][OSCILLATOR_WAVETABLE_LENGTH + 1];
+
+} OscillatorWavetables;
+
+typedef struct Oscillator
+{
+    uint32 waveform;
+
+    // Hertz is the same as "cycles per second". E.g. 256 = middle C.
+    float32 hertz;
+
+    // Peak amplitude in 16-bit sample units
+    float32 volume;
+
+    // How far through the current cycle. Wraps at 2^32.
+    uint32 phase;
+
+    // Added to the phase for every sample. (hertz / samplesPerSecond) * 2^32
+    uint32 phaseIncrement;
+
+    // Which of the waveform's tables to read for this frequency
+    uint32 level;
+
+} Oscillator;
+
+/**
+ * @brief Builds every waveform's tables, band limited for samplesPerSecond
+ *
+ * @param wavetables        Tables to fill
+ * @param samplesPerSecond  Platform audio sample rate
+ */
+void oscillatorBuildWavetables(OscillatorWavetables *wavetables, uint32 samplesPerSecond);
+
+/**
+ * @brief Sets an oscillator's waveform, frequency and volume. The phase is
+ * left as is so a change of note doesn't click.
+ */
+void oscillatorSet(Oscillator *oscillator,
+                    OscillatorWavetables *wavetables,
+                    uint32 waveform,
+                    float32 hertz,
+                    float32 volume);
+
+/**
+ * @brief Writes sampleCount stereo samples (the same value to the left and
+ * right channel) and advances the phase. Uses the widest instruction set the
+ * CPU supports.
+ *
+ * @param samples   Interleaved left + right 16-bit samples. sampleCount * 2 values.
+ */
+void oscillatorWrite(Oscillator *oscillator,
+                        OscillatorWavetables *wavetables,
+                        int16 *samples,
+                        uint32 sampleCount);
+
+/**
+ * @brief Writes sampleCount mono float samples and advances the phase. For
+ * baking a waveform into a sound (E.g. a MixerSound). Samples are scaled to
+ * -1 to 1 at full (32767) volume.
+ */
+void oscillatorWriteFloat(Oscillator *oscillator,
+                            OscillatorWavetables *wavetables,
+                            float32 *samples,
+                            uint32 sampleCount);
+
+// The implementations oscillatorWrite picks between. Exposed for benchmarking.
+// The SIMD versions hand any remainder to the scalar version.
+void oscillatorWriteScalar(Oscillator *oscillator, OscillatorWavetables *wavetables, int16 *samples, uint32 sampleCount);
+void oscillatorWriteSSE2(Oscillator *oscillator, OscillatorWavetables *wavetables, int16 *samples, uint32 sampleCount);
+void oscillatorWriteAVX2(Oscillator *oscillator, OscillatorWavetables *wavetables, int16 *samples, uint32 sampleCount);
+
+#endif
@@ -6,7 +6,8 @@ void playerHandleMovement(GameState *gameState,
                             GameFrameBuffer *frameBuffer,
                             GameAudioBuffer *audioBuffer,
                             GameInput *gameInput,
-                            uint8 selectedController)
+                            uint8 selectedController,
+                            float32 secondsElapsed)
 {
     GameControllerInput controller = gameInput->controllers[selectedController];
 
@@ -14,29 +15,11 @@ void playerHandleMovement(GameState *gameState,
 
     bool playerAttemptingMove = false;
 
-    // Normalise pixel movement regardless of framerate
-    // @NOTE(JM) The truncated fractions cause issues with different framerates.
-    // Not sure how to resolve at this point.
+    // Called once per fixed simulation step, so the distance covered is the
+    // same whatever the frame rate. Fractions of a pixel are kept in the
+    // player's (float) position rather than truncated away.
     float32 pixelsPerSecond = (gameState->world.pixelsPerMeter * gameState->player1.movementSpeedMPS);
-    float32 pixelsPerFrame = (pixelsPerSecond / gameInput->fps);
-
-    // Any movement to take?
-    if (pixelsPerFrame < 1.0f){
-        return;
-    }
-
-    {
-        char buff[400] = {};
-        memory->DEBUG_platformLog(buff, sizeof(buff),
-            "MS per frame: %f. \
-FPS: %f. \
-Pixels per second: %f. \
-Pixels per frame: %f\n",
-gameInput->msPerFrame,
-gameInput->fps,
-pixelsPerSecond,
-pixelsPerFrame);
-    }
+    float32 pixelsPerStep = (pixelsPerSecond * secondsElapsed);
 
     struct Vector2 playerNewPosTmp = {0};
     playerNewPosTmp.x = gameState->player1.absolutePosition.x;
@@ -49,26 +32,26 @@ pixelsPerFrame);
         // by if they're moving diagonally. The square root of 0.5 is approximately
         // 0.70710678118. 
         float32 sqrtOfHalf = 0.70710678118f;
-        pixelsPerFrame = (pixelsPerFrame * sqrtOfHalf);
+        pixelsPerStep = (pixelsPerStep * sqrtOfHalf);
     }
 
     if (controller.dPadLeft.endedDown) {
         playerAttemptingMove = true;
-        playerNewPosTmp.x += (int32)(pixelsPerFrame * -1.0f);
+        playerNewPosTmp.x += (pixelsPerStep * -1.0f);
         gameState->player1.currentBitmapIndex = 3;
     }else if (controller.dPadRight.endedDown) {
         playerAttemptingMove = true;
-        playerNewPosTmp.x += (int32)pixelsPerFrame;
+        playerNewPosTmp.x += pixelsPerStep;
         gameState->player1.currentBitmapIndex = 1;
     }
 
     if (controller.dPadUp.endedDown) {
         playerAttemptingMove = true;
-        playerNewPosTmp.y += (int32)pixelsPerFrame;
+        playerNewPosTmp.y += pixelsPerStep;
         gameState->player1.currentBitmapIndex = 0;
     }else if (controller.dPadDown.endedDown) {
         playerAttemptingMove = true;
-        playerNewPosTmp.y += (int32)(pixelsPerFrame * -1.0f);
+        playerNewPosTmp.y += (pixelsPerStep * -1.0f);
         gameState->player1.currentBitmapIndex = 2;
     }
 
@@ -77,17 +60,17 @@ pixelsPerFrame);
         if (controller.leftThumbstick.position.x) {
             playerAttemptingMove = true;
             if (controller.leftThumbstick.position.x >= 0.0f) {
-                playerNewPosTmp.x += (int32)pixelsPerFrame;
+                playerNewPosTmp.x += pixelsPerStep;
             }else{
-                playerNewPosTmp.x += (int32)(pixelsPerFrame * -1.0f);
+                playerNewPosTmp.x += (pixelsPerStep * -1.0f);
             }
         }else if (controller.leftThumbstick.position.y) {
             playerAttemptingMove = true;
             if (controller.leftThumbstick.position.y >= 0.0f) {
-                playerNewPosTmp.y += (int32)(pixelsPerFrame * -1.0f);
+                playerNewPosTmp.y += (pixelsPerStep * -1.0f);
             }
             else {
-                playerNewPosTmp.y += (int32)pixelsPerFrame;
+                playerNewPosTmp.y += pixelsPerStep;
             }
         }
     }
@@ -198,7 +181,7 @@ gameState->player1.gamePosition.y);
                 setCameraPosition(gameState, frameBuffer);
 
                 if (switchedTile){
-                    switch(*gameState->worldPosition.activeTile){
+                    switch(gameState->worldPosition.activeTile){
                         case 5:
                             ++gameState->player1.zIndex;
                             break;
@@ -284,6 +267,43 @@ gameState->worldPosition.tileRelativePixelPos.x, gameState->worldPosition.tileRe
 
 }
 
+/**
+ * Where to draw the player from this frame. Blends the previous simulation
+ * step's absolute position with the current one by the game state's
+ * interpolation alpha. Snaps to the current position if the player has
+ * changed z-plane or wrapped around the toroidal world between the steps.
+ *
+ * @param gameState
+ * @return
+*/
+struct Vector2 getPlayerInterpolatedPosition(GameState *gameState)
+{
+    Player *player = &gameState->player1;
+
+    struct Vector2 current = player->absolutePosition;
+    struct Vector2 previous = player->previousAbsolutePosition;
+
+    float32 deltaX = (current.x - previous.x);
+    float32 deltaY = (current.y - previous.y);
+
+    float32 halfWorldWidth = ((float32)gameState->world.worldWidthPx / 2.0f);
+    float32 halfWorldHeight = ((float32)gameState->world.worldHeightPx / 2.0f);
+
+    if ((player->previousZIndex != player->zIndex)
+        || (deltaX > halfWorldWidth) || (deltaX < -halfWorldWidth)
+        || (deltaY > halfWorldHeight) || (deltaY < -halfWorldHeight)) {
+        return current;
+    }
+
+    float32 alpha = gameState->simInterpolationAlpha;
+
+    struct Vector2 position = {0};
+    position.x = (previous.x + (deltaX * alpha));
+    position.y = (previous.y + (deltaY * alpha));
+
+    return position;
+}
+
 /**
  * The absolute player position within the game state is the absolute
  * position where we start drawing the player from (bottom left). It's not
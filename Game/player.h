@@ -40,6 +40,11 @@ typedef struct Player {
     // Which tilemap z-plane is the player on?
     uint32 zIndex;
 
+    // The absolute position and z-plane as of the previous simulation step.
+    // Drawing interpolates from here to absolutePosition.
+    struct Vector2 previousAbsolutePosition;
+    uint32 previousZIndex;
+
     // The fixed position that we draw the player from if the game scroll type
     // is set to screen scrolling
     struct Vector2 fixedPosition;
@@ -121,7 +126,10 @@ void playerHandleMovement(GameState *gameState,
                             GameFrameBuffer *frameBuffer,
                             GameAudioBuffer *audioBuffer,
                             GameInput *gameInput,
-                            uint8 selectedController);
+                            uint8 selectedController,
+                            float32 secondsElapsed);
+
+struct Vector2 getPlayerInterpolatedPosition(GameState *gameState);
 
 internal_func bool playerHasSwitchedActiveTile(GameState *gameState);
 
@@ -0,0 +1,907 @@
+#include "renderer.h"
+#include "graphics.h"
+#include "intrinsics.h"
+#include "memory.h"
+
+// Commands are packed back to back. Keeping each one a multiple of this keeps
+// the pointers in the next one aligned.
+#define RENDER_COMMAND_ALIGNMENT 8
+
+void renderGroupInit(RenderGroup *group,
+                        MemoryRegion *memoryRegion,
+                        MemoryBlock *memoryBlock,
+                        uint32 pushBufferSize,
+                        uint32 maxCommands,
+                        uint32 maxTiles)
+{
+    assert((pushBufferSize % RENDER_COMMAND_ALIGNMENT) == 0);
+
+    group->pushBuffer = memoryBlockReserveArray(memoryRegion, memoryBlock, uint8, pushBufferSize);
+    group->pushBufferSize = pushBufferSize;
+
+    group->maxCommands = maxCommands;
+    group->sortEntries = memoryBlockReserveArray(memoryRegion, memoryBlock, RenderSortEntry, maxCommands);
+    group->sortScratch = memoryBlockReserveArray(memoryRegion, memoryBlock, RenderSortEntry, maxCommands);
+    group->entries = memoryBlockReserveArray(memoryRegion, memoryBlock, RenderEntry, maxCommands);
+
+    group->maxTiles = maxTiles;
+    group->tiles = memoryBlockReserveArray(memoryRegion, memoryBlock, RenderTile, maxTiles);
+
+    renderGroupClear(group);
+}
+
+void renderGroupClear(RenderGroup *group)
+{
+    group->pushBufferUsed = 0;
+    group->commandCount = 0;
+    group->entryCount = 0;
+    group->commandsDropped = 0;
+    group->rectanglesMerged = 0;
+    group->scaleX = 1.0f;
+    group->scaleY = 1.0f;
+}
+
+/**
+ * Reserves room for a command in the push buffer and gives it a sort entry.
+ * Returns NULL if the group is full.
+ */
+internal_func void *renderGroupPushCommand(RenderGroup *group,
+                                            uint8 layer,
+                                            RenderCommandType type,
+                                            uint32 size)
+{
+    size = ((size + (RENDER_COMMAND_ALIGNMENT - 1)) & ~(uint32)(RENDER_COMMAND_ALIGNMENT - 1));
+
+    if ((group->commandCount >= group->maxCommands)
+            || (size > (group->pushBufferSize - group->pushBufferUsed))) {
+        group->commandsDropped++;
+        return NULL;
+    }
+
+    RenderSortEntry *sortEntry = &group->sortEntries[group->commandCount++];
+    sortEntry->key = (((uint32)layer << 8) | (uint32)type);
+    sortEntry->offset = group->pushBufferUsed;
+
+    RenderCommandHeader *header = (RenderCommandHeader *)(group->pushBuffer + group->pushBufferUsed);
+    header->type = type;
+
+    group->pushBufferUsed = (group->pushBufferUsed + size);
+
+    return header;
+}
+
+/**
+ * Commands are kept in int32 pixels. Anything further off screen than that
+ * can't be seen anyway.
+ */
+internal_func int32 renderClampToInt32(int64 value)
+{
+    if (value > (int64)0x7FFFFFFF) {
+        return 0x7FFFFFFF;
+    }
+
+    if (value < -(int64)0x7FFFFFFF) {
+        return -0x7FFFFFFF;
+    }
+
+    return (int32)value;
+}
+
+void renderGroupPushClear(RenderGroup *group, uint32 colour)
+{
+    // Layer 0 and the first material, so it sorts before everything else
+    RenderCommandClear *command = (RenderCommandClear *)renderGroupPushCommand(group,
+                                                                                0,
+                                                                                RENDER_COMMAND_CLEAR,
+                                                                                sizeof(RenderCommandClear));
+
+    if (!command) {
+        return;
+    }
+
+    command->colour = colour;
+}
+
+void renderGroupPushRectangle(RenderGroup *group,
+                                uint8 layer,
+                                float32 xOffsetf,
+                                float32 yOffsetf,
+                                uint32 width,
+                                uint32 height,
+                                uint32 colour)
+{
+    if (!width || !height) {
+        return;
+    }
+
+    RenderCommandRectangle *command = (RenderCommandRectangle *)renderGroupPushCommand(group,
+                                                                                        layer,
+                                                                                        RENDER_COMMAND_RECTANGLE,
+                                                                                        sizeof(RenderCommandRectangle));
+
+    if (!command) {
+        return;
+    }
+
+    int32 xOffset = intrin_roundF32ToI32(xOffsetf);
+    int32 yOffset = intrin_roundF32ToI32(yOffsetf);
+
+    command->minX = xOffset;
+    command->minY = yOffset;
+    command->maxX = renderClampToInt32((int64)xOffset + width);
+    command->maxY = renderClampToInt32((int64)yOffset + height);
+    command->colour = colour;
+}
+
+void renderGroupPushBitmap(RenderGroup *group,
+                            uint8 layer,
+                            float32 xOffsetf,
+                            float32 yOffsetf,
+                            float32 widthf,
+                            float32 heightf,
+                            float32 alignXf,
+                            float32 alignYf,
+                            BitmapFile *bitmap)
+{
+    assert(widthf >= 1.0f);
+    assert(heightf >= 1.0f);
+
+    if (bitmap->flags & BITMAP_FLAG_TRANSPARENT) {
+        return;
+    }
+
+    RenderCommandBitmap *command = (RenderCommandBitmap *)renderGroupPushCommand(group,
+                                                                                    layer,
+                                                                                    RENDER_COMMAND_BITMAP,
+                                                                                    sizeof(RenderCommandBitmap));
+
+    if (!command) {
+        return;
+    }
+
+    // Rounded the same way as writeBitmap, so that drawing the command at its
+    // rounded position puts every pixel in the same place
+    int32 xOffset = (intrin_roundF32ToI32(xOffsetf) + intrin_roundF32ToI32(alignXf));
+    int32 yOffset = (intrin_roundF32ToI32(yOffsetf) + intrin_roundF32ToI32(alignYf));
+
+    command->minX = xOffset;
+    command->minY = yOffset;
+    command->maxX = (xOffset + intrin_roundF32ToI32(widthf));
+    command->maxY = (yOffset + intrin_roundF32ToI32(heightf));
+    command->bitmap = bitmap;
+}
+
+/**
+ * Rounds a pixel coordinate down, clamped to what the renderer's bounds can
+ * hold
+ */
+internal_func int32 renderFloorToInt32(float32 value)
+{
+    if (value > (float32)0x40000000) {
+        return 0x40000000;
+    }
+
+    if (value < -(float32)0x40000000) {
+        return -0x40000000;
+    }
+
+    return intrin_floorF32ToI32(value);
+}
+
+void renderGroupPushBitmapAffine(RenderGroup *group,
+                                    uint8 layer,
+                                    Vector2 origin,
+                                    Vector2 xAxis,
+                                    Vector2 yAxis,
+                                    BitmapFile *bitmap)
+{
+    if (bitmap->flags & BITMAP_FLAG_TRANSPARENT) {
+        return;
+    }
+
+    RenderCommandBitmapAffine *command = (RenderCommandBitmapAffine *)renderGroupPushCommand(group,
+                                                                                                layer,
+                                                                                                RENDER_COMMAND_BITMAP_AFFINE,
+                                                                                                sizeof(RenderCommandBitmapAffine));
+
+    if (!command) {
+        return;
+    }
+
+    float32 minX = origin.x;
+    float32 minY = origin.y;
+    float32 maxX = origin.x;
+    float32 maxY = origin.y;
+
+    Vector2 corners[3] = {xAxis, yAxis, {(xAxis.x + yAxis.x), (xAxis.y + yAxis.y)}};
+
+    for (uint32 i = 0; i < 3; i++) {
+        float32 cornerX = (origin.x + corners[i].x);
+        float32 cornerY = (origin.y + corners[i].y);
+        minX = ((cornerX < minX) ? cornerX : minX);
+        minY = ((cornerY < minY) ? cornerY : minY);
+        maxX = ((cornerX > maxX) ? cornerX : maxX);
+        maxY = ((cornerY > maxY) ? cornerY : maxY);
+    }
+
+    command->minX = renderFloorToInt32(minX);
+    command->minY = renderFloorToInt32(minY);
+    command->maxX = (renderFloorToInt32(maxX) + 1);
+    command->maxY = (renderFloorToInt32(maxY) + 1);
+    command->origin = origin;
+    command->xAxis = xAxis;
+    command->yAxis = yAxis;
+    command->bitmap = bitmap;
+}
+
+void renderGroupPushLine(RenderGroup *group,
+                            uint8 layer,
+                            int32 x0,
+                            int32 y0,
+                            int32 x1,
+                            int32 y1,
+                            uint32 colour)
+{
+    // Tiles draw the line relative to themselves, which must stay within
+    // writeLine's limits
+    assert((x0 > -(WRITE_LINE_MAX_COORDINATE / 2)) && (x0 < (WRITE_LINE_MAX_COORDINATE / 2)));
+    assert((y0 > -(WRITE_LINE_MAX_COORDINATE / 2)) && (y0 < (WRITE_LINE_MAX_COORDINATE / 2)));
+    assert((x1 > -(WRITE_LINE_MAX_COORDINATE / 2)) && (x1 < (WRITE_LINE_MAX_COORDINATE / 2)));
+    assert((y1 > -(WRITE_LINE_MAX_COORDINATE / 2)) && (y1 < (WRITE_LINE_MAX_COORDINATE / 2)));
+
+    RenderCommandLine *command = (RenderCommandLine *)renderGroupPushCommand(group,
+                                                                                layer,
+                                                                                RENDER_COMMAND_LINE,
+                                                                                sizeof(RenderCommandLine));
+
+    if (!command) {
+        return;
+    }
+
+    command->from.x = x0;
+    command->from.y = y0;
+    command->to.x = x1;
+    command->to.y = y1;
+    command->colour = colour;
+}
+
+/**
+ * Pushes one segment of a polyline. Hard lines are rounded to whole pixels,
+ * smooth lines to subpixels.
+ */
+internal_func void renderGroupPushSegment(RenderGroup *group,
+                                            uint8 layer,
+                                            Vector2 from,
+                                            Vector2 to,
+                                            uint32 colour,
+                                            bool32 smooth)
+{
+    if (!smooth) {
+        renderGroupPushLine(group,
+                            layer,
+                            intrin_roundF32ToI32(from.x),
+                            intrin_roundF32ToI32(from.y),
+                            intrin_roundF32ToI32(to.x),
+                            intrin_roundF32ToI32(to.y),
+                            colour);
+        return;
+    }
+
+    float32 subpixels = (float32)(1 << WRITE_LINE_SUBPIXEL_BITS);
+
+    int32 x0 = intrin_roundF32ToI32(from.x * subpixels);
+    int32 y0 = intrin_roundF32ToI32(from.y * subpixels);
+    int32 x1 = intrin_roundF32ToI32(to.x * subpixels);
+    int32 y1 = intrin_roundF32ToI32(to.y * subpixels);
+
+    assert((x0 > -(WRITE_LINE_MAX_COORDINATE / 2)) && (x0 < (WRITE_LINE_MAX_COORDINATE / 2)));
+    assert((y0 > -(WRITE_LINE_MAX_COORDINATE / 2)) && (y0 < (WRITE_LINE_MAX_COORDINATE / 2)));
+    assert((x1 > -(WRITE_LINE_MAX_COORDINATE / 2)) && (x1 < (WRITE_LINE_MAX_COORDINATE / 2)));
+    assert((y1 > -(WRITE_LINE_MAX_COORDINATE / 2)) && (y1 < (WRITE_LINE_MAX_COORDINATE / 2)));
+
+    RenderCommandLine *command = (RenderCommandLine *)renderGroupPushCommand(group,
+                                                                                layer,
+                                                                                RENDER_COMMAND_LINE_SMOOTH,
+                                                                                sizeof(RenderCommandLine));
+
+    if (!command) {
+        return;
+    }
+
+    command->from.x = x0;
+    command->from.y = y0;
+    command->to.x = x1;
+    command->to.y = y1;
+    command->colour = colour;
+}
+
+void renderGroupPushPolyline(RenderGroup *group,
+                                uint8 layer,
+                                Vector2 *points,
+                                uint32 pointCount,
+                                uint32 colour,
+                                bool32 smooth)
+{
+    for (uint32 i = 1; i < pointCount; i++) {
+        renderGroupPushSegment(group, layer, points[i - 1], points[i], colour, smooth);
+    }
+}
+
+void renderGroupPushArrow(RenderGroup *group,
+                            uint8 layer,
+                            Vector2 from,
+                            Vector2 to,
+                            float32 headLengthPx,
+                            uint32 colour,
+                            bool32 smooth)
+{
+    renderGroupPushSegment(group, layer, from, to, colour, smooth);
+
+    Vector2 direction = {(to.x - from.x), (to.y - from.y)};
+    float32 length = getVectorMagnitude(direction);
+
+    if (length <= 0.0f) {
+        return;
+    }
+
+    // Back along the line and out either side, at half the head's length
+    Vector2 back = {((direction.x / length) * headLengthPx), ((direction.y / length) * headLengthPx)};
+    Vector2 side = {(back.y * -0.5f), (back.x * 0.5f)};
+
+    Vector2 head[3] = {
+        {(to.x - back.x + side.x), (to.y - back.y + side.y)},
+        to,
+        {(to.x - back.x - side.x), (to.y - back.y - side.y)},
+    };
+
+    renderGroupPushPolyline(group, layer, head, countArray(head), colour, smooth);
+}
+
+/**
+ * Radix sorts the sort entries on their keys, a byte at a time. Each pass is
+ * stable, so commands with the same key stay in the order they were pushed.
+ * Keys are 16 bits, so after the two passes the result is back in
+ * sortEntries.
+ */
+internal_func void renderGroupSort(RenderGroup *group)
+{
+    RenderSortEntry *source = group->sortEntries;
+    RenderSortEntry *dest = group->sortScratch;
+
+    for (uint32 shift = 0; shift < 16; shift += 8) {
+
+        uint32 offsets[256] = {};
+
+        for (uint32 i = 0; i < group->commandCount; i++) {
+            offsets[((source[i].key >> shift) & 0xFF)]++;
+        }
+
+        // Counts to where each byte value starts
+        uint32 total = 0;
+
+        for (uint32 i = 0; i < countArray(offsets); i++) {
+            uint32 count = offsets[i];
+            offsets[i] = total;
+            total = (total + count);
+        }
+
+        for (uint32 i = 0; i < group->commandCount; i++) {
+            dest[offsets[((source[i].key >> shift) & 0xFF)]++] = source[i];
+        }
+
+        RenderSortEntry *swap = source;
+        source = dest;
+        dest = swap;
+    }
+}
+
+/**
+ * A pixel edge (E.g. a rectangle's min or max), scaled and rounded to the
+ * nearest edge. Edges shared by two commands still line up once scaled.
+ */
+internal_func int32 renderScaleEdge(int32 value, float32 scale)
+{
+    return renderFloorToInt32(((float32)value * scale) + 0.5f);
+}
+
+/**
+ * A pixel, scaled to the pixel its centre lands in
+ */
+internal_func int32 renderScalePixel(int32 value, float32 scale)
+{
+    return renderFloorToInt32(((float32)value + 0.5f) * scale);
+}
+
+/**
+ * A position in subpixels (WRITE_LINE_SUBPIXEL_BITS), where whole pixels are
+ * pixel centres
+ */
+internal_func int32 renderScaleSubpixel(int32 value, float32 scale)
+{
+    float32 half = (float32)(1 << (WRITE_LINE_SUBPIXEL_BITS - 1));
+
+    return renderFloorToInt32((((float32)value + half) * scale) - half + 0.5f);
+}
+
+/**
+ * Turns the sorted commands into entries for the tiles to draw. Skips
+ * anything entirely off the frame buffer and merges a rectangle into the one
+ * drawn just before it when they're the same colour and share an edge, as
+ * they'd fill exactly the same pixels either way.
+ */
+internal_func void renderGroupResolve(RenderGroup *group, GameFrameBuffer *frameBuffer)
+{
+    group->entryCount = 0;
+    group->rectanglesMerged = 0;
+
+    float32 scaleX = group->scaleX;
+    float32 scaleY = group->scaleY;
+    bool32 scaled = ((scaleX != 1.0f) || (scaleY != 1.0f));
+
+    RenderEntry *previous = NULL;
+
+    for (uint32 i = 0; i < group->commandCount; i++) {
+
+        RenderCommandHeader *header = (RenderCommandHeader *)(group->pushBuffer + group->sortEntries[i].offset);
+        RenderEntry *entry = &group->entries[group->entryCount];
+
+        entry->type = header->type;
+        entry->colour = 0;
+        entry->bitmap = NULL;
+
+        switch (header->type) {
+        case RENDER_COMMAND_CLEAR: {
+            RenderCommandClear *command = (RenderCommandClear *)header;
+            entry->minX = 0;
+            entry->minY = 0;
+            entry->maxX = (int32)frameBuffer->widthPx;
+            entry->maxY = (int32)frameBuffer->heightPx;
+            entry->colour = command->colour;
+        } break;
+
+        case RENDER_COMMAND_RECTANGLE: {
+            RenderCommandRectangle *command = (RenderCommandRectangle *)header;
+
+            int32 minX = command->minX;
+            int32 minY = command->minY;
+            int32 maxX = command->maxX;
+            int32 maxY = command->maxY;
+
+            if (scaled) {
+                minX = renderScaleEdge(minX, scaleX);
+                minY = renderScaleEdge(minY, scaleY);
+                maxX = renderScaleEdge(maxX, scaleX);
+                maxY = renderScaleEdge(maxY, scaleY);
+
+                // Too small to cover a pixel's centre at this scale
+                if ((minX >= maxX) || (minY >= maxY)) {
+                    continue;
+                }
+            }
+
+            if (previous
+                    && (previous->type == RENDER_COMMAND_RECTANGLE)
+                    && (previous->colour == command->colour)) {
+
+                // Side by side
+                if ((previous->minY == minY)
+                        && (previous->maxY == maxY)
+                        && (previous->maxX == minX)) {
+                    previous->maxX = maxX;
+                    group->rectanglesMerged++;
+                    continue;
+                }
+
+                // One on top of the other
+                if ((previous->minX == minX)
+                        && (previous->maxX == maxX)
+                        && (previous->maxY == minY)) {
+                    previous->maxY = maxY;
+                    group->rectanglesMerged++;
+                    continue;
+                }
+            }
+
+            entry->minX = minX;
+            entry->minY = minY;
+            entry->maxX = maxX;
+            entry->maxY = maxY;
+            entry->colour = command->colour;
+        } break;
+
+        case RENDER_COMMAND_BITMAP: {
+            RenderCommandBitmap *command = (RenderCommandBitmap *)header;
+            entry->minX = command->minX;
+            entry->minY = command->minY;
+            entry->maxX = command->maxX;
+            entry->maxY = command->maxY;
+            entry->bitmap = command->bitmap;
+
+            // The bitmap no longer maps one texel to one pixel, so it's
+            // filtered onto its scaled bounds
+            if (scaled) {
+                entry->type = RENDER_COMMAND_BITMAP_AFFINE;
+                entry->origin = {((float32)command->minX * scaleX), ((float32)command->minY * scaleY)};
+                entry->xAxis = {((float32)(command->maxX - command->minX) * scaleX), 0.0f};
+                entry->yAxis = {0.0f, ((float32)(command->maxY - command->minY) * scaleY)};
+                entry->minX = renderFloorToInt32(entry->origin.x);
+                entry->minY = renderFloorToInt32(entry->origin.y);
+                entry->maxX = (renderFloorToInt32(entry->origin.x + entry->xAxis.x) + 1);
+                entry->maxY = (renderFloorToInt32(entry->origin.y + entry->yAxis.y) + 1);
+            }
+        } break;
+
+        case RENDER_COMMAND_BITMAP_AFFINE: {
+            RenderCommandBitmapAffine *command = (RenderCommandBitmapAffine *)header;
+            entry->minX = command->minX;
+            entry->minY = command->minY;
+            entry->maxX = command->maxX;
+            entry->maxY = command->maxY;
+            entry->bitmap = command->bitmap;
+            entry->origin = command->origin;
+            entry->xAxis = command->xAxis;
+            entry->yAxis = command->yAxis;
+
+            if (scaled) {
+                entry->minX = renderFloorToInt32((float32)command->minX * scaleX);
+                entry->minY = renderFloorToInt32((float32)command->minY * scaleY);
+                entry->maxX = (renderFloorToInt32((float32)command->maxX * scaleX) + 1);
+                entry->maxY = (renderFloorToInt32((float32)command->maxY * scaleY) + 1);
+                entry->origin = {(command->origin.x * scaleX), (command->origin.y * scaleY)};
+                entry->xAxis = {(command->xAxis.x * scaleX), (command->xAxis.y * scaleY)};
+                entry->yAxis = {(command->yAxis.x * scaleX), (command->yAxis.y * scaleY)};
+            }
+        } break;
+
+        case RENDER_COMMAND_LINE: {
+            RenderCommandLine *command = (RenderCommandLine *)header;
+
+            xyint from = command->from;
+            xyint to = command->to;
+
+            if (scaled) {
+                from = {renderScalePixel(from.x, scaleX), renderScalePixel(from.y, scaleY)};
+                to = {renderScalePixel(to.x, scaleX), renderScalePixel(to.y, scaleY)};
+            }
+
+            entry->minX = ((from.x < to.x) ? from.x : to.x);
+            entry->minY = ((from.y < to.y) ? from.y : to.y);
+            entry->maxX = (((from.x > to.x) ? from.x : to.x) + 1);
+            entry->maxY = (((from.y > to.y) ? from.y : to.y) + 1);
+            entry->colour = command->colour;
+            entry->from = from;
+            entry->to = to;
+        } break;
+
+        case RENDER_COMMAND_LINE_SMOOTH: {
+            RenderCommandLine *command = (RenderCommandLine *)header;
+
+            xyint from = command->from;
+            xyint to = command->to;
+
+            if (scaled) {
+                from = {renderScaleSubpixel(from.x, scaleX), renderScaleSubpixel(from.y, scaleY)};
+                to = {renderScaleSubpixel(to.x, scaleX), renderScaleSubpixel(to.y, scaleY)};
+            }
+
+            // The pixels either side of the line, rounded out
+            int32 minX = ((from.x < to.x) ? from.x : to.x);
+            int32 minY = ((from.y < to.y) ? from.y : to.y);
+            int32 maxX = ((from.x > to.x) ? from.x : to.x);
+            int32 maxY = ((from.y > to.y) ? from.y : to.y);
+
+            entry->minX = ((minX >> WRITE_LINE_SUBPIXEL_BITS) - 1);
+            entry->minY = ((minY >> WRITE_LINE_SUBPIXEL_BITS) - 1);
+            entry->maxX = ((maxX >> WRITE_LINE_SUBPIXEL_BITS) + 2);
+            entry->maxY = ((maxY >> WRITE_LINE_SUBPIXEL_BITS) + 2);
+            entry->colour = command->colour;
+            entry->from = from;
+            entry->to = to;
+        } break;
+        }
+
+        if ((entry->maxX <= 0)
+                || (entry->minX >= (int32)frameBuffer->widthPx)
+                || (entry->maxY <= 0)
+                || (entry->minY >= (int32)frameBuffer->heightPx)) {
+            continue;
+        }
+
+        previous = entry;
+        group->entryCount++;
+    }
+}
+
+/**
+ * Draws every entry overlapping a tile into a frame buffer that covers just
+ * the tile's pixels. The drawing functions clip to it like they would to the
+ * whole frame.
+ */
+internal_func PLATFORM_WORK_QUEUE_CALLBACK(renderTile)
+{
+    RenderTile *tile = (RenderTile *)data;
+    RenderGroup *group = tile->group;
+    GameFrameBuffer *frameBuffer = tile->frameBuffer;
+
+    // Same rows, fewer of them and narrower. Memory points at the tile's top
+    // left pixel, as frame buffer rows are stored top down.
+    GameFrameBuffer tileBuffer = *frameBuffer;
+    tileBuffer.widthPx = (uint32)(tile->maxX - tile->minX);
+    tileBuffer.heightPx = (uint32)(tile->maxY - tile->minY);
+    tileBuffer.memory = ((uint8 *)frameBuffer->memory
+                            + ((sizet)frameBuffer->byteWidthPerRow * (frameBuffer->heightPx - (uint32)tile->maxY))
+                            + ((sizet)tile->minX * frameBuffer->bytesPerPixel));
+
+    for (uint32 i = 0; i < group->entryCount; i++) {
+
+        RenderEntry *entry = &group->entries[i];
+
+        if ((entry->maxX <= tile->minX)
+                || (entry->minX >= tile->maxX)
+                || (entry->maxY <= tile->minY)
+                || (entry->minY >= tile->maxY)) {
+            continue;
+        }
+
+        // Relative to the tile. Whole pixels, so nothing is rounded again.
+        int32 x = (entry->minX - tile->minX);
+        int32 y = (entry->minY - tile->minY);
+        uint32 width = (uint32)(entry->maxX - entry->minX);
+        uint32 height = (uint32)(entry->maxY - entry->minY);
+
+        switch (entry->type) {
+        case RENDER_COMMAND_CLEAR:
+        case RENDER_COMMAND_RECTANGLE:
+            writeRectangleInt(&tileBuffer, x, y, width, height, entry->colour);
+            break;
+
+        case RENDER_COMMAND_BITMAP:
+            writeBitmap(&tileBuffer,
+                        (float32)x,
+                        (float32)y,
+                        (float32)width,
+                        (float32)height,
+                        0.0f,
+                        0.0f,
+                        *entry->bitmap);
+            break;
+
+        case RENDER_COMMAND_BITMAP_AFFINE: {
+            // Relative to the tile. The samples can round a fraction of a
+            // texel differently to drawing the bitmap over the whole frame
+            // buffer at once, but the tiles are the same whichever thread
+            // draws them.
+            Vector2 origin = {(entry->origin.x - (float32)tile->minX), (entry->origin.y - (float32)tile->minY)};
+
+            writeBitmapAffine(&tileBuffer, origin, entry->xAxis, entry->yAxis, entry->bitmap);
+        } break;
+
+        case RENDER_COMMAND_LINE:
+            // Moved whole pixels, so the same pixels are stepped on
+            writeLine(&tileBuffer,
+                        (entry->from.x - tile->minX),
+                        (entry->from.y - tile->minY),
+                        (entry->to.x - tile->minX),
+                        (entry->to.y - tile->minY),
+                        entry->colour);
+            break;
+
+        case RENDER_COMMAND_LINE_SMOOTH: {
+            // Moved whole pixels too, so nothing's rounded differently
+            int32 tileX = (tile->minX * (1 << WRITE_LINE_SUBPIXEL_BITS));
+            int32 tileY = (tile->minY * (1 << WRITE_LINE_SUBPIXEL_BITS));
+
+            writeLineSmooth(&tileBuffer,
+                            (entry->from.x - tileX),
+                            (entry->from.y - tileY),
+                            (entry->to.x - tileX),
+                            (entry->to.y - tileY),
+                            entry->colour);
+        } break;
+        }
+    }
+}
+
+/**
+ * Whether any of the region's rectangles overlap the tile
+ */
+internal_func bool32 renderDirtyRegionOverlaps(FrameBufferDirtyRegion *region, RenderTile *tile)
+{
+    if (region->all) {
+        return true;
+    }
+
+    for (uint32 i = 0; i < region->rectCount; i++) {
+
+        FrameBufferRect *rect = &region->rects[i];
+
+        if ((rect->maxX > tile->minX)
+                && (rect->minX < tile->maxX)
+                && (rect->maxY > tile->minY)
+                && (rect->minY < tile->maxY)) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void renderGroupExecute(PlatformThreadContext *thread,
+                        RenderGroup *group,
+                        GameFrameBuffer *frameBuffer,
+                        FrameBufferDirtyRegion *redrawRegion,
+                        PlatformWorkQueue *queue,
+                        PlatformAddWorkQueueEntry *addWorkQueueEntry,
+                        PlatformCompleteAllWork *completeAllWork)
+{
+    uint32 tileCount = renderTileCount(frameBuffer->widthPx, frameBuffer->heightPx);
+
+    assert(tileCount <= group->maxTiles);
+
+    if (tileCount > group->maxTiles) {
+        return;
+    }
+
+    renderGroupSort(group);
+    renderGroupResolve(group, frameBuffer);
+
+    uint32 tileIndex = 0;
+
+    for (uint32 y = 0; y < frameBuffer->heightPx; y += RENDER_TILE_SIZE_PX) {
+        for (uint32 x = 0; x < frameBuffer->widthPx; x += RENDER_TILE_SIZE_PX) {
+
+            RenderTile *tile = &group->tiles[tileIndex++];
+
+            // Tiles along the right and top edges may be cut short
+            uint32 maxX = (x + RENDER_TILE_SIZE_PX);
+            uint32 maxY = (y + RENDER_TILE_SIZE_PX);
+
+            if (maxX > frameBuffer->widthPx) {
+                maxX = frameBuffer->widthPx;
+            }
+
+            if (maxY > frameBuffer->heightPx) {
+                maxY = frameBuffer->heightPx;
+            }
+
+            tile->group = group;
+            tile->frameBuffer = frameBuffer;
+            tile->minX = (int32)x;
+            tile->minY = (int32)y;
+            tile->maxX = (int32)maxX;
+            tile->maxY = (int32)maxY;
+
+            if (redrawRegion && !renderDirtyRegionOverlaps(redrawRegion, tile)) {
+                continue;
+            }
+
+            if (queue) {
+                addWorkQueueEntry(queue, renderTile, tile);
+            } else {
+                renderTile(thread, tile);
+            }
+        }
+    }
+
+    if (queue) {
+        completeAllWork(thread, queue);
+    }
+}
+
+void renderDirtyRegionClear(FrameBufferDirtyRegion *region)
+{
+    region->all = false;
+    region->rectCount = 0;
+}
+
+void renderDirtyRegionAddAll(FrameBufferDirtyRegion *region)
+{
+    region->all = true;
+    region->rectCount = 0;
+}
+
+void renderDirtyRegionAddRect(FrameBufferDirtyRegion *region,
+                                GameFrameBuffer *frameBuffer,
+                                int64 minX,
+                                int64 minY,
+                                int64 maxX,
+                                int64 maxY)
+{
+    if (region->all) {
+        return;
+    }
+
+    if (minX < 0) {
+        minX = 0;
+    }
+
+    if (minY < 0) {
+        minY = 0;
+    }
+
+    if (maxX > (int64)frameBuffer->widthPx) {
+        maxX = (int64)frameBuffer->widthPx;
+    }
+
+    if (maxY > (int64)frameBuffer->heightPx) {
+        maxY = (int64)frameBuffer->heightPx;
+    }
+
+    if ((minX >= maxX) || (minY >= maxY)) {
+        return;
+    }
+
+    FrameBufferRect newRect = {(int32)minX, (int32)minY, (int32)maxX, (int32)maxY};
+
+    // Already covered (E.g. a sprite that hasn't moved)
+    for (uint32 i = 0; i < region->rectCount; i++) {
+
+        FrameBufferRect *rect = &region->rects[i];
+
+        if ((rect->minX <= newRect.minX)
+                && (rect->minY <= newRect.minY)
+                && (rect->maxX >= newRect.maxX)
+                && (rect->maxY >= newRect.maxY)) {
+            return;
+        }
+    }
+
+    if (region->rectCount < FRAME_BUFFER_MAX_DIRTY_RECTS) {
+        region->rects[region->rectCount++] = newRect;
+        return;
+    }
+
+    // Full. Merge into whichever rectangle's area grows the least.
+    FrameBufferRect *bestRect = NULL;
+    FrameBufferRect bestMerged = {};
+    int64 bestGrowth = 0;
+
+    for (uint32 i = 0; i < region->rectCount; i++) {
+
+        FrameBufferRect *rect = &region->rects[i];
+
+        FrameBufferRect merged = *rect;
+
+        if (newRect.minX < merged.minX) {
+            merged.minX = newRect.minX;
+        }
+
+        if (newRect.minY < merged.minY) {
+            merged.minY = newRect.minY;
+        }
+
+        if (newRect.maxX > merged.maxX) {
+            merged.maxX = newRect.maxX;
+        }
+
+        if (newRect.maxY > merged.maxY) {
+            merged.maxY = newRect.maxY;
+        }
+
+        int64 growth = (((int64)(merged.maxX - merged.minX) * (int64)(merged.maxY - merged.minY))
+                            - ((int64)(rect->maxX - rect->minX) * (int64)(rect->maxY - rect->minY)));
+
+        if (!bestRect || (growth < bestGrowth)) {
+            bestRect = rect;
+            bestMerged = merged;
+            bestGrowth = growth;
+        }
+    }
+
+    *bestRect = bestMerged;
+}
+
+void renderDirtyRegionAddRegion(FrameBufferDirtyRegion *region,
+                                GameFrameBuffer *frameBuffer,
+                                FrameBufferDirtyRegion *other)
+{
+    if (other->all) {
+        renderDirtyRegionAddAll(region);
+        return;
+    }
+
+    for (uint32 i = 0; i < other->rectCount; i++) {
+        FrameBufferRect *rect = &other->rects[i];
+        renderDirtyRegionAddRect(region, frameBuffer, rect->minX, rect->minY, rect->maxX, rect->maxY);
+    }
+}
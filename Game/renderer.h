@@ -0,0 +1,384 @@
+#ifndef HEADER_HH_RENDERER
+#define HEADER_HH_RENDERER
+
+#include "global.h"
+#include "math.h"
+
+//
+// Renderer
+//====================================================
+// Rather than drawing straight into the frame buffer, the game pushes
+// commands into a RenderGroup: a push buffer that's emptied every frame.
+// Commands are packed one after the other, each only as big as its type
+// needs. Every command also gets a sort entry, keyed on its layer and
+// material.
+//
+// renderGroupExecute then draws the frame in three stages:
+//
+// 1. Sort. The sort entries are ordered by layer, then by material, then by
+//    the order they were pushed. Layers are drawn bottom up. Within a layer,
+//    everything of one material (E.g. every rectangle) is drawn before the
+//    next, so commands that overlap must either be on different layers or
+//    share a material.
+// 2. Resolve. The sorted commands are turned into RenderEntry bounds,
+//    merging rectangles of the same colour that sit edge to edge (E.g. a run
+//    of floor tiles) into one.
+// 3. Rasterise. The frame buffer is split into RENDER_TILE_SIZE_PX square
+//    tiles, each drawn as a separate entry on the platform's work queue. A
+//    tile draws every entry that overlaps it, in order, clipped to its own
+//    pixels, so no two threads ever write the same pixel and the frame comes
+//    out exactly as if it had been drawn on one thread.
+//
+// A tile is 16KiB of frame buffer, so it stays in the L1/L2 cache of the
+// thread drawing it whilst everything overlapping it is drawn.
+//
+// renderGroupExecute can also be given the region of the frame buffer that
+// needs drawing. Tiles outside of it are skipped and keep whatever the frame
+// buffer already has in them. A tile that is drawn is drawn in full, so the
+// group still needs everything that overlaps it pushing.
+
+#define RENDER_TILE_SIZE_PX 64
+
+// Tiles needed to cover a frame buffer
+#define renderTileCount(widthPx, heightPx) ((((widthPx) + RENDER_TILE_SIZE_PX - 1) / RENDER_TILE_SIZE_PX) * \
+                                            (((heightPx) + RENDER_TILE_SIZE_PX - 1) / RENDER_TILE_SIZE_PX))
+
+// The command types double as the materials, in the order they're drawn
+// within a layer
+typedef enum RenderCommandType
+{
+    RENDER_COMMAND_CLEAR,
+    RENDER_COMMAND_RECTANGLE,
+    RENDER_COMMAND_BITMAP,
+    RENDER_COMMAND_BITMAP_AFFINE,
+    RENDER_COMMAND_LINE,
+    RENDER_COMMAND_LINE_SMOOTH,
+} RenderCommandType;
+
+//
+// Commands, as stored in the push buffer
+//====================================================
+
+typedef struct RenderCommandHeader
+{
+    RenderCommandType type;
+} RenderCommandHeader;
+
+// Fills the whole frame buffer. Drawn before anything else, whatever layer
+// it's pushed on.
+typedef struct RenderCommandClear
+{
+    RenderCommandHeader header;
+    uint32 colour;
+} RenderCommandClear;
+
+// Bounds are in pixels from the bottom left, like the frame buffer. Rounded
+// when pushed, exactly as writeRectangle and writeBitmap would. max is
+// exclusive.
+typedef struct RenderCommandRectangle
+{
+    RenderCommandHeader header;
+    int32 minX;
+    int32 minY;
+    int32 maxX;
+    int32 maxY;
+    uint32 colour;
+} RenderCommandRectangle;
+
+typedef struct RenderCommandBitmap
+{
+    RenderCommandHeader header;
+    int32 minX;
+    int32 minY;
+    int32 maxX;
+    int32 maxY;
+
+    // Must still be loaded when the group is executed
+    BitmapFile *bitmap;
+} RenderCommandBitmap;
+
+// As writeBitmapAffine takes them. Bounds are the pixels the bitmap's corners
+// reach, rounded out.
+typedef struct RenderCommandBitmapAffine
+{
+    RenderCommandHeader header;
+    int32 minX;
+    int32 minY;
+    int32 maxX;
+    int32 maxY;
+
+    Vector2 origin;
+    Vector2 xAxis;
+    Vector2 yAxis;
+
+    // Must still be loaded when the group is executed
+    BitmapFile *bitmap;
+} RenderCommandBitmapAffine;
+
+// Both ends are drawn. In pixels for RENDER_COMMAND_LINE and in subpixels
+// (WRITE_LINE_SUBPIXEL_BITS) for RENDER_COMMAND_LINE_SMOOTH.
+typedef struct RenderCommandLine
+{
+    RenderCommandHeader header;
+    xyint from;
+    xyint to;
+    uint32 colour;
+} RenderCommandLine;
+
+typedef struct RenderSortEntry
+{
+    // (layer << 8) | material
+    uint32 key;
+
+    // Where the command starts in the push buffer
+    uint32 offset;
+} RenderSortEntry;
+
+//
+// Resolved by renderGroupExecute, for the tiles to draw
+//====================================================
+
+typedef struct RenderEntry
+{
+    RenderCommandType type;
+
+    // The pixels covered. max is exclusive.
+    int32 minX;
+    int32 minY;
+    int32 maxX;
+    int32 maxY;
+
+    // Everything but RENDER_COMMAND_BITMAP. Packed (0xAARRGGBB).
+    uint32 colour;
+
+    // RENDER_COMMAND_BITMAP and RENDER_COMMAND_BITMAP_AFFINE
+    BitmapFile *bitmap;
+
+    // RENDER_COMMAND_BITMAP_AFFINE, as pushed
+    Vector2 origin;
+    Vector2 xAxis;
+    Vector2 yAxis;
+
+    // RENDER_COMMAND_LINE and RENDER_COMMAND_LINE_SMOOTH, as pushed
+    xyint from;
+    xyint to;
+
+} RenderEntry;
+
+typedef struct RenderTile
+{
+    struct RenderGroup *group;
+    GameFrameBuffer *frameBuffer;
+
+    int32 minX;
+    int32 minY;
+    int32 maxX;
+    int32 maxY;
+
+} RenderTile;
+
+typedef struct RenderGroup
+{
+    // Commands, packed in the order they were pushed
+    uint8 *pushBuffer;
+    uint32 pushBufferSize;
+    uint32 pushBufferUsed;
+
+    // One per command
+    uint32 commandCount;
+    uint32 maxCommands;
+    RenderSortEntry *sortEntries;
+
+    // Room for maxCommands sort entries, to sort into
+    RenderSortEntry *sortScratch;
+
+    // Room for maxCommands entries. Filled in by renderGroupExecute.
+    uint32 entryCount;
+    RenderEntry *entries;
+
+    // Filled in by renderGroupExecute. Work queue entries point at them.
+    uint32 maxTiles;
+    RenderTile *tiles;
+
+    // How much bigger (or smaller) the frame buffer the group's executed
+    // into is than the one its commands were pushed for, E.g. 0.5 to draw a
+    // frame laid out at 1280x720 into 640x360. Commands are scaled as they're
+    // resolved. renderGroupClear resets both to 1.
+    float32 scaleX;
+    float32 scaleY;
+
+    // Last frame. Commands that didn't fit (nothing is drawn for them) and
+    // rectangles merged into the one before.
+    uint32 commandsDropped;
+    uint32 rectanglesMerged;
+
+} RenderGroup;
+
+/**
+ * @brief Reserves the push buffer and everything renderGroupExecute needs
+ * from a memory block
+ *
+ * @param pushBufferSize    Bytes of commands per frame
+ * @param maxCommands       Most commands per frame
+ * @param maxTiles          renderTileCount of the biggest frame buffer that
+ *                          will be drawn to
+ */
+void renderGroupInit(RenderGroup *group,
+                        MemoryRegion *memoryRegion,
+                        MemoryBlock *memoryBlock,
+                        uint32 pushBufferSize,
+                        uint32 maxCommands,
+                        uint32 maxTiles);
+
+/**
+ * @brief Empties the group, ready for the next frame
+ */
+void renderGroupClear(RenderGroup *group);
+
+/**
+ * @param colour    Packed with packColour
+ */
+void renderGroupPushClear(RenderGroup *group, uint32 colour);
+
+/**
+ * @brief Records a writeRectangle
+ *
+ * @param layer     Higher layers are drawn over lower ones
+ * @param colour    Packed with packColour
+ */
+void renderGroupPushRectangle(RenderGroup *group,
+                                uint8 layer,
+                                float32 xOffsetf,
+                                float32 yOffsetf,
+                                uint32 width,
+                                uint32 height,
+                                uint32 colour);
+
+/**
+ * @brief Records a writeBitmap
+ *
+ * @param layer     Higher layers are drawn over lower ones
+ */
+void renderGroupPushBitmap(RenderGroup *group,
+                            uint8 layer,
+                            float32 xOffsetf,
+                            float32 yOffsetf,
+                            float32 widthf,
+                            float32 heightf,
+                            float32 alignXf,
+                            float32 alignYf,
+                            BitmapFile *bitmap);
+
+/**
+ * @brief Records a writeBitmapAffine: a bitmap scaled, rotated or sheared
+ * onto two axes
+ *
+ * @param layer     Higher layers are drawn over lower ones
+ * @param origin    Where the bitmap's bottom left corner goes, in pixels
+ * @param xAxis     The bitmap's bottom edge, from origin
+ * @param yAxis     The bitmap's left edge, from origin
+ */
+void renderGroupPushBitmapAffine(RenderGroup *group,
+                                    uint8 layer,
+                                    Vector2 origin,
+                                    Vector2 xAxis,
+                                    Vector2 yAxis,
+                                    BitmapFile *bitmap);
+
+/**
+ * @brief Records a writeLine
+ *
+ * @param layer     Higher layers are drawn over lower ones
+ * @param colour    Packed with packColour
+ */
+void renderGroupPushLine(RenderGroup *group,
+                            uint8 layer,
+                            int32 x0,
+                            int32 y0,
+                            int32 x1,
+                            int32 y1,
+                            uint32 colour);
+
+/**
+ * @brief Records a line through each point in turn, as one writeLine (or
+ * writeLineSmooth) per segment
+ *
+ * @param layer     Higher layers are drawn over lower ones
+ * @param points    In pixels. Smooth lines keep their fractions.
+ * @param colour    Packed with packColour
+ * @param smooth    Anti-aliased. Drawn after the hard lines on the layer.
+ */
+void renderGroupPushPolyline(RenderGroup *group,
+                                uint8 layer,
+                                Vector2 *points,
+                                uint32 pointCount,
+                                uint32 colour,
+                                bool32 smooth);
+
+/**
+ * @brief Records a line from one point to another with an arrow head on the
+ * end, E.g. to show a vector
+ *
+ * @param headLengthPx  How far the head's sides reach back along the line
+ */
+void renderGroupPushArrow(RenderGroup *group,
+                            uint8 layer,
+                            Vector2 from,
+                            Vector2 to,
+                            float32 headLengthPx,
+                            uint32 colour,
+                            bool32 smooth);
+
+/**
+ * @brief Sorts the group's commands, then draws them into the frame buffer a
+ * tile at a time. Commands are scaled by the group's scaleX and scaleY on the
+ * way; bitmaps drawn at any scale but 1 are filtered as writeBitmapAffine
+ * would. The tiles are shared out over queue's threads. Returns once
+ * every tile has been drawn.
+ *
+ * @param redrawRegion  The pixels that need drawing. Tiles that don't overlap
+ *                      it are left as they are. NULL to draw every tile.
+ * @param queue         NULL to draw every tile on the calling thread
+ */
+void renderGroupExecute(PlatformThreadContext *thread,
+                        RenderGroup *group,
+                        GameFrameBuffer *frameBuffer,
+                        FrameBufferDirtyRegion *redrawRegion,
+                        PlatformWorkQueue *queue,
+                        PlatformAddWorkQueueEntry *addWorkQueueEntry,
+                        PlatformCompleteAllWork *completeAllWork);
+
+//
+// Dirty regions
+//====================================================
+
+/**
+ * @brief Empties the region
+ */
+void renderDirtyRegionClear(FrameBufferDirtyRegion *region);
+
+/**
+ * @brief Marks the whole frame buffer dirty
+ */
+void renderDirtyRegionAddAll(FrameBufferDirtyRegion *region);
+
+/**
+ * @brief Adds a rectangle, clipped to the frame buffer. Once the region has
+ * FRAME_BUFFER_MAX_DIRTY_RECTS rectangles, the new one is merged into the one
+ * it grows the least.
+ */
+void renderDirtyRegionAddRect(FrameBufferDirtyRegion *region,
+                                GameFrameBuffer *frameBuffer,
+                                int64 minX,
+                                int64 minY,
+                                int64 maxX,
+                                int64 maxY);
+
+/**
+ * @brief Adds everything in another region
+ */
+void renderDirtyRegionAddRegion(FrameBufferDirtyRegion *region,
+                                GameFrameBuffer *frameBuffer,
+                                FrameBufferDirtyRegion *other);
+
+#endif
@@ -0,0 +1,70 @@
+#include "resolution.h"
+
+void resolutionControllerInit(ResolutionController *controller)
+{
+    controller->scale = RESOLUTION_SCALE_MAX;
+    controller->frameCount = 0;
+    controller->nextFrame = 0;
+}
+
+internal_func void resolutionControllerSetScale(ResolutionController *controller, uint32 scale)
+{
+    controller->scale = scale;
+    controller->frameCount = 0;
+    controller->nextFrame = 0;
+}
+
+uint32 resolutionControllerUpdate(ResolutionController *controller,
+                                    float32 msWorkPerFrame,
+                                    uint32 targetFPS)
+{
+    if ((msWorkPerFrame <= 0.0f) || (0 == targetFPS)) {
+        return controller->scale;
+    }
+
+    controller->frameMS[controller->nextFrame] = msWorkPerFrame;
+    controller->nextFrame = ((controller->nextFrame + 1) % RESOLUTION_FRAME_WINDOW);
+
+    if (controller->frameCount < RESOLUTION_FRAME_WINDOW) {
+        controller->frameCount++;
+    }
+
+    if (controller->frameCount < RESOLUTION_FRAME_WINDOW) {
+        return controller->scale;
+    }
+
+    float32 msTotal = 0.0f;
+
+    for (uint32 i = 0; i < RESOLUTION_FRAME_WINDOW; i++) {
+        msTotal += controller->frameMS[i];
+    }
+
+    float32 msMean = (msTotal / (float32)RESOLUTION_FRAME_WINDOW);
+    float32 msBudget = ((1000.0f / (float32)targetFPS) * RESOLUTION_BUDGET_FRACTION);
+
+    uint32 scale = controller->scale;
+
+    if ((msMean > msBudget) && (scale > RESOLUTION_SCALE_MIN)) {
+
+        resolutionControllerSetScale(controller, (scale - 1));
+
+    } else if (scale < RESOLUTION_SCALE_MAX) {
+
+        // Assumes all of the work grows with the pixels drawn. Some of it
+        // doesn't, so this errs towards staying put.
+        float32 growth = (((float32)(scale + 1) * (float32)(scale + 1)) / ((float32)scale * (float32)scale));
+
+        if ((msMean * growth) < (msBudget * RESOLUTION_STEP_UP_FRACTION)) {
+            resolutionControllerSetScale(controller, (scale + 1));
+        }
+    }
+
+    return controller->scale;
+}
+
+uint32 resolutionScaleSize(uint32 sizePx, uint32 scale)
+{
+    uint32 scaledPx = ((sizePx * scale) / RESOLUTION_SCALE_MAX);
+
+    return ((scaledPx > 0) ? scaledPx : 1);
+}
@@ -0,0 +1,78 @@
+#ifndef HEADER_HH_RESOLUTION
+#define HEADER_HH_RESOLUTION
+
+#include "types.h"
+#include "global_macros.h"
+
+//
+// Dynamic resolution
+//====================================================
+// When a frame takes too long to make, the game draws it at a lower
+// resolution and scales it up to fill the frame buffer. Layout doesn't change:
+// the game still places everything for the frame buffer's size, and the
+// renderer scales the commands as it draws them (see RenderGroup scaleX).
+//
+// The resolution is a fraction of the frame buffer's, in eighths
+// (RESOLUTION_SCALE_MIN to RESOLUTION_SCALE_MAX). The controller keeps the
+// time the last RESOLUTION_FRAME_WINDOW frames spent working (not waiting for
+// the next frame) and:
+//
+// - Steps down an eighth when they averaged more than the frame's budget.
+// - Steps up an eighth when the average, grown by the extra pixels the next
+//   eighth would draw, would still sit comfortably inside it.
+//
+// Every step starts the window again, so the scale moves at most once every
+// RESOLUTION_FRAME_WINDOW frames and never hunts back and forth on a single
+// slow frame.
+
+// Eighths of the frame buffer's resolution
+#define RESOLUTION_SCALE_MAX 8
+#define RESOLUTION_SCALE_MIN 4
+
+// Frames averaged before the scale can change
+#define RESOLUTION_FRAME_WINDOW 30
+
+// Fraction of the time between frames the work should fit in, leaving the
+// rest for the platform layer and the odd slow frame
+#define RESOLUTION_BUDGET_FRACTION 0.8f
+
+// Fraction of the budget a step up must be predicted to fit in
+#define RESOLUTION_STEP_UP_FRACTION 0.9f
+
+typedef struct ResolutionController
+{
+    // Eighths of the frame buffer's resolution
+    uint32 scale;
+
+    // Milliseconds of work for each frame in the window, oldest first once
+    // the window's full
+    float32 frameMS[RESOLUTION_FRAME_WINDOW];
+    uint32 frameCount;
+    uint32 nextFrame;
+
+} ResolutionController;
+
+/**
+ * @brief Starts at full resolution
+ */
+void resolutionControllerInit(ResolutionController *controller);
+
+/**
+ * @brief Records a frame's work and returns the scale to draw the next one
+ * at
+ *
+ * @param msWorkPerFrame    Milliseconds the last frame spent working. 0 if
+ *                          the platform layer doesn't know, which leaves the
+ *                          scale as it is.
+ * @param targetFPS         Frames per second the platform layer is aiming for
+ */
+uint32 resolutionControllerUpdate(ResolutionController *controller,
+                                    float32 msWorkPerFrame,
+                                    uint32 targetFPS);
+
+/**
+ * @brief Pixels across (or up) a frame buffer drawn at a scale. At least 1.
+ */
+uint32 resolutionScaleSize(uint32 sizePx, uint32 scale);
+
+#endif
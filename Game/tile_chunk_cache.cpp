@@ -0,0 +1,172 @@
+#include "tile_chunk_cache.h"
+#include "graphics.h"
+
+// Tiles in the biggest chunk the cache can build
+#define TILE_CHUNK_CACHE_MAX_TILES (1 << (TILE_CHUNK_TILE_DIMENSIONS_BIT_SHIFT * 2))
+
+sizet tileChunkCacheSizeInBytes(Tilemap *tilemap)
+{
+    sizet chunkTiles = ((sizet)tilemap->tileChunkTileDimensions * tilemap->tileChunkTileDimensions);
+
+    return (TILE_CHUNK_CACHE_SLOTS * chunkTiles * sizeof(TileChunkCacheRectangle));
+}
+
+void tileChunkCacheInit(TileChunkCache *cache,
+                        MemoryRegion *memoryRegion,
+                        MemoryBlock *memoryBlock,
+                        Tilemap *tilemap)
+{
+    sizet chunkTiles = ((sizet)tilemap->tileChunkTileDimensions * tilemap->tileChunkTileDimensions);
+
+    assert(chunkTiles <= TILE_CHUNK_CACHE_MAX_TILES);
+
+    cache->frame = 0;
+    cache->chunksBuilt = 0;
+
+    for (uint32 i = 0; i < TILE_CHUNK_CACHE_SLOTS; i++) {
+
+        TileChunkCacheSlot *slot = &cache->slots[i];
+
+        slot->tileChunk = NULL;
+        slot->version = 0;
+        slot->builtFrame = 0;
+        slot->lastUsedFrame = 0;
+        slot->rectangleCount = 0;
+        slot->rectangles = memoryBlockReserveArray(memoryRegion,
+                                                    memoryBlock,
+                                                    TileChunkCacheRectangle,
+                                                    chunkTiles);
+    }
+}
+
+void tileChunkCacheBeginFrame(TileChunkCache *cache)
+{
+    cache->frame++;
+    cache->chunksBuilt = 0;
+}
+
+/**
+ * Greedily covers the chunk's tiles with rectangles of one colour: each
+ * rectangle starts at the first tile not yet covered, runs right as far as
+ * the colour does, then up for as many rows as match it all the way along.
+ */
+internal_func void tileChunkCacheBuild(TileChunkCache *cache, TileChunkCacheSlot *slot, Tilemap *tilemap)
+{
+    uint32 dimensions = tilemap->tileChunkTileDimensions;
+
+    uint32 colours[TILE_CHUNK_CACHE_MAX_TILES];
+    bool8 covered[TILE_CHUNK_CACHE_MAX_TILES];
+
+    // The tiles are encoded, so unpack their values first
+    tileChunkStoreGetTiles(tilemap->tileChunkStore, slot->tileChunk, colours);
+
+    // Tile values that look the same (E.g. every unset value) merge too
+    for (uint32 i = 0; i < (dimensions * dimensions); i++) {
+        Colour colour = {};
+        setTileColour(&colour, colours[i]);
+        colours[i] = packColour(colour);
+        covered[i] = false;
+    }
+
+    slot->rectangleCount = 0;
+
+    for (uint32 y = 0; y < dimensions; y++) {
+        for (uint32 x = 0; x < dimensions; x++) {
+
+            uint32 start = ((y * dimensions) + x);
+
+            if (covered[start]) {
+                continue;
+            }
+
+            uint32 colour = colours[start];
+
+            uint32 maxX = (x + 1);
+
+            while ((maxX < dimensions)
+                    && !covered[(y * dimensions) + maxX]
+                    && (colours[(y * dimensions) + maxX] == colour)) {
+                maxX++;
+            }
+
+            uint32 maxY = (y + 1);
+
+            for (; maxY < dimensions; maxY++) {
+
+                bool32 rowMatches = true;
+
+                for (uint32 rowX = x; rowX < maxX; rowX++) {
+                    uint32 tile = ((maxY * dimensions) + rowX);
+                    if (covered[tile] || (colours[tile] != colour)) {
+                        rowMatches = false;
+                        break;
+                    }
+                }
+
+                if (!rowMatches) {
+                    break;
+                }
+            }
+
+            for (uint32 rowY = y; rowY < maxY; rowY++) {
+                for (uint32 rowX = x; rowX < maxX; rowX++) {
+                    covered[(rowY * dimensions) + rowX] = true;
+                }
+            }
+
+            TileChunkCacheRectangle *rectangle = &slot->rectangles[slot->rectangleCount++];
+            rectangle->minX = (uint16)x;
+            rectangle->minY = (uint16)y;
+            rectangle->maxX = (uint16)maxX;
+            rectangle->maxY = (uint16)maxY;
+            rectangle->colour = colour;
+        }
+    }
+
+    slot->version = slot->tileChunk->version;
+    slot->builtFrame = cache->frame;
+    cache->chunksBuilt++;
+}
+
+TileChunkCacheSlot *tileChunkCacheGet(TileChunkCache *cache,
+                                        TileChunk *tileChunk,
+                                        Tilemap *tilemap)
+{
+    assert(TILE_CHUNK_ENCODING_NONE != tileChunk->encoding);
+
+    TileChunkCacheSlot *slot = NULL;
+    TileChunkCacheSlot *oldestSlot = &cache->slots[0];
+
+    for (uint32 i = 0; i < TILE_CHUNK_CACHE_SLOTS; i++) {
+
+        if (cache->slots[i].tileChunk == tileChunk) {
+            slot = &cache->slots[i];
+            break;
+        }
+
+        // Empty slots have never been used, so are the oldest
+        if (cache->slots[i].lastUsedFrame < oldestSlot->lastUsedFrame) {
+            oldestSlot = &cache->slots[i];
+        }
+    }
+
+    if (!slot) {
+
+        // Every slot has been handed out this frame, and its rectangles may
+        // not have been pushed yet
+        assert(oldestSlot->lastUsedFrame != cache->frame);
+
+        slot = oldestSlot;
+        slot->tileChunk = tileChunk;
+
+        tileChunkCacheBuild(cache, slot, tilemap);
+
+    } else if (slot->version != tileChunk->version) {
+
+        tileChunkCacheBuild(cache, slot, tilemap);
+    }
+
+    slot->lastUsedFrame = cache->frame;
+
+    return slot;
+}
@@ -0,0 +1,103 @@
+#ifndef HEADER_HH_TILE_CHUNK_CACHE
+#define HEADER_HH_TILE_CHUNK_CACHE
+
+#include "types.h"
+#include "tilemap.h"
+
+//
+// Tile chunk cache
+//====================================================
+// Each tile chunk on screen is turned into rectangles once: tiles of the
+// same colour are merged into as few rectangles as possible, with their
+// colours already packed. Drawing the background is then pushing each
+// visible chunk's rectangles, rather than looking up and colouring every
+// tile, every frame.
+//
+// The chunks are cached as rectangles rather than pixels on purpose. Filling
+// a rectangle only writes the frame buffer, whereas copying a chunk's pixels
+// also has to read them back in, and a screen's worth of chunk pixels doesn't
+// fit in the cache, so copies came out slower than the fills.
+//
+// A cached chunk is rebuilt when its version no longer matches the one it was
+// built at (setTileValue bumps it). The cache holds TILE_CHUNK_CACHE_SLOTS
+// chunks; when it's full the chunk that's gone longest without being drawn
+// is dropped.
+
+// Chunks that can be cached at once. A 1280x720 screen shows at most 3x3
+// 640x640 chunks, so this leaves room for the ones scrolling on and off.
+#define TILE_CHUNK_CACHE_SLOTS 16
+
+// In tiles, from the chunk's bottom left
+typedef struct TileChunkCacheRectangle
+{
+    uint16 minX;
+    uint16 minY;
+    uint16 maxX;
+    uint16 maxY;
+
+    // Packed (0xAARRGGBB)
+    uint32 colour;
+
+} TileChunkCacheRectangle;
+
+typedef struct TileChunkCacheSlot
+{
+    // NULL if the slot's empty
+    TileChunk *tileChunk;
+
+    // tileChunk->version when the rectangles were built
+    uint32 version;
+
+    // The frame the rectangles were built. Equal to the cache's frame if the
+    // chunk may look different to when it was last drawn.
+    uint32 builtFrame;
+
+    // The frame the slot was last used
+    uint32 lastUsedFrame;
+
+    // Room for one per tile, which is the most a chunk can need
+    uint32 rectangleCount;
+    TileChunkCacheRectangle *rectangles;
+
+} TileChunkCacheSlot;
+
+typedef struct TileChunkCache
+{
+    uint32 frame;
+
+    // Chunks built this frame
+    uint32 chunksBuilt;
+
+    TileChunkCacheSlot slots[TILE_CHUNK_CACHE_SLOTS];
+
+} TileChunkCache;
+
+/**
+ * @brief Reserves every slot's rectangles from a memory block
+ */
+void tileChunkCacheInit(TileChunkCache *cache,
+                        MemoryRegion *memoryRegion,
+                        MemoryBlock *memoryBlock,
+                        Tilemap *tilemap);
+
+/**
+ * @brief Bytes tileChunkCacheInit will reserve
+ */
+sizet tileChunkCacheSizeInBytes(Tilemap *tilemap);
+
+/**
+ * @brief Call once a frame, before getting any chunks
+ */
+void tileChunkCacheBeginFrame(TileChunkCache *cache);
+
+/**
+ * @brief The chunk's rectangles, built from its tiles if they're not already
+ * cached or have changed since. Valid until the end of the frame.
+ *
+ * @param tileChunk     Must have its tiles allocated
+ */
+TileChunkCacheSlot *tileChunkCacheGet(TileChunkCache *cache,
+                                        TileChunk *tileChunk,
+                                        Tilemap *tilemap);
+
+#endif
@@ -0,0 +1,709 @@
+#include <string.h> // memmove
+#include "tile_chunk_store.h"
+
+/**
+ * Mixes the chunk index so that neighbouring chunks land far apart in the
+ * table. Each coordinate is multiplied by a different odd constant, then the
+ * bits are folded down (the finaliser from MurmurHash3).
+ */
+internal_func uint32 tileChunkStoreHash(uint32 chunkX, uint32 chunkY, uint32 chunkZ)
+{
+    uint32 hash = ((chunkX * 0x9E3779B1u) ^ (chunkY * 0x85EBCA77u) ^ (chunkZ * 0xC2B2AE3Du));
+
+    hash ^= (hash >> 16);
+    hash *= 0x85EBCA6Bu;
+    hash ^= (hash >> 13);
+    hash *= 0xC2B2AE35u;
+    hash ^= (hash >> 16);
+
+    return hash;
+}
+
+internal_func TileChunkStoreCacheEntry *tileChunkStoreCacheEntry(TileChunkStore *store, uint32 hash)
+{
+    return &store->cache[hash & (TILE_CHUNK_STORE_CACHE_SIZE - 1)];
+}
+
+/**
+ * The slot the chunk is in, or the empty slot it would go in
+ */
+internal_func TileChunk **tileChunkStoreFindSlot(TileChunk **slots,
+                                                    uint32 slotCount,
+                                                    uint32 hash,
+                                                    uint32 chunkX,
+                                                    uint32 chunkY,
+                                                    uint32 chunkZ)
+{
+    uint32 mask = (slotCount - 1);
+
+    // The table's never full, so this always finds one or the other
+    for (uint32 index = (hash & mask);; index = ((index + 1) & mask)) {
+
+        TileChunk *tileChunk = slots[index];
+
+        if (!tileChunk) {
+            return &slots[index];
+        }
+
+        if ((tileChunk->chunkX == chunkX) && (tileChunk->chunkY == chunkY) && (tileChunk->chunkZ == chunkZ)) {
+            return &slots[index];
+        }
+    }
+}
+
+TileChunkStore *tileChunkStoreInit(MemoryRegion *memoryRegion,
+                                    MemoryBlock *memoryBlock,
+                                    uint32 tileChunkTileDimensions)
+{
+    TileChunkStore *store = memoryBlockReserveStruct(memoryRegion, memoryBlock, TileChunkStore);
+
+    store->tileChunkTileDimensions = tileChunkTileDimensions;
+    store->tilesPerChunk = (tileChunkTileDimensions * tileChunkTileDimensions);
+    store->tileBytesReserved = 0;
+
+    // A quarter of a byte a tile, but always enough for a chunk of one value
+    // with one tile split out of it
+    uint32 runsPerRow = ((tileChunkTileDimensions + (TILE_CHUNK_STORE_MAX_RUN_LENGTH - 1)) / TILE_CHUNK_STORE_MAX_RUN_LENGTH);
+    store->runCapacity = (store->tilesPerChunk / 4);
+
+    if (store->runCapacity < ((tileChunkTileDimensions * runsPerRow) + 2)) {
+        store->runCapacity = ((tileChunkTileDimensions * runsPerRow) + 2);
+    }
+
+    store->slotCount = TILE_CHUNK_STORE_INITIAL_SLOTS;
+    store->slots = memoryBlockReserveArray(memoryRegion, memoryBlock, TileChunk *, store->slotCount);
+    store->chunkCount = 0;
+
+    for (uint32 i = 0; i < store->slotCount; i++) {
+        store->slots[i] = NULL;
+    }
+
+    for (uint32 i = 0; i < TILE_CHUNK_STORE_CACHE_SIZE; i++) {
+        store->cache[i].used = false;
+    }
+
+    return store;
+}
+
+TileChunk *tileChunkStoreGet(TileChunkStore *store, uint32 chunkX, uint32 chunkY, uint32 chunkZ)
+{
+    uint32 hash = tileChunkStoreHash(chunkX, chunkY, chunkZ);
+
+    TileChunkStoreCacheEntry *entry = tileChunkStoreCacheEntry(store, hash);
+
+    if (entry->used && (entry->chunkX == chunkX) && (entry->chunkY == chunkY) && (entry->chunkZ == chunkZ)) {
+        return entry->tileChunk;
+    }
+
+    TileChunk **slot = tileChunkStoreFindSlot(store->slots, store->slotCount, hash, chunkX, chunkY, chunkZ);
+
+    entry->chunkX = chunkX;
+    entry->chunkY = chunkY;
+    entry->chunkZ = chunkZ;
+    entry->used = true;
+    entry->tileChunk = *slot;
+
+    return *slot;
+}
+
+/**
+ * Moves every chunk into a table twice the size
+ */
+internal_func void tileChunkStoreGrow(TileChunkStore *store, MemoryRegion *memoryRegion, MemoryBlock *memoryBlock)
+{
+    uint32 slotCount = (store->slotCount * 2);
+    TileChunk **slots = memoryBlockReserveArray(memoryRegion, memoryBlock, TileChunk *, slotCount);
+
+    for (uint32 i = 0; i < slotCount; i++) {
+        slots[i] = NULL;
+    }
+
+    for (uint32 i = 0; i < store->slotCount; i++) {
+
+        TileChunk *tileChunk = store->slots[i];
+
+        if (!tileChunk) {
+            continue;
+        }
+
+        uint32 hash = tileChunkStoreHash(tileChunk->chunkX, tileChunk->chunkY, tileChunk->chunkZ);
+
+        *tileChunkStoreFindSlot(slots, slotCount, hash, tileChunk->chunkX, tileChunk->chunkY, tileChunk->chunkZ) = tileChunk;
+    }
+
+    store->slots = slots;
+    store->slotCount = slotCount;
+}
+
+TileChunk *tileChunkStoreGetOrCreate(TileChunkStore *store,
+                                        MemoryRegion *memoryRegion,
+                                        MemoryBlock *memoryBlock,
+                                        uint32 chunkX,
+                                        uint32 chunkY,
+                                        uint32 chunkZ)
+{
+    TileChunk *tileChunk = tileChunkStoreGet(store, chunkX, chunkY, chunkZ);
+
+    if (tileChunk) {
+        return tileChunk;
+    }
+
+    // No more than 3/4 full, so probes stay short
+    if (((store->chunkCount + 1) * 4) > (store->slotCount * 3)) {
+        tileChunkStoreGrow(store, memoryRegion, memoryBlock);
+    }
+
+    tileChunk = memoryBlockReserveStruct(memoryRegion, memoryBlock, TileChunk);
+    tileChunk->chunkX = chunkX;
+    tileChunk->chunkY = chunkY;
+    tileChunk->chunkZ = chunkZ;
+    tileChunk->version = 0;
+    tileChunk->encoding = TILE_CHUNK_ENCODING_NONE;
+    tileChunk->uniformValue = 0;
+    tileChunk->palette = NULL;
+    tileChunk->paletteCount = 0;
+    tileChunk->paletteSize = 0;
+    tileChunk->runCount = 0;
+    tileChunk->bitsPerTile = 0;
+    tileChunk->tiles = NULL;
+
+    uint32 hash = tileChunkStoreHash(chunkX, chunkY, chunkZ);
+
+    *tileChunkStoreFindSlot(store->slots, store->slotCount, hash, chunkX, chunkY, chunkZ) = tileChunk;
+    store->chunkCount++;
+
+    // The lookup above remembered that there was no such chunk
+    TileChunkStoreCacheEntry *entry = tileChunkStoreCacheEntry(store, hash);
+    entry->chunkX = chunkX;
+    entry->chunkY = chunkY;
+    entry->chunkZ = chunkZ;
+    entry->used = true;
+    entry->tileChunk = tileChunk;
+
+    return tileChunk;
+}
+
+/**
+ * Reserves bytes from the tiles' block as whole uint32s, so that whatever is
+ * reserved after them stays 4 byte aligned
+ */
+internal_func void *tileChunkStoreReserve(TileChunkStore *store,
+                                            MemoryRegion *memoryRegion,
+                                            MemoryBlock *tilesMemoryBlock,
+                                            uint32 bytes)
+{
+    uint32 words = ((bytes + 3) / 4);
+
+    store->tileBytesReserved += (words * sizeof(uint32));
+
+    return memoryBlockReserveArray(memoryRegion, tilesMemoryBlock, uint32, words);
+}
+
+//
+// Palette
+//====================================================
+
+/**
+ * The value's index in the chunk's palette, or paletteCount if it's not in it
+ */
+internal_func uint32 tileChunkStoreFindValue(TileChunk *tileChunk, uint32 value)
+{
+    uint32 index = 0;
+
+    while ((index < tileChunk->paletteCount) && (tileChunk->palette[index] != value)) {
+        index++;
+    }
+
+    return index;
+}
+
+internal_func uint32 tileChunkStoreAddValue(TileChunkStore *store,
+                                            TileChunk *tileChunk,
+                                            MemoryRegion *memoryRegion,
+                                            MemoryBlock *tilesMemoryBlock,
+                                            uint32 value)
+{
+    if (tileChunk->paletteCount == tileChunk->paletteSize) {
+
+        uint32 paletteSize = (tileChunk->paletteSize * 2);
+        uint32 *palette = (uint32 *)tileChunkStoreReserve(store,
+                                                            memoryRegion,
+                                                            tilesMemoryBlock,
+                                                            (paletteSize * sizeof(uint32)));
+
+        for (uint32 i = 0; i < tileChunk->paletteCount; i++) {
+            palette[i] = tileChunk->palette[i];
+        }
+
+        tileChunk->palette = palette;
+        tileChunk->paletteSize = paletteSize;
+    }
+
+    tileChunk->palette[tileChunk->paletteCount] = value;
+
+    return tileChunk->paletteCount++;
+}
+
+//
+// Runs
+//====================================================
+
+// A run is a byte: the palette index in the top 4 bits, the length - 1 in
+// the bottom 4
+#define tileChunkStoreRun(index, length) ((uint8)(((index) << 4) | ((length) - 1)))
+#define tileChunkStoreRunIndex(run) ((uint32)(run) >> 4)
+#define tileChunkStoreRunLength(run) (((uint32)(run) & 0xF) + 1)
+
+/**
+ * The run the tile's in, and the index of the run's first tile
+ */
+internal_func uint32 tileChunkStoreFindRun(TileChunk *tileChunk, uint32 tileIndex, uint32 *runStart)
+{
+    uint32 start = 0;
+
+    for (uint32 i = 0; i < tileChunk->runCount; i++) {
+
+        uint32 length = tileChunkStoreRunLength(tileChunk->tiles[i]);
+
+        if (tileIndex < (start + length)) {
+            *runStart = start;
+            return i;
+        }
+
+        start += length;
+    }
+
+    assert(!"The runs don't cover every tile");
+    *runStart = 0;
+    return 0;
+}
+
+/**
+ * Every tile as one value, each row in runs as long as they'll go
+ */
+internal_func void tileChunkStoreUniformToRuns(TileChunkStore *store,
+                                                TileChunk *tileChunk,
+                                                MemoryRegion *memoryRegion,
+                                                MemoryBlock *tilesMemoryBlock)
+{
+    // Use what the chunk had when it last had runs, if it has
+    if (!tileChunk->tiles) {
+        tileChunk->palette = (uint32 *)tileChunkStoreReserve(store,
+                                                                memoryRegion,
+                                                                tilesMemoryBlock,
+                                                                (TILE_CHUNK_STORE_INITIAL_PALETTE_SIZE * sizeof(uint32)));
+        tileChunk->paletteSize = TILE_CHUNK_STORE_INITIAL_PALETTE_SIZE;
+        tileChunk->tiles = (uint8 *)tileChunkStoreReserve(store, memoryRegion, tilesMemoryBlock, store->runCapacity);
+    }
+
+    tileChunk->palette[0] = tileChunk->uniformValue;
+    tileChunk->paletteCount = 1;
+    tileChunk->runCount = 0;
+
+    for (uint32 y = 0; y < store->tileChunkTileDimensions; y++) {
+
+        uint32 remaining = store->tileChunkTileDimensions;
+
+        while (remaining) {
+            uint32 length = ((remaining < TILE_CHUNK_STORE_MAX_RUN_LENGTH) ? remaining : TILE_CHUNK_STORE_MAX_RUN_LENGTH);
+            tileChunk->tiles[tileChunk->runCount++] = tileChunkStoreRun(0, length);
+            remaining -= length;
+        }
+    }
+
+    tileChunk->encoding = TILE_CHUNK_ENCODING_RUNS;
+}
+
+/**
+ * Splits the tile's run around it, joining the tile onto the runs either side
+ * where they're the same value and on the same row. False (and the runs left
+ * as they were) if that would need more runs than the store has room for.
+ */
+internal_func bool32 tileChunkStoreSetRun(TileChunkStore *store, TileChunk *tileChunk, uint32 tileIndex, uint32 index)
+{
+    uint8 *runs = tileChunk->tiles;
+    uint32 dimensions = store->tileChunkTileDimensions;
+
+    uint32 start = 0;
+    uint32 i = tileChunkStoreFindRun(tileChunk, tileIndex, &start);
+
+    uint32 oldIndex = tileChunkStoreRunIndex(runs[i]);
+    uint32 length = tileChunkStoreRunLength(runs[i]);
+
+    if (oldIndex == index) {
+        return true;
+    }
+
+    // Tiles of the run either side of this one
+    uint32 before = (tileIndex - start);
+    uint32 after = ((start + length) - (tileIndex + 1));
+
+    // The runs to replace
+    uint32 first = i;
+    uint32 last = i;
+    uint32 newLength = 1;
+
+    if (!before
+            && (start % dimensions)
+            && (tileChunkStoreRunIndex(runs[i - 1]) == index)
+            && (tileChunkStoreRunLength(runs[i - 1]) < TILE_CHUNK_STORE_MAX_RUN_LENGTH)) {
+        first = (i - 1);
+        newLength += tileChunkStoreRunLength(runs[i - 1]);
+    }
+
+    if (!after
+            && ((start + length) % dimensions)
+            && (tileChunkStoreRunIndex(runs[i + 1]) == index)
+            && ((newLength + tileChunkStoreRunLength(runs[i + 1])) <= TILE_CHUNK_STORE_MAX_RUN_LENGTH)) {
+        last = (i + 1);
+        newLength += tileChunkStoreRunLength(runs[i + 1]);
+    }
+
+    uint8 replacements[3];
+    uint32 replacementCount = 0;
+
+    if (before) {
+        replacements[replacementCount++] = tileChunkStoreRun(oldIndex, before);
+    }
+
+    replacements[replacementCount++] = tileChunkStoreRun(index, newLength);
+
+    if (after) {
+        replacements[replacementCount++] = tileChunkStoreRun(oldIndex, after);
+    }
+
+    uint32 replacedCount = ((last - first) + 1);
+    uint32 runCount = ((tileChunk->runCount - replacedCount) + replacementCount);
+
+    if (runCount > store->runCapacity) {
+        return false;
+    }
+
+    // Move the runs after along to fit
+    memmove(&runs[first + replacementCount], &runs[last + 1], (tileChunk->runCount - (last + 1)));
+
+    for (uint32 j = 0; j < replacementCount; j++) {
+        runs[first + j] = replacements[j];
+    }
+
+    tileChunk->runCount = runCount;
+
+    return true;
+}
+
+/**
+ * Whether every tile is the same value: as few runs as the rows can be in,
+ * all of one value
+ */
+internal_func bool32 tileChunkStoreRunsAreUniform(TileChunkStore *store, TileChunk *tileChunk)
+{
+    uint32 runsPerRow = ((store->tileChunkTileDimensions + (TILE_CHUNK_STORE_MAX_RUN_LENGTH - 1)) / TILE_CHUNK_STORE_MAX_RUN_LENGTH);
+
+    if (tileChunk->runCount != (store->tileChunkTileDimensions * runsPerRow)) {
+        return false;
+    }
+
+    for (uint32 i = 1; i < tileChunk->runCount; i++) {
+        if (tileChunkStoreRunIndex(tileChunk->tiles[i]) != tileChunkStoreRunIndex(tileChunk->tiles[0])) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+//
+// Packed indices and values
+//====================================================
+
+internal_func uint32 tileChunkStoreGetIndex(TileChunk *tileChunk, uint32 tileIndex)
+{
+    if (4 == tileChunk->bitsPerTile) {
+        return ((tileChunk->tiles[tileIndex >> 1] >> ((tileIndex & 1) << 2)) & 0xF);
+    }
+
+    return tileChunk->tiles[tileIndex];
+}
+
+internal_func void tileChunkStoreSetIndex(TileChunk *tileChunk, uint32 tileIndex, uint32 index)
+{
+    if (4 == tileChunk->bitsPerTile) {
+        uint8 *pair = &tileChunk->tiles[tileIndex >> 1];
+        uint32 shift = ((tileIndex & 1) << 2);
+        *pair = (uint8)((*pair & ~(0xF << shift)) | (index << shift));
+        return;
+    }
+
+    tileChunk->tiles[tileIndex] = (uint8)index;
+}
+
+/**
+ * Runs to 4 bit indices. The palette stays as it is.
+ */
+internal_func void tileChunkStoreRunsToPacked(TileChunkStore *store,
+                                                TileChunk *tileChunk,
+                                                MemoryRegion *memoryRegion,
+                                                MemoryBlock *tilesMemoryBlock)
+{
+    uint8 *runs = tileChunk->tiles;
+    uint32 runCount = tileChunk->runCount;
+
+    tileChunk->tiles = (uint8 *)tileChunkStoreReserve(store,
+                                                        memoryRegion,
+                                                        tilesMemoryBlock,
+                                                        ((store->tilesPerChunk + 1) / 2));
+    tileChunk->bitsPerTile = 4;
+    tileChunk->encoding = TILE_CHUNK_ENCODING_PACKED;
+    tileChunk->runCount = 0;
+
+    uint32 tileIndex = 0;
+
+    for (uint32 i = 0; i < runCount; i++) {
+        for (uint32 j = 0; j < tileChunkStoreRunLength(runs[i]); j++) {
+            tileChunkStoreSetIndex(tileChunk, tileIndex++, tileChunkStoreRunIndex(runs[i]));
+        }
+    }
+}
+
+/**
+ * 4 bit indices to 8 bit ones, or 8 bit indices to the values themselves
+ */
+internal_func void tileChunkStoreWiden(TileChunkStore *store,
+                                        TileChunk *tileChunk,
+                                        MemoryRegion *memoryRegion,
+                                        MemoryBlock *tilesMemoryBlock)
+{
+    if (4 == tileChunk->bitsPerTile) {
+
+        uint8 *indices = (uint8 *)tileChunkStoreReserve(store, memoryRegion, tilesMemoryBlock, store->tilesPerChunk);
+
+        for (uint32 i = 0; i < store->tilesPerChunk; i++) {
+            indices[i] = (uint8)tileChunkStoreGetIndex(tileChunk, i);
+        }
+
+        tileChunk->tiles = indices;
+        tileChunk->bitsPerTile = 8;
+        return;
+    }
+
+    assert(8 == tileChunk->bitsPerTile);
+
+    uint32 *values = (uint32 *)tileChunkStoreReserve(store,
+                                                        memoryRegion,
+                                                        tilesMemoryBlock,
+                                                        (store->tilesPerChunk * sizeof(uint32)));
+
+    for (uint32 i = 0; i < store->tilesPerChunk; i++) {
+        values[i] = tileChunk->palette[tileChunk->tiles[i]];
+    }
+
+    tileChunk->tiles = (uint8 *)values;
+    tileChunk->encoding = TILE_CHUNK_ENCODING_VALUES;
+    tileChunk->bitsPerTile = 0;
+    tileChunk->palette = NULL;
+    tileChunk->paletteCount = 0;
+    tileChunk->paletteSize = 0;
+}
+
+uint32 tileChunkStoreGetTile(TileChunkStore *store, TileChunk *tileChunk, uint32 tileIndex)
+{
+    assert(tileIndex < store->tilesPerChunk);
+
+    switch (tileChunk->encoding) {
+    case TILE_CHUNK_ENCODING_UNIFORM:
+        return tileChunk->uniformValue;
+
+    case TILE_CHUNK_ENCODING_RUNS: {
+        uint32 start = 0;
+        uint32 run = tileChunkStoreFindRun(tileChunk, tileIndex, &start);
+        return tileChunk->palette[tileChunkStoreRunIndex(tileChunk->tiles[run])];
+    }
+
+    case TILE_CHUNK_ENCODING_PACKED:
+        return tileChunk->palette[tileChunkStoreGetIndex(tileChunk, tileIndex)];
+
+    case TILE_CHUNK_ENCODING_VALUES:
+        return ((uint32 *)tileChunk->tiles)[tileIndex];
+
+    default:
+        assert(!"The chunk's tiles haven't been set");
+        return 0;
+    }
+}
+
+void tileChunkStoreGetTiles(TileChunkStore *store, TileChunk *tileChunk, uint32 *values)
+{
+    switch (tileChunk->encoding) {
+    case TILE_CHUNK_ENCODING_UNIFORM:
+        for (uint32 i = 0; i < store->tilesPerChunk; i++) {
+            values[i] = tileChunk->uniformValue;
+        }
+        break;
+
+    case TILE_CHUNK_ENCODING_RUNS: {
+        uint32 tileIndex = 0;
+
+        for (uint32 i = 0; i < tileChunk->runCount; i++) {
+
+            uint32 value = tileChunk->palette[tileChunkStoreRunIndex(tileChunk->tiles[i])];
+
+            for (uint32 j = 0; j < tileChunkStoreRunLength(tileChunk->tiles[i]); j++) {
+                values[tileIndex++] = value;
+            }
+        }
+    } break;
+
+    case TILE_CHUNK_ENCODING_PACKED:
+        if (4 == tileChunk->bitsPerTile) {
+
+            // Two tiles a byte, the first in the low bits
+            for (uint32 i = 0; (i + 1) < store->tilesPerChunk; i += 2) {
+                uint8 pair = tileChunk->tiles[i >> 1];
+                values[i] = tileChunk->palette[pair & 0xF];
+                values[i + 1] = tileChunk->palette[pair >> 4];
+            }
+
+            if (store->tilesPerChunk & 1) {
+                values[store->tilesPerChunk - 1] = tileChunkStoreGetTile(store, tileChunk, (store->tilesPerChunk - 1));
+            }
+
+        } else {
+            for (uint32 i = 0; i < store->tilesPerChunk; i++) {
+                values[i] = tileChunk->palette[tileChunk->tiles[i]];
+            }
+        }
+        break;
+
+    case TILE_CHUNK_ENCODING_VALUES:
+        for (uint32 i = 0; i < store->tilesPerChunk; i++) {
+            values[i] = ((uint32 *)tileChunk->tiles)[i];
+        }
+        break;
+
+    default:
+        assert(!"The chunk's tiles haven't been set");
+        break;
+    }
+}
+
+void tileChunkStoreSetTile(TileChunkStore *store,
+                            TileChunk *tileChunk,
+                            MemoryRegion *memoryRegion,
+                            MemoryBlock *tilesMemoryBlock,
+                            uint32 tileIndex,
+                            uint32 value)
+{
+    assert(tileIndex < store->tilesPerChunk);
+
+    if (TILE_CHUNK_ENCODING_NONE == tileChunk->encoding) {
+        tileChunk->encoding = TILE_CHUNK_ENCODING_UNIFORM;
+        tileChunk->uniformValue = 0;
+    }
+
+    if (TILE_CHUNK_ENCODING_UNIFORM == tileChunk->encoding) {
+
+        if (value == tileChunk->uniformValue) {
+            return;
+        }
+
+        tileChunkStoreUniformToRuns(store, tileChunk, memoryRegion, tilesMemoryBlock);
+    }
+
+    if (TILE_CHUNK_ENCODING_RUNS == tileChunk->encoding) {
+
+        uint32 index = tileChunkStoreFindValue(tileChunk, value);
+
+        if ((index < tileChunk->paletteCount) || (tileChunk->paletteCount < TILE_CHUNK_STORE_MAX_RUN_VALUES)) {
+
+            if (index == tileChunk->paletteCount) {
+                index = tileChunkStoreAddValue(store, tileChunk, memoryRegion, tilesMemoryBlock, value);
+            }
+
+            if (tileChunkStoreSetRun(store, tileChunk, tileIndex, index)) {
+
+                if (tileChunkStoreRunsAreUniform(store, tileChunk)) {
+                    tileChunk->encoding = TILE_CHUNK_ENCODING_UNIFORM;
+                    tileChunk->uniformValue = value;
+                }
+
+                return;
+            }
+        }
+
+        // Written too irregularly for runs
+        tileChunkStoreRunsToPacked(store, tileChunk, memoryRegion, tilesMemoryBlock);
+    }
+
+    if (TILE_CHUNK_ENCODING_PACKED == tileChunk->encoding) {
+
+        uint32 index = tileChunkStoreFindValue(tileChunk, value);
+
+        // A value the chunk hasn't used before
+        if (index == tileChunk->paletteCount) {
+
+            // Too many values for the indices to tell apart?
+            if (index == ((uint32)1 << tileChunk->bitsPerTile)) {
+                tileChunkStoreWiden(store, tileChunk, memoryRegion, tilesMemoryBlock);
+            }
+
+            if (TILE_CHUNK_ENCODING_PACKED == tileChunk->encoding) {
+                index = tileChunkStoreAddValue(store, tileChunk, memoryRegion, tilesMemoryBlock, value);
+            }
+        }
+
+        if (TILE_CHUNK_ENCODING_PACKED == tileChunk->encoding) {
+            tileChunkStoreSetIndex(tileChunk, tileIndex, index);
+            return;
+        }
+    }
+
+    ((uint32 *)tileChunk->tiles)[tileIndex] = value;
+}
+
+TileChunkStoreMemory tileChunkStoreGetMemory(TileChunkStore *store)
+{
+    TileChunkStoreMemory memory = {};
+
+    memory.reservedBytes = store->tileBytesReserved;
+
+    // Bytes as tileChunkStoreReserve rounds them
+    sizet runBytes = (((store->runCapacity + 3) / 4) * sizeof(uint32));
+
+    for (uint32 i = 0; i < store->slotCount; i++) {
+
+        TileChunk *tileChunk = store->slots[i];
+
+        if (!tileChunk) {
+            continue;
+        }
+
+        sizet bytes = (tileChunk->paletteSize * sizeof(uint32));
+
+        switch (tileChunk->encoding) {
+        case TILE_CHUNK_ENCODING_UNIFORM:
+        case TILE_CHUNK_ENCODING_RUNS:
+            // Uniform chunks may be holding on to their old runs
+            if (tileChunk->tiles) {
+                bytes += runBytes;
+            }
+            break;
+
+        case TILE_CHUNK_ENCODING_PACKED:
+            bytes += ((((store->tilesPerChunk * tileChunk->bitsPerTile) + 31) / 32) * sizeof(uint32));
+            break;
+
+        case TILE_CHUNK_ENCODING_VALUES:
+            bytes += (store->tilesPerChunk * sizeof(uint32));
+            break;
+
+        default:
+            break;
+        }
+
+        memory.chunks[tileChunk->encoding]++;
+        memory.bytes[tileChunk->encoding] += bytes;
+        memory.unencodedBytes += (store->tilesPerChunk * sizeof(uint32));
+    }
+
+    return memory;
+}
@@ -0,0 +1,219 @@
+#ifndef HEADER_HH_TILE_CHUNK_STORE
+#define HEADER_HH_TILE_CHUNK_STORE
+
+#include "types.h"
+#include "memory.h"
+
+//
+// Tile chunk store
+//====================================================
+// Tile chunks are only stored once a tile in them is set. Each one is
+// reserved from a memory block the first time it's written to and found
+// again through an open addressing hash table keyed on its chunk index
+// (x, y and z), so memory grows with the number of chunks in use rather than
+// with the size of the world.
+//
+// The table is probed linearly and kept no more than 3/4 full. When it would
+// go over, a table twice the size is reserved from the same block and every
+// chunk is re-inserted. Chunks themselves never move, so pointers to them
+// (E.g. TilemapPosition.tileChunk, the tile chunk cache's slots) stay valid.
+// The tables left behind are never reused, but come to less than the current
+// one.
+//
+// In front of the table sits a small direct mapped cache of recent lookups,
+// including the ones that found nothing. A frame looks up the same handful
+// of chunks (the player's, the camera's and the ones on screen) over and
+// over, and they nearly always hit it.
+//
+// A chunk's tiles are kept in the most compact of these that fits them,
+// starting with the first:
+//
+// 1. Uniform. Every tile has the same value, so nothing is stored but it.
+// 2. Runs. Each row as runs of up to 16 tiles of one value, a byte each (a 4
+//    bit index into a palette of the chunk's values and the run's length).
+//    Runs never cross from one row to the next. There's room for a quarter
+//    of a byte a tile, so a 16x16 chunk takes 64 bytes of runs and a 16 byte
+//    palette.
+// 3. Packed. Each tile is an index into the palette: 4 bits a tile, widened
+//    to 8 once the chunk holds more than 16 values.
+// 4. Values. Each tile is its value (32 bits), once the chunk holds more
+//    than 256.
+//
+// A chunk moves down the list only when a tile is set that the form it's in
+// can't hold: a second value for a uniform chunk, too many runs or values for
+// a run chunk, and so on. A run chunk whose tiles all end up the same goes
+// back to being uniform, keeping its runs and palette to use again. Moving
+// down the list reserves new arrays from the tiles' block and leaves the old
+// ones behind, like the table does.
+
+// Slots in the first table. Must be a power of 2.
+#define TILE_CHUNK_STORE_INITIAL_SLOTS 256
+
+// Lookups remembered. Must be a power of 2.
+#define TILE_CHUNK_STORE_CACHE_SIZE 16
+
+// Values a chunk's first palette holds. Doubled as it fills.
+#define TILE_CHUNK_STORE_INITIAL_PALETTE_SIZE 4
+
+// Longest run, and most values a run chunk can hold
+#define TILE_CHUNK_STORE_MAX_RUN_LENGTH 16
+#define TILE_CHUNK_STORE_MAX_RUN_VALUES 16
+
+typedef enum TileChunkEncoding
+{
+    // None of the tiles have been set
+    TILE_CHUNK_ENCODING_NONE,
+    TILE_CHUNK_ENCODING_UNIFORM,
+    TILE_CHUNK_ENCODING_RUNS,
+    TILE_CHUNK_ENCODING_PACKED,
+    TILE_CHUNK_ENCODING_VALUES,
+} TileChunkEncoding;
+
+typedef struct TileChunk
+{
+    // Which chunk this is
+    uint32 chunkX;
+    uint32 chunkY;
+    uint32 chunkZ;
+
+    // Bumped whenever one of the tiles changes, so that anything cached from
+    // them (E.g. the tile chunk cache's pixels) can tell it's out of date
+    uint32 version;
+
+    TileChunkEncoding encoding;
+
+    // TILE_CHUNK_ENCODING_UNIFORM. The value of every tile.
+    uint32 uniformValue;
+
+    // TILE_CHUNK_ENCODING_RUNS and TILE_CHUNK_ENCODING_PACKED. The values
+    // used in the chunk.
+    uint32 *palette;
+    uint32 paletteCount;
+    uint32 paletteSize;
+
+    // TILE_CHUNK_ENCODING_RUNS. Runs in use, of the store's runCapacity.
+    uint32 runCount;
+
+    // TILE_CHUNK_ENCODING_PACKED. 4 or 8.
+    uint32 bitsPerTile;
+
+    // The runs, indices or values, in rows from the bottom left. May be left
+    // over from when the chunk last had runs if it's uniform.
+    uint8 *tiles;
+
+} TileChunk;
+
+typedef struct TileChunkStoreCacheEntry
+{
+    uint32 chunkX;
+    uint32 chunkY;
+    uint32 chunkZ;
+
+    // False if the entry's never been used
+    bool32 used;
+
+    // NULL if there's no such chunk
+    TileChunk *tileChunk;
+
+} TileChunkStoreCacheEntry;
+
+typedef struct TileChunkStore
+{
+    // NULL where a slot's empty
+    TileChunk **slots;
+    uint32 slotCount;
+
+    // Chunks stored
+    uint32 chunkCount;
+
+    // Tiles across one side of each chunk, and in all
+    uint32 tileChunkTileDimensions;
+    uint32 tilesPerChunk;
+
+    // Most runs a run chunk can have
+    uint32 runCapacity;
+
+    // Bytes reserved from the tiles' block, including the arrays chunks have
+    // left behind
+    sizet tileBytesReserved;
+
+    TileChunkStoreCacheEntry cache[TILE_CHUNK_STORE_CACHE_SIZE];
+
+} TileChunkStore;
+
+// Where the tiles' memory has gone, for comparing the encodings
+typedef struct TileChunkStoreMemory
+{
+    // Chunks in each encoding, indexed by TileChunkEncoding
+    uint32 chunks[TILE_CHUNK_ENCODING_VALUES + 1];
+
+    // Bytes held by the chunks in each encoding, palettes included
+    sizet bytes[TILE_CHUNK_ENCODING_VALUES + 1];
+
+    // Bytes reserved from the tiles' block, including the arrays chunks have
+    // left behind
+    sizet reservedBytes;
+
+    // Bytes the chunks' tiles would take as one uint32 a tile
+    sizet unencodedBytes;
+
+} TileChunkStoreMemory;
+
+/**
+ * @brief Reserves the store and its first table from a memory block
+ *
+ * @param tileChunkTileDimensions   Tiles across one side of a chunk
+ */
+TileChunkStore *tileChunkStoreInit(MemoryRegion *memoryRegion,
+                                    MemoryBlock *memoryBlock,
+                                    uint32 tileChunkTileDimensions);
+
+/**
+ * @brief The chunk, or NULL if none of its tiles have been set
+ */
+TileChunk *tileChunkStoreGet(TileChunkStore *store, uint32 chunkX, uint32 chunkY, uint32 chunkZ);
+
+/**
+ * @brief The chunk, reserved (with no tiles yet) from memoryBlock if it isn't
+ * already stored. Pass the block the store was initialised with, as a bigger
+ * table may be reserved from it too.
+ */
+TileChunk *tileChunkStoreGetOrCreate(TileChunkStore *store,
+                                        MemoryRegion *memoryRegion,
+                                        MemoryBlock *memoryBlock,
+                                        uint32 chunkX,
+                                        uint32 chunkY,
+                                        uint32 chunkZ);
+
+/**
+ * @brief The value of one of the chunk's tiles. The chunk's tiles must have
+ * been set.
+ *
+ * @param tileIndex     (y * the chunk's tile dimensions) + x
+ */
+uint32 tileChunkStoreGetTile(TileChunkStore *store, TileChunk *tileChunk, uint32 tileIndex);
+
+/**
+ * @brief Unpacks the value of every one of the chunk's tiles into values,
+ * which must have room for tilesPerChunk of them
+ */
+void tileChunkStoreGetTiles(TileChunkStore *store, TileChunk *tileChunk, uint32 *values);
+
+/**
+ * @brief Sets the value of one of the chunk's tiles, moving it to a less
+ * compact encoding (and reserving what that needs from tilesMemoryBlock) if
+ * the one it's in can't hold it. Tiles that haven't been set are 0.
+ */
+void tileChunkStoreSetTile(TileChunkStore *store,
+                            TileChunk *tileChunk,
+                            MemoryRegion *memoryRegion,
+                            MemoryBlock *tilesMemoryBlock,
+                            uint32 tileIndex,
+                            uint32 value);
+
+/**
+ * @brief Adds up how much memory the chunks take in each encoding
+ */
+TileChunkStoreMemory tileChunkStoreGetMemory(TileChunkStore *store);
+
+#endif
@@ -10,7 +10,6 @@ void initTilemap(MemoryRegion *memoryRegion,
                     MemoryBlock *memoryBlock,
                     uint16 pixelsPerMeter,
                     uint32 tileDimensionsBitShift,
-                    uint32 tileChunkDimensionsBitShift,
                     uint32 tilemapTotalZPlanes,
                     uint32 tileChunkTileDimensionsBitShift,
                     float32 tileDimensionsMeters,
@@ -21,32 +20,41 @@ void initTilemap(MemoryRegion *memoryRegion,
     gameState->world.tilemap.tileDimensionsBitShift     = tileDimensionsBitShift;
     gameState->world.tilemap.tileDimensions             = (1 << tileDimensionsBitShift);
 
-    gameState->world.tilemap.tileChunkDimensionsBitShift    = tileChunkDimensionsBitShift;
-    gameState->world.tilemap.tileChunkDimensions            = (1 << tileChunkDimensionsBitShift);
-
     gameState->world.tilemap.tileChunkTileDimensionsBitShift    = tileChunkTileDimensionsBitShift;
     gameState->world.tilemap.tileChunkTileDimensions            = (1 << tileChunkTileDimensionsBitShift);
 
-    // Check that the tilemap's total possible tile dimensions are at least
-    // big enough to hold the number of tile chunks and tile chunk tile dimensions
-    assert(gameState->world.tilemap.tileDimensions >= (gameState->world.tilemap.tileChunkDimensions * gameState->world.tilemap.tileChunkTileDimensions))
+    // Check that the tilemap is at least one tile chunk across
+    assert(tileDimensionsBitShift >= tileChunkTileDimensionsBitShift);
+
+    gameState->world.tilemap.tileChunkDimensionsBitShift    = (tileDimensionsBitShift - tileChunkTileDimensionsBitShift);
+    gameState->world.tilemap.tileChunkDimensions            = (1 << gameState->world.tilemap.tileChunkDimensionsBitShift);
+
+    gameState->world.tilemap.zPlanes = tilemapTotalZPlanes;
 
     gameState->world.tilemap.tileHeightPx = (uint32)((uint32)pixelsPerMeter * tileDimensionsMeters);
     gameState->world.tilemap.tileWidthPx = gameState->world.tilemap.tileHeightPx;
 
+    setTilemapScreenSize(&gameState->world.tilemap, frameBuffer->widthPx, frameBuffer->heightPx);
+
+    // The tile chunks are reserved from within the memory block as they're
+    // written to
+    gameState->world.tilemap.tileChunkStore = tileChunkStoreInit(memoryRegion,
+                                                                    memoryBlock,
+                                                                    gameState->world.tilemap.tileChunkTileDimensions);
+}
+
+void setTilemapScreenSize(Tilemap *tilemap, uint32 screenWidthPx, uint32 screenHeightPx)
+{
+    tilemap->screenWidthPx = screenWidthPx;
+    tilemap->screenHeightPx = screenHeightPx;
+
     // Calculate how many rows/columns we can fit on a screen and add
     // margin of safety for smooth scrolling.
-    gameState->world.tilemap.tilesPerScreenX = (u32RoundUpDivide(frameBuffer->widthPx, gameState->world.tilemap.tileWidthPx) + 2);
-    gameState->world.tilemap.tilesPerHalfScreenX = i32RoundUpDivide((int32)gameState->world.tilemap.tilesPerScreenX, 2);
+    tilemap->tilesPerScreenX = (u32RoundUpDivide(screenWidthPx, tilemap->tileWidthPx) + 2);
+    tilemap->tilesPerHalfScreenX = i32RoundUpDivide((int32)tilemap->tilesPerScreenX, 2);
 
-    gameState->world.tilemap.tilesPerScreenY = (u32RoundUpDivide(frameBuffer->heightPx, gameState->world.tilemap.tileHeightPx) + 2);
-    gameState->world.tilemap.tilesPerHalfScreenY = i32RoundUpDivide((int32)gameState->world.tilemap.tilesPerScreenY, 2);
-
-    // Reserve the tile chunk arrays from within the memory block
-    gameState->world.tilemap.tileChunks = memoryBlockReserveArray(memoryRegion,
-                                                                    memoryBlock,
-                                                                    TileChunk,
-                                                                    (sizet)((gameState->world.tilemap.tileChunkDimensions * gameState->world.tilemap.tileChunkDimensions) * tilemapTotalZPlanes));
+    tilemap->tilesPerScreenY = (u32RoundUpDivide(screenHeightPx, tilemap->tileHeightPx) + 2);
+    tilemap->tilesPerHalfScreenY = i32RoundUpDivide((int32)tilemap->tilesPerScreenY, 2);
 }
 
 /**
@@ -102,9 +110,13 @@ void setTilemapPositionData(TilemapPosition *tilemapPosition,
     tilemapPosition->tileChunk = getTileChunkFromTileChunkIndex(chunkIndex, tilemap);
 
     // Get the active tile
-    uint32 *tile = tilemapPosition->tileChunk->tiles;
-    tile += (chunkRelativeTileIndex.y * tilemap.tileChunkTileDimensions) + chunkRelativeTileIndex.x;
-    tilemapPosition->activeTile = tile;
+    tilemapPosition->activeTile = 0;
+
+    if (tilemapPosition->tileChunk && (TILE_CHUNK_ENCODING_NONE != tilemapPosition->tileChunk->encoding)) {
+        tilemapPosition->activeTile = tileChunkStoreGetTile(tilemap.tileChunkStore,
+                                                            tilemapPosition->tileChunk,
+                                                            ((chunkRelativeTileIndex.y * tilemap.tileChunkTileDimensions) + chunkRelativeTileIndex.x));
+    }
 
     return;
 }
@@ -136,9 +148,7 @@ TileChunk *getTileChunkForAbsTile(uint32 absTileX, uint32 absTileY, uint32 absTi
 
 TileChunk *getTileChunkFromTileChunkIndex(xyzuint tileChunkIndex, Tilemap tilemap)
 {
-    TileChunk *tileChunk = tilemap.tileChunks;
-    tileChunk = tileChunk + (tileChunkIndex.z * (tilemap.tileChunkDimensions * tilemap.tileChunkDimensions)) + (tileChunkIndex.y * tilemap.tileChunkDimensions) + tileChunkIndex.x;
-    return tileChunk;
+    return tileChunkStoreGet(tilemap.tileChunkStore, tileChunkIndex.x, tileChunkIndex.y, tileChunkIndex.z);
 }
 
 
@@ -171,29 +181,34 @@ void setTileValue(MemoryRegion memoryRegion,
 {
     Tilemap tilemap = gameState->world.tilemap;
 
-    TileChunk *tileChunk = getTileChunkForAbsTile(absTileX, absTileY, absTileZ, tilemap);
-
-    // Is this tile chunk out of the sparse storage memory bounds?
-#if HANDMADE_LOCAL_BUILD
-    if ((uint8 *)tileChunk > gameState->tileChunksMemoryBlock.lastAddressReserved
-        || (uint8 *)tileChunk < gameState->tileChunksMemoryBlock.startingAddress){
-        assert(!"Cannot set tile value for an absolute tile that sits outside of the available tile chunks")
+    // Is this tile outside of the world?
+    if ((absTileX >= tilemap.tileDimensions)
+        || (absTileY >= tilemap.tileDimensions)
+        || (absTileZ >= tilemap.zPlanes)){
+        assert(!"Cannot set tile value for an absolute tile that sits outside of the tilemap");
+        return;
     }
-#endif
 
-    if (!tileChunk->tiles){
-        tileChunk->tiles = memoryBlockReserveArray(&memoryRegion,
-                                                    &gameState->tilesMemoryBlock,
-                                                    uint32,
-                                                    (sizet)(tilemap.tileChunkTileDimensions * tilemap.tileChunkTileDimensions));
+    xyzuint tileChunkIndex = getTileChunkIndexForAbsTile(absTileX, absTileY, absTileZ, tilemap);
 
-    }
+    TileChunk *tileChunk = tileChunkStoreGetOrCreate(tilemap.tileChunkStore,
+                                                        &memoryRegion,
+                                                        &gameState->tileChunksMemoryBlock,
+                                                        tileChunkIndex.x,
+                                                        tileChunkIndex.y,
+                                                        tileChunkIndex.z);
 
     xyuint chunkRelTileIndex = getChunkRelativeTileIndex(absTileX, absTileY, tilemap);
 
-    uint32 *tile = tileChunk->tiles;
-    tile += (chunkRelTileIndex.y * tilemap.tileChunkTileDimensions) + chunkRelTileIndex.x;
-    *tile = value;
+    // Whatever the tiles' encoding needs is reserved from their own block
+    tileChunkStoreSetTile(tilemap.tileChunkStore,
+                            tileChunk,
+                            &memoryRegion,
+                            &gameState->tilesMemoryBlock,
+                            ((chunkRelTileIndex.y * tilemap.tileChunkTileDimensions) + chunkRelTileIndex.x),
+                            value);
+
+    tileChunk->version++;
 }
 
 
@@ -204,27 +219,23 @@ bool isTilemapTileFree(GameState *gameState, Tilemap tilemap, PlayerPositionData
     return true;
 #else
 
-    // Is this tile chunk out of the sparse storage memory bounds?
+    // Is this tile chunk outside of the tilemap?
     if ( (playerPositionData->tilemapPosition.chunkIndex.x > (tilemap.tileChunkDimensions -1))
         || (playerPositionData->tilemapPosition.chunkIndex.y > (tilemap.tileChunkDimensions -1))){
         return false;
     }
 
-    if ((uint8 *)playerPositionData->tilemapPosition.tileChunk > gameState->tileChunksMemoryBlock.lastAddressReserved
-        || (uint8 *)playerPositionData->tilemapPosition.tileChunk < gameState->tileChunksMemoryBlock.startingAddress){
+    // Has any tile within this tile chunk been set?
+    if (!playerPositionData->tilemapPosition.tileChunk) {
         return false;
     }
 
     // Have the tiles within this tile chunk been initialised?
-    if (!playerPositionData->tilemapPosition.tileChunk->tiles) {
-        return false;
-    }
-
-    if (!playerPositionData->tilemapPosition.activeTile) {
+    if (TILE_CHUNK_ENCODING_NONE == playerPositionData->tilemapPosition.tileChunk->encoding) {
         return false;
     }
 
-    if (*playerPositionData->tilemapPosition.activeTile == 2) {
+    if (playerPositionData->tilemapPosition.activeTile == 2) {
         return false;
     }
 
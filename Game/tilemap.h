@@ -4,6 +4,7 @@
 #include "types.h"
 #include "utility.h"
 #include "memory.h"
+#include "tile_chunk_store.h"
 
 //
 // Tilemap
@@ -15,17 +16,15 @@
 // 0 = 1x1
 // 1 = 2x2
 // 2 = 4x4 etc
-#define TILE_DIMENSIONS_BIT_SHIFT 10
-
-// How many bits of a 32-bit integer do we want to allocate to the total number
-// of possible "tile chunks" dimensions*? (*along one side)
-// 
-// Note:
-// 1) Tiles can only be stored within a tile chunk, not arbitrarily anywhere in the world 
-// 2) Not all tile chunks have to be used.
-#define TILE_CHUNK_DIMENSIONS_BIT_SHIFT 6
-
-// How many z-planes should be allocated? Min 1
+//
+// Tile chunks are only stored once they're written to (see
+// tile_chunk_store.h), so a bigger world costs nothing until it's used. The
+// player's position is a float32 though, so keep the world's width in pixels
+// well under 2^24 (16384 40px tiles is 655360px, a 1/16th pixel step at the
+// far edge).
+#define TILE_DIMENSIONS_BIT_SHIFT 14
+
+// How many z-planes the world has. Min 1
 #define TILEMAP_Z_PLANES 3
 
 // How many bits of a 32-bit integer do we want to allocate to each tile chunk's
@@ -38,13 +37,6 @@
 // How many meters does one side of an individual tile have? (Tiles are always square)
 #define TILE_DIMENSIONS_METERS 2.0f
 
-typedef struct TileChunk
-{
-    // Pointer to all of the tile data
-    uint32 *tiles;
-
-} TileChunk;
-
 typedef struct Tilemap
 {
     // Total number of tiles across 1 whole side of the tilemap
@@ -52,10 +44,13 @@ typedef struct Tilemap
     uint32 tileDimensionsBitShift;
     uint32 tileDimensions;
 
-    // Total number of tile chunks requested within the tilemap
+    // Total number of tile chunks across 1 whole side of the tilemap.
+    // Worked out from the tile and tile chunk dimensions.
     uint32 tileChunkDimensionsBitShift;
     uint32 tileChunkDimensions;
 
+    uint32 zPlanes;
+
     // Total number of tiles across one side of an individual tile chunk
     // (Tile chunks are always square)
     uint32 tileChunkTileDimensionsBitShift;
@@ -67,9 +62,13 @@ typedef struct Tilemap
     uint32 tileHeightPx;
     uint32 tileWidthPx;
 
-    // Pointer to all of the tile chunks
-    TileChunk *tileChunks;
+    // Every tile chunk that's been written to
+    TileChunkStore *tileChunkStore;
 
+    // Worked out from the size of the screen (the frame buffer the game lays
+    // out for) by setTilemapScreenSize
+    uint32 screenWidthPx;
+    uint32 screenHeightPx;
     uint32 tilesPerScreenX;
     uint32 tilesPerHalfScreenX;
     uint32 tilesPerScreenY;
@@ -95,10 +94,13 @@ typedef struct TilemapPosition
     // The tile relative pixel position
     xyuint tileRelativePixelPos;
 
-    // Pointer to the active tile chunk
+    // Pointer to the active tile chunk. NULL if none of its tiles have been
+    // set.
     TileChunk *tileChunk;
 
-    uint32 *activeTile;
+    // The active tile's value. 0 if the tile chunk's tiles haven't been set,
+    // as for a tile that hasn't.
+    uint32 activeTile;
 
 } TilemapPosition;
 
@@ -112,12 +114,17 @@ void initTilemap(MemoryRegion *memoryRegion,
                     MemoryBlock *memoryBlock,
                     uint16 pixelsPerMeter,
                     uint32 tileDimensionsBitShift,
-                    uint32 tileChunkDimensionsBitShift,
                     uint32 tilemapTotalZPlanes,
                     uint32 tileChunkTileDimensionsBitShift,
                     float32 tileDimensionsMeters,
                     GameFrameBuffer *frameBuffer);
 
+/**
+ * @brief Works out how many tiles fit on a screen of the given size. Call
+ * whenever the size changes.
+ */
+void setTilemapScreenSize(Tilemap *tilemap, uint32 screenWidthPx, uint32 screenHeightPx);
+
 void setTilemapPositionData(TilemapPosition *tilemapPosition,
                             uint32 pixelX,
                             uint32 pixelY,
@@ -141,6 +148,7 @@ xyuint geAbsTileIndexFromAbsPixel(uint32 pixelX, uint32 pixelY, Tilemap tilemap)
 
 xyzuint getTileChunkIndexForAbsTile(uint32 absTileX, uint32 absTileY, uint32 absTileZ, Tilemap tilemap);
 
+// NULL if none of the chunk's tiles have been set
 TileChunk *getTileChunkForAbsTile(uint32 absTileX, uint32 absTileY, uint32 absTileZ, Tilemap tilemap);
 TileChunk *getTileChunkFromTileChunkIndex(xyzuint tileChunkIndex, Tilemap tilemap);
 xyuint getChunkRelativeTileIndex(uint32 absTileX, uint32 absTileY, Tilemap tilemap);
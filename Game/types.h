@@ -27,6 +27,8 @@ typedef unsigned long long  uint64;     // 8 bytes
 typedef float               float32;    // 4 bytes
 typedef double              float64;    // 8 bytes
 
+// size_t is built in to MSVC but needs declaring for GCC/Clang
+#include <stddef.h>
 typedef size_t              sizet;      // To represent the size or count of something
 
 // Boolean
@@ -0,0 +1,97 @@
+#include "work_queue.h"
+
+void workQueueInit(WorkQueue *queue, uint32 threadCount)
+{
+    assert((threadCount > 0) && (threadCount <= WORK_QUEUE_MAX_THREADS));
+
+    queue->threadCount = threadCount;
+    queue->nextDeque = 0;
+    queue->entriesAdded = 0;
+    queue->entriesCompleted = 0;
+
+    for (uint32 i = 0; i < WORK_QUEUE_MAX_THREADS; i++) {
+        queue->deques[i].addIndex = 0;
+        queue->deques[i].takeIndex = 0;
+    }
+}
+
+bool32 workQueueAdd(WorkQueue *queue, PlatformWorkQueueCallback *callback, void *data)
+{
+    WorkQueueDeque *deque = &queue->deques[queue->nextDeque];
+
+    uint32 addIndex = deque->addIndex;
+
+    // Unsigned, so still correct once the indexes wrap
+    if ((addIndex - workQueueLoad(&deque->takeIndex)) >= WORK_QUEUE_DEQUE_ENTRIES) {
+        return false;
+    }
+
+    WorkQueueEntry *entry = &deque->entries[addIndex & (WORK_QUEUE_DEQUE_ENTRIES - 1)];
+    entry->callback = callback;
+    entry->data = data;
+
+    // Count it before it can be taken, so the queue can't look complete
+    // whilst it's running
+    workQueueIncrement(&queue->entriesAdded);
+
+    // Publishes the entry
+    workQueueStore(&deque->addIndex, (addIndex + 1));
+
+    queue->nextDeque = ((queue->nextDeque + 1) % queue->threadCount);
+
+    return true;
+}
+
+/**
+ * Claims the oldest entry in a deque. A thread that reads takeIndex just
+ * before another thread claims the same entry fails the compare and exchange
+ * and tries again with the next one.
+ */
+internal_func bool32 workQueueTake(WorkQueueDeque *deque, WorkQueueEntry *entry)
+{
+    for (;;) {
+
+        uint32 takeIndex = workQueueLoad(&deque->takeIndex);
+
+        if (takeIndex == workQueueLoad(&deque->addIndex)) {
+            return false;
+        }
+
+        // Read before claiming. Once it's claimed the owner may reuse the slot.
+        *entry = deque->entries[takeIndex & (WORK_QUEUE_DEQUE_ENTRIES - 1)];
+
+        if (workQueueCompareExchange(&deque->takeIndex, takeIndex, (takeIndex + 1))) {
+            return true;
+        }
+    }
+}
+
+bool32 workQueueRunNextEntry(WorkQueue *queue, PlatformThreadContext *thread)
+{
+    uint32 ownDeque = (thread->threadIndex % queue->threadCount);
+
+    WorkQueueEntry entry;
+
+    // Own deque first, then the others, starting with the next thread along
+    // so that thieves spread out rather than all raiding thread 0
+    for (uint32 i = 0; i < queue->threadCount; i++) {
+
+        WorkQueueDeque *deque = &queue->deques[((ownDeque + i) % queue->threadCount)];
+
+        if (workQueueTake(deque, &entry)) {
+
+            entry.callback(thread, entry.data);
+
+            workQueueIncrement(&queue->entriesCompleted);
+
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool32 workQueueIsComplete(WorkQueue *queue)
+{
+    return (workQueueLoad(&queue->entriesCompleted) == workQueueLoad(&queue->entriesAdded));
+}
@@ -0,0 +1,106 @@
+#ifndef HEADER_HH_WORK_QUEUE
+#define HEADER_HH_WORK_QUEUE
+
+//
+// Work queue. Shared by the platform layers
+// ============================================================================
+//
+// The lock-free part of PlatformWorkQueue. The platform layers own the
+// threads and wake them, this decides which entry each thread runs next.
+//
+// Every thread (the one adding entries as well as the workers) has a deque of
+// its own. Entries are dealt out to the deques in turn, so each thread starts
+// on its own share of the work. A thread whose deque runs dry steals from the
+// others, so a thread that's been handed slow entries, or has been descheduled,
+// doesn't hold everyone up.
+//
+// Entries are only ever added by the thread that owns the queue. Each deque's
+// addIndex and takeIndex are free running counters masked into the deque, and
+// an entry is claimed by moving takeIndex on with a compare and exchange. The
+// owner and thieves take from the same end, so claiming is the only place
+// they race.
+
+#include "global.h"
+
+// Threads that can take from a queue, including the thread that adds to it
+#define WORK_QUEUE_MAX_THREADS 32
+
+// Entries each thread's deque can hold at once. Power of two.
+#define WORK_QUEUE_DEQUE_ENTRIES 1024
+
+#if COMPILER_MSVC
+#define workQueueLoad(ptr)                              ((uint32)_InterlockedOr((volatile long *)(ptr), 0))
+#define workQueueStore(ptr, value)                      _InterlockedExchange((volatile long *)(ptr), (long)(value))
+#define workQueueIncrement(ptr)                         _InterlockedIncrement((volatile long *)(ptr))
+#define workQueueCompareExchange(ptr, expected, value)  ((long)(expected) == _InterlockedCompareExchange((volatile long *)(ptr), (long)(value), (long)(expected)))
+#else
+#define workQueueLoad(ptr)                              __atomic_load_n((ptr), __ATOMIC_ACQUIRE)
+#define workQueueStore(ptr, value)                      __atomic_store_n((ptr), (value), __ATOMIC_RELEASE)
+#define workQueueIncrement(ptr)                         __atomic_add_fetch((ptr), 1, __ATOMIC_ACQ_REL)
+#define workQueueCompareExchange(ptr, expected, value)  __atomic_compare_exchange_n((ptr), &(expected), (value), false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)
+#endif
+
+typedef struct WorkQueueEntry
+{
+    PlatformWorkQueueCallback *callback;
+    void *data;
+} WorkQueueEntry;
+
+typedef struct WorkQueueDeque
+{
+    // Entries added / claimed since the start
+    volatile uint32 addIndex;
+    volatile uint32 takeIndex;
+
+    // Keep the indexes of neighbouring deques off each other's cache lines
+    uint8 padding[56];
+
+    WorkQueueEntry entries[WORK_QUEUE_DEQUE_ENTRIES];
+
+} WorkQueueDeque;
+
+typedef struct WorkQueue
+{
+    // Thread 0 is the one that adds entries. The rest are workers.
+    uint32 threadCount;
+
+    // The deque the next entry goes in. Owner only.
+    uint32 nextDeque;
+
+    // Entries added / finished since the start. The queue is idle when
+    // they're equal.
+    volatile uint32 entriesAdded;
+    volatile uint32 entriesCompleted;
+
+    WorkQueueDeque deques[WORK_QUEUE_MAX_THREADS];
+
+} WorkQueue;
+
+/**
+ * @param threadCount   The thread that adds entries plus the workers. At
+ *                      most WORK_QUEUE_MAX_THREADS.
+ */
+void workQueueInit(WorkQueue *queue, uint32 threadCount);
+
+/**
+ * @brief Adds an entry to the next deque in turn. Owner only.
+ *
+ * @return False if that deque is full
+ */
+bool32 workQueueAdd(WorkQueue *queue, PlatformWorkQueueCallback *callback, void *data);
+
+/**
+ * @brief Runs one entry: from the calling thread's own deque if it has any,
+ * otherwise stolen from another thread's.
+ *
+ * @param thread    threadIndex picks the thread's own deque
+ * @return          False if there was nothing left to take
+ */
+bool32 workQueueRunNextEntry(WorkQueue *queue, PlatformThreadContext *thread);
+
+/**
+ * @brief True once every entry added so far has finished running
+ */
+bool32 workQueueIsComplete(WorkQueue *queue);
+
+#endif
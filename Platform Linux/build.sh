@@ -0,0 +1,125 @@
+#!/bin/sh
+
+# =========================================================================================
+#
+# Builds the Linux platform layer executable and the Game shared object
+#
+# Usage: build.sh <Configuration> [CopyAssets] [GameOnly]
+# E.g. build.sh Debug 1
+#
+# Pass GameOnly as 1 to rebuild just Game.so whilst the game is running. The
+# running platform layer will notice the new Game.so and reload it.
+#
+# Set CXX to use a compiler other than g++
+#
+# =========================================================================================
+
+set -e
+
+if [ -z "$1" ]; then
+    echo "Usage: $0 <Configuration> <CopyAssets> <GameOnly>"
+    exit 1
+fi
+
+Configuration=$1
+CopyAssets=${2:-0}
+GameOnly=${3:-0}
+
+if [ "$Configuration" = "Debug" ]; then
+    ConfigurationFlags="-g -O0 -DHANDMADE_LOCAL_BUILD=1"
+elif [ "$Configuration" = "Release" ]; then
+    ConfigurationFlags="-g -O2 -DNDEBUG"
+else
+    echo "Invalid configuration. Supported configurations: Debug, Release"
+    exit 1
+fi
+
+CXX=${CXX:-g++}
+
+echo =============
+echo Building Linux $Configuration
+echo =============
+
+# Root build folder
+ScriptFolder=$(cd "$(dirname "$0")" && pwd)
+SolutionFolder="$ScriptFolder/.."
+GameFolder="$SolutionFolder/Game"
+DataFolder="$SolutionFolder/data"
+BuildConfigurationFolder="$SolutionFolder/build/Linux/$Configuration"
+
+mkdir -p "$BuildConfigurationFolder"
+
+CompilerFlags="-std=c++17 -Wall -Wno-unused-variable -Wno-unused-function -Wno-unused-but-set-variable -fno-exceptions -fno-rtti $ConfigurationFlags"
+
+# Copy the data assets
+if [ "$CopyAssets" = "1" ]; then
+    echo "COPY ASSETS"
+    rm -rf "$BuildConfigurationFolder/data"
+    cp -R "$DataFolder" "$BuildConfigurationFolder/data"
+fi
+
+# Build the game code. We build to a temporary file and rename it into place
+# so that a running platform layer never sees a half written Game.so
+$CXX $CompilerFlags -fPIC -shared -fvisibility=hidden \
+    -o "$BuildConfigurationFolder/Game.so.tmp" \
+    "$GameFolder/game.cpp" \
+    "$GameFolder/intrinsics.cpp" \
+    "$GameFolder/global_utility.cpp" \
+    "$GameFolder/utility.cpp" \
+    "$GameFolder/memory.cpp" \
+    "$GameFolder/player.cpp" \
+    "$GameFolder/world.cpp" \
+    "$GameFolder/tilemap.cpp" \
+    "$GameFolder/graphics.cpp" \
+    "$GameFolder/audio.cpp" \
+    "$GameFolder/oscillator.cpp" \
+    "$GameFolder/mixer.cpp" \
+    "$GameFolder/renderer.cpp" \
+    "$GameFolder/tile_chunk_cache.cpp" \
+    "$GameFolder/tile_chunk_store.cpp" \
+    "$GameFolder/resolution.cpp" \
+    "$GameFolder/filesystem.cpp" \
+    "$GameFolder/math.cpp"
+
+mv -f "$BuildConfigurationFolder/Game.so.tmp" "$BuildConfigurationFolder/Game.so"
+
+if [ "$GameOnly" = "1" ]; then
+    exit 0
+fi
+
+# Build the platform layer
+$CXX $CompilerFlags \
+    -o "$BuildConfigurationFolder/handmade" \
+    "$ScriptFolder/linux_handmade.cpp" \
+    -lX11 -ldl -lpthread
+
+# Build the headless runner
+$CXX $CompilerFlags \
+    -o "$BuildConfigurationFolder/handmade_headless" \
+    "$ScriptFolder/linux_headless.cpp" \
+    -ldl -lpthread
+
+# Build the benchmark runner. It links the game code in directly, rather than
+# loading Game.so, so that it can time the game's internals
+$CXX $CompilerFlags \
+    -o "$BuildConfigurationFolder/handmade_benchmark" \
+    "$ScriptFolder/linux_benchmark.cpp" \
+    "$GameFolder/game.cpp" \
+    "$GameFolder/intrinsics.cpp" \
+    "$GameFolder/global_utility.cpp" \
+    "$GameFolder/utility.cpp" \
+    "$GameFolder/memory.cpp" \
+    "$GameFolder/player.cpp" \
+    "$GameFolder/world.cpp" \
+    "$GameFolder/tilemap.cpp" \
+    "$GameFolder/graphics.cpp" \
+    "$GameFolder/audio.cpp" \
+    "$GameFolder/oscillator.cpp" \
+    "$GameFolder/mixer.cpp" \
+    "$GameFolder/renderer.cpp" \
+    "$GameFolder/tile_chunk_cache.cpp" \
+    "$GameFolder/tile_chunk_store.cpp" \
+    "$GameFolder/resolution.cpp" \
+    "$GameFolder/filesystem.cpp" \
+    "$GameFolder/math.cpp" \
+    -ldl -lpthread
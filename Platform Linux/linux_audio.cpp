@@ -0,0 +1,600 @@
+// Audio output shared by the Linux platform layer and the headless runner.
+// This file is included directly into each executable's translation unit
+// (after linux_audio.h), in the same way linux_common.cpp is.
+
+internal_func uint32 linuxAudioFramesFromUS(uint64 microseconds, uint32 samplesPerSecond)
+{
+    return (uint32)((microseconds * samplesPerSecond) / 1000000);
+}
+
+//
+// PulseAudio sink
+//
+
+LINUX_AUDIO_SINK_WRITE(linuxPulseAudioSinkWrite)
+{
+    int error = 0;
+    return (0 == sink->pulseAudioSimpleWrite(sink->device, frames, (frameCount * AUDIO_RING_BUFFER_BYTES_PER_FRAME), &error));
+}
+
+LINUX_AUDIO_SINK_DELAY(linuxPulseAudioSinkDelay)
+{
+    int error = 0;
+    uint64 latencyUS = sink->pulseAudioSimpleGetLatency(sink->device, &error);
+
+    // Failing returns (pa_usec_t)-1, which isn't a latency
+    if (error) {
+        return 0;
+    }
+
+    return linuxAudioFramesFromUS(latencyUS, sink->samplesPerSecond);
+}
+
+LINUX_AUDIO_SINK_CLOSE(linuxPulseAudioSinkClose)
+{
+    sink->pulseAudioSimpleFree(sink->device);
+    dlclose(sink->libraryHandle);
+}
+
+LINUX_AUDIO_SINK_OPEN(linuxPulseAudioSinkOpen)
+{
+    sink->libraryHandle = dlopen(LINUX_PULSE_AUDIO_LIBRARY, RTLD_NOW);
+
+    if (!sink->libraryHandle) {
+        return false;
+    }
+
+    PulseAudioSimpleNewDT *pulseAudioSimpleNew = (PulseAudioSimpleNewDT *)dlsym(sink->libraryHandle, "pa_simple_new");
+
+    sink->pulseAudioSimpleWrite = (PulseAudioSimpleWriteDT *)dlsym(sink->libraryHandle, "pa_simple_write");
+    sink->pulseAudioSimpleGetLatency = (PulseAudioSimpleGetLatencyDT *)dlsym(sink->libraryHandle, "pa_simple_get_latency");
+    sink->pulseAudioSimpleFree = (PulseAudioSimpleFreeDT *)dlsym(sink->libraryHandle, "pa_simple_free");
+
+    if (!pulseAudioSimpleNew
+        || !sink->pulseAudioSimpleWrite
+        || !sink->pulseAudioSimpleGetLatency
+        || !sink->pulseAudioSimpleFree) {
+        dlclose(sink->libraryHandle);
+        return false;
+    }
+
+    LinuxPulseAudioSampleSpec sampleSpec = {0};
+    sampleSpec.format = LINUX_PULSE_AUDIO_SAMPLE_S16LE;
+    sampleSpec.rate = samplesPerSecond;
+    sampleSpec.channels = LINUX_AUDIO_CHANNELS;
+
+    // Ask the server to hold no more than our device latency. (uint32)-1
+    // leaves the rest at the server's defaults.
+    LinuxPulseAudioBufferAttr bufferAttr = {0};
+    bufferAttr.maxlength = (uint32)-1;
+    bufferAttr.tlength = (linuxAudioFramesFromUS(LINUX_AUDIO_DEVICE_LATENCY_US, samplesPerSecond) * AUDIO_RING_BUFFER_BYTES_PER_FRAME);
+    bufferAttr.prebuf = (uint32)-1;
+    bufferAttr.minreq = (uint32)-1;
+    bufferAttr.fragsize = (uint32)-1;
+
+    int error = 0;
+    sink->device = pulseAudioSimpleNew(NULL,
+                                        "Handmade Hero",
+                                        LINUX_PULSE_AUDIO_STREAM_PLAYBACK,
+                                        NULL,
+                                        "Game",
+                                        &sampleSpec,
+                                        NULL,
+                                        &bufferAttr,
+                                        &error);
+
+    if (!sink->device) {
+        dlclose(sink->libraryHandle);
+        return false;
+    }
+
+    sink->name = "pulse";
+    sink->realTime = true;
+    sink->write = &linuxPulseAudioSinkWrite;
+    sink->delay = &linuxPulseAudioSinkDelay;
+    sink->close = &linuxPulseAudioSinkClose;
+
+    return true;
+}
+
+//
+// ALSA sink
+//
+
+LINUX_AUDIO_SINK_WRITE(linuxALSASinkWrite)
+{
+    const uint32 *framesLeft = (const uint32 *)frames;
+
+    while (frameCount > 0) {
+
+        long framesWritten = sink->alsaPCMWritei(sink->device, framesLeft, frameCount);
+
+        if (framesWritten < 0) {
+
+            // Recovers from a device underrun (-EPIPE) or suspend. Anything
+            // else and the device has gone.
+            if (sink->alsaPCMRecover(sink->device, (int)framesWritten, 1) < 0) {
+                return false;
+            }
+
+            continue;
+        }
+
+        framesLeft += framesWritten;
+        frameCount -= (uint32)framesWritten;
+    }
+
+    return true;
+}
+
+LINUX_AUDIO_SINK_DELAY(linuxALSASinkDelay)
+{
+    long delayFrames = 0;
+
+    if ((sink->alsaPCMDelay(sink->device, &delayFrames) < 0) || (delayFrames < 0)) {
+        return 0;
+    }
+
+    return (uint32)delayFrames;
+}
+
+LINUX_AUDIO_SINK_CLOSE(linuxALSASinkClose)
+{
+    sink->alsaPCMClose(sink->device);
+    dlclose(sink->libraryHandle);
+}
+
+LINUX_AUDIO_SINK_OPEN(linuxALSASinkOpen)
+{
+    sink->libraryHandle = dlopen(LINUX_ALSA_LIBRARY, RTLD_NOW);
+
+    if (!sink->libraryHandle) {
+        return false;
+    }
+
+    ALSAPCMOpenDT *alsaPCMOpen = (ALSAPCMOpenDT *)dlsym(sink->libraryHandle, "snd_pcm_open");
+    ALSAPCMSetParamsDT *alsaPCMSetParams = (ALSAPCMSetParamsDT *)dlsym(sink->libraryHandle, "snd_pcm_set_params");
+
+    sink->alsaPCMWritei = (ALSAPCMWriteiDT *)dlsym(sink->libraryHandle, "snd_pcm_writei");
+    sink->alsaPCMRecover = (ALSAPCMRecoverDT *)dlsym(sink->libraryHandle, "snd_pcm_recover");
+    sink->alsaPCMDelay = (ALSAPCMDelayDT *)dlsym(sink->libraryHandle, "snd_pcm_delay");
+    sink->alsaPCMClose = (ALSAPCMCloseDT *)dlsym(sink->libraryHandle, "snd_pcm_close");
+
+    if (!alsaPCMOpen
+        || !alsaPCMSetParams
+        || !sink->alsaPCMWritei
+        || !sink->alsaPCMRecover
+        || !sink->alsaPCMDelay
+        || !sink->alsaPCMClose) {
+        dlclose(sink->libraryHandle);
+        return false;
+    }
+
+    if (alsaPCMOpen(&sink->device, "default", LINUX_ALSA_PCM_STREAM_PLAYBACK, 0) < 0) {
+        dlclose(sink->libraryHandle);
+        return false;
+    }
+
+    if (alsaPCMSetParams(sink->device,
+                            LINUX_ALSA_PCM_FORMAT_S16_LE,
+                            LINUX_ALSA_PCM_ACCESS_RW_INTERLEAVED,
+                            LINUX_AUDIO_CHANNELS,
+                            samplesPerSecond,
+                            1,
+                            LINUX_AUDIO_DEVICE_LATENCY_US) < 0) {
+        sink->alsaPCMClose(sink->device);
+        dlclose(sink->libraryHandle);
+        return false;
+    }
+
+    sink->name = "alsa";
+    sink->realTime = true;
+    sink->write = &linuxALSASinkWrite;
+    sink->delay = &linuxALSASinkDelay;
+    sink->close = &linuxALSASinkClose;
+
+    return true;
+}
+
+//
+// Null sink. Throws the frames away but takes as long as a device would to
+// play them, so everything upstream behaves as it would with a real device.
+//
+
+LINUX_AUDIO_SINK_DELAY(linuxNullSinkDelay)
+{
+    struct timespec now = linuxGetTime();
+
+    int64 aheadNS = (((int64)(sink->playedUntil.tv_sec - now.tv_sec) * 1000000000LL) + (int64)(sink->playedUntil.tv_nsec - now.tv_nsec));
+
+    if (aheadNS <= 0) {
+        return 0;
+    }
+
+    return linuxAudioFramesFromUS((uint64)(aheadNS / 1000), sink->samplesPerSecond);
+}
+
+LINUX_AUDIO_SINK_WRITE(linuxNullSinkWrite)
+{
+    struct timespec now = linuxGetTime();
+
+    // The "device" ran dry. Playback restarts from now.
+    if (0 == linuxNullSinkDelay(sink)) {
+        sink->playedUntil = now;
+    }
+
+    sink->playedUntil = linuxTimespecAddNS(sink->playedUntil, (((int64)frameCount * 1000000000LL) / sink->samplesPerSecond));
+
+    // Block whilst more than the device latency is queued
+    struct timespec wakeAt = linuxTimespecAddNS(sink->playedUntil, -((int64)LINUX_AUDIO_DEVICE_LATENCY_US * 1000LL));
+
+    while (EINTR == clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &wakeAt, NULL)) {
+        // Interrupted by a signal. Go back to sleep.
+    }
+
+    return true;
+}
+
+LINUX_AUDIO_SINK_CLOSE(linuxNullSinkClose)
+{
+}
+
+LINUX_AUDIO_SINK_OPEN(linuxNullSinkOpen)
+{
+    sink->name = "null";
+    sink->realTime = true;
+    sink->write = &linuxNullSinkWrite;
+    sink->delay = &linuxNullSinkDelay;
+    sink->close = &linuxNullSinkClose;
+    sink->playedUntil = linuxGetTime();
+
+    return true;
+}
+
+//
+// WAV file sink. Not real time: every frame the game produces is written.
+//
+
+typedef struct LinuxWavHeader
+{
+    char riff[4];
+    uint32 riffSize;
+    char wave[4];
+    char fmt[4];
+    uint32 fmtSize;
+    uint16 format;
+    uint16 channels;
+    uint32 samplesPerSecond;
+    uint32 bytesPerSecond;
+    uint16 blockAlign;
+    uint16 bitsPerSample;
+    char data[4];
+    uint32 dataSize;
+} LinuxWavHeader;
+
+static_assert(sizeof(LinuxWavHeader) == 44, "A WAV header is 44 bytes");
+
+internal_func void linuxWriteWavHeader(LinuxAudioSink *sink)
+{
+    uint32 dataSize = (uint32)(sink->framesWritten * AUDIO_RING_BUFFER_BYTES_PER_FRAME);
+
+    LinuxWavHeader header = {
+        {'R', 'I', 'F', 'F'},
+        (36 + dataSize),
+        {'W', 'A', 'V', 'E'},
+        {'f', 'm', 't', ' '},
+        16,
+        1, // PCM
+        LINUX_AUDIO_CHANNELS,
+        sink->samplesPerSecond,
+        (sink->samplesPerSecond * AUDIO_RING_BUFFER_BYTES_PER_FRAME),
+        AUDIO_RING_BUFFER_BYTES_PER_FRAME,
+        16,
+        {'d', 'a', 't', 'a'},
+        dataSize
+    };
+
+    pwrite(sink->fd, &header, sizeof(header), 0);
+}
+
+LINUX_AUDIO_SINK_WRITE(linuxWavSinkWrite)
+{
+    const uint8 *bytes = (const uint8 *)frames;
+    sizet bytesLeft = (frameCount * AUDIO_RING_BUFFER_BYTES_PER_FRAME);
+
+    while (bytesLeft > 0) {
+
+        ssize_t bytesWritten = write(sink->fd, bytes, bytesLeft);
+
+        if (bytesWritten <= 0) {
+            return false;
+        }
+
+        bytes += bytesWritten;
+        bytesLeft -= (sizet)bytesWritten;
+    }
+
+    sink->framesWritten += frameCount;
+
+    return true;
+}
+
+LINUX_AUDIO_SINK_DELAY(linuxWavSinkDelay)
+{
+    return 0;
+}
+
+LINUX_AUDIO_SINK_CLOSE(linuxWavSinkClose)
+{
+    // Now that the sizes are known
+    linuxWriteWavHeader(sink);
+    close(sink->fd);
+}
+
+LINUX_AUDIO_SINK_OPEN(linuxWavSinkOpen)
+{
+    if (!path) {
+        return false;
+    }
+
+    sink->fd = open(path, (O_WRONLY | O_CREAT | O_TRUNC), 0644);
+
+    if (-1 == sink->fd) {
+        return false;
+    }
+
+    sink->name = "wav";
+    sink->realTime = false;
+    sink->write = &linuxWavSinkWrite;
+    sink->delay = &linuxWavSinkDelay;
+    sink->close = &linuxWavSinkClose;
+    sink->framesWritten = 0;
+
+    // Sizes are filled in on close
+    linuxWriteWavHeader(sink);
+    lseek(sink->fd, sizeof(LinuxWavHeader), SEEK_SET);
+
+    return true;
+}
+
+//
+// The audio thread
+//
+
+internal_func bool32 linuxOpenAudioSink(LinuxAudioSink *sink, uint32 sinkType, const char *path, uint32 samplesPerSecond)
+{
+    sink->samplesPerSecond = samplesPerSecond;
+
+    switch (sinkType) {
+        case LINUX_AUDIO_SINK_PULSE:
+            return linuxPulseAudioSinkOpen(sink, samplesPerSecond, path);
+        case LINUX_AUDIO_SINK_ALSA:
+            return linuxALSASinkOpen(sink, samplesPerSecond, path);
+        case LINUX_AUDIO_SINK_NULL:
+            return linuxNullSinkOpen(sink, samplesPerSecond, path);
+        case LINUX_AUDIO_SINK_WAV:
+            return linuxWavSinkOpen(sink, samplesPerSecond, path);
+        default:
+            break;
+    }
+
+    // Allow the sink to be picked without a rebuild
+    const char *sinkName = getenv("HANDMADE_AUDIO_SINK");
+
+    if (sinkName) {
+        if (0 == strcmp(sinkName, "pulse")) {
+            return linuxPulseAudioSinkOpen(sink, samplesPerSecond, path);
+        } else if (0 == strcmp(sinkName, "alsa")) {
+            return linuxALSASinkOpen(sink, samplesPerSecond, path);
+        } else if (0 == strcmp(sinkName, "null")) {
+            return linuxNullSinkOpen(sink, samplesPerSecond, path);
+        }
+    }
+
+    // The first real device that opens, otherwise play to nothing
+    return (linuxPulseAudioSinkOpen(sink, samplesPerSecond, path)
+            || linuxALSASinkOpen(sink, samplesPerSecond, path)
+            || linuxNullSinkOpen(sink, samplesPerSecond, path));
+}
+
+internal_func bool32 linuxStartAudioOutput(PlatformThreadContext *thread,
+                                            LinuxAudioOutput *output,
+                                            uint32 sinkType,
+                                            const char *path,
+                                            uint32 samplesPerSecond)
+{
+    if (!linuxOpenAudioSink(&output->sink, sinkType, path, samplesPerSecond)) {
+        return false;
+    }
+
+    void *ringMemory = platformAllocateMemory(thread, 0, (LINUX_AUDIO_RING_FRAMES * AUDIO_RING_BUFFER_BYTES_PER_FRAME));
+
+    if (!ringMemory) {
+        output->sink.close(&output->sink);
+        return false;
+    }
+
+    audioRingBufferInit(&output->ring, ringMemory, LINUX_AUDIO_RING_FRAMES);
+
+    output->samplesPerSecond = samplesPerSecond;
+    output->framesPlayed = 0;
+    output->latencyFrames = 0;
+    output->maxLatencyFrames = 0;
+    output->realTimePriority = false;
+    output->running = true;
+    output->failed = false;
+
+    sem_init(&output->samplesReady, 0, 0);
+
+    if (0 != pthread_create(&output->thread, NULL, linuxAudioThread, output)) {
+        sem_destroy(&output->samplesReady);
+        output->sink.close(&output->sink);
+        platformFreeMemory(thread, ringMemory);
+        return false;
+    }
+
+    return true;
+}
+
+internal_func void *linuxAudioThread(void *param)
+{
+    LinuxAudioOutput *output = (LinuxAudioOutput *)param;
+    LinuxAudioSink *sink = &output->sink;
+
+    // A real time sink has to be fed every period whatever the rest of the
+    // game is doing. Ask for real time scheduling. Without the rights to
+    // (no rtkit or RLIMIT_RTPRIO) we simply carry on at normal priority.
+    if (sink->realTime) {
+        struct sched_param schedParam = {0};
+        schedParam.sched_priority = sched_get_priority_min(SCHED_FIFO);
+        output->realTimePriority = (0 == pthread_setschedparam(pthread_self(), SCHED_FIFO, &schedParam));
+    }
+
+    uint32 period[LINUX_AUDIO_PERIOD_FRAMES];
+
+    for (;;) {
+
+        // Checked before reading so that frames submitted just before the
+        // stop are still written out
+        bool32 running = __atomic_load_n(&output->running, __ATOMIC_ACQUIRE);
+
+        uint32 frameCount = 0;
+
+        if (sink->realTime) {
+
+            if (!running) {
+                break;
+            }
+
+            // Always a full period. Silence makes up anything the game
+            // hasn't produced in time.
+            audioRingBufferReadPadded(&output->ring, period, LINUX_AUDIO_PERIOD_FRAMES);
+            frameCount = LINUX_AUDIO_PERIOD_FRAMES;
+
+        } else {
+
+            frameCount = audioRingBufferRead(&output->ring, period, LINUX_AUDIO_PERIOD_FRAMES);
+
+            if (0 == frameCount) {
+
+                if (!running) {
+                    break;
+                }
+
+                sem_wait(&output->samplesReady);
+                continue;
+            }
+        }
+
+        if (!sink->write(sink, period, frameCount)) {
+            fprintf(stderr, "Audio sink (%s) failed. Stopping audio output\n", sink->name);
+
+            // So that linuxSubmitAudio stops waiting for room in the ring
+            __atomic_store_n(&output->failed, true, __ATOMIC_RELEASE);
+            break;
+        }
+
+        output->framesPlayed += frameCount;
+
+        uint32 latencyFrames = (audioRingBufferFramesQueued(&output->ring) + sink->delay(sink));
+
+        output->latencyFrames = latencyFrames;
+
+        if (latencyFrames > output->maxLatencyFrames) {
+            output->maxLatencyFrames = latencyFrames;
+        }
+    }
+
+    return NULL;
+}
+
+internal_func uint32 linuxAudioFramesToRequest(LinuxAudioOutput *output, uint32 targetFrames)
+{
+    uint32 framesQueued = audioRingBufferFramesQueued(&output->ring);
+
+    if (framesQueued >= targetFrames) {
+        return 0;
+    }
+
+    uint32 framesToRequest = (targetFrames - framesQueued);
+    uint32 framesFree = (output->ring.capacityFrames - framesQueued);
+
+    return ((framesToRequest < framesFree) ? framesToRequest : framesFree);
+}
+
+internal_func bool32 linuxSubmitAudio(LinuxAudioOutput *output, const void *frames, uint32 frameCount)
+{
+    // Nothing's reading the ring any more
+    if (__atomic_load_n(&output->failed, __ATOMIC_ACQUIRE)) {
+        return false;
+    }
+
+    if (!frameCount) {
+        return true;
+    }
+
+    if (output->sink.realTime) {
+
+        // Never wait on the audio thread. If the ring is somehow full the
+        // extra frames are dropped (and counted).
+        audioRingBufferWrite(&output->ring, frames, frameCount);
+
+    } else {
+
+        // Every frame has to reach the file. Wait for room if need be.
+        const uint32 *framesLeft = (const uint32 *)frames;
+
+        for (;;) {
+
+            uint32 framesFree = (output->ring.capacityFrames - audioRingBufferFramesQueued(&output->ring));
+            uint32 framesToWrite = ((frameCount < framesFree) ? frameCount : framesFree);
+
+            audioRingBufferWrite(&output->ring, framesLeft, framesToWrite);
+            sem_post(&output->samplesReady);
+
+            framesLeft += framesToWrite;
+            frameCount -= framesToWrite;
+
+            if (!frameCount) {
+                break;
+            }
+
+            if (__atomic_load_n(&output->failed, __ATOMIC_ACQUIRE)) {
+                return false;
+            }
+
+            sched_yield();
+        }
+    }
+
+    return true;
+}
+
+internal_func void linuxStopAudioOutput(PlatformThreadContext *thread, LinuxAudioOutput *output)
+{
+    __atomic_store_n(&output->running, false, __ATOMIC_RELEASE);
+    sem_post(&output->samplesReady);
+
+    pthread_join(output->thread, NULL);
+
+    sem_destroy(&output->samplesReady);
+    output->sink.close(&output->sink);
+
+    platformFreeMemory(thread, output->ring.frames);
+    output->ring.frames = NULL;
+}
+
+internal_func void linuxLogAudioOutput(LinuxAudioOutput *output)
+{
+    float32 msPerFrame = (1000.0f / (float32)output->samplesPerSecond);
+
+    fprintf(stderr,
+            "Audio (%s%s): latency %.1fms (max %.1fms). Underruns %llu (%llu frames). Dropped %llu frames\n",
+            output->sink.name,
+            (output->realTimePriority ? ", real time" : ""),
+            ((float32)output->latencyFrames * msPerFrame),
+            ((float32)output->maxLatencyFrames * msPerFrame),
+            (unsigned long long)output->ring.underruns,
+            (unsigned long long)output->ring.underrunFrames,
+            (unsigned long long)output->ring.droppedFrames);
+}
@@ -0,0 +1,227 @@
+#ifndef HEADER_LINUX_AUDIO
+#define HEADER_LINUX_AUDIO
+
+//
+// Audio output. Shared by the platform layer and the headless runner
+// ============================================================================
+//
+// The main loop hands the game's samples to an AudioRingBuffer. A dedicated
+// audio thread pulls them back out a period at a time and writes them to a
+// sink. Sinks are pluggable: PulseAudio and ALSA for real devices, a null
+// sink that plays silence at the device rate, and a WAV file for headless
+// runs. PulseAudio and ALSA are loaded at runtime with dlopen, so neither is
+// needed to build or to run.
+
+// Stereo 16-bit frames
+#define LINUX_AUDIO_CHANNELS 2
+
+// The audio thread hands the sink this many frames at a time (5ms at 48kHz)
+#define LINUX_AUDIO_PERIOD_FRAMES 240
+
+// How many frames the ring buffer between the main loop and the audio thread
+// can hold. A power of two. ~340ms at 48kHz.
+#define LINUX_AUDIO_RING_FRAMES 16384
+
+// How much audio PulseAudio/ALSA are asked to buffer on the device side
+#define LINUX_AUDIO_DEVICE_LATENCY_US 20000
+
+// Sinks. Chosen with the HANDMADE_AUDIO_SINK environment variable
+// ("pulse", "alsa" or "null"), otherwise the first that opens.
+#define LINUX_AUDIO_SINK_DEFAULT    0x0
+#define LINUX_AUDIO_SINK_PULSE      0x1
+#define LINUX_AUDIO_SINK_ALSA       0x2
+#define LINUX_AUDIO_SINK_NULL       0x3
+#define LINUX_AUDIO_SINK_WAV        0x4
+
+//
+// PulseAudio (libpulse-simple) and ALSA (libasound). Just what we use of each,
+// declared here so that their headers aren't needed to build.
+//
+#define LINUX_PULSE_AUDIO_LIBRARY       "libpulse-simple.so.0"
+#define LINUX_PULSE_AUDIO_SAMPLE_S16LE  3
+#define LINUX_PULSE_AUDIO_STREAM_PLAYBACK 1
+
+typedef struct LinuxPulseAudioSampleSpec
+{
+    int32 format;
+    uint32 rate;
+    uint8 channels;
+} LinuxPulseAudioSampleSpec;
+
+typedef struct LinuxPulseAudioBufferAttr
+{
+    uint32 maxlength;
+    uint32 tlength;
+    uint32 prebuf;
+    uint32 minreq;
+    uint32 fragsize;
+} LinuxPulseAudioBufferAttr;
+
+typedef void *PulseAudioSimpleNewDT(const char *server,
+                                    const char *name,
+                                    int32 direction,
+                                    const char *device,
+                                    const char *streamName,
+                                    const LinuxPulseAudioSampleSpec *sampleSpec,
+                                    const void *channelMap,
+                                    const LinuxPulseAudioBufferAttr *bufferAttr,
+                                    int *error);
+typedef int PulseAudioSimpleWriteDT(void *simple, const void *data, size_t bytes, int *error);
+typedef uint64 PulseAudioSimpleGetLatencyDT(void *simple, int *error);
+typedef void PulseAudioSimpleFreeDT(void *simple);
+
+#define LINUX_ALSA_LIBRARY                  "libasound.so.2"
+#define LINUX_ALSA_PCM_STREAM_PLAYBACK      0
+#define LINUX_ALSA_PCM_FORMAT_S16_LE        2
+#define LINUX_ALSA_PCM_ACCESS_RW_INTERLEAVED 3
+
+typedef int ALSAPCMOpenDT(void **pcm, const char *name, int stream, int mode);
+typedef int ALSAPCMSetParamsDT(void *pcm,
+                                int format,
+                                int access,
+                                unsigned int channels,
+                                unsigned int rate,
+                                int softResample,
+                                unsigned int latencyUS);
+typedef long ALSAPCMWriteiDT(void *pcm, const void *buffer, unsigned long frames);
+typedef int ALSAPCMRecoverDT(void *pcm, int err, int silent);
+typedef int ALSAPCMDelayDT(void *pcm, long *delayFrames);
+typedef int ALSAPCMCloseDT(void *pcm);
+
+typedef struct LinuxAudioSink LinuxAudioSink;
+
+/**
+ * @brief Opens the sink for 16-bit stereo at samplesPerSecond
+ *
+ * @param path The file to write to. WAV sink only.
+ * @return false if the device (or its library) isn't available
+ */
+#define LINUX_AUDIO_SINK_OPEN(name) bool32 name(LinuxAudioSink *sink, uint32 samplesPerSecond, const char *path)
+typedef LINUX_AUDIO_SINK_OPEN(LinuxAudioSinkOpen);
+
+/**
+ * @brief Writes frames to the sink. Real time sinks block until the device
+ * has room, which is what paces the audio thread.
+ */
+#define LINUX_AUDIO_SINK_WRITE(name) bool32 name(LinuxAudioSink *sink, const void *frames, uint32 frameCount)
+typedef LINUX_AUDIO_SINK_WRITE(LinuxAudioSinkWrite);
+
+/**
+ * @brief How many frames have been written to the sink but not yet played
+ */
+#define LINUX_AUDIO_SINK_DELAY(name) uint32 name(LinuxAudioSink *sink)
+typedef LINUX_AUDIO_SINK_DELAY(LinuxAudioSinkDelay);
+
+#define LINUX_AUDIO_SINK_CLOSE(name) void name(LinuxAudioSink *sink)
+typedef LINUX_AUDIO_SINK_CLOSE(LinuxAudioSinkClose);
+
+struct LinuxAudioSink
+{
+    const char *name;
+
+    // Real time sinks consume at the device rate and the audio thread plays
+    // silence if the game falls behind. Otherwise (WAV) the audio thread
+    // waits for the game's samples and nothing is ever lost.
+    bool32 realTime;
+
+    LinuxAudioSinkWrite *write;
+    LinuxAudioSinkDelay *delay;
+    LinuxAudioSinkClose *close;
+
+    uint32 samplesPerSecond;
+
+    // dlopen handle for PulseAudio/ALSA and the functions looked up from it
+    void *libraryHandle;
+
+    PulseAudioSimpleWriteDT *pulseAudioSimpleWrite;
+    PulseAudioSimpleGetLatencyDT *pulseAudioSimpleGetLatency;
+    PulseAudioSimpleFreeDT *pulseAudioSimpleFree;
+
+    ALSAPCMWriteiDT *alsaPCMWritei;
+    ALSAPCMRecoverDT *alsaPCMRecover;
+    ALSAPCMDelayDT *alsaPCMDelay;
+    ALSAPCMCloseDT *alsaPCMClose;
+
+    // pa_simple * or snd_pcm_t *
+    void *device;
+
+    // WAV sink
+    int fd;
+    uint64 framesWritten;
+
+    // Null sink. When the last frames written will have been played.
+    struct timespec playedUntil;
+};
+
+/**
+ * The audio thread, its sink and the ring buffer the main loop fills.
+ */
+typedef struct LinuxAudioOutput
+{
+    AudioRingBuffer ring;
+    LinuxAudioSink sink;
+
+    pthread_t thread;
+    bool32 running;
+
+    // Set by the audio thread if the sink fails, just before it stops
+    bool32 failed;
+
+    // Posted by linuxSubmitAudio. Only waited on for sinks that aren't real time.
+    sem_t samplesReady;
+
+    uint32 samplesPerSecond;
+
+    // Written by the audio thread
+    uint64 framesPlayed;
+
+    // End to end latency: frames waiting in the ring plus frames waiting in
+    // the device, as of the last period written. And the worst seen.
+    uint32 latencyFrames;
+    uint32 maxLatencyFrames;
+
+    // The audio thread got real time scheduling (SCHED_FIFO)
+    bool32 realTimePriority;
+
+} LinuxAudioOutput;
+
+/**
+ * @brief Opens a sink and starts the audio thread
+ *
+ * @param sinkType  One of the LINUX_AUDIO_SINK_* values
+ * @param path      The file to write to for LINUX_AUDIO_SINK_WAV
+ * @return false if the sink couldn't be opened or the thread started
+ */
+internal_func bool32 linuxStartAudioOutput(PlatformThreadContext *thread,
+                                            LinuxAudioOutput *output,
+                                            uint32 sinkType,
+                                            const char *path,
+                                            uint32 samplesPerSecond);
+
+internal_func void *linuxAudioThread(void *param);
+
+/**
+ * @brief How many frames the game should write this frame to keep
+ * targetFrames of audio queued ahead of the device
+ */
+internal_func uint32 linuxAudioFramesToRequest(LinuxAudioOutput *output, uint32 targetFrames);
+
+/**
+ * @brief Queues the game's frames for the audio thread. Main loop only.
+ *
+ * @return false (and the frames dropped) if the sink has failed
+ */
+internal_func bool32 linuxSubmitAudio(LinuxAudioOutput *output, const void *frames, uint32 frameCount);
+
+/**
+ * @brief Stops the audio thread, once it has written everything queued to
+ * sinks that aren't real time, and closes the sink
+ */
+internal_func void linuxStopAudioOutput(PlatformThreadContext *thread, LinuxAudioOutput *output);
+
+/**
+ * @brief Logs the underrun and latency counters
+ */
+internal_func void linuxLogAudioOutput(LinuxAudioOutput *output);
+
+#endif
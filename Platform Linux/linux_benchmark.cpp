@@ -0,0 +1,1964 @@
+// POSIX/Linux APIs
+#include <pthread.h>    // Worker threads
+#include <sched.h>      // sched_yield
+#include <semaphore.h>  // Waking the worker threads
+#include <stdio.h>      // printf, fprintf, fopen
+#include <stdlib.h>     // strtoul, getenv
+#include <string.h>     // strcmp, strstr, memcpy, memcmp
+#include <sys/mman.h>   // mmap, munmap
+#include <time.h>       // clock_gettime
+#include <unistd.h>     // sysconf, readlink
+#include <x86intrin.h>  // __rdtsc
+
+#include "../Game/game.h" // Game internals, which are linked straight in
+#include "../Game/work_queue.h" // Shares work out over the worker threads
+#include "linux_work_queue.h" // Worker threads shared with the platform layer
+#include "linux_benchmark.h" // Benchmark runner specific function signatures
+
+#include "../Game/work_queue.cpp"
+#include "linux_work_queue.cpp"
+
+/*
+ * The benchmark runner times game layer routines in isolation. Unlike the
+ * platform layer and the headless runner it doesn't load Game.so, it's built
+ * with the game's sources so that it can call their internals directly.
+ *
+ * Results are printed one per line as "<name>_<unit>_per_second <value>",
+ * followed by "<name>_ns_per_run <value>", so that runs can be diffed or
+ * parsed by a script. Benchmarks that the CPU can't run are printed with a
+ * value of "unsupported".
+ *
+ * The graphics matrix (see linux_benchmark.h) follows, then the runner exits
+ * with 1 if any of it didn't match its golden hash.
+ *
+ * Usage: handmade_benchmark [--filter text] [--min-ms N] [--matrix-ms N]
+ *                           [--data folder/] [--golden file]
+ *                           [--write-golden file]
+ */
+
+/**
+ * The game's original debug sine wave, kept word for word (other than
+ * where its state lives) so that the oscillator has something to beat.
+ */
+internal_func void benchmarkReferenceSineWaveWrite(BenchmarkReferenceSineWave *sineWave, GameAudioBuffer *audioBuffer)
+{
+    // Calculate the total number of 4-byte audio sample groups that we will have per complete cycle.
+    uint64 audioSampleGroupsPerCycle = ((audioBuffer->platformBufferSizeInBytes / audioBuffer->bytesPerSample) / sineWave->hertz);
+
+    // At the start of which 4 byte group index we are starting our write from?
+    uint32 byteGroupIndex = 0;
+
+    float32 percentageOfAngle = 0.0f;
+    float32 angle = 0.0f;
+    float32 radians = 0.0f;
+    float64 sine = 0.0f;
+
+    uint16 *audioSample = (uint16*)audioBuffer->memory;
+
+    // Iterate over each 2 - bytes and write the same data for both...
+    for (uint32 i = 0; i < audioBuffer->noOfSamplesToWrite; i++) {
+
+        percentageOfAngle = percentageOfAnotherf((float32)byteGroupIndex, (float32)audioSampleGroupsPerCycle);
+        angle = (360.0f * percentageOfAngle);
+        radians = (angle * ((float32)GAME_PI / 180.0f));
+        sine = intrin_sin(radians);
+
+        int16 audioSampleValue = (int16)(sine * sineWave->sizeOfWave);
+
+        // Left channel (16-bits)
+        *audioSample = audioSampleValue;
+
+        // Move to the right sample (16-bits)
+        audioSample++;
+
+        // Right channel (16-bits)
+        *audioSample = audioSampleValue;
+
+        // Move cursor to the start of the next sample grouping.
+        audioSample++;
+
+        // Write another 4 to the running byte group index.
+        byteGroupIndex = (uint32)((byteGroupIndex + audioBuffer->bytesPerSample) % (uint32)audioSampleGroupsPerCycle);
+    }
+}
+
+internal_func BENCHMARK(benchmarkReferenceSineWave)
+{
+    BenchmarkAudioData *audio = (BenchmarkAudioData *)data;
+    benchmarkReferenceSineWaveWrite(&audio->referenceSineWave, &audio->audioBuffer);
+}
+
+internal_func BENCHMARK(benchmarkOscillatorScalar)
+{
+    BenchmarkAudioData *audio = (BenchmarkAudioData *)data;
+    oscillatorWriteScalar(&audio->oscillator, audio->wavetables, (int16 *)audio->audioBuffer.memory, audio->audioBuffer.noOfSamplesToWrite);
+}
+
+internal_func BENCHMARK(benchmarkOscillatorSSE2)
+{
+    BenchmarkAudioData *audio = (BenchmarkAudioData *)data;
+    oscillatorWriteSSE2(&audio->oscillator, audio->wavetables, (int16 *)audio->audioBuffer.memory, audio->audioBuffer.noOfSamplesToWrite);
+}
+
+internal_func BENCHMARK(benchmarkOscillatorAVX2)
+{
+    BenchmarkAudioData *audio = (BenchmarkAudioData *)data;
+    oscillatorWriteAVX2(&audio->oscillator, audio->wavetables, (int16 *)audio->audioBuffer.memory, audio->audioBuffer.noOfSamplesToWrite);
+}
+
+/**
+ * Starts voices until voiceCount are playing. The volumes and pans are spread
+ * out so that a budget has something to choose between.
+ */
+internal_func void benchmarkMixerFillVoices(BenchmarkMixerData *mixerData)
+{
+    Mixer *mixer = mixerData->mixer;
+    uint32 playingCount = 0;
+
+    for (uint32 i = 0; i < MIXER_MAX_VOICES; i++) {
+        if (mixer->voices[i].flags & MIXER_VOICE_PLAYING) {
+            playingCount++;
+        }
+    }
+
+    for (uint32 i = playingCount; i < mixerData->voiceCount; i++) {
+
+        float32 volume = (0.05f + (0.95f * ((float32)(i % 17) / 16.0f)));
+        float32 pan = (-1.0f + (2.0f * ((float32)(i % 9) / 8.0f)));
+
+        uint32 voiceID = mixerPlay(mixer, &mixerData->sounds[i % BENCHMARK_MIXER_SOUNDS], volume, pan, (i & 1));
+
+        if (MIXER_VOICE_NONE == voiceID) {
+            break;
+        }
+    }
+}
+
+internal_func BENCHMARK(benchmarkMixer)
+{
+    BenchmarkMixerData *mixerData = (BenchmarkMixerData *)data;
+    mixerData->mix(mixerData->mixer, mixerData->samples, BENCHMARK_AUDIO_SAMPLES_PER_RUN);
+    benchmarkMixerFillVoices(mixerData);
+}
+
+internal_func BENCHMARK(benchmarkBlit)
+{
+    BenchmarkBlitData *blit = (BenchmarkBlitData *)data;
+
+    for (uint32 y = 0; y < BENCHMARK_BLIT_HEIGHT; y++) {
+        blit->writeBitmapRow((blit->pixels + (y * BENCHMARK_BLIT_WIDTH)),
+                                (blit->bitmapPixels + (y * BENCHMARK_BLIT_WIDTH)),
+                                BENCHMARK_BLIT_WIDTH);
+    }
+}
+
+internal_func BENCHMARK(benchmarkFill)
+{
+    BenchmarkFillData *fill = (BenchmarkFillData *)data;
+
+    if (!fill->writeRectangleRows) {
+        writeRectangle(&fill->frameBuffer,
+                        (float32)fill->x,
+                        0.0f,
+                        fill->width,
+                        fill->height,
+                        (uint32)0xFF336699);
+        return;
+    }
+
+    fill->writeRectangleRows(((uint32 *)fill->frameBuffer.memory + fill->x), (int32)fill->frameBuffer.widthPx, fill->width, fill->height, (uint32)0xFF336699);
+}
+
+internal_func BENCHMARK(benchmarkLine)
+{
+    BenchmarkLineData *line = (BenchmarkLineData *)data;
+
+    for (uint32 i = 0; i < BENCHMARK_LINE_COUNT; i++) {
+
+        xyint from = line->from[i];
+        xyint to = line->to[i];
+
+        switch (line->mode) {
+        case BENCHMARK_LINE_MODE_REFERENCE: {
+            Vector2 direction = {(float32)(to.x - from.x), (float32)(to.y - from.y)};
+            float32 magnitude = getVectorMagnitude(direction);
+
+            float32 xfract = (direction.x / magnitude);
+            float32 yfract = (direction.y / magnitude);
+
+            for (size_t pixel = 0; pixel < (size_t)magnitude; pixel++) {
+                writeRectangle(&line->frameBuffer,
+                                ((float32)from.x + ((float32)pixel * xfract)),
+                                ((float32)from.y + ((float32)pixel * yfract)),
+                                1,
+                                1,
+                                (uint32)0xFFFF00FF);
+            }
+        } break;
+
+        case BENCHMARK_LINE_MODE_HARD:
+            writeLine(&line->frameBuffer, from.x, from.y, to.x, to.y, (uint32)0xFFFF00FF);
+            break;
+
+        case BENCHMARK_LINE_MODE_SMOOTH:
+            writeLineSmooth(&line->frameBuffer, from.x, from.y, to.x, to.y, (uint32)0xFFFF00FF);
+            break;
+        }
+    }
+}
+
+internal_func BENCHMARK(benchmarkSprite)
+{
+    BenchmarkSpriteData *sprite = (BenchmarkSpriteData *)data;
+
+    for (uint32 i = 0; i < BENCHMARK_SPRITE_COUNT; i++) {
+
+        if (!sprite->writeBitmapAffineRow) {
+            writeBitmap(&sprite->frameBuffer,
+                        sprite->origin[i].x,
+                        sprite->origin[i].y,
+                        (float32)sprite->bitmap.widthPx,
+                        (float32)sprite->bitmap.heightPx,
+                        0.0f,
+                        0.0f,
+                        sprite->bitmap);
+            continue;
+        }
+
+        writeBitmapAffineRows(&sprite->frameBuffer,
+                                sprite->origin[i],
+                                sprite->xAxis[i],
+                                sprite->yAxis[i],
+                                &sprite->bitmap,
+                                sprite->writeBitmapAffineRow);
+    }
+}
+
+internal_func BENCHMARK(benchmarkUpscale)
+{
+    BenchmarkUpscaleData *upscale = (BenchmarkUpscaleData *)data;
+
+    upscaleFrameBufferRows(&upscale->dest,
+                            &upscale->source,
+                            upscale->filter,
+                            upscale->scratchRow,
+                            upscale->upscaleRow,
+                            upscale->blendRows);
+}
+
+internal_func BENCHMARK(benchmarkRender)
+{
+    BenchmarkRenderData *render = (BenchmarkRenderData *)data;
+
+    PlatformThreadContext thread = {0};
+
+    renderGroupExecute(&thread,
+                        &render->group,
+                        &render->frameBuffer,
+                        NULL,
+                        render->queue,
+                        platformAddWorkQueueEntry,
+                        platformCompleteAllWork);
+}
+
+internal_func bool32 benchmarkParseOptions(int argc, char **argv, BenchmarkOptions *options)
+{
+    options->filter = NULL;
+    options->minMS = BENCHMARK_DEFAULT_MIN_MS;
+    options->matrixMS = BENCHMARK_MATRIX_DEFAULT_MS;
+    options->dataPath = NULL;
+    options->goldenPath = NULL;
+    options->writeGoldenPath = NULL;
+
+    for (int i = 1; i < argc; i++) {
+
+        const char *arg = argv[i];
+        const char *value = ((i + 1) < argc) ? argv[i + 1] : NULL;
+
+        if ((0 == strcmp(arg, "--filter")) && value) {
+            options->filter = value;
+            i++;
+        } else if ((0 == strcmp(arg, "--min-ms")) && value) {
+            options->minMS = (uint32)strtoul(value, NULL, 10);
+            i++;
+        } else if ((0 == strcmp(arg, "--matrix-ms")) && value) {
+            options->matrixMS = (uint32)strtoul(value, NULL, 10);
+            i++;
+        } else if ((0 == strcmp(arg, "--data")) && value) {
+            options->dataPath = value;
+            i++;
+        } else if ((0 == strcmp(arg, "--golden")) && value) {
+            options->goldenPath = value;
+            i++;
+        } else if ((0 == strcmp(arg, "--write-golden")) && value) {
+            options->writeGoldenPath = value;
+            i++;
+        } else {
+            fprintf(stderr,
+                    "Usage: %s [--filter text] [--min-ms N] [--matrix-ms N] [--data folder/] [--golden file] [--write-golden file]\n",
+                    argv[0]);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+internal_func bool32 benchmarkSelected(BenchmarkOptions *options, Benchmark *benchmark)
+{
+    return (!options->filter || strstr(benchmark->name, options->filter));
+}
+
+internal_func uint64 benchmarkGetTimeNS()
+{
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return (((uint64)time.tv_sec * 1000000000ull) + (uint64)time.tv_nsec);
+}
+
+internal_func void benchmarkRun(Benchmark *benchmark, uint32 minMS)
+{
+    if (!benchmark->supported) {
+        printf("%s_%s_per_second unsupported\n", benchmark->name, benchmark->unit);
+        return;
+    }
+
+    // One untimed run to warm the caches and fault in any pages
+    benchmark->function(benchmark->data);
+
+    uint64 minNS = ((uint64)minMS * 1000000ull);
+    uint64 runs = 0;
+    uint64 startNS = benchmarkGetTimeNS();
+    uint64 elapsedNS = 0;
+
+    // Checking the clock is cheap next to a run, but check it in batches anyway
+    // so that it never shows up in the numbers
+    do {
+        for (uint32 i = 0; i < 8; i++) {
+            benchmark->function(benchmark->data);
+        }
+        runs += 8;
+        elapsedNS = (benchmarkGetTimeNS() - startNS);
+    } while (elapsedNS < minNS);
+
+    float64 itemsPerSecond = (((float64)(runs * benchmark->itemsPerRun) * 1000000000.0) / (float64)elapsedNS);
+
+    if (benchmark->itemsPerUnit) {
+        itemsPerSecond = (itemsPerSecond / (float64)benchmark->itemsPerUnit);
+    }
+
+    printf("%s_%s_per_second %.0f\n", benchmark->name, benchmark->unit, itemsPerSecond);
+    printf("%s_ns_per_run %.0f\n", benchmark->name, ((float64)elapsedNS / (float64)runs));
+    fflush(stdout);
+}
+
+internal_func void *benchmarkAllocate(sizet sizeInBytes)
+{
+    void *memory = mmap(NULL, sizeInBytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+    // Anonymous mappings are zeroed
+    if (MAP_FAILED == memory) {
+        fprintf(stderr, "Could not allocate %zu bytes\n", (size_t)sizeInBytes);
+        return NULL;
+    }
+
+    return memory;
+}
+
+/**
+ * The folder the executable is in, with a trailing slash
+ */
+internal_func void benchmarkGetExecutableFolder(char *path, sizet sizeInBytes)
+{
+    ssize_t length = readlink("/proc/self/exe", path, (sizeInBytes - 1));
+
+    if (length <= 0) {
+        path[0] = '\0';
+        return;
+    }
+
+    // Cut the path off after the last slash
+    ssize_t lastSlash = -1;
+    for (ssize_t i = 0; i < length; i++) {
+        if (path[i] == '/') {
+            lastSlash = i;
+        }
+    }
+
+    path[lastSlash + 1] = '\0';
+}
+
+/**
+ * Reads a BMP file and converts it into memoryBlock, as the game does
+ */
+internal_func bool32 benchmarkReadBMP(const char *folder,
+                                        const char *filename,
+                                        MemoryRegion *memoryRegion,
+                                        MemoryBlock *memoryBlock,
+                                        BitmapFile *bitmap)
+{
+    char path[GAME_MAX_PATH];
+    int pathLength = snprintf(path, sizeof(path), "%s%s", folder, filename);
+
+    if ((pathLength < 0) || ((sizet)pathLength >= sizeof(path))) {
+        fprintf(stderr, "Path too long: %s%s\n", folder, filename);
+        return false;
+    }
+
+    FILE *file = fopen(path, "rb");
+
+    if (!file) {
+        fprintf(stderr, "Could not open %s\n", path);
+        return false;
+    }
+
+    fseek(file, 0, SEEK_END);
+    long sizeInBytes = ftell(file);
+    fseek(file, 0, SEEK_SET);
+
+    void *fileMemory = ((sizeInBytes > 0) ? benchmarkAllocate((sizet)sizeInBytes) : NULL);
+
+    bool32 read = (fileMemory && (1 == fread(fileMemory, (size_t)sizeInBytes, 1, file)));
+
+    fclose(file);
+
+    bool32 converted = (read && readBMPFromMemory(memoryRegion, memoryBlock, fileMemory, (uint32)sizeInBytes, bitmap));
+
+    if (fileMemory) {
+        munmap(fileMemory, (size_t)sizeInBytes);
+    }
+
+    if (!converted) {
+        fprintf(stderr, "Could not read %s\n", path);
+    }
+
+    return converted;
+}
+
+internal_func BENCHMARK(benchmarkMatrixDraw)
+{
+    BenchmarkMatrixCase *matrixCase = (BenchmarkMatrixCase *)data;
+    GameFrameBuffer *frameBuffer = matrixCase->frameBuffer;
+
+    switch (matrixCase->kind) {
+    case BENCHMARK_MATRIX_RECTANGLE:
+        if (!matrixCase->writeRectangleRows) {
+            writeRectangle(frameBuffer,
+                            (float32)matrixCase->x,
+                            (float32)matrixCase->y,
+                            matrixCase->width,
+                            matrixCase->height,
+                            matrixCase->colour);
+            break;
+        }
+
+        writeRectangleIntRows(frameBuffer,
+                                matrixCase->x,
+                                matrixCase->y,
+                                matrixCase->width,
+                                matrixCase->height,
+                                matrixCase->colour,
+                                matrixCase->writeRectangleRows);
+        break;
+
+    case BENCHMARK_MATRIX_BITMAP:
+        if (!matrixCase->writeBitmapRow) {
+            writeBitmap(frameBuffer,
+                        (float32)matrixCase->x,
+                        (float32)matrixCase->y,
+                        (float32)matrixCase->bitmap->widthPx,
+                        (float32)matrixCase->bitmap->heightPx,
+                        0.0f,
+                        0.0f,
+                        *matrixCase->bitmap);
+            break;
+        }
+
+        writeBitmapRows(frameBuffer, matrixCase->x, matrixCase->y, matrixCase->bitmap, matrixCase->writeBitmapRow);
+        break;
+
+    case BENCHMARK_MATRIX_BITMAP_AFFINE:
+        if (!matrixCase->writeBitmapAffineRow) {
+            writeBitmapAffine(frameBuffer, matrixCase->origin, matrixCase->xAxis, matrixCase->yAxis, matrixCase->bitmap);
+            break;
+        }
+
+        writeBitmapAffineRows(frameBuffer,
+                                matrixCase->origin,
+                                matrixCase->xAxis,
+                                matrixCase->yAxis,
+                                matrixCase->bitmap,
+                                matrixCase->writeBitmapAffineRow);
+        break;
+
+    case BENCHMARK_MATRIX_LINE:
+        writeLine(frameBuffer, matrixCase->from.x, matrixCase->from.y, matrixCase->to.x, matrixCase->to.y, matrixCase->colour);
+        break;
+
+    case BENCHMARK_MATRIX_LINE_SMOOTH:
+        writeLineSmooth(frameBuffer, matrixCase->from.x, matrixCase->from.y, matrixCase->to.x, matrixCase->to.y, matrixCase->colour);
+        break;
+    }
+}
+
+/**
+ * FNV-1a 64 over the buffer's pixels, as the headless runner hashes frames
+ */
+internal_func uint64 benchmarkHashFrameBuffer(GameFrameBuffer *frameBuffer)
+{
+    uint64 hash = 0xcbf29ce484222325ULL;
+
+    for (uint32 row = 0; row < frameBuffer->heightPx; row++) {
+
+        uint64 *words = (uint64 *)((uint8 *)frameBuffer->memory + (row * frameBuffer->byteWidthPerRow));
+        uint32 wordCount = ((frameBuffer->widthPx * frameBuffer->bytesPerPixel) / sizeof(uint64));
+
+        for (uint32 i = 0; i < wordCount; i++) {
+            hash = ((hash ^ words[i]) * 0x100000001b3ULL);
+        }
+    }
+
+    return hash;
+}
+
+/**
+ * Reads "<case> <hash>" lines. Blank lines and lines starting with # are
+ * skipped.
+ */
+internal_func bool32 benchmarkLoadGolden(const char *path, BenchmarkGolden *golden)
+{
+    golden->count = 0;
+
+    FILE *file = fopen(path, "r");
+
+    if (!file) {
+        return false;
+    }
+
+    char line[256];
+
+    while (fgets(line, sizeof(line), file) && (golden->count < BENCHMARK_MATRIX_MAX_GOLDEN)) {
+
+        if (('#' == line[0]) || ('\n' == line[0]) || ('\r' == line[0])) {
+            continue;
+        }
+
+        char name[BENCHMARK_MATRIX_MAX_NAME];
+        unsigned long long hash = 0;
+
+        if (2 != sscanf(line, "%95s %llx", name, &hash)) {
+            continue;
+        }
+
+        memcpy(golden->names[golden->count], name, sizeof(name));
+        golden->hashes[golden->count] = (uint64)hash;
+        golden->count++;
+    }
+
+    fclose(file);
+
+    return true;
+}
+
+internal_func bool32 benchmarkFindGolden(BenchmarkGolden *golden, const char *name, uint64 *hash)
+{
+    for (uint32 i = 0; i < golden->count; i++) {
+        if (0 == strcmp(golden->names[i], name)) {
+            *hash = golden->hashes[i];
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/**
+ * Pixels the case's draw has to visit: the bounds of the rectangle, bitmap or
+ * transformed bitmap, clipped to the frame buffer. Lines only visit the
+ * pixels they change.
+ */
+internal_func uint64 benchmarkMatrixCoveredPixels(BenchmarkMatrixCase *matrixCase, uint32 *background)
+{
+    GameFrameBuffer *frameBuffer = matrixCase->frameBuffer;
+
+    float32 minX = (float32)matrixCase->x;
+    float32 minY = (float32)matrixCase->y;
+    float32 maxX = (minX + (float32)matrixCase->width);
+    float32 maxY = (minY + (float32)matrixCase->height);
+
+    switch (matrixCase->kind) {
+    case BENCHMARK_MATRIX_RECTANGLE:
+        break;
+
+    case BENCHMARK_MATRIX_BITMAP:
+        maxX = (minX + (float32)matrixCase->bitmap->widthPx);
+        maxY = (minY + (float32)matrixCase->bitmap->heightPx);
+        break;
+
+    case BENCHMARK_MATRIX_BITMAP_AFFINE: {
+        Vector2 corners[4] = {
+            matrixCase->origin,
+            {(matrixCase->origin.x + matrixCase->xAxis.x), (matrixCase->origin.y + matrixCase->xAxis.y)},
+            {(matrixCase->origin.x + matrixCase->yAxis.x), (matrixCase->origin.y + matrixCase->yAxis.y)},
+            {(matrixCase->origin.x + matrixCase->xAxis.x + matrixCase->yAxis.x), (matrixCase->origin.y + matrixCase->xAxis.y + matrixCase->yAxis.y)},
+        };
+
+        minX = maxX = corners[0].x;
+        minY = maxY = corners[0].y;
+
+        for (uint32 i = 1; i < countArray(corners); i++) {
+            minX = ((corners[i].x < minX) ? corners[i].x : minX);
+            minY = ((corners[i].y < minY) ? corners[i].y : minY);
+            maxX = ((corners[i].x > maxX) ? corners[i].x : maxX);
+            maxY = ((corners[i].y > maxY) ? corners[i].y : maxY);
+        }
+
+        minX = (float32)intrin_floorF32ToI32(minX);
+        minY = (float32)intrin_floorF32ToI32(minY);
+        maxX = intrin_ceilf(maxX);
+        maxY = intrin_ceilf(maxY);
+    } break;
+
+    case BENCHMARK_MATRIX_LINE:
+    case BENCHMARK_MATRIX_LINE_SMOOTH: {
+        uint64 changedPixels = 0;
+        uint32 pixelCount = (frameBuffer->widthPx * frameBuffer->heightPx);
+
+        for (uint32 i = 0; i < pixelCount; i++) {
+            changedPixels += (((uint32 *)frameBuffer->memory)[i] != background[i]);
+        }
+
+        return changedPixels;
+    }
+    }
+
+    minX = ((minX < 0.0f) ? 0.0f : minX);
+    minY = ((minY < 0.0f) ? 0.0f : minY);
+    maxX = ((maxX > (float32)frameBuffer->widthPx) ? (float32)frameBuffer->widthPx : maxX);
+    maxY = ((maxY > (float32)frameBuffer->heightPx) ? (float32)frameBuffer->heightPx : maxY);
+
+    if ((minX >= maxX) || (minY >= maxY)) {
+        return 0;
+    }
+
+    return ((uint64)(maxX - minX) * (uint64)(maxY - minY));
+}
+
+/**
+ * Draws the case over and over for at least minMS, without resetting the
+ * buffer in between, and returns the TSC cycles each draw took. Runs are
+ * batched so that reading the clock doesn't show up in small cases.
+ */
+internal_func float64 benchmarkMatrixCyclesPerRun(BenchmarkMatrixCase *matrixCase, uint32 minMS)
+{
+    uint64 minNS = ((uint64)minMS * 1000000ull);
+    uint64 runs = 0;
+    uint64 startNS = benchmarkGetTimeNS();
+    uint64 startCycles = __rdtsc();
+
+    do {
+        for (uint32 i = 0; i < 16; i++) {
+            benchmarkMatrixDraw(matrixCase);
+        }
+        runs += 16;
+    } while ((benchmarkGetTimeNS() - startNS) < minNS);
+
+    return ((float64)(__rdtsc() - startCycles) / (float64)runs);
+}
+
+/**
+ * Writes "<case>_<version>" into name. False if it doesn't fit, as a cut
+ * short name would match the wrong filter and golden entry.
+ */
+internal_func bool32 benchmarkMatrixPathName(const char *caseName,
+                                                BenchmarkMatrixPath *path,
+                                                char *name,
+                                                sizet nameSize)
+{
+    int length = snprintf(name, nameSize, "%s_%s", caseName, path->name);
+
+    if ((length < 0) || ((sizet)length >= nameSize)) {
+        fprintf(stderr, "Benchmark name too long: %s_%s\n", caseName, path->name);
+        return false;
+    }
+
+    return true;
+}
+
+internal_func bool32 benchmarkMatrixPathSelected(BenchmarkOptions *options,
+                                                    const char *caseName,
+                                                    BenchmarkMatrixPath *path,
+                                                    char *name,
+                                                    sizet nameSize)
+{
+    if (!benchmarkMatrixPathName(caseName, path, name, nameSize)) {
+        return false;
+    }
+
+    Benchmark benchmark = {name};
+
+    return benchmarkSelected(options, &benchmark);
+}
+
+internal_func bool32 benchmarkMatrixCaseSelected(BenchmarkOptions *options,
+                                                    const char *caseName,
+                                                    BenchmarkMatrixPath *paths,
+                                                    uint32 pathCount)
+{
+    char name[BENCHMARK_MATRIX_MAX_NAME];
+
+    for (uint32 path = 0; path < pathCount; path++) {
+        if (benchmarkMatrixPathSelected(options, caseName, &paths[path], name, sizeof(name))) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/**
+ * Runs one case with each of its kind's versions. The first version's hash is
+ * the case's, and the one written to the golden file. Returns the number of
+ * versions that didn't match.
+ */
+internal_func uint32 benchmarkMatrixRunCase(BenchmarkOptions *options,
+                                            BenchmarkGolden *golden,
+                                            FILE *writeGolden,
+                                            BenchmarkMatrixCase *matrixCase,
+                                            const char *caseName,
+                                            BenchmarkMatrixPath *paths,
+                                            uint32 pathCount,
+                                            uint32 *background)
+{
+    GameFrameBuffer *frameBuffer = matrixCase->frameBuffer;
+    sizet frameBufferSize = ((sizet)frameBuffer->byteWidthPerRow * frameBuffer->heightPx);
+    uint32 *pixels = (uint32 *)frameBuffer->memory;
+
+    char names[8][BENCHMARK_MATRIX_MAX_NAME];
+    bool32 selected[8] = {};
+    bool32 anySelected = false;
+
+    assert(pathCount <= countArray(names));
+
+    for (uint32 path = 0; path < pathCount; path++) {
+
+        // Counted as a mismatch, so the run fails
+        if (!benchmarkMatrixPathName(caseName, &paths[path], names[path], sizeof(names[path]))) {
+            return 1;
+        }
+
+        Benchmark benchmark = {names[path]};
+
+        selected[path] = benchmarkSelected(options, &benchmark);
+        anySelected = (anySelected || selected[path]);
+    }
+
+    if (!anySelected) {
+        return 0;
+    }
+
+    uint64 goldenHash = 0;
+    bool32 inGolden = benchmarkFindGolden(golden, caseName, &goldenHash);
+
+    uint64 caseHash = 0;
+    bool32 hashed = false;
+    uint64 coveredPixels = 0;
+    uint32 mismatches = 0;
+
+    for (uint32 path = 0; path < pathCount; path++) {
+
+        if (!selected[path]) {
+            continue;
+        }
+
+        if (!paths[path].supported) {
+            printf("%s_matches_golden unsupported\n", names[path]);
+            continue;
+        }
+
+        matrixCase->writeRectangleRows = paths[path].writeRectangleRows;
+        matrixCase->writeBitmapRow = paths[path].writeBitmapRow;
+        matrixCase->writeBitmapAffineRow = paths[path].writeBitmapAffineRow;
+
+        memcpy(pixels, background, frameBufferSize);
+
+        benchmarkMatrixDraw(matrixCase);
+
+        uint64 hash = benchmarkHashFrameBuffer(frameBuffer);
+
+        if (!hashed) {
+
+            caseHash = hash;
+            hashed = true;
+            coveredPixels = benchmarkMatrixCoveredPixels(matrixCase, background);
+
+            printf("%s_hash %016llx\n", caseName, (unsigned long long)caseHash);
+
+            if (writeGolden) {
+                fprintf(writeGolden, "%s %016llx\n", caseName, (unsigned long long)caseHash);
+            }
+        }
+
+        // When writing the golden file, every version must match the one
+        // being written
+        bool32 matches = (writeGolden ? (hash == caseHash) : (inGolden && (hash == goldenHash)));
+
+        printf("%s_matches_golden %u\n", names[path], (matches ? 1 : 0));
+
+        if (!matches) {
+            mismatches++;
+        }
+
+        float64 cyclesPerRun = benchmarkMatrixCyclesPerRun(matrixCase, options->matrixMS);
+
+        if (coveredPixels) {
+            printf("%s_cycles_per_pixel %.2f\n", names[path], (cyclesPerRun / (float64)coveredPixels));
+        } else {
+            printf("%s_cycles_per_run %.0f\n", names[path], cyclesPerRun);
+        }
+
+        fflush(stdout);
+    }
+
+    return mismatches;
+}
+
+/**
+ * Where a size x size sprite goes for each clipping case, as its bottom left
+ * corner
+ */
+typedef enum BenchmarkMatrixClip
+{
+    BENCHMARK_MATRIX_CLIP_INSIDE,
+    BENCHMARK_MATRIX_CLIP_LEFT,
+    BENCHMARK_MATRIX_CLIP_RIGHT,
+    BENCHMARK_MATRIX_CLIP_BOTTOM,
+    BENCHMARK_MATRIX_CLIP_TOP,
+    BENCHMARK_MATRIX_CLIP_OFFSCREEN,
+} BenchmarkMatrixClip;
+
+global_var const char *benchmarkMatrixClipNames[] = {"inside", "left", "right", "bottom", "top", "offscreen"};
+
+internal_func xyint benchmarkMatrixPlace(BenchmarkMatrixClip clip, uint32 width, uint32 height)
+{
+    int32 w = (int32)width;
+    int32 h = (int32)height;
+
+    // Centred, unless hanging half over an edge or past the left edge
+    xyint position = {((BENCHMARK_MATRIX_WIDTH - w) / 2), ((BENCHMARK_MATRIX_HEIGHT - h) / 2)};
+
+    switch (clip) {
+    case BENCHMARK_MATRIX_CLIP_INSIDE:
+        break;
+    case BENCHMARK_MATRIX_CLIP_LEFT:
+        position.x = -(w / 2);
+        break;
+    case BENCHMARK_MATRIX_CLIP_RIGHT:
+        position.x = (BENCHMARK_MATRIX_WIDTH - ((w + 1) / 2));
+        break;
+    case BENCHMARK_MATRIX_CLIP_BOTTOM:
+        position.y = -(h / 2);
+        break;
+    case BENCHMARK_MATRIX_CLIP_TOP:
+        position.y = (BENCHMARK_MATRIX_HEIGHT - ((h + 1) / 2));
+        break;
+    case BENCHMARK_MATRIX_CLIP_OFFSCREEN:
+        position.x = (-w - 3);
+        break;
+    }
+
+    return position;
+}
+
+internal_func int32 benchmarkGraphicsMatrix(BenchmarkOptions *options, bool32 avx2)
+{
+    char folder[GAME_MAX_PATH];
+    int folderLength;
+
+    if (options->dataPath) {
+        folderLength = snprintf(folder, sizeof(folder), "%s", options->dataPath);
+    } else {
+        char executableFolder[GAME_MAX_PATH];
+        benchmarkGetExecutableFolder(executableFolder, sizeof(executableFolder));
+        folderLength = snprintf(folder, sizeof(folder), "%sdata/test/", executableFolder);
+    }
+
+    char goldenPath[GAME_MAX_PATH];
+    int goldenPathLength;
+
+    if (options->goldenPath) {
+        goldenPathLength = snprintf(goldenPath, sizeof(goldenPath), "%s", options->goldenPath);
+    } else {
+        goldenPathLength = snprintf(goldenPath, sizeof(goldenPath), "%s%s", folder, BENCHMARK_MATRIX_GOLDEN_FILENAME);
+    }
+
+    // A path cut short would read (or write) the wrong file
+    if ((folderLength < 0)
+            || ((sizet)folderLength >= sizeof(folder))
+            || (goldenPathLength < 0)
+            || ((sizet)goldenPathLength >= sizeof(goldenPath))) {
+        fprintf(stderr, "Data or golden file path too long\n");
+        return -1;
+    }
+
+    BenchmarkGolden *golden = (BenchmarkGolden *)benchmarkAllocate(sizeof(BenchmarkGolden));
+
+    if (!golden) {
+        return -1;
+    }
+
+    FILE *writeGolden = NULL;
+    bool32 goldenLoaded = false;
+
+    if (options->writeGoldenPath) {
+
+        writeGolden = fopen(options->writeGoldenPath, "w");
+
+        if (!writeGolden) {
+            fprintf(stderr, "Could not write %s\n", options->writeGoldenPath);
+            return -1;
+        }
+
+        fprintf(writeGolden, "# FNV-1a 64 hashes of the graphics matrix's cases, drawn over noise.\n");
+        fprintf(writeGolden, "# Written by handmade_benchmark --write-golden. Check any change by eye first.\n");
+
+    } else {
+
+        // Without them, every case is reported as a mismatch
+        goldenLoaded = benchmarkLoadGolden(goldenPath, golden);
+    }
+
+    GameFrameBuffer frameBuffer = {};
+    uint32 pixelCount = (BENCHMARK_MATRIX_WIDTH * BENCHMARK_MATRIX_HEIGHT);
+
+    frameBuffer.widthPx = BENCHMARK_MATRIX_WIDTH;
+    frameBuffer.heightPx = BENCHMARK_MATRIX_HEIGHT;
+    frameBuffer.bytesPerPixel = sizeof(uint32);
+    frameBuffer.byteWidthPerRow = (BENCHMARK_MATRIX_WIDTH * sizeof(uint32));
+    frameBuffer.memory = benchmarkAllocate(pixelCount * sizeof(uint32));
+
+    uint32 *background = (uint32 *)benchmarkAllocate(pixelCount * sizeof(uint32));
+
+    // The bitmaps are loaded into a memory block, like they are in the game
+    MemoryRegion bitmapRegion = {};
+    bitmapRegion.sizeInBytes = utilMebibytesToBytes(16);
+    bitmapRegion.bytesFree = bitmapRegion.sizeInBytes;
+    bitmapRegion.bytes = benchmarkAllocate(bitmapRegion.sizeInBytes);
+
+    if (!frameBuffer.memory || !background || !bitmapRegion.bytes) {
+        return -1;
+    }
+
+    MemoryBlock bitmapBlock = {};
+    memoryRegionReserveBlock(bitmapRegion, &bitmapBlock, (uint8 *)bitmapRegion.bytes, bitmapRegion.sizeInBytes);
+
+    for (uint32 i = 0; i < pixelCount; i++) {
+        background[i] = (i * 2654435761u);
+    }
+
+    uint32 mismatches = 0;
+    char caseName[BENCHMARK_MATRIX_MAX_CASE_NAME];
+
+    BenchmarkMatrixCase matrixCase = {};
+    matrixCase.frameBuffer = &frameBuffer;
+    matrixCase.colour = 0xFF336699;
+
+    // Starting pixels added to each case's x, so that rows start on and off
+    // SIMD alignment
+    int32 alignments[] = {0, 1, 5};
+
+    //
+    // Rectangles: a debug vector pixel, odd sizes, a tile, a sprite sized
+    // block and the whole frame
+    //====================================================
+
+    xyint rectangleSizes[] = {{1, 1}, {3, 7}, {40, 40}, {257, 129}, {BENCHMARK_MATRIX_WIDTH, BENCHMARK_MATRIX_HEIGHT}};
+
+    BenchmarkMatrixPath rectanglePaths[] = {
+        {"scalar", true, writeRectangleRowsScalar},
+        {"sse2", true, writeRectangleRowsSSE2},
+        {"avx2", avx2, writeRectangleRowsAVX2},
+        {"stream", true, writeRectangleRowsStream},
+        {"writerectangle", true, NULL},
+    };
+
+    matrixCase.kind = BENCHMARK_MATRIX_RECTANGLE;
+
+    for (uint32 size = 0; size < countArray(rectangleSizes); size++) {
+        for (uint32 alignment = 0; alignment < countArray(alignments); alignment++) {
+            for (uint32 clip = 0; clip < countArray(benchmarkMatrixClipNames); clip++) {
+
+                matrixCase.width = (uint32)rectangleSizes[size].x;
+                matrixCase.height = (uint32)rectangleSizes[size].y;
+
+                xyint position = benchmarkMatrixPlace((BenchmarkMatrixClip)clip, matrixCase.width, matrixCase.height);
+                matrixCase.x = (position.x + alignments[alignment]);
+                matrixCase.y = position.y;
+
+                snprintf(caseName,
+                            sizeof(caseName),
+                            "graphics_rect_%ux%u_x%d_%s",
+                            matrixCase.width,
+                            matrixCase.height,
+                            alignments[alignment],
+                            benchmarkMatrixClipNames[clip]);
+
+                mismatches += benchmarkMatrixRunCase(options,
+                                                        golden,
+                                                        writeGolden,
+                                                        &matrixCase,
+                                                        caseName,
+                                                        rectanglePaths,
+                                                        countArray(rectanglePaths),
+                                                        background);
+            }
+        }
+    }
+
+    //
+    // Bitmaps: the hero's parts and shadow, and full screen scenery
+    //====================================================
+
+    const char *bitmapNames[] = {"hero_front_head", "hero_front_torso", "hero_front_cape", "hero_shadow", "background", "scene_layer_02"};
+    BitmapFile bitmaps[countArray(bitmapNames)] = {};
+
+    BenchmarkMatrixPath bitmapPaths[] = {
+        {"scalar", true, NULL, writeBitmapRowScalar},
+        {"sse2", true, NULL, writeBitmapRowSSE2},
+        {"avx2", avx2, NULL, writeBitmapRowAVX2},
+        {"opaque", true, NULL, writeBitmapRowOpaque},
+        {"writebitmap", true, NULL, NULL},
+    };
+
+    BenchmarkMatrixPath affinePaths[] = {
+        {"scalar", true, NULL, NULL, writeBitmapAffineRowScalar},
+        {"sse2", true, NULL, NULL, writeBitmapAffineRowSSE2},
+        {"avx2", avx2, NULL, NULL, writeBitmapAffineRowAVX2},
+        {"writebitmapaffine", true, NULL, NULL, NULL},
+    };
+
+    uint32 affineBitmaps[] = {1, 3};
+    const char *affineNames[] = {"scaled", "rotated"};
+
+    // Only loaded if a case that draws them is selected, so that the rest of
+    // the benchmarks don't need the data folder
+    bool32 bitmapsNeeded = false;
+
+    for (uint32 clip = 0; clip < countArray(benchmarkMatrixClipNames); clip++) {
+
+        for (uint32 i = 0; i < countArray(bitmapNames); i++) {
+            for (uint32 alignment = 0; alignment < countArray(alignments); alignment++) {
+                snprintf(caseName,
+                            sizeof(caseName),
+                            "graphics_bitmap_%s_x%d_%s",
+                            bitmapNames[i],
+                            alignments[alignment],
+                            benchmarkMatrixClipNames[clip]);
+                bitmapsNeeded = (bitmapsNeeded || benchmarkMatrixCaseSelected(options, caseName, bitmapPaths, countArray(bitmapPaths)));
+            }
+        }
+
+        for (uint32 i = 0; i < countArray(affineBitmaps); i++) {
+            for (uint32 transform = 0; transform < countArray(affineNames); transform++) {
+                snprintf(caseName,
+                            sizeof(caseName),
+                            "graphics_affine_%s_%s_%s",
+                            bitmapNames[affineBitmaps[i]],
+                            affineNames[transform],
+                            benchmarkMatrixClipNames[clip]);
+                bitmapsNeeded = (bitmapsNeeded || benchmarkMatrixCaseSelected(options, caseName, affinePaths, countArray(affinePaths)));
+            }
+        }
+    }
+
+    for (uint32 i = 0; (i < countArray(bitmapNames)) && bitmapsNeeded; i++) {
+
+        char filename[64];
+        snprintf(filename, sizeof(filename), "test_%s.bmp", bitmapNames[i]);
+
+        if (!benchmarkReadBMP(folder, filename, &bitmapRegion, &bitmapBlock, &bitmaps[i])) {
+            if (writeGolden) {
+                fclose(writeGolden);
+            }
+            return -1;
+        }
+    }
+
+    matrixCase.kind = BENCHMARK_MATRIX_BITMAP;
+
+    for (uint32 i = 0; (i < countArray(bitmapNames)) && bitmapsNeeded; i++) {
+        for (uint32 alignment = 0; alignment < countArray(alignments); alignment++) {
+            for (uint32 clip = 0; clip < countArray(benchmarkMatrixClipNames); clip++) {
+
+                matrixCase.bitmap = &bitmaps[i];
+
+                xyint position = benchmarkMatrixPlace((BenchmarkMatrixClip)clip, bitmaps[i].widthPx, bitmaps[i].heightPx);
+                matrixCase.x = (position.x + alignments[alignment]);
+                matrixCase.y = position.y;
+
+                snprintf(caseName,
+                            sizeof(caseName),
+                            "graphics_bitmap_%s_x%d_%s",
+                            bitmapNames[i],
+                            alignments[alignment],
+                            benchmarkMatrixClipNames[clip]);
+
+                // Copying rows only gives the same result for opaque bitmaps
+                bool32 opaque = (bitmaps[i].flags & BITMAP_FLAG_OPAQUE);
+                bitmapPaths[3].supported = opaque;
+
+                mismatches += benchmarkMatrixRunCase(options,
+                                                        golden,
+                                                        writeGolden,
+                                                        &matrixCase,
+                                                        caseName,
+                                                        bitmapPaths,
+                                                        countArray(bitmapPaths),
+                                                        background);
+            }
+        }
+    }
+
+    //
+    // Affine bitmaps: scaled up on one axis and down on the other, and
+    // rotated, each from a fractional origin
+    //====================================================
+
+    matrixCase.kind = BENCHMARK_MATRIX_BITMAP_AFFINE;
+
+    for (uint32 i = 0; (i < countArray(affineBitmaps)) && bitmapsNeeded; i++) {
+        for (uint32 transform = 0; transform < countArray(affineNames); transform++) {
+            for (uint32 clip = 0; clip < countArray(benchmarkMatrixClipNames); clip++) {
+
+                BitmapFile *bitmap = &bitmaps[affineBitmaps[i]];
+                matrixCase.bitmap = bitmap;
+
+                float32 width = ((float32)bitmap->widthPx * 1.37f);
+                float32 height = ((float32)bitmap->heightPx * 0.81f);
+
+                if (0 == transform) {
+                    matrixCase.xAxis = {width, 0.0f};
+                    matrixCase.yAxis = {0.0f, height};
+                } else {
+                    // 30 degrees
+                    matrixCase.xAxis = {(width * 0.8660254f), (width * 0.5f)};
+                    matrixCase.yAxis = {(height * -0.5f), (height * 0.8660254f)};
+                }
+
+                xyint position = benchmarkMatrixPlace((BenchmarkMatrixClip)clip, (uint32)width, (uint32)height);
+                matrixCase.origin = {((float32)position.x + 0.25f), ((float32)position.y + 0.625f)};
+
+                snprintf(caseName,
+                            sizeof(caseName),
+                            "graphics_affine_%s_%s_%s",
+                            bitmapNames[affineBitmaps[i]],
+                            affineNames[transform],
+                            benchmarkMatrixClipNames[clip]);
+
+                mismatches += benchmarkMatrixRunCase(options,
+                                                        golden,
+                                                        writeGolden,
+                                                        &matrixCase,
+                                                        caseName,
+                                                        affinePaths,
+                                                        countArray(affinePaths),
+                                                        background);
+            }
+        }
+    }
+
+    //
+    // Lines, hard and smooth, across the middle and over each edge
+    //====================================================
+
+    xyint lineFrom[] = {{100, 50}, {-300, 100}, {900, 100}, {200, -200}, {200, 300}, {-500, -100}};
+    xyint lineTo[] = {{1100, 650}, {400, 600}, {1600, 700}, {900, 500}, {1000, 1000}, {-10, 800}};
+
+    BenchmarkMatrixPath linePaths[] = {
+        {"writeline", true},
+        {"writelinesmooth", true},
+    };
+
+    BenchmarkMatrixKind lineKinds[] = {BENCHMARK_MATRIX_LINE, BENCHMARK_MATRIX_LINE_SMOOTH};
+    const char *lineKindNames[] = {"hard", "smooth"};
+
+    for (uint32 kind = 0; kind < countArray(lineKinds); kind++) {
+        for (uint32 clip = 0; clip < countArray(benchmarkMatrixClipNames); clip++) {
+
+            matrixCase.kind = lineKinds[kind];
+            matrixCase.from = lineFrom[clip];
+            matrixCase.to = lineTo[clip];
+
+            // Smooth lines are given in subpixels. Start them off a pixel
+            // centre too.
+            if (BENCHMARK_MATRIX_LINE_SMOOTH == lineKinds[kind]) {
+                matrixCase.from.x = ((matrixCase.from.x * (1 << WRITE_LINE_SUBPIXEL_BITS)) + 77);
+                matrixCase.from.y = ((matrixCase.from.y * (1 << WRITE_LINE_SUBPIXEL_BITS)) + 31);
+                matrixCase.to.x = (matrixCase.to.x * (1 << WRITE_LINE_SUBPIXEL_BITS));
+                matrixCase.to.y = (matrixCase.to.y * (1 << WRITE_LINE_SUBPIXEL_BITS));
+            }
+
+            snprintf(caseName, sizeof(caseName), "graphics_line_%s_%s", lineKindNames[kind], benchmarkMatrixClipNames[clip]);
+
+            mismatches += benchmarkMatrixRunCase(options,
+                                                    golden,
+                                                    writeGolden,
+                                                    &matrixCase,
+                                                    caseName,
+                                                    &linePaths[kind],
+                                                    1,
+                                                    background);
+        }
+    }
+
+    if (writeGolden) {
+        fclose(writeGolden);
+    }
+
+    if (mismatches && !writeGolden && !goldenLoaded) {
+        fprintf(stderr, "Could not read golden hashes from %s\n", goldenPath);
+    }
+
+    printf("graphics_matrix_mismatches %u\n", mismatches);
+
+    return (int32)mismatches;
+}
+
+int main(int argc, char **argv)
+{
+    BenchmarkOptions options = {};
+
+    if (!benchmarkParseOptions(argc, argv, &options)) {
+        return 1;
+    }
+
+    bool32 avx2 = intrin_cpuSupportsAVX2();
+
+    printf("cpu_avx2 %u\n", (avx2 ? 1 : 0));
+
+    //
+    // Audio
+    //====================================================
+
+    BenchmarkAudioData *audio = (BenchmarkAudioData *)benchmarkAllocate(sizeof(BenchmarkAudioData));
+    if (!audio) {
+        return 1;
+    }
+
+    // A platform buffer of one second, as the platform layers allocate, with
+    // one frame's worth of samples to write each run
+    audio->audioBuffer.bytesPerSample = (sizeof(int16) * 2); // Left + right channel
+    audio->audioBuffer.platformBufferSizeInBytes = (BENCHMARK_AUDIO_SAMPLES_PER_SECOND * audio->audioBuffer.bytesPerSample);
+    audio->audioBuffer.samplesPerSecond = BENCHMARK_AUDIO_SAMPLES_PER_SECOND;
+    audio->audioBuffer.noOfSamplesToWrite = BENCHMARK_AUDIO_SAMPLES_PER_RUN;
+    audio->audioBuffer.noOfBytesToWrite = (BENCHMARK_AUDIO_SAMPLES_PER_RUN * audio->audioBuffer.bytesPerSample);
+    audio->audioBuffer.memorySizeInBytes = audio->audioBuffer.noOfBytesToWrite;
+    audio->audioBuffer.memory = benchmarkAllocate(audio->audioBuffer.memorySizeInBytes);
+
+    audio->wavetables = (OscillatorWavetables *)benchmarkAllocate(sizeof(OscillatorWavetables));
+
+    if (!audio->audioBuffer.memory || !audio->wavetables) {
+        return 1;
+    }
+
+    oscillatorBuildWavetables(audio->wavetables, BENCHMARK_AUDIO_SAMPLES_PER_SECOND);
+
+    audio->referenceSineWave.hertz = 100;
+    audio->referenceSineWave.sizeOfWave = 1000;
+
+    const char *waveformNames[OSCILLATOR_WAVEFORM_COUNT] = {"sine", "square", "saw"};
+
+    Benchmark referenceSine = {"audio_reference_sine", "samples", benchmarkReferenceSineWave, audio, BENCHMARK_AUDIO_SAMPLES_PER_RUN, true};
+
+    if (benchmarkSelected(&options, &referenceSine)) {
+        benchmarkRun(&referenceSine, options.minMS);
+    }
+
+    for (uint32 waveform = 0; waveform < OSCILLATOR_WAVEFORM_COUNT; waveform++) {
+
+        oscillatorSet(&audio->oscillator, audio->wavetables, waveform, 100.0f, 1000.0f);
+
+        char names[3][64];
+        snprintf(names[0], sizeof(names[0]), "oscillator_%s_scalar", waveformNames[waveform]);
+        snprintf(names[1], sizeof(names[1]), "oscillator_%s_sse2", waveformNames[waveform]);
+        snprintf(names[2], sizeof(names[2]), "oscillator_%s_avx2", waveformNames[waveform]);
+
+        Benchmark oscillatorBenchmarks[] = {
+            {names[0], "samples", benchmarkOscillatorScalar, audio, BENCHMARK_AUDIO_SAMPLES_PER_RUN, true},
+            {names[1], "samples", benchmarkOscillatorSSE2, audio, BENCHMARK_AUDIO_SAMPLES_PER_RUN, true},
+            {names[2], "samples", benchmarkOscillatorAVX2, audio, BENCHMARK_AUDIO_SAMPLES_PER_RUN, avx2},
+        };
+
+        for (uint32 i = 0; i < countArray(oscillatorBenchmarks); i++) {
+            if (benchmarkSelected(&options, &oscillatorBenchmarks[i])) {
+                benchmarkRun(&oscillatorBenchmarks[i], options.minMS);
+            }
+        }
+    }
+
+    //
+    // Mixer
+    //====================================================
+
+    BenchmarkMixerData mixerData = {};
+
+    mixerData.mixer = (Mixer *)benchmarkAllocate(sizeof(Mixer));
+    mixerData.samples = (int16 *)audio->audioBuffer.memory;
+
+    uint32 soundLengths[BENCHMARK_MIXER_SOUNDS] = {
+        BENCHMARK_AUDIO_SAMPLES_PER_SECOND,
+        (BENCHMARK_AUDIO_SAMPLES_PER_SECOND / 2) + 11,
+        (BENCHMARK_AUDIO_SAMPLES_PER_SECOND / 5) + 7,
+        997,
+    };
+
+    uint32 noise = 0x12345678;
+
+    for (uint32 i = 0; i < BENCHMARK_MIXER_SOUNDS; i++) {
+
+        mixerData.sounds[i].sampleCount = soundLengths[i];
+        mixerData.sounds[i].samples = (float32 *)benchmarkAllocate(soundLengths[i] * sizeof(float32));
+
+        if (!mixerData.sounds[i].samples) {
+            return 1;
+        }
+
+        // xorshift noise, -0.5 to 0.5
+        for (uint32 j = 0; j < soundLengths[i]; j++) {
+            noise ^= (noise << 13);
+            noise ^= (noise >> 17);
+            noise ^= (noise << 5);
+            mixerData.sounds[i].samples[j] = (((float32)(noise >> 8) / (float32)(1 << 24)) - 0.5f);
+        }
+    }
+
+    if (!mixerData.mixer) {
+        return 1;
+    }
+
+    // Every voice mixed, then 512 voices against the default budget
+    uint32 mixerVoiceCounts[] = {32, 128, 512};
+
+    const char *mixerPathNames[] = {"scalar", "sse2", "avx2"};
+    BenchmarkMixFunction *mixerPaths[] = {mixerMixScalar, mixerMixSSE2, mixerMixAVX2};
+    bool32 mixerPathSupported[] = {true, true, avx2};
+
+    for (uint32 i = 0; i <= countArray(mixerVoiceCounts); i++) {
+
+        bool32 budgeted = (i == countArray(mixerVoiceCounts));
+
+        for (uint32 path = 0; path < countArray(mixerPaths); path++) {
+
+            char name[64];
+
+            if (budgeted) {
+                snprintf(name, sizeof(name), "mixer_%u_voices_budget_%u_%s", MIXER_MAX_VOICES, MIXER_DEFAULT_VOICE_BUDGET, mixerPathNames[path]);
+            } else {
+                snprintf(name, sizeof(name), "mixer_%u_voices_%s", mixerVoiceCounts[i], mixerPathNames[path]);
+            }
+
+            Benchmark mixerBenchmark = {name, "samples", benchmarkMixer, &mixerData, BENCHMARK_AUDIO_SAMPLES_PER_RUN, mixerPathSupported[path]};
+
+            if (!benchmarkSelected(&options, &mixerBenchmark)) {
+                continue;
+            }
+
+            mixerInit(mixerData.mixer);
+
+            mixerData.mixer->voiceBudget = (budgeted ? MIXER_DEFAULT_VOICE_BUDGET : MIXER_MAX_VOICES);
+            mixerData.voiceCount = (budgeted ? MIXER_MAX_VOICES : mixerVoiceCounts[i]);
+            mixerData.mix = mixerPaths[path];
+
+            benchmarkMixerFillVoices(&mixerData);
+            benchmarkRun(&mixerBenchmark, options.minMS);
+        }
+    }
+
+    //
+    // Bitmaps
+    //====================================================
+
+    BenchmarkBlitData blitData = {};
+
+    uint32 blitPixelCount = (BENCHMARK_BLIT_WIDTH * BENCHMARK_BLIT_HEIGHT);
+
+    blitData.bitmapPixels = (uint32 *)benchmarkAllocate(blitPixelCount * sizeof(uint32));
+    blitData.pixels = (uint32 *)benchmarkAllocate(blitPixelCount * sizeof(uint32));
+
+    // The frame buffer pixels before blending, and after the scalar version
+    uint32 *blitStart = (uint32 *)benchmarkAllocate(blitPixelCount * sizeof(uint32));
+    uint32 *blitReference = (uint32 *)benchmarkAllocate(blitPixelCount * sizeof(uint32));
+
+    if (!blitData.bitmapPixels || !blitData.pixels || !blitStart || !blitReference) {
+        return 1;
+    }
+
+    for (uint32 i = 0; i < blitPixelCount; i++) {
+
+        noise ^= (noise << 13);
+        noise ^= (noise >> 17);
+        noise ^= (noise << 5);
+
+        // Roughly a third each transparent, opaque and somewhere between
+        uint32 alpha = (noise >> 24);
+        alpha = ((alpha < 85) ? 0 : ((alpha < 170) ? 255 : alpha));
+
+        // Premultiplied, as DEBUGReadBMP leaves them
+        uint32 red = ((((noise >> 16) & 0xFF) * alpha) / 255);
+        uint32 green = ((((noise >> 8) & 0xFF) * alpha) / 255);
+        uint32 blue = (((noise & 0xFF) * alpha) / 255);
+
+        blitData.bitmapPixels[i] = ((alpha << 24) | (red << 16) | (green << 8) | blue);
+        blitStart[i] = (noise >> 4);
+        blitReference[i] = blitStart[i];
+    }
+
+    // Every version must give exactly the scalar version's result
+    WriteBitmapRow *blitPaths[] = {writeBitmapRowScalar, writeBitmapRowSSE2, writeBitmapRowAVX2};
+    bool32 blitPathSupported[] = {true, true, avx2};
+    const char *blitPathNames[] = {"scalar", "sse2", "avx2"};
+
+    writeBitmapRowScalar(blitReference, blitData.bitmapPixels, blitPixelCount);
+
+    for (uint32 path = 0; path < countArray(blitPaths); path++) {
+
+        char name[64];
+        snprintf(name, sizeof(name), "blit_%ux%u_%s", BENCHMARK_BLIT_WIDTH, BENCHMARK_BLIT_HEIGHT, blitPathNames[path]);
+
+        Benchmark blitBenchmark = {name, "pixels", benchmarkBlit, &blitData, blitPixelCount, blitPathSupported[path]};
+
+        if (!benchmarkSelected(&options, &blitBenchmark)) {
+            continue;
+        }
+
+        blitData.writeBitmapRow = blitPaths[path];
+
+        if (blitPathSupported[path]) {
+
+            memcpy(blitData.pixels, blitStart, (blitPixelCount * sizeof(uint32)));
+
+            benchmarkBlit(&blitData);
+
+            bool32 matches = (0 == memcmp(blitData.pixels, blitReference, (blitPixelCount * sizeof(uint32))));
+
+            printf("%s_matches_scalar %u\n", name, (matches ? 1 : 0));
+        }
+
+        benchmarkRun(&blitBenchmark, options.minMS);
+    }
+
+    //
+    // Rectangles
+    //====================================================
+
+    BenchmarkFillData fillData = {};
+
+    uint32 fillPixelCount = (FRAME_BUFFER_PIXEL_WIDTH * FRAME_BUFFER_PIXEL_HEIGHT);
+
+    fillData.frameBuffer.widthPx = FRAME_BUFFER_PIXEL_WIDTH;
+    fillData.frameBuffer.heightPx = FRAME_BUFFER_PIXEL_HEIGHT;
+    fillData.frameBuffer.bytesPerPixel = sizeof(uint32);
+    fillData.frameBuffer.byteWidthPerRow = (FRAME_BUFFER_PIXEL_WIDTH * sizeof(uint32));
+    fillData.frameBuffer.memory = benchmarkAllocate(fillPixelCount * sizeof(uint32));
+
+    uint32 *fillStart = (uint32 *)benchmarkAllocate(fillPixelCount * sizeof(uint32));
+    uint32 *fillReference = (uint32 *)benchmarkAllocate(fillPixelCount * sizeof(uint32));
+
+    if (!fillData.frameBuffer.memory || !fillStart || !fillReference) {
+        return 1;
+    }
+
+    for (uint32 i = 0; i < fillPixelCount; i++) {
+        fillStart[i] = (i * 2654435761u);
+    }
+
+    uint32 fillWidths[BENCHMARK_FILL_SIZES] = {1, 40, 256, FRAME_BUFFER_PIXEL_WIDTH};
+    uint32 fillHeights[BENCHMARK_FILL_SIZES] = {1, 40, 256, FRAME_BUFFER_PIXEL_HEIGHT};
+
+    // Every version must fill exactly the same pixels as the scalar version.
+    // writeRectangle picks between the others, and isn't checked as its rows
+    // start from the bottom of the buffer rather than the top.
+    WriteRectangleRows *fillPaths[] = {writeRectangleRowsScalar, writeRectangleRowsSSE2, writeRectangleRowsAVX2, writeRectangleRowsStream, NULL};
+    bool32 fillPathSupported[] = {true, true, avx2, true, true};
+    const char *fillPathNames[] = {"scalar", "sse2", "avx2", "stream", "writerectangle"};
+
+    for (uint32 size = 0; size < BENCHMARK_FILL_SIZES; size++) {
+
+        fillData.width = fillWidths[size];
+        fillData.height = fillHeights[size];
+
+        fillData.x = ((fillData.width < FRAME_BUFFER_PIXEL_WIDTH) ? 1 : 0);
+
+        memcpy(fillReference, fillStart, (fillPixelCount * sizeof(uint32)));
+        writeRectangleRowsScalar((fillReference + fillData.x), FRAME_BUFFER_PIXEL_WIDTH, fillData.width, fillData.height, (uint32)0xFF336699);
+
+        for (uint32 path = 0; path < countArray(fillPaths); path++) {
+
+            char name[64];
+            snprintf(name, sizeof(name), "fill_%ux%u_%s", fillData.width, fillData.height, fillPathNames[path]);
+
+            Benchmark fillBenchmark = {name, "mpixels", benchmarkFill, &fillData, (fillData.width * fillData.height), fillPathSupported[path], 1000000};
+
+            if (!benchmarkSelected(&options, &fillBenchmark)) {
+                continue;
+            }
+
+            fillData.writeRectangleRows = fillPaths[path];
+
+            if (fillPathSupported[path] && fillPaths[path]) {
+
+                memcpy(fillData.frameBuffer.memory, fillStart, (fillPixelCount * sizeof(uint32)));
+
+                benchmarkFill(&fillData);
+
+                bool32 matches = (0 == memcmp(fillData.frameBuffer.memory, fillReference, (fillPixelCount * sizeof(uint32))));
+
+                printf("%s_matches_scalar %u\n", name, (matches ? 1 : 0));
+            }
+
+            benchmarkRun(&fillBenchmark, options.minMS);
+        }
+    }
+
+    //
+    // Lines
+    //====================================================
+
+    BenchmarkLineData lineData = {};
+
+    lineData.frameBuffer = fillData.frameBuffer;
+
+    const char *lineSetNames[] = {"onscreen", "clipped"};
+    const char *lineModeNames[] = {"reference", "hard", "smooth"};
+
+    for (uint32 set = 0; set < countArray(lineSetNames); set++) {
+
+        // Lines are measured in pixels along their longer axis, whether
+        // they're on screen or not
+        uint64 linePixels = 0;
+
+        int32 reach = ((set == 0) ? 1 : 9);
+        int32 offset = ((set == 0) ? 0 : 4);
+
+        for (uint32 i = 0; i < BENCHMARK_LINE_COUNT; i++) {
+
+            uint32 noise0 = ((i * 2) * 2654435761u);
+            uint32 noise1 = (((i * 2) + 1) * 2654435761u);
+
+            xyint from = {(int32)((noise0 % (FRAME_BUFFER_PIXEL_WIDTH * reach))) - (FRAME_BUFFER_PIXEL_WIDTH * offset),
+                            (int32)(((noise0 >> 12) % (FRAME_BUFFER_PIXEL_HEIGHT * reach))) - (FRAME_BUFFER_PIXEL_HEIGHT * offset)};
+            xyint to = {(int32)((noise1 % (FRAME_BUFFER_PIXEL_WIDTH * reach))) - (FRAME_BUFFER_PIXEL_WIDTH * offset),
+                        (int32)(((noise1 >> 12) % (FRAME_BUFFER_PIXEL_HEIGHT * reach))) - (FRAME_BUFFER_PIXEL_HEIGHT * offset)};
+
+            lineData.from[i] = from;
+            lineData.to[i] = to;
+
+            int32 width = ((to.x > from.x) ? (to.x - from.x) : (from.x - to.x));
+            int32 height = ((to.y > from.y) ? (to.y - from.y) : (from.y - to.y));
+
+            linePixels += (uint64)(((width > height) ? width : height) + 1);
+        }
+
+        for (uint32 mode = 0; mode < countArray(lineModeNames); mode++) {
+
+            char name[64];
+            snprintf(name, sizeof(name), "line_%u_%s_%s", BENCHMARK_LINE_COUNT, lineSetNames[set], lineModeNames[mode]);
+
+            Benchmark lineBenchmark = {name, "mpixels", benchmarkLine, &lineData, linePixels, true, 1000000};
+
+            if (!benchmarkSelected(&options, &lineBenchmark)) {
+                continue;
+            }
+
+            lineData.mode = (BenchmarkLineMode)mode;
+
+            // Smooth lines are given in subpixels
+            if (mode == BENCHMARK_LINE_MODE_SMOOTH) {
+                for (uint32 i = 0; i < BENCHMARK_LINE_COUNT; i++) {
+                    lineData.from[i].x *= (1 << WRITE_LINE_SUBPIXEL_BITS);
+                    lineData.from[i].y *= (1 << WRITE_LINE_SUBPIXEL_BITS);
+                    lineData.to[i].x *= (1 << WRITE_LINE_SUBPIXEL_BITS);
+                    lineData.to[i].y *= (1 << WRITE_LINE_SUBPIXEL_BITS);
+                }
+            }
+
+            benchmarkRun(&lineBenchmark, options.minMS);
+        }
+    }
+
+    //
+    // Scaled and rotated sprites
+    //====================================================
+
+    BenchmarkSpriteData *spriteData = (BenchmarkSpriteData *)benchmarkAllocate(sizeof(BenchmarkSpriteData));
+
+    uint32 spritePixelCount = (BENCHMARK_RENDER_WIDTH * BENCHMARK_RENDER_HEIGHT);
+
+    if (!spriteData) {
+        return 1;
+    }
+
+    spriteData->frameBuffer.widthPx = BENCHMARK_RENDER_WIDTH;
+    spriteData->frameBuffer.heightPx = BENCHMARK_RENDER_HEIGHT;
+    spriteData->frameBuffer.bytesPerPixel = sizeof(uint32);
+    spriteData->frameBuffer.byteWidthPerRow = (BENCHMARK_RENDER_WIDTH * sizeof(uint32));
+    spriteData->frameBuffer.memory = benchmarkAllocate(spritePixelCount * sizeof(uint32));
+
+    spriteData->bitmap.widthPx = BENCHMARK_BLIT_WIDTH;
+    spriteData->bitmap.heightPx = BENCHMARK_BLIT_HEIGHT;
+    spriteData->bitmap.pitchPx = BENCHMARK_BLIT_WIDTH;
+    spriteData->bitmap.memory = blitData.bitmapPixels;
+
+    uint32 *spriteStart = (uint32 *)benchmarkAllocate(spritePixelCount * sizeof(uint32));
+    uint32 *spriteReference = (uint32 *)benchmarkAllocate(spritePixelCount * sizeof(uint32));
+
+    if (!spriteData->frameBuffer.memory || !spriteStart || !spriteReference) {
+        return 1;
+    }
+
+    for (uint32 i = 0; i < spritePixelCount; i++) {
+        spriteStart[i] = (i * 2654435761u);
+    }
+
+    const char *spriteSetNames[] = {"unscaled", "scaled", "rotated"};
+
+    // Every version must give exactly the scalar version's result, and
+    // unscaled sprites exactly writeBitmap's
+    WriteBitmapAffineRow *spritePaths[] = {writeBitmapAffineRowScalar, writeBitmapAffineRowSSE2, writeBitmapAffineRowAVX2, NULL};
+    bool32 spritePathSupported[] = {true, true, avx2, true};
+    const char *spritePathNames[] = {"scalar", "sse2", "avx2", "writebitmap"};
+
+    for (uint32 set = 0; set < countArray(spriteSetNames); set++) {
+
+        // Sprites are measured in the pixels they cover, on screen or not
+        uint64 spritePixels = 0;
+
+        for (uint32 i = 0; i < BENCHMARK_SPRITE_COUNT; i++) {
+
+            uint32 spriteNoise = (i * 2654435761u);
+
+            // Between half and twice the sprite's size
+            float32 scale = ((set == 0) ? 1.0f : (0.5f + ((float32)((spriteNoise >> 8) & 0xFF) / 170.0f)));
+
+            Vector2 direction = {1.0f, 0.0f};
+
+            if (set == 2) {
+                direction.x = ((float32)((spriteNoise >> 16) & 0xFF) - 127.5f);
+                direction.y = ((float32)((spriteNoise >> 24) & 0xFF) - 127.5f);
+                float32 magnitude = getVectorMagnitude(direction);
+                direction.x = (direction.x / magnitude);
+                direction.y = (direction.y / magnitude);
+            }
+
+            float32 width = ((float32)BENCHMARK_BLIT_WIDTH * scale);
+            float32 height = ((float32)BENCHMARK_BLIT_HEIGHT * scale);
+
+            // Whole pixels, and some hanging off each edge
+            spriteData->origin[i].x = (float32)((int32)(spriteNoise % (BENCHMARK_RENDER_WIDTH + BENCHMARK_BLIT_WIDTH)) - BENCHMARK_BLIT_WIDTH);
+            spriteData->origin[i].y = (float32)((int32)((spriteNoise >> 11) % (BENCHMARK_RENDER_HEIGHT + BENCHMARK_BLIT_HEIGHT)) - BENCHMARK_BLIT_HEIGHT);
+            spriteData->xAxis[i] = {(direction.x * width), (direction.y * width)};
+            spriteData->yAxis[i] = {(-direction.y * height), (direction.x * height)};
+
+            spritePixels += (uint64)(width * height);
+        }
+
+        spriteData->writeBitmapAffineRow = writeBitmapAffineRowScalar;
+        memcpy(spriteData->frameBuffer.memory, spriteStart, (spritePixelCount * sizeof(uint32)));
+        benchmarkSprite(spriteData);
+        memcpy(spriteReference, spriteData->frameBuffer.memory, (spritePixelCount * sizeof(uint32)));
+
+        for (uint32 path = 0; path < countArray(spritePaths); path++) {
+
+            // writeBitmap can only draw sprites at their own size
+            if (!spritePaths[path] && (set != 0)) {
+                continue;
+            }
+
+            char name[64];
+            snprintf(name, sizeof(name), "sprite_%u_%s_%s", BENCHMARK_SPRITE_COUNT, spriteSetNames[set], spritePathNames[path]);
+
+            Benchmark spriteBenchmark = {name, "mpixels", benchmarkSprite, spriteData, spritePixels, spritePathSupported[path], 1000000};
+
+            if (!benchmarkSelected(&options, &spriteBenchmark)) {
+                continue;
+            }
+
+            spriteData->writeBitmapAffineRow = spritePaths[path];
+
+            if (spritePathSupported[path]) {
+
+                memcpy(spriteData->frameBuffer.memory, spriteStart, (spritePixelCount * sizeof(uint32)));
+
+                benchmarkSprite(spriteData);
+
+                bool32 matches = (0 == memcmp(spriteData->frameBuffer.memory, spriteReference, (spritePixelCount * sizeof(uint32))));
+
+                printf("%s_matches_scalar %u\n", name, (matches ? 1 : 0));
+            }
+
+            benchmarkRun(&spriteBenchmark, options.minMS);
+        }
+    }
+
+    //
+    // Upscaling frames drawn at a lower resolution
+    //====================================================
+
+    BenchmarkUpscaleData upscaleData = {};
+
+    uint32 upscalePixelCount = (BENCHMARK_UPSCALE_WIDTH * BENCHMARK_UPSCALE_HEIGHT);
+
+    upscaleData.dest.widthPx = BENCHMARK_UPSCALE_WIDTH;
+    upscaleData.dest.heightPx = BENCHMARK_UPSCALE_HEIGHT;
+    upscaleData.dest.bytesPerPixel = sizeof(uint32);
+    upscaleData.dest.byteWidthPerRow = (BENCHMARK_UPSCALE_WIDTH * sizeof(uint32));
+    upscaleData.dest.memory = benchmarkAllocate(upscalePixelCount * sizeof(uint32));
+    upscaleData.source.bytesPerPixel = sizeof(uint32);
+    upscaleData.source.memory = benchmarkAllocate(upscalePixelCount * sizeof(uint32));
+    upscaleData.scratchRow = (uint32 *)benchmarkAllocate(BENCHMARK_UPSCALE_WIDTH * sizeof(uint32));
+
+    uint32 *upscaleReference = (uint32 *)benchmarkAllocate(upscalePixelCount * sizeof(uint32));
+
+    if (!upscaleData.dest.memory || !upscaleData.source.memory || !upscaleData.scratchRow || !upscaleReference) {
+        return 1;
+    }
+
+    // Noise, so every channel of neighbouring pixels differs
+    for (uint32 i = 0; i < upscalePixelCount; i++) {
+        ((uint32 *)upscaleData.source.memory)[i] = (i * 2654435761u);
+    }
+
+    // Eighths of the frame buffer's resolution, as the game draws at
+    uint32 upscaleScales[] = {4, 6};
+
+    UpscaleFilter upscaleFilters[] = {UPSCALE_FILTER_NEAREST, UPSCALE_FILTER_BILINEAR};
+    const char *upscaleFilterNames[] = {"nearest", "bilinear"};
+
+    // Every version must give exactly the scalar version's result
+    UpscaleRow *upscaleNearestPaths[] = {upscaleRowNearestScalar, upscaleRowNearestSSE2, upscaleRowNearestAVX2};
+    UpscaleRow *upscaleBilinearPaths[] = {upscaleRowBilinearScalar, upscaleRowBilinearSSE2, upscaleRowBilinearAVX2};
+    UpscaleBlendRows *upscaleBlendPaths[] = {upscaleBlendRowsScalar, upscaleBlendRowsSSE2, upscaleBlendRowsAVX2};
+    bool32 upscalePathSupported[] = {true, true, avx2};
+    const char *upscalePathNames[] = {"scalar", "sse2", "avx2"};
+
+    for (uint32 scale = 0; scale < countArray(upscaleScales); scale++) {
+
+        upscaleData.source.widthPx = ((BENCHMARK_UPSCALE_WIDTH * upscaleScales[scale]) / 8);
+        upscaleData.source.heightPx = ((BENCHMARK_UPSCALE_HEIGHT * upscaleScales[scale]) / 8);
+        upscaleData.source.byteWidthPerRow = (upscaleData.source.widthPx * sizeof(uint32));
+
+        for (uint32 filter = 0; filter < countArray(upscaleFilters); filter++) {
+
+            UpscaleRow **upscaleRows = ((UPSCALE_FILTER_NEAREST == upscaleFilters[filter]) ? upscaleNearestPaths : upscaleBilinearPaths);
+
+            upscaleData.filter = upscaleFilters[filter];
+            upscaleData.upscaleRow = upscaleRows[0];
+            upscaleData.blendRows = upscaleBlendPaths[0];
+            benchmarkUpscale(&upscaleData);
+            memcpy(upscaleReference, upscaleData.dest.memory, (upscalePixelCount * sizeof(uint32)));
+
+            for (uint32 path = 0; path < countArray(upscalePathNames); path++) {
+
+                char name[64];
+                snprintf(name,
+                            sizeof(name),
+                            "upscale_%ux%u_%s_%s",
+                            upscaleData.source.widthPx,
+                            upscaleData.source.heightPx,
+                            upscaleFilterNames[filter],
+                            upscalePathNames[path]);
+
+                // Measured in the pixels filled
+                Benchmark upscaleBenchmark = {name, "mpixels", benchmarkUpscale, &upscaleData, upscalePixelCount, upscalePathSupported[path], 1000000};
+
+                if (!benchmarkSelected(&options, &upscaleBenchmark)) {
+                    continue;
+                }
+
+                upscaleData.upscaleRow = upscaleRows[path];
+                upscaleData.blendRows = upscaleBlendPaths[path];
+
+                if (upscalePathSupported[path]) {
+
+                    memset(upscaleData.dest.memory, 0, (upscalePixelCount * sizeof(uint32)));
+
+                    benchmarkUpscale(&upscaleData);
+
+                    bool32 matches = (0 == memcmp(upscaleData.dest.memory, upscaleReference, (upscalePixelCount * sizeof(uint32))));
+
+                    printf("%s_matches_scalar %u\n", name, (matches ? 1 : 0));
+                }
+
+                benchmarkRun(&upscaleBenchmark, options.minMS);
+            }
+        }
+    }
+
+    //
+    // Tiled renderer
+    //====================================================
+
+    BenchmarkRenderData renderData = {};
+
+    uint32 renderPixelCount = (BENCHMARK_RENDER_WIDTH * BENCHMARK_RENDER_HEIGHT);
+    uint32 renderMaxTiles = renderTileCount(BENCHMARK_RENDER_WIDTH, BENCHMARK_RENDER_HEIGHT);
+
+    renderData.frameBuffer.widthPx = BENCHMARK_RENDER_WIDTH;
+    renderData.frameBuffer.heightPx = BENCHMARK_RENDER_HEIGHT;
+    renderData.frameBuffer.bytesPerPixel = sizeof(uint32);
+    renderData.frameBuffer.byteWidthPerRow = (BENCHMARK_RENDER_WIDTH * sizeof(uint32));
+    renderData.frameBuffer.memory = benchmarkAllocate(renderPixelCount * sizeof(uint32));
+
+    uint32 *renderReference = (uint32 *)benchmarkAllocate(renderPixelCount * sizeof(uint32));
+    PlatformWorkQueue *renderQueue = (PlatformWorkQueue *)benchmarkAllocate(sizeof(PlatformWorkQueue));
+
+    // The render group reserves everything it needs from a memory block, like
+    // it does in the game
+    MemoryRegion renderRegion = {};
+    renderRegion.sizeInBytes = utilMebibytesToBytes(2);
+    renderRegion.bytesFree = renderRegion.sizeInBytes;
+    renderRegion.bytes = benchmarkAllocate(renderRegion.sizeInBytes);
+
+    if (!renderData.frameBuffer.memory || !renderRegion.bytes || !renderReference || !renderQueue) {
+        return 1;
+    }
+
+    MemoryBlock renderBlock = {};
+    memoryRegionReserveBlock(renderRegion, &renderBlock, (uint8 *)renderRegion.bytes, renderRegion.sizeInBytes);
+
+    renderGroupInit(&renderData.group,
+                    &renderRegion,
+                    &renderBlock,
+                    BENCHMARK_RENDER_PUSH_BUFFER_SIZE,
+                    BENCHMARK_RENDER_MAX_COMMANDS,
+                    renderMaxTiles);
+
+    // The blit benchmark's sprite
+    BitmapFile renderBitmap = {};
+    renderBitmap.widthPx = BENCHMARK_BLIT_WIDTH;
+    renderBitmap.heightPx = BENCHMARK_BLIT_HEIGHT;
+    renderBitmap.pitchPx = BENCHMARK_BLIT_WIDTH;
+    renderBitmap.memory = blitData.bitmapPixels;
+
+    // Pushed in the opposite order to how they're layered, so the sort has
+    // something to do
+    for (uint32 i = 0; i < BENCHMARK_RENDER_DOTS; i++) {
+        uint32 noise = (i * 2654435761u);
+        renderGroupPushRectangle(&renderData.group,
+                                    2,
+                                    (float32)(noise % BENCHMARK_RENDER_WIDTH),
+                                    (float32)((noise >> 12) % BENCHMARK_RENDER_HEIGHT),
+                                    1,
+                                    1,
+                                    0xFFFFFFFF);
+    }
+
+    for (uint32 i = 0; i < 8; i++) {
+        renderGroupPushLine(&renderData.group,
+                            2,
+                            (int32)(i * 240),
+                            0,
+                            (int32)(BENCHMARK_RENDER_WIDTH - 1 - (i * 240)),
+                            (BENCHMARK_RENDER_HEIGHT - 1),
+                            0xFFFF00FF);
+    }
+
+    // Arrows fanning out from the middle, with fractional ends, so they
+    // cross tile edges at every angle
+    for (uint32 i = 0; i < 16; i++) {
+        Vector2 from = {(BENCHMARK_RENDER_WIDTH / 2.0f) + 0.25f, (BENCHMARK_RENDER_HEIGHT / 2.0f) + 0.75f};
+        Vector2 to = {(from.x + (((float32)(i % 8) - 3.5f) * 130.0f)),
+                        (from.y + (((i < 8) ? 1.0f : -1.0f) * (float32)(30 + (i * 30))))};
+
+        renderGroupPushArrow(&renderData.group, 2, from, to, 12.0f, 0xFF00FFFF, true);
+    }
+
+    // Scaled and rotated, over the tile edges
+    for (uint32 i = 0; i < 3; i++) {
+        Vector2 origin = {(200.5f + (i * 150.0f)), (300.25f + (i * 40.0f))};
+        Vector2 xAxis = {(BENCHMARK_BLIT_WIDTH * 0.8f), (BENCHMARK_BLIT_WIDTH * (0.3f * i))};
+        Vector2 yAxis = {-(BENCHMARK_BLIT_HEIGHT * (0.3f * i)), (BENCHMARK_BLIT_HEIGHT * 0.8f)};
+
+        renderGroupPushBitmapAffine(&renderData.group, 1, origin, xAxis, yAxis, &renderBitmap);
+    }
+
+    for (uint32 i = 0; i < 3; i++) {
+        renderGroupPushBitmap(&renderData.group,
+                                1,
+                                (float32)(800 + (i * 100)),
+                                (float32)(400 + (i * 30)),
+                                (float32)BENCHMARK_BLIT_WIDTH,
+                                (float32)BENCHMARK_BLIT_HEIGHT,
+                                0.0f,
+                                0.0f,
+                                &renderBitmap);
+    }
+
+    // Runs of four tiles share a colour, so they're merged
+    for (uint32 y = 0; y < BENCHMARK_RENDER_HEIGHT; y += BENCHMARK_RENDER_TILE_PX) {
+        for (uint32 x = 0; x < BENCHMARK_RENDER_WIDTH; x += BENCHMARK_RENDER_TILE_PX) {
+            uint32 run = (x / (BENCHMARK_RENDER_TILE_PX * 4));
+            renderGroupPushRectangle(&renderData.group,
+                                        0,
+                                        (float32)x,
+                                        (float32)y,
+                                        BENCHMARK_RENDER_TILE_PX,
+                                        BENCHMARK_RENDER_TILE_PX,
+                                        (0xFF000000 | ((run * 2654435761u) ^ y)));
+        }
+    }
+
+    renderGroupPushClear(&renderData.group, 0xFF000000);
+
+    // Every thread count must draw exactly what one thread does without the
+    // queue
+    renderData.queue = NULL;
+    benchmarkRender(&renderData);
+    memcpy(renderReference, renderData.frameBuffer.memory, (renderPixelCount * sizeof(uint32)));
+
+    uint32 renderThreadCounts[] = {1, 2, 4, 8};
+
+    for (uint32 i = 0; i < countArray(renderThreadCounts); i++) {
+
+        char name[64];
+        snprintf(name, sizeof(name), "render_%ux%u_%u_threads", BENCHMARK_RENDER_WIDTH, BENCHMARK_RENDER_HEIGHT, renderThreadCounts[i]);
+
+        Benchmark renderBenchmark = {name, "mpixels", benchmarkRender, &renderData, renderPixelCount, true, 1000000};
+
+        if (!benchmarkSelected(&options, &renderBenchmark)) {
+            continue;
+        }
+
+        // The calling thread works too
+        if (!linuxStartWorkQueue(renderQueue, (renderThreadCounts[i] - 1))) {
+            fprintf(stderr, "Could not start %u worker threads\n", (renderThreadCounts[i] - 1));
+            return 1;
+        }
+
+        renderData.queue = renderQueue;
+
+        memset(renderData.frameBuffer.memory, 0, (renderPixelCount * sizeof(uint32)));
+
+        benchmarkRender(&renderData);
+
+        bool32 matches = (0 == memcmp(renderData.frameBuffer.memory, renderReference, (renderPixelCount * sizeof(uint32))));
+
+        printf("%s_matches_serial %u\n", name, (matches ? 1 : 0));
+
+        benchmarkRun(&renderBenchmark, options.minMS);
+
+        linuxStopWorkQueue(renderQueue);
+    }
+
+    //
+    // Graphics matrix
+    //====================================================
+
+    int32 matrixMismatches = benchmarkGraphicsMatrix(&options, avx2);
+
+    if (matrixMismatches != 0) {
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,345 @@
+#ifndef HEADER_LINUX_BENCHMARK
+#define HEADER_LINUX_BENCHMARK
+
+// Each benchmark is run repeatedly for at least this long (by default)
+#define BENCHMARK_DEFAULT_MIN_MS 250
+
+// Samples written per run of an audio benchmark. One frame's worth at 30fps.
+// Runs are also reported in ns (<name>_ns_per_run), which for these is the
+// cost per frame.
+#define BENCHMARK_AUDIO_SAMPLES_PER_SECOND 48000
+#define BENCHMARK_AUDIO_SAMPLES_PER_RUN (BENCHMARK_AUDIO_SAMPLES_PER_SECOND / 30)
+
+/**
+ * One run of a benchmark. Does a fixed amount of work (Benchmark.itemsPerRun)
+ * each time it's called.
+ */
+#define BENCHMARK(name) void name(void *data)
+typedef BENCHMARK(BenchmarkFunction);
+
+typedef struct Benchmark
+{
+    // Reported as <name>_<unit>_per_second
+    const char *name;
+    const char *unit;
+
+    BenchmarkFunction *function;
+    void *data;
+
+    uint64 itemsPerRun;
+
+    // False if the CPU can't run it (E.g. no AVX2)
+    bool32 supported;
+
+    // Items that make up one unit (E.g. 1000000 to report megapixels).
+    // 0 is the same as 1.
+    uint64 itemsPerUnit;
+
+} Benchmark;
+
+typedef struct BenchmarkOptions
+{
+    // Only run benchmarks whose name contains this
+    const char *filter;
+
+    uint32 minMS;
+
+    // How long each graphics matrix case is timed for
+    uint32 matrixMS;
+
+    // Folder the graphics matrix loads its bitmaps from, with a trailing
+    // slash. NULL for data/test/ next to the executable.
+    const char *dataPath;
+
+    // Hashes to check the graphics matrix against. NULL for
+    // graphics_golden.txt in dataPath.
+    const char *goldenPath;
+
+    // Writes the hashes the graphics matrix draws here, rather than checking
+    // them. NULL to check.
+    const char *writeGoldenPath;
+
+} BenchmarkOptions;
+
+/**
+ * The debug sine wave as the game used to write it: a divide, a degrees to
+ * radians conversion and a double precision sin() per sample, restarting at
+ * the start of the cycle each call. Kept as the baseline for the oscillator.
+ */
+typedef struct BenchmarkReferenceSineWave
+{
+    uint16 hertz;
+    uint16 sizeOfWave;
+} BenchmarkReferenceSineWave;
+
+typedef struct BenchmarkAudioData
+{
+    GameAudioBuffer audioBuffer;
+
+    BenchmarkReferenceSineWave referenceSineWave;
+
+    OscillatorWavetables *wavetables;
+    Oscillator oscillator;
+
+} BenchmarkAudioData;
+
+// Sounds the mixer benchmarks' voices play
+#define BENCHMARK_MIXER_SOUNDS 4
+
+typedef void BenchmarkMixFunction(Mixer *mixer, int16 *samples, uint32 sampleCount);
+
+typedef struct BenchmarkMixerData
+{
+    Mixer *mixer;
+
+    // Noise of different lengths, so that voices wrap and end at different
+    // points in the frame
+    MixerSound sounds[BENCHMARK_MIXER_SOUNDS];
+
+    // Kept playing. Half loop and half are one-shots, restarted as they end.
+    uint32 voiceCount;
+
+    BenchmarkMixFunction *mix;
+
+    int16 *samples;
+
+} BenchmarkMixerData;
+
+// Sprite blended by the blit benchmarks. The size of a hero bitmap.
+#define BENCHMARK_BLIT_WIDTH 144
+#define BENCHMARK_BLIT_HEIGHT 217
+
+typedef struct BenchmarkBlitData
+{
+    // Premultiplied bitmap pixels: a mix of transparent, opaque and partly
+    // transparent
+    uint32 *bitmapPixels;
+
+    // Frame buffer pixels to blend over
+    uint32 *pixels;
+
+    WriteBitmapRow *writeBitmapRow;
+
+} BenchmarkBlitData;
+
+// Rectangles filled by the fill benchmarks: a debug vector pixel, a tile, a
+// large sprite and the whole frame
+#define BENCHMARK_FILL_SIZES 4
+
+typedef struct BenchmarkFillData
+{
+    // A frame sized buffer
+    GameFrameBuffer frameBuffer;
+
+    // Inset by a pixel unless the rectangle is the width of the frame, so
+    // that rows don't start 16 byte aligned
+    uint32 x;
+
+    uint32 width;
+    uint32 height;
+
+    // NULL to go through writeRectangle
+    WriteRectangleRows *writeRectangleRows;
+
+} BenchmarkFillData;
+
+// Lines drawn by the line benchmarks, from end to end of a frame sized buffer.
+// The clipped set reaches up to four screens past each edge, so most of each
+// line is off screen.
+#define BENCHMARK_LINE_COUNT 64
+
+typedef enum BenchmarkLineMode
+{
+    // The way the debug vectors used to be drawn: a 1x1 writeRectangle per
+    // pixel along the line
+    BENCHMARK_LINE_MODE_REFERENCE,
+    BENCHMARK_LINE_MODE_HARD,
+    BENCHMARK_LINE_MODE_SMOOTH,
+} BenchmarkLineMode;
+
+typedef struct BenchmarkLineData
+{
+    // A frame sized buffer
+    GameFrameBuffer frameBuffer;
+
+    // In pixels, and in subpixels (WRITE_LINE_SUBPIXEL_BITS) for smooth lines
+    xyint from[BENCHMARK_LINE_COUNT];
+    xyint to[BENCHMARK_LINE_COUNT];
+
+    BenchmarkLineMode mode;
+
+} BenchmarkLineData;
+
+// The render group draws a clear, a screen of 40x40 tiles, three hero sized
+// bitmaps, a few hard and smooth lines and a scatter of 1x1 rectangles, like
+// a frame of the game, at 1080p
+#define BENCHMARK_RENDER_WIDTH 1920
+#define BENCHMARK_RENDER_HEIGHT 1080
+#define BENCHMARK_RENDER_TILE_PX 40
+#define BENCHMARK_RENDER_DOTS 600
+#define BENCHMARK_RENDER_MAX_COMMANDS 4096
+#define BENCHMARK_RENDER_PUSH_BUFFER_SIZE (BENCHMARK_RENDER_MAX_COMMANDS * 32)
+
+typedef struct BenchmarkRenderData
+{
+    RenderGroup group;
+
+    GameFrameBuffer frameBuffer;
+
+    // NULL to draw every tile on the calling thread
+    PlatformWorkQueue *queue;
+
+} BenchmarkRenderData;
+
+// Sprites drawn by the sprite benchmarks, per run, over a 1080p frame: the
+// blit benchmark's bitmap at its own size, scaled, and scaled and rotated
+#define BENCHMARK_SPRITE_COUNT 256
+
+typedef struct BenchmarkSpriteData
+{
+    GameFrameBuffer frameBuffer;
+
+    BitmapFile bitmap;
+
+    Vector2 origin[BENCHMARK_SPRITE_COUNT];
+    Vector2 xAxis[BENCHMARK_SPRITE_COUNT];
+    Vector2 yAxis[BENCHMARK_SPRITE_COUNT];
+
+    // NULL to draw with writeBitmap, at the sprite's own size
+    WriteBitmapAffineRow *writeBitmapAffineRow;
+
+} BenchmarkSpriteData;
+
+// Frames scaled up by the upscale benchmarks: the game's 1280x720 frame
+// buffer, filled from half and three quarters of its resolution
+#define BENCHMARK_UPSCALE_WIDTH 1280
+#define BENCHMARK_UPSCALE_HEIGHT 720
+
+typedef struct BenchmarkUpscaleData
+{
+    GameFrameBuffer dest;
+    GameFrameBuffer source;
+
+    UpscaleFilter filter;
+    UpscaleRow *upscaleRow;
+    UpscaleBlendRows *blendRows;
+
+    // One source row
+    uint32 *scratchRow;
+
+} BenchmarkUpscaleData;
+
+//
+// Graphics matrix
+//====================================================
+// Every rasteriser version (scalar, SSE2, AVX2, streaming and the entry point
+// that picks between them) draws each case of a matrix of sizes, starting
+// alignments and clipping (inside, over each edge and fully off screen) into
+// a frame sized buffer of noise. The buffer is hashed (FNV-1a 64) after one
+// draw and checked against a hash checked in to data/test, so a change to a
+// kernel that changes a single pixel fails, even if every version changes the
+// same way. Each version is then timed for a few milliseconds and reported in
+// TSC cycles per pixel of the case's clipped bounds (or per pixel changed, for
+// lines).
+//
+// Results are printed as "<case>_hash <hash>" and, per version,
+// "<case>_<version>_matches_golden 1|0" and
+// "<case>_<version>_cycles_per_pixel <value>" (or "_cycles_per_run" for cases
+// that draw nothing). A new case or kernel isn't in the golden file until
+// it's written again with --write-golden.
+
+#define BENCHMARK_MATRIX_DEFAULT_MS 5
+#define BENCHMARK_MATRIX_WIDTH 1280
+#define BENCHMARK_MATRIX_HEIGHT 720
+#define BENCHMARK_MATRIX_GOLDEN_FILENAME "graphics_golden.txt"
+#define BENCHMARK_MATRIX_MAX_GOLDEN 1024
+
+// Longest case name, and longest case and version name together. Names that
+// don't fit fail the run rather than being cut short.
+#define BENCHMARK_MATRIX_MAX_CASE_NAME 64
+#define BENCHMARK_MATRIX_MAX_NAME 96
+
+typedef enum BenchmarkMatrixKind
+{
+    BENCHMARK_MATRIX_RECTANGLE,
+    BENCHMARK_MATRIX_BITMAP,
+    BENCHMARK_MATRIX_BITMAP_AFFINE,
+    BENCHMARK_MATRIX_LINE,
+    BENCHMARK_MATRIX_LINE_SMOOTH,
+} BenchmarkMatrixKind;
+
+typedef struct BenchmarkMatrixCase
+{
+    GameFrameBuffer *frameBuffer;
+
+    BenchmarkMatrixKind kind;
+
+    // Rectangles and bitmaps, in whole pixels. Bitmaps are drawn at their
+    // own size.
+    int32 x;
+    int32 y;
+    uint32 width;
+    uint32 height;
+    uint32 colour;
+
+    BitmapFile *bitmap;
+
+    // Affine bitmaps
+    Vector2 origin;
+    Vector2 xAxis;
+    Vector2 yAxis;
+
+    // Lines, in subpixels for smooth lines
+    xyint from;
+    xyint to;
+
+    // The version to draw with, for the case's kind. NULL to go through the
+    // entry point (writeRectangle, writeBitmap or writeBitmapAffine).
+    WriteRectangleRows *writeRectangleRows;
+    WriteBitmapRow *writeBitmapRow;
+    WriteBitmapAffineRow *writeBitmapAffineRow;
+
+} BenchmarkMatrixCase;
+
+// One version to run each case of a kind with
+typedef struct BenchmarkMatrixPath
+{
+    const char *name;
+
+    // False if it can't draw the case (E.g. no AVX2, or copying the rows of
+    // a bitmap that isn't opaque)
+    bool32 supported;
+
+    // As BenchmarkMatrixCase
+    WriteRectangleRows *writeRectangleRows;
+    WriteBitmapRow *writeBitmapRow;
+    WriteBitmapAffineRow *writeBitmapAffineRow;
+
+} BenchmarkMatrixPath;
+
+typedef struct BenchmarkGolden
+{
+    uint32 count;
+    char names[BENCHMARK_MATRIX_MAX_GOLDEN][BENCHMARK_MATRIX_MAX_NAME];
+    uint64 hashes[BENCHMARK_MATRIX_MAX_GOLDEN];
+
+} BenchmarkGolden;
+
+internal_func bool32 benchmarkParseOptions(int argc, char **argv, BenchmarkOptions *options);
+
+internal_func bool32 benchmarkSelected(BenchmarkOptions *options, Benchmark *benchmark);
+
+/**
+ * @brief Runs a benchmark for at least minMS and prints its throughput
+ */
+internal_func void benchmarkRun(Benchmark *benchmark, uint32 minMS);
+
+internal_func void *benchmarkAllocate(sizet sizeInBytes);
+
+/**
+ * @brief Runs the graphics matrix. Returns the number of versions that didn't
+ * match their golden hash, or -1 if the matrix couldn't be set up.
+ */
+internal_func int32 benchmarkGraphicsMatrix(BenchmarkOptions *options, bool32 avx2);
+
+#endif
@@ -0,0 +1,853 @@
+// Platform services shared by the Linux platform layer and the headless
+// runner. This file is included directly into each executable's translation
+// unit (after linux_common.h), in the same way global_utility.cpp is.
+
+// Older glibc headers don't define MAP_FIXED_NOREPLACE. Kernels older than
+// 4.17 ignore the flag and treat the address as a hint, which is what we want.
+#ifndef MAP_FIXED_NOREPLACE
+#define MAP_FIXED_NOREPLACE 0x100000
+#endif
+
+internal_func struct timespec linuxGetTime()
+{
+    struct timespec time = { 0 };
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return time;
+}
+
+internal_func float32 linuxGetElapsedTimeMS(const struct timespec start, const struct timespec end)
+{
+    int64 elapsedNS = (((int64)(end.tv_sec - start.tv_sec) * 1000000000LL) + (int64)(end.tv_nsec - start.tv_nsec));
+    return ((float32)elapsedNS / 1000000.0f);
+}
+
+internal_func struct timespec linuxTimespecAddNS(struct timespec time, int64 nanoseconds)
+{
+    int64 totalNS = ((int64)time.tv_nsec + nanoseconds);
+
+    time.tv_sec = (time.tv_sec + (time_t)(totalNS / 1000000000LL));
+    time.tv_nsec = (long)(totalNS % 1000000000LL);
+
+    // Going backwards can leave a negative remainder
+    if (time.tv_nsec < 0) {
+        time.tv_sec -= 1;
+        time.tv_nsec += 1000000000L;
+    }
+
+    return time;
+}
+
+/*
+ * Copies a file by writing to a temporary file and renaming it over the
+ * destination. The rename gives the copy a new inode, so dlopen will never
+ * hand us back a stale, cached mapping of the old library.
+ */
+internal_func bool32 linuxCopyFile(const char *sourceFilename, const char *destinationFilename)
+{
+    char tmpFilename[GAME_MAX_PATH] = { 0 };
+    snprintf(tmpFilename, sizeof(tmpFilename), "%s.tmp", destinationFilename);
+
+    int sourceFD = open(sourceFilename, O_RDONLY);
+
+    if (-1 == sourceFD) {
+        return false;
+    }
+
+    int destinationFD = open(tmpFilename, (O_WRONLY | O_CREAT | O_TRUNC), 0755);
+
+    if (-1 == destinationFD) {
+        close(sourceFD);
+        return false;
+    }
+
+    bool32 res = true;
+    char buffer[64 * 1024];
+
+    for (;;) {
+        ssize_t bytesRead = read(sourceFD, buffer, sizeof(buffer));
+
+        if (bytesRead == 0) {
+            break;
+        }
+
+        if ((bytesRead < 0) || (write(destinationFD, buffer, (size_t)bytesRead) != bytesRead)) {
+            res = false;
+            break;
+        }
+    }
+
+    close(sourceFD);
+    close(destinationFD);
+
+    if (res) {
+        res = (0 == rename(tmpFilename, destinationFilename));
+    }
+
+    if (!res) {
+        unlink(tmpFilename);
+    }
+
+    return res;
+}
+
+internal_func void linuxGetAbsolutePath(char *path)
+{
+    // Get the path for the running executable
+    char modulePath[GAME_MAX_PATH] = { 0 };
+    ssize_t length = readlink("/proc/self/exe", modulePath, (sizeof(modulePath) - 1));
+
+    if (length <= 0) {
+        path[0] = '\0';
+        return;
+    }
+
+    // Copy the contents of the module path up to (and including) the last slash
+    ssize_t lastSlash = -1;
+    for (ssize_t i = 0; i < length; i++) {
+        if (modulePath[i] == '/') {
+            lastSlash = i;
+        }
+    }
+
+    for (ssize_t i = 0; i <= lastSlash; i++) {
+        path[i] = modulePath[i];
+    }
+
+    path[lastSlash + 1] = '\0';
+}
+
+/**
+ * Allocates memory directly from the kernel with mmap. Unlike VirtualFree,
+ * munmap needs to know the size of the mapping, so every allocation is
+ * prefixed with one page that records the size of the whole mapping. If a
+ * start address is requested we place that header page directly below it so
+ * the caller still gets the exact address they asked for.
+ */
+PLATFORM_ALLOCATE_MEMORY(platformAllocateMemory)
+{
+    sizet pageSize = (sizet)sysconf(_SC_PAGESIZE);
+    sizet mappingSizeInBytes = ((sizet)memorySizeInBytes + pageSize);
+
+    void *mapping = MAP_FAILED;
+
+    if (memoryStartAddress) {
+        mapping = mmap((void *)(memoryStartAddress - pageSize),
+                        mappingSizeInBytes,
+                        (PROT_READ | PROT_WRITE),
+                        (MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE),
+                        -1,
+                        0);
+    }
+
+    // No address requested, or it's already taken. Let the kernel choose.
+    if (MAP_FAILED == mapping) {
+        mapping = mmap(NULL,
+                        mappingSizeInBytes,
+                        (PROT_READ | PROT_WRITE),
+                        (MAP_PRIVATE | MAP_ANONYMOUS),
+                        -1,
+                        0);
+    }
+
+    if (MAP_FAILED == mapping) {
+        return NULL;
+    }
+
+    *(sizet *)mapping = mappingSizeInBytes;
+
+    return ((uint8 *)mapping + pageSize);
+}
+
+PLATFORM_FREE_MEMORY(platformFreeMemory)
+{
+    if (!address) {
+        return;
+    }
+
+    sizet pageSize = (sizet)sysconf(_SC_PAGESIZE);
+    uint8 *mapping = ((uint8 *)address - pageSize);
+
+    munmap(mapping, *(sizet *)mapping);
+}
+
+//===========================================
+// Reserved memory
+//===========================================
+
+// The reservation that the game's memory regions live within. Used to look up
+// the chunk states when the game asks for memory to be committed.
+global_var LinuxMemoryReservation *linuxGameMemoryReservation = NULL;
+
+// The reservation whose writes are being tracked, for the SIGSEGV handler
+global_var LinuxMemoryReservation *linuxWriteTrackedReservation = NULL;
+
+internal_func void *linuxReserveMemory(PlatformThreadContext *thread,
+                                        LinuxMemoryReservation *reservation,
+                                        uint64 startAddress,
+                                        sizet sizeInBytes)
+{
+    sizet chunkCount = ((sizeInBytes + (LINUX_MEMORY_COMMIT_CHUNK_SIZE - 1)) / LINUX_MEMORY_COMMIT_CHUNK_SIZE);
+    sizet reservedSizeInBytes = (chunkCount * LINUX_MEMORY_COMMIT_CHUNK_SIZE);
+
+    void *mapping = MAP_FAILED;
+
+    if (startAddress && (0 == (startAddress % LINUX_MEMORY_COMMIT_CHUNK_SIZE))) {
+        mapping = mmap((void *)startAddress,
+                        reservedSizeInBytes,
+                        PROT_NONE,
+                        (MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE | MAP_FIXED_NOREPLACE),
+                        -1,
+                        0);
+    }
+
+    uint8 *base = NULL;
+
+    if (MAP_FAILED != mapping) {
+
+        base = (uint8 *)mapping;
+
+    } else {
+
+        // No address requested, or it's already taken. Let the kernel choose,
+        // but over-reserve so the base can be aligned to a chunk boundary.
+        mapping = mmap(NULL,
+                        (reservedSizeInBytes + LINUX_MEMORY_COMMIT_CHUNK_SIZE),
+                        PROT_NONE,
+                        (MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE),
+                        -1,
+                        0);
+
+        if (MAP_FAILED == mapping) {
+            return NULL;
+        }
+
+        uint64 alignedAddress = ((((uint64)mapping) + (LINUX_MEMORY_COMMIT_CHUNK_SIZE - 1)) & ~((uint64)LINUX_MEMORY_COMMIT_CHUNK_SIZE - 1));
+        base = (uint8 *)alignedAddress;
+    }
+
+    reservation->base = base;
+    reservation->sizeInBytes = reservedSizeInBytes;
+    reservation->chunkCount = chunkCount;
+    reservation->committedSizeInBytes = 0;
+    reservation->hugePageSizeInBytes = 0;
+    reservation->chunkStates = (uint8 *)platformAllocateMemory(thread, 0, chunkCount);
+
+    if (!reservation->chunkStates) {
+        return NULL;
+    }
+
+    // Only touched if the reservation's writes are tracked
+    reservation->pageSize = (sizet)sysconf(_SC_PAGESIZE);
+    reservation->pageCount = (reservedSizeInBytes / reservation->pageSize);
+    reservation->dirtyPages = (uint8 *)platformAllocateMemory(thread, 0, reservation->pageCount);
+    reservation->trackingWrites = false;
+
+    if (!reservation->dirtyPages) {
+        return NULL;
+    }
+
+#if !defined(HANDMADE_COMMIT_MEMORY_ON_DEMAND)
+    if (!linuxCommitMemory(reservation, base, reservedSizeInBytes, false)) {
+        return NULL;
+    }
+#endif
+
+    return base;
+}
+
+internal_func bool32 linuxCommitMemory(LinuxMemoryReservation *reservation,
+                                        void *address,
+                                        sizet sizeInBytes,
+                                        bool32 largePages)
+{
+    if (0 == sizeInBytes) {
+        return true;
+    }
+
+    sizet startOffset = (sizet)((uint8 *)address - reservation->base);
+    sizet endOffset = (startOffset + sizeInBytes);
+
+    if ((uint8 *)address < reservation->base || endOffset > reservation->sizeInBytes) {
+        return false;
+    }
+
+    sizet firstChunk = (startOffset / LINUX_MEMORY_COMMIT_CHUNK_SIZE);
+    sizet lastChunk = ((endOffset - 1) / LINUX_MEMORY_COMMIT_CHUNK_SIZE);
+
+    for (sizet chunk = firstChunk; chunk <= lastChunk; chunk++) {
+
+        if (LINUX_MEMORY_CHUNK_RESERVED != reservation->chunkStates[chunk]) {
+            continue;
+        }
+
+        uint8 *chunkAddress = (reservation->base + (chunk * LINUX_MEMORY_COMMIT_CHUNK_SIZE));
+
+        // Freshly committed pages are zero, same as they'd be in a snapshot
+        // taken before they were committed. Only track them once written to.
+        int protection = (reservation->trackingWrites ? PROT_READ : (PROT_READ | PROT_WRITE));
+
+#if defined(HANDMADE_LARGE_PAGES)
+        if (largePages) {
+
+            // Replace the reserved chunk with an explicit huge page. This only
+            // succeeds if the system has huge pages set aside
+            // (/proc/sys/vm/nr_hugepages).
+            void *hugePage = mmap(chunkAddress,
+                                    LINUX_MEMORY_COMMIT_CHUNK_SIZE,
+                                    protection,
+                                    (MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED | MAP_HUGETLB),
+                                    -1,
+                                    0);
+
+            if (MAP_FAILED != hugePage) {
+                reservation->chunkStates[chunk] = LINUX_MEMORY_CHUNK_HUGE_PAGE;
+                reservation->committedSizeInBytes += LINUX_MEMORY_COMMIT_CHUNK_SIZE;
+                reservation->hugePageSizeInBytes += LINUX_MEMORY_COMMIT_CHUNK_SIZE;
+                continue;
+            }
+
+            // A failed MAP_FIXED can leave a hole where the reserved chunk was,
+            // so map the chunk again rather than mprotect it. Then ask for
+            // transparent huge pages instead.
+            void *regularPages = mmap(chunkAddress,
+                                        LINUX_MEMORY_COMMIT_CHUNK_SIZE,
+                                        protection,
+                                        (MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE | MAP_FIXED),
+                                        -1,
+                                        0);
+
+            if (MAP_FAILED == regularPages) {
+                return false;
+            }
+
+            madvise(chunkAddress, LINUX_MEMORY_COMMIT_CHUNK_SIZE, MADV_HUGEPAGE);
+
+            reservation->chunkStates[chunk] = LINUX_MEMORY_CHUNK_COMMITTED;
+            reservation->committedSizeInBytes += LINUX_MEMORY_COMMIT_CHUNK_SIZE;
+            continue;
+        }
+#endif
+
+        if (-1 == mprotect(chunkAddress, LINUX_MEMORY_COMMIT_CHUNK_SIZE, protection)) {
+            return false;
+        }
+
+        reservation->chunkStates[chunk] = LINUX_MEMORY_CHUNK_COMMITTED;
+        reservation->committedSizeInBytes += LINUX_MEMORY_COMMIT_CHUNK_SIZE;
+    }
+
+    return true;
+}
+
+internal_func void linuxCopyCommittedMemory(LinuxMemoryReservation *destination, LinuxMemoryReservation *source)
+{
+    assert(destination->sizeInBytes == source->sizeInBytes);
+
+    for (sizet chunk = 0; chunk < source->chunkCount; chunk++) {
+
+        if (LINUX_MEMORY_CHUNK_RESERVED == source->chunkStates[chunk]) {
+            continue;
+        }
+
+        sizet offset = (chunk * LINUX_MEMORY_COMMIT_CHUNK_SIZE);
+
+        if (!linuxCommitMemory(destination, (destination->base + offset), LINUX_MEMORY_COMMIT_CHUNK_SIZE, false)) {
+            assert(!"Could not commit memory to copy into");
+            return;
+        }
+
+        memcpy((destination->base + offset), (source->base + offset), LINUX_MEMORY_COMMIT_CHUNK_SIZE);
+    }
+}
+
+/*
+ * Marks the faulting page as dirty and makes it writable so the write can
+ * carry on. Faults outside of the tracked reservation's committed chunks fall
+ * through to the default handler.
+ */
+internal_func void linuxWriteTrackingSignalHandler(int signalNumber, siginfo_t *info, void *context)
+{
+    LinuxMemoryReservation *reservation = linuxWriteTrackedReservation;
+    uint8 *address = (uint8 *)info->si_addr;
+
+    if (reservation
+            && reservation->trackingWrites
+            && (address >= reservation->base)
+            && (address < (reservation->base + reservation->sizeInBytes))) {
+
+        sizet offset = (sizet)(address - reservation->base);
+        sizet chunk = (offset / LINUX_MEMORY_COMMIT_CHUNK_SIZE);
+
+        if (LINUX_MEMORY_CHUNK_HUGE_PAGE == reservation->chunkStates[chunk]) {
+
+            // Explicit huge pages can only be protected as a whole
+            uint8 *chunkAddress = (reservation->base + (chunk * LINUX_MEMORY_COMMIT_CHUNK_SIZE));
+            sizet pagesPerChunk = (LINUX_MEMORY_COMMIT_CHUNK_SIZE / reservation->pageSize);
+
+            if (0 == mprotect(chunkAddress, LINUX_MEMORY_COMMIT_CHUNK_SIZE, (PROT_READ | PROT_WRITE))) {
+                memset((reservation->dirtyPages + (chunk * pagesPerChunk)), 1, pagesPerChunk);
+                return;
+            }
+
+        } else if (LINUX_MEMORY_CHUNK_COMMITTED == reservation->chunkStates[chunk]) {
+
+            sizet page = (offset / reservation->pageSize);
+
+            if (0 == mprotect((reservation->base + (page * reservation->pageSize)), reservation->pageSize, (PROT_READ | PROT_WRITE))) {
+                reservation->dirtyPages[page] = 1;
+                return;
+            }
+        }
+    }
+
+    // A genuine fault. Returning re-runs the faulting instruction, which now
+    // hits the default handler.
+    signal(SIGSEGV, SIG_DFL);
+}
+
+internal_func void linuxBeginWriteTracking(LinuxMemoryReservation *reservation)
+{
+    assert(!linuxWriteTrackedReservation || (linuxWriteTrackedReservation == reservation));
+
+    if (!linuxWriteTrackedReservation) {
+        struct sigaction action = {0};
+        action.sa_sigaction = &linuxWriteTrackingSignalHandler;
+        action.sa_flags = SA_SIGINFO;
+        sigemptyset(&action.sa_mask);
+
+        if (-1 == sigaction(SIGSEGV, &action, NULL)) {
+            assert(!"Could not install the write tracking signal handler");
+            return;
+        }
+
+        linuxWriteTrackedReservation = reservation;
+    }
+
+    memset(reservation->dirtyPages, 0, reservation->pageCount);
+
+    for (sizet chunk = 0; chunk < reservation->chunkCount; chunk++) {
+        if (LINUX_MEMORY_CHUNK_RESERVED != reservation->chunkStates[chunk]) {
+            mprotect((reservation->base + (chunk * LINUX_MEMORY_COMMIT_CHUNK_SIZE)), LINUX_MEMORY_COMMIT_CHUNK_SIZE, PROT_READ);
+        }
+    }
+
+    reservation->trackingWrites = true;
+}
+
+internal_func sizet linuxRestoreDirtyMemory(LinuxMemoryReservation *reservation, LinuxMemoryReservation *snapshot)
+{
+    assert(reservation->sizeInBytes == snapshot->sizeInBytes);
+    assert(reservation->trackingWrites);
+
+    sizet pageSize = reservation->pageSize;
+    sizet pagesPerChunk = (LINUX_MEMORY_COMMIT_CHUNK_SIZE / pageSize);
+    sizet restoredSizeInBytes = 0;
+
+    sizet page = 0;
+
+    while (page < reservation->pageCount) {
+
+        if (!reservation->dirtyPages[page]) {
+            page++;
+            continue;
+        }
+
+        // Restore a run of dirty pages at a time so that they can be
+        // write-protected again with a single call
+        sizet firstPage = page;
+
+        while ((page < reservation->pageCount) && reservation->dirtyPages[page]) {
+
+            sizet offset = (page * pageSize);
+
+            if (LINUX_MEMORY_CHUNK_RESERVED == snapshot->chunkStates[page / pagesPerChunk]) {
+                memset((reservation->base + offset), 0, pageSize);
+            } else {
+                memcpy((reservation->base + offset), (snapshot->base + offset), pageSize);
+            }
+
+            reservation->dirtyPages[page] = 0;
+            page++;
+        }
+
+        sizet runSizeInBytes = ((page - firstPage) * pageSize);
+
+        mprotect((reservation->base + (firstPage * pageSize)), runSizeInBytes, PROT_READ);
+
+        restoredSizeInBytes += runSizeInBytes;
+    }
+
+    return restoredSizeInBytes;
+}
+
+internal_func sizet linuxGetResidentMemorySize(LinuxMemoryReservation *reservation)
+{
+    sizet pageSize = (sizet)sysconf(_SC_PAGESIZE);
+    sizet pagesPerChunk = (LINUX_MEMORY_COMMIT_CHUNK_SIZE / pageSize);
+
+    // One byte per page. 512 for 4KiB pages.
+    unsigned char pageStates[LINUX_MEMORY_COMMIT_CHUNK_SIZE / 4096];
+
+    if (pagesPerChunk > sizeof(pageStates)) {
+        pagesPerChunk = sizeof(pageStates);
+    }
+
+    sizet residentSizeInBytes = 0;
+
+    for (sizet chunk = 0; chunk < reservation->chunkCount; chunk++) {
+
+        // Explicit huge pages are allocated when they're mapped
+        if (LINUX_MEMORY_CHUNK_HUGE_PAGE == reservation->chunkStates[chunk]) {
+            residentSizeInBytes += LINUX_MEMORY_COMMIT_CHUNK_SIZE;
+            continue;
+        }
+
+        if (LINUX_MEMORY_CHUNK_COMMITTED != reservation->chunkStates[chunk]) {
+            continue;
+        }
+
+        uint8 *chunkAddress = (reservation->base + (chunk * LINUX_MEMORY_COMMIT_CHUNK_SIZE));
+
+        if (0 != mincore(chunkAddress, LINUX_MEMORY_COMMIT_CHUNK_SIZE, pageStates)) {
+            continue;
+        }
+
+        for (sizet page = 0; page < pagesPerChunk; page++) {
+            if (pageStates[page] & 1) {
+                residentSizeInBytes += pageSize;
+            }
+        }
+    }
+
+    return residentSizeInBytes;
+}
+
+PLATFORM_COMMIT_MEMORY(platformCommitMemory)
+{
+    if (!linuxGameMemoryReservation) {
+        return false;
+    }
+
+    return linuxCommitMemory(linuxGameMemoryReservation, address, sizeInBytes, largePages);
+}
+
+//
+// Input recording
+//====================================================
+
+/*
+ * Hands the block being filled to the writer thread. Waits if the writer
+ * thread has fallen so far behind that there's no free block to fill next.
+ */
+internal_func void linuxSubmitInputRecorderBlock(LinuxInputRecorder *recorder)
+{
+    recorder->framesSinceSubmit = 0;
+
+    if (0 == recorder->currentBlockSize) {
+        return;
+    }
+
+    pthread_mutex_lock(&recorder->mutex);
+
+    recorder->blockSizes[recorder->blocksSubmitted % LINUX_INPUT_RECORDER_BLOCK_COUNT] = recorder->currentBlockSize;
+    recorder->blocksSubmitted++;
+
+    pthread_cond_broadcast(&recorder->condition);
+
+    while ((recorder->blocksSubmitted - recorder->blocksWritten) >= LINUX_INPUT_RECORDER_BLOCK_COUNT) {
+        pthread_cond_wait(&recorder->condition, &recorder->mutex);
+    }
+
+    pthread_mutex_unlock(&recorder->mutex);
+
+    recorder->currentBlockSize = 0;
+}
+
+internal_func uint8 *linuxInputRecorderCurrentBlock(LinuxInputRecorder *recorder)
+{
+    uint32 blockIndex = (recorder->blocksSubmitted % LINUX_INPUT_RECORDER_BLOCK_COUNT);
+    return (recorder->blocks + (blockIndex * LINUX_INPUT_RECORDER_BLOCK_SIZE) + recorder->currentBlockSize);
+}
+
+internal_func bool32 linuxStartInputRecorder(PlatformThreadContext *thread, LinuxInputRecorder *recorder, const char *filename)
+{
+    *recorder = {0};
+
+    recorder->blocks = (uint8 *)platformAllocateMemory(thread, 0, (LINUX_INPUT_RECORDER_BLOCK_SIZE * LINUX_INPUT_RECORDER_BLOCK_COUNT));
+
+    if (!recorder->blocks) {
+        return false;
+    }
+
+    recorder->fileHandle = open(filename, (O_WRONLY | O_CREAT | O_TRUNC), 0644);
+
+    if (-1 == recorder->fileHandle) {
+        fprintf(stderr, "Cannot open %s for writing\n", filename);
+        platformFreeMemory(thread, recorder->blocks);
+        return false;
+    }
+
+    pthread_mutex_init(&recorder->mutex, NULL);
+    pthread_cond_init(&recorder->condition, NULL);
+
+    if (0 != pthread_create(&recorder->thread, NULL, linuxInputRecorderThread, recorder)) {
+        close(recorder->fileHandle);
+        platformFreeMemory(thread, recorder->blocks);
+        return false;
+    }
+
+    recorder->currentBlockSize += inputRecordingWriteHeader(&recorder->encoder, linuxInputRecorderCurrentBlock(recorder));
+
+    return true;
+}
+
+internal_func void linuxRecordInputFrame(LinuxInputRecorder *recorder, GameInput *input)
+{
+    inputRecordingQuantise(input);
+
+    // Room for a repeat record and a frame record
+    if ((recorder->currentBlockSize + (INPUT_RECORDING_MAX_RECORD_BYTES * 2)) > LINUX_INPUT_RECORDER_BLOCK_SIZE) {
+        linuxSubmitInputRecorderBlock(recorder);
+    }
+
+    recorder->currentBlockSize += inputRecordingEncodeFrame(&recorder->encoder, input, linuxInputRecorderCurrentBlock(recorder));
+
+    recorder->framesSinceSubmit++;
+
+    if (recorder->framesSinceSubmit >= LINUX_INPUT_RECORDER_SUBMIT_FRAMES) {
+        linuxSubmitInputRecorderBlock(recorder);
+    }
+}
+
+internal_func bool32 linuxStopInputRecorder(PlatformThreadContext *thread, LinuxInputRecorder *recorder)
+{
+    if ((recorder->currentBlockSize + INPUT_RECORDING_MAX_RECORD_BYTES) > LINUX_INPUT_RECORDER_BLOCK_SIZE) {
+        linuxSubmitInputRecorderBlock(recorder);
+    }
+
+    recorder->currentBlockSize += inputRecordingEncodeFlush(&recorder->encoder, linuxInputRecorderCurrentBlock(recorder));
+
+    linuxSubmitInputRecorderBlock(recorder);
+
+    pthread_mutex_lock(&recorder->mutex);
+    recorder->stopping = true;
+    pthread_cond_broadcast(&recorder->condition);
+    pthread_mutex_unlock(&recorder->mutex);
+
+    pthread_join(recorder->thread, NULL);
+
+    pthread_mutex_destroy(&recorder->mutex);
+    pthread_cond_destroy(&recorder->condition);
+
+    close(recorder->fileHandle);
+    recorder->fileHandle = -1;
+
+    platformFreeMemory(thread, recorder->blocks);
+    recorder->blocks = NULL;
+
+    return !recorder->writeFailed;
+}
+
+internal_func void *linuxInputRecorderThread(void *param)
+{
+    LinuxInputRecorder *recorder = (LinuxInputRecorder *)param;
+
+    pthread_mutex_lock(&recorder->mutex);
+
+    for (;;) {
+
+        while ((recorder->blocksWritten == recorder->blocksSubmitted) && !recorder->stopping) {
+            pthread_cond_wait(&recorder->condition, &recorder->mutex);
+        }
+
+        if (recorder->blocksWritten == recorder->blocksSubmitted) {
+            // Stopping and everything has been written
+            break;
+        }
+
+        uint32 blockIndex = (recorder->blocksWritten % LINUX_INPUT_RECORDER_BLOCK_COUNT);
+        uint8 *block = (recorder->blocks + (blockIndex * LINUX_INPUT_RECORDER_BLOCK_SIZE));
+        sizet blockSize = recorder->blockSizes[blockIndex];
+
+        // The main thread doesn't touch a submitted block until it's been
+        // written, so write it without holding the lock
+        pthread_mutex_unlock(&recorder->mutex);
+
+        sizet bytesWritten = 0;
+
+        while (bytesWritten < blockSize) {
+
+            ssize_t res = write(recorder->fileHandle, (block + bytesWritten), (blockSize - bytesWritten));
+
+            if (res <= 0) {
+                recorder->writeFailed = true;
+                break;
+            }
+
+            bytesWritten += (sizet)res;
+        }
+
+        pthread_mutex_lock(&recorder->mutex);
+
+        recorder->blocksWritten++;
+        pthread_cond_broadcast(&recorder->condition);
+    }
+
+    pthread_mutex_unlock(&recorder->mutex);
+
+    return NULL;
+}
+
+internal_func bool32 linuxOpenInputPlayback(LinuxInputPlayback *playback, const char *filename)
+{
+    *playback = {0};
+
+    int fd = open(filename, O_RDONLY);
+
+    if (-1 == fd) {
+        fprintf(stderr, "Cannot read file %s\n", filename);
+        return false;
+    }
+
+    struct stat fileStat;
+
+    if ((-1 == fstat(fd, &fileStat)) || (0 == fileStat.st_size)) {
+        close(fd);
+        return false;
+    }
+
+    void *mapping = mmap(NULL, (sizet)fileStat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+    // The mapping keeps the file alive
+    close(fd);
+
+    if (MAP_FAILED == mapping) {
+        return false;
+    }
+
+    playback->mapping = (uint8 *)mapping;
+    playback->sizeInBytes = (sizet)fileStat.st_size;
+
+    if (!inputRecordingDecoderInit(&playback->decoder, playback->mapping, playback->sizeInBytes)) {
+        fprintf(stderr, "%s isn't an input recording made with this build\n", filename);
+        linuxCloseInputPlayback(playback);
+        return false;
+    }
+
+    return true;
+}
+
+internal_func void linuxCloseInputPlayback(LinuxInputPlayback *playback)
+{
+    if (playback->mapping) {
+        munmap(playback->mapping, playback->sizeInBytes);
+    }
+
+    *playback = {0};
+}
+
+#if HANDMADE_LOCAL_BUILD
+
+DEBUG_PLATFORM_READ_ENTIRE_FILE(DEBUG_platformReadEntireFile)
+{
+    char fullFilename[GAME_MAX_PATH] = {0};
+
+    // Concatenate the absolute path and filename
+    int length = snprintf(fullFilename, sizeof(fullFilename), "%s%s", absPath, filename);
+
+    if ((length < 0) || (length >= (int)sizeof(fullFilename))) {
+        assert(!"Error concatenating file paths")
+    }
+
+    // The game layer uses Windows path separators
+    for (int i = 0; fullFilename[i] != '\0'; i++) {
+        if (fullFilename[i] == '\\') {
+            fullFilename[i] = '/';
+        }
+    }
+
+    DEBUG_file file = { 0 };
+
+    // Open the file for reading.
+    int fd = open(fullFilename, O_RDONLY);
+
+    if (-1 == fd) {
+        fprintf(stderr, "Cannot read file %s\n", fullFilename);
+        return file;
+    }
+
+    // Get the size of the file in bytes.
+    struct stat fileStat = { 0 };
+
+    if (-1 == fstat(fd, &fileStat)) {
+        fprintf(stderr, "Cannot get file size\n");
+        close(fd);
+        return file;
+    }
+
+    // We can only read files up to 4GB, to match DEBUG_file's sizeinBytes
+    assert((uint64)fileStat.st_size <= 0xffffffff);
+    uint32 sizeInBytes32 = (uint32)fileStat.st_size;
+
+    // Allocate enough memory for the file.
+    file.memory = platformAllocateMemory(thread, 0, sizeInBytes32);
+
+    if (NULL == file.memory) {
+        fprintf(stderr, "Cannot allocate memory for file\n");
+        close(fd);
+        return file;
+    }
+
+    // Read the file into the memory.
+    uint32 bytesRead = 0;
+    while (bytesRead < sizeInBytes32) {
+        ssize_t res = read(fd, ((uint8 *)file.memory + bytesRead), (sizeInBytes32 - bytesRead));
+        if (res <= 0) {
+            fprintf(stderr, "Cannot read file into memory\n");
+            break;
+        }
+        bytesRead += (uint32)res;
+    }
+
+    file.sizeinBytes = bytesRead;
+
+    close(fd);
+
+    return file;
+}
+
+DEBUG_PLATFORM_FREE_FILE_MEMORY(DEBUG_platformFreeFileMemory)
+{
+    platformFreeMemory(thread, file->memory);
+    file->memory = 0;
+    file->sizeinBytes = 0;
+}
+
+DEBUG_PLATFORM_WRITE_ENTIRE_FILE(DEBUG_platformWriteEntireFile)
+{
+    // Open the file for writing.
+    int fd = open(filename, (O_WRONLY | O_CREAT | O_TRUNC), 0644);
+
+    if (-1 == fd) {
+        fprintf(stderr, "Cannot open file for writing\n");
+        return false;
+    }
+
+    // Write the memory into the file.
+    uint32 bytesWritten = 0;
+    while (bytesWritten < memorySizeInBytes) {
+        ssize_t res = write(fd, ((uint8 *)memory + bytesWritten), (memorySizeInBytes - bytesWritten));
+        if (res <= 0) {
+            fprintf(stderr, "Could not write file to location\n");
+            close(fd);
+            return false;
+        }
+        bytesWritten += (uint32)res;
+    }
+
+    close(fd);
+
+    return true;
+}
+
+#endif
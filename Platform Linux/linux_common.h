@@ -0,0 +1,194 @@
+#ifndef HEADER_LINUX_COMMON
+#define HEADER_LINUX_COMMON
+
+/*
+ * Creates and returns the current time via CLOCK_MONOTONIC
+ */
+internal_func struct timespec linuxGetTime();
+
+/*
+ * Calculates the time elapsed (milliseconds) between time a (start) and time b (end)
+ */
+internal_func float32 linuxGetElapsedTimeMS(const struct timespec start, const struct timespec end);
+
+/*
+ * Advances a timespec by a number of nanoseconds, carrying into the seconds
+ */
+internal_func struct timespec linuxTimespecAddNS(struct timespec time, int64 nanoseconds);
+
+internal_func void linuxGetAbsolutePath(char *path);
+
+internal_func bool32 linuxCopyFile(const char *sourceFilename, const char *destinationFilename);
+
+// Reserved memory is committed in chunks of this size. 2MiB so that a chunk
+// can be backed by a single huge page.
+#define LINUX_MEMORY_COMMIT_CHUNK_SIZE (2 * 1024 * 1024)
+
+// LinuxMemoryReservation.chunkStates values
+#define LINUX_MEMORY_CHUNK_RESERVED     0x0
+#define LINUX_MEMORY_CHUNK_COMMITTED    0x1
+#define LINUX_MEMORY_CHUNK_HUGE_PAGE    0x2
+
+/**
+ * An address range that's reserved up front and committed a chunk at a time.
+ * Reserved memory costs address space only. Pages are readable and writable
+ * once their chunk has been committed.
+ */
+typedef struct LinuxMemoryReservation
+{
+    uint8 *base;
+    sizet sizeInBytes;
+
+    // The state of each chunk within the range. One byte per chunk.
+    uint8 *chunkStates;
+    sizet chunkCount;
+
+    sizet committedSizeInBytes;
+    sizet hugePageSizeInBytes;
+
+    // Write tracking for snapshots. Whilst tracking, committed pages are
+    // read-only and the first write to each page faults, marks it as dirty
+    // and makes it writable again. One byte per page.
+    uint8 *dirtyPages;
+    sizet pageSize;
+    sizet pageCount;
+    volatile bool32 trackingWrites;
+} LinuxMemoryReservation;
+
+/*
+ * Reserves an address range, starting at startAddress if it's available.
+ * Unless HANDMADE_COMMIT_MEMORY_ON_DEMAND is defined the whole range is
+ * committed straight away.
+ */
+internal_func void *linuxReserveMemory(PlatformThreadContext *thread,
+                                        LinuxMemoryReservation *reservation,
+                                        uint64 startAddress,
+                                        sizet sizeInBytes);
+
+/*
+ * Commits every chunk that overlaps the given range. If largePages is set,
+ * chunks are backed with explicit huge pages (MAP_HUGETLB), falling back to
+ * transparent huge pages if none are available.
+ */
+internal_func bool32 linuxCommitMemory(LinuxMemoryReservation *reservation,
+                                        void *address,
+                                        sizet sizeInBytes,
+                                        bool32 largePages);
+
+/*
+ * Copies every committed chunk of source into the same offset of destination,
+ * committing it in destination if need be. Both must be the same size.
+ */
+internal_func void linuxCopyCommittedMemory(LinuxMemoryReservation *destination, LinuxMemoryReservation *source);
+
+/*
+ * Write-protects every committed page of the reservation and starts marking
+ * pages as dirty when they're written to. Chunks committed whilst tracking are
+ * write-protected too. Only one reservation can be tracked at a time.
+ */
+internal_func void linuxBeginWriteTracking(LinuxMemoryReservation *reservation);
+
+/*
+ * Puts every page written to since tracking began (or since the last restore)
+ * back to how it is in snapshot, then write-protects the pages again. Pages
+ * whose chunk isn't committed in snapshot are zeroed, as they were before
+ * being committed. Returns the number of bytes restored.
+ */
+internal_func sizet linuxRestoreDirtyMemory(LinuxMemoryReservation *reservation, LinuxMemoryReservation *snapshot);
+
+/*
+ * How many bytes of a reservation are actually in physical memory
+ */
+internal_func sizet linuxGetResidentMemorySize(LinuxMemoryReservation *reservation);
+
+// Encoded input is handed to the recorder's writer thread in blocks
+#define LINUX_INPUT_RECORDER_BLOCK_SIZE     (64 * 1024)
+#define LINUX_INPUT_RECORDER_BLOCK_COUNT    8
+
+// Hand over a partly filled block at least this often (in frames) so that
+// little is lost if the process dies
+#define LINUX_INPUT_RECORDER_SUBMIT_FRAMES  300
+
+/**
+ * Streams a compressed input recording (see input_recording.h) to a file.
+ * The main thread only encodes. A writer thread does the file I/O.
+ */
+typedef struct LinuxInputRecorder
+{
+    int fileHandle;
+
+    InputRecordingEncoder encoder;
+
+    // LINUX_INPUT_RECORDER_BLOCK_COUNT blocks. The main thread fills them in
+    // turn and the writer thread writes them out in the same order.
+    uint8 *blocks;
+    sizet blockSizes[LINUX_INPUT_RECORDER_BLOCK_COUNT];
+
+    // How many blocks have been handed to and written by the writer thread.
+    // Only ever go up. Guarded by mutex.
+    uint32 blocksSubmitted;
+    uint32 blocksWritten;
+
+    // Bytes in the block being filled (blocksSubmitted % BLOCK_COUNT)
+    sizet currentBlockSize;
+    uint32 framesSinceSubmit;
+
+    pthread_t thread;
+    pthread_mutex_t mutex;
+    pthread_cond_t condition;
+    bool32 stopping;
+    bool32 writeFailed;
+} LinuxInputRecorder;
+
+/**
+ * A recording mapped into memory for playback
+ */
+typedef struct LinuxInputPlayback
+{
+    uint8 *mapping;
+    sizet sizeInBytes;
+    InputRecordingDecoder decoder;
+} LinuxInputPlayback;
+
+/*
+ * Creates the file and starts the writer thread
+ */
+internal_func bool32 linuxStartInputRecorder(PlatformThreadContext *thread, LinuxInputRecorder *recorder, const char *filename);
+
+/*
+ * Quantises the input in place (so the game sees exactly what playback will
+ * give it) and appends it to the recording
+ */
+internal_func void linuxRecordInputFrame(LinuxInputRecorder *recorder, GameInput *input);
+
+/*
+ * Writes out everything still buffered, stops the writer thread and closes
+ * the file. Returns false if any of the recording couldn't be written.
+ */
+internal_func bool32 linuxStopInputRecorder(PlatformThreadContext *thread, LinuxInputRecorder *recorder);
+
+internal_func void *linuxInputRecorderThread(void *param);
+
+/*
+ * Maps a recording into memory and checks its header
+ */
+internal_func bool32 linuxOpenInputPlayback(LinuxInputPlayback *playback, const char *filename);
+
+internal_func void linuxCloseInputPlayback(LinuxInputPlayback *playback);
+
+//===========================================
+// Game-required platform layer signatures
+//===========================================
+PLATFORM_ALLOCATE_MEMORY(platformAllocateMemory);
+PLATFORM_FREE_MEMORY(platformFreeMemory);
+PLATFORM_COMMIT_MEMORY(platformCommitMemory);
+
+#if HANDMADE_LOCAL_BUILD
+
+DEBUG_PLATFORM_READ_ENTIRE_FILE(DEBUG_platformReadEntireFile);
+DEBUG_PLATFORM_FREE_FILE_MEMORY(DEBUG_platformFreeFileMemory);
+DEBUG_PLATFORM_WRITE_ENTIRE_FILE(DEBUG_platformWriteEntireFile);
+
+#endif
+
+#endif
@@ -0,0 +1,1500 @@
+// POSIX/Linux APIs
+#include <dlfcn.h>      // dlopen, dlsym, dlclose for loading the game code
+#include <errno.h>      // EINTR
+#include <fcntl.h>      // open
+#include <signal.h>     // sigaction for tracking writes to game memory
+#include <pthread.h>    // Game code reload and worker threads
+#include <sched.h>      // sched_yield
+#include <semaphore.h>  // Waking the presenter, audio and worker threads
+#include <stdarg.h>     // va_list
+#include <stdio.h>      // fprintf, vsnprintf
+#include <stdlib.h>     // getenv
+#include <string.h>     // memcpy, strncpy, strncat
+#include <sys/inotify.h> // Watching for rebuilds of the game code
+#include <sys/mman.h>   // mmap, munmap
+#include <sys/stat.h>   // stat, fstat
+#include <time.h>       // clock_gettime, clock_nanosleep
+#include <unistd.h>     // read, write, readlink, sysconf
+
+// X11 for the window, input and presenting the frame buffer
+#include <X11/Xlib.h>
+#include <X11/Xutil.h>
+#include <X11/XKBlib.h>
+#include <X11/keysym.h>
+
+#include "../Game/global.h" // Game layer specific function signatures
+#include "../Game/input_recording.h" // Compressed input recordings
+#include "../Game/audio_ring_buffer.h" // Hands audio to the audio thread
+#include "../Game/work_queue.h" // Shares work out over the worker threads
+#include "linux_common.h" // Platform services shared with the headless runner
+#include "linux_audio.h" // Audio output shared with the headless runner
+#include "linux_work_queue.h" // Worker threads shared with the headless runner
+#include "linux_handmade.h" // Platform layer specific function signatures
+
+#include "../Game/global_utility.cpp"
+#include "../Game/input_recording.cpp"
+#include "../Game/audio_ring_buffer.cpp"
+#include "../Game/work_queue.cpp"
+#include "linux_common.cpp"
+#include "linux_audio.cpp"
+#include "linux_work_queue.cpp"
+
+// Function stubs for functions provided by the external shared object
+GAME_INIT_AUDIO_BUFFER(gameInitAudioBufferStub) { return 0; }
+GAME_INIT_FRAME_BUFFER(gameInitFrameBufferStub) { return 0; }
+GAME_UPDATE(gameUpdateStub) { return; }
+
+// Whether or not the application is running/paused
+global_var bool8 running = true;
+global_var bool8 paused = false;
+
+// Create the Linux frame buffer
+// @TOOD(JM) move this out of the global scope
+global_var LinuxFrameBuffer linuxFrameBuffer = { 0 };
+
+/*
+ * The entry point for the Linux (X11) application.
+ */
+int main(int argc, char **argv)
+{
+    // Open the connection to the X server
+    Display *display = XOpenDisplay(NULL);
+
+    if (!display) {
+        fprintf(stderr, "Error 1. Could not open X display\n");
+        return 1;
+    }
+
+    int screen = XDefaultScreen(display);
+    Window rootWindow = XRootWindow(display, screen);
+
+    // We need a 24-bit TrueColor visual so that our 0xPPRRGGBB pixels can be
+    // handed to the X server as they are.
+    XVisualInfo visualInfo = { 0 };
+    if (!XMatchVisualInfo(display, screen, 24, TrueColor, &visualInfo)) {
+        fprintf(stderr, "Error 2. No 24-bit TrueColor visual available\n");
+        return 1;
+    }
+
+    XSetWindowAttributes windowAttributes = { 0 };
+    windowAttributes.background_pixel = 0;
+    windowAttributes.colormap = XCreateColormap(display, rootWindow, visualInfo.visual, AllocNone);
+    windowAttributes.event_mask = (StructureNotifyMask
+                                    | ExposureMask
+                                    | KeyPressMask
+                                    | KeyReleaseMask
+                                    | ButtonPressMask
+                                    | ButtonReleaseMask);
+
+    Window window = XCreateWindow(display,
+                                    rootWindow,
+                                    0,
+                                    0,
+                                    FRAME_BUFFER_PIXEL_WIDTH,
+                                    FRAME_BUFFER_PIXEL_HEIGHT,
+                                    0,
+                                    visualInfo.depth,
+                                    InputOutput,
+                                    visualInfo.visual,
+                                    CWBackPixel | CWColormap | CWEventMask,
+                                    &windowAttributes);
+
+    if (!window) {
+        fprintf(stderr, "Error 3. Window not created via XCreateWindow\n");
+        return 1;
+    }
+
+    XStoreName(display, window, "Handmade Hero");
+
+    // Ask the window manager to tell us when the window is closed, rather than
+    // simply killing our connection.
+    Atom wmDeleteWindow = XInternAtom(display, "WM_DELETE_WINDOW", False);
+    XSetWMProtocols(display, window, &wmDeleteWindow, 1);
+
+    // Only send a key release when the key is actually released, not for
+    // every auto-repeat.
+    XkbSetDetectableAutoRepeat(display, True, NULL);
+
+    XMapWindow(display, window);
+
+    GC gc = XCreateGC(display, window, 0, NULL);
+
+    // The main thread's context. The worker threads are numbered from 1.
+    PlatformThreadContext thread = { 0 };
+
+    // Create a Linux state object to hold persistent data for the platform layer.
+    LinuxState linuxState = { 0 };
+
+    linuxState.display = display;
+    linuxState.window = &window;
+    linuxState.wmDeleteWindow = wmDeleteWindow;
+
+#if HANDMADE_LOCAL_BUILD
+    linuxState.inputRecording = 0;
+    linuxState.inputPlayback = 0;
+#endif
+
+    // Calculate the absolute path to this executable.
+    linuxGetAbsolutePath(linuxState.absPath);
+
+    GameCode gameCode = { 0 };
+    linuxLoadGameSOFunctions(linuxState.absPath, &gameCode);
+
+#ifdef HANDMADE_LIVE_LOOP_EDITING
+    // Watch for rebuilds of the game code on a background thread
+    LinuxGameCodeReloader gameCodeReloader = { 0 };
+    linuxStartGameCodeReloader(&gameCodeReloader, linuxState.absPath);
+#endif
+
+    /*
+     * Game memory
+     */
+#if HANDMADE_LOCAL_BUILD
+    uint64 memoryStartAddress = utilTebibyteToBytes(4);
+#else
+    uint64 memoryStartAddress = 0;
+#endif
+
+    // Reserve all required memory for the game from within our platform layer
+    sizet permanentStorageSizeInBytes = utilGibibytesToBytes(1);
+    sizet transientStorageSizeInBytes = utilMebibytesToBytes(64);
+
+    sizet memoryTotalSize = (permanentStorageSizeInBytes + transientStorageSizeInBytes);
+
+    void *platformMemory = linuxReserveMemory(&thread, &linuxState.gameMemoryReservation, memoryStartAddress, memoryTotalSize);
+    linuxGameMemoryReservation = &linuxState.gameMemoryReservation;
+
+    // Init game memory
+    GameMemory memory = {0};
+
+    memory.platformStateWindows = NULL;
+    memory.platformStateMacOS = NULL;
+    memory.platformStateLinux = &linuxState;
+
+    memory.permanentStorage.bytes = platformMemory;
+    memory.permanentStorage.sizeInBytes = permanentStorageSizeInBytes;
+    memory.permanentStorage.bytesUsed = 0;
+    memory.permanentStorage.bytesFree = permanentStorageSizeInBytes;
+
+    memory.transientStorage.bytes = ((uint8 *)platformMemory + permanentStorageSizeInBytes);
+    memory.transientStorage.sizeInBytes = transientStorageSizeInBytes;
+    memory.transientStorage.bytesUsed = 0;
+    memory.transientStorage.bytesFree = transientStorageSizeInBytes;
+
+#if defined(HANDMADE_COMMIT_MEMORY_ON_DEMAND)
+    // Only the address range is reserved. The game's memory blocks commit
+    // pages as they grow.
+    memory.permanentStorage.platformCommitMemory = &platformCommitMemory;
+    memory.transientStorage.platformCommitMemory = &platformCommitMemory;
+#endif
+
+    memory.platformAllocateMemory = &platformAllocateMemory;
+    memory.platformFreeMemory = &platformFreeMemory;
+    memory.platformControllerVibrate = &platformControllerVibrate;
+    memory.platformToggleFullscreen = &platformToggleFullscreen;
+
+    int absPathLength = snprintf(memory.platformAbsPath, sizeof(memory.platformAbsPath), "%s", linuxState.absPath);
+
+    if ((absPathLength < 0) || ((sizet)absPathLength >= sizeof(memory.platformAbsPath))) {
+        fprintf(stderr, "Error 4. The executable's path is too long\n");
+        return 1;
+    }
+
+    // Worker threads for the renderer. The main thread works alongside them.
+    PlatformWorkQueue *renderQueue = (PlatformWorkQueue *)platformAllocateMemory(&thread, 0, sizeof(PlatformWorkQueue));
+
+    if (renderQueue && linuxStartWorkQueue(renderQueue, linuxGetWorkerThreadCount())) {
+        memory.renderQueue = renderQueue;
+    } else {
+        fprintf(stderr, "Unable to start the worker threads. Drawing on the main thread\n");
+        platformFreeMemory(&thread, renderQueue);
+    }
+
+    memory.platformAddWorkQueueEntry = &platformAddWorkQueueEntry;
+    memory.platformCompleteAllWork = &platformCompleteAllWork;
+
+#if HANDMADE_LOCAL_BUILD
+    memory.DEBUG_platformLog = &DEBUG_platformLog;
+    memory.DEBUG_platformReadEntireFile = &DEBUG_platformReadEntireFile;
+    memory.DEBUG_platformWriteEntireFile = &DEBUG_platformWriteEntireFile;
+    memory.DEBUG_platformFreeFileMemory = &DEBUG_platformFreeFileMemory;
+#endif
+
+    if (memory.permanentStorage.bytes && memory.transientStorage.bytes) {
+
+        linuxState.gameMemorySize = memoryTotalSize;
+        linuxState.gameMemory = memory.permanentStorage.bytes;
+
+#ifdef HANDMADE_LIVE_LOOP_EDITING
+        // Reserved alongside the game memory. Pages are committed as they're
+        // snapshotted into.
+        uint64 reservationSize = linuxState.gameMemoryReservation.sizeInBytes;
+
+        memory.recordingStorageGameState   = linuxReserveMemory(&thread,
+                                                                &linuxState.recordedStateReservation,
+                                                                (memoryStartAddress ? (memoryStartAddress + reservationSize) : 0),
+                                                                memoryTotalSize);
+
+        linuxState.gameMemoryRecordedState = memory.recordingStorageGameState;
+#endif
+
+        /*
+         * Framerate fixing.
+         */
+        LinuxFixedFrameRate linuxFixedFrameRate = {0};
+        linuxFixedFrameRate.gameTargetFPS = TARGET_FPS;
+        linuxFixedFrameRate.gameTargetMSPerFrame = (1000.0f / (float32)linuxFixedFrameRate.gameTargetFPS);
+        linuxFixedFrameRate.gameTargetNSPerFrame = (1000000000LL / (int64)linuxFixedFrameRate.gameTargetFPS);
+
+        /*
+         * Audio
+         */
+
+        uint8 audioBytesPerSample = (sizeof(int16) * 2);
+        uint32 audioBufferSizeInBytes = (LINUX_AUDIO_SAMPLES_PER_SECOND * audioBytesPerSample);
+        uint32 audioSamplesPerFrame = (LINUX_AUDIO_SAMPLES_PER_SECOND / TARGET_FPS);
+
+        // Create the game audio buffer.
+        GameAudioBuffer gameAudioBuffer = {0};
+        gameAudioBuffer.writeEntireBuffer = false;
+        gameAudioBuffer.minFramesWorthOfAudio = 2;
+
+        // The game's samples are handed to an audio thread, which feeds them
+        // to the device at its own pace. Each frame the game tops the queue up
+        // to minFramesWorthOfAudio frames' worth. If no sink opens the game
+        // writes a frame's worth of samples each frame and we discard them.
+        LinuxAudioOutput audioOutput = {0};
+        bool32 audioOutputStarted = linuxStartAudioOutput(&thread,
+                                                            &audioOutput,
+                                                            LINUX_AUDIO_SINK_DEFAULT,
+                                                            NULL,
+                                                            LINUX_AUDIO_SAMPLES_PER_SECOND);
+
+        if (!audioOutputStarted) {
+            fprintf(stderr, "Unable to start audio output. Audio will be discarded\n");
+        }
+
+#if defined(HANDMADE_DEBUG_AUDIO)
+        uint32 framesSinceAudioLog = 0;
+#endif
+
+        /*
+         * Graphics
+         */
+
+        // Presenting on its own thread means the main loop draws into the
+        // presenter's frame buffers. Otherwise there's just the one.
+        LinuxPresenter presenter = {0};
+        bool32 pipelinedPresent = false;
+
+#if defined(HANDMADE_PIPELINED_PRESENT)
+        pipelinedPresent = linuxStartPresenter(&thread,
+                                                &presenter,
+                                                display,
+                                                visualInfo.visual,
+                                                window,
+                                                FRAME_BUFFER_PIXEL_WIDTH,
+                                                FRAME_BUFFER_PIXEL_HEIGHT);
+
+        if (!pipelinedPresent) {
+            fprintf(stderr, "Unable to start the presenter thread. Presenting from the main loop\n");
+        }
+#endif
+
+        // Create the Linux frame buffer
+        if (!pipelinedPresent && !linuxInitFrameBuffer(&thread,
+                                                        display,
+                                                        visualInfo.visual,
+                                                        &linuxFrameBuffer,
+                                                        FRAME_BUFFER_PIXEL_WIDTH,
+                                                        FRAME_BUFFER_PIXEL_HEIGHT)) {
+            fprintf(stderr, "Error allocating the frame buffer. Unable to run game\n");
+            return 1;
+        }
+
+        /*
+         * Controllers
+         */
+
+        // How many controllers does the platform layer support?
+        // @TODO(JM) Gamepad support via evdev. Keyboard only for now.
+        ControllerCounts controllerCounts = {0};
+        controllerCounts.gameMaxControllers = MAX_CONTROLLERS;
+        controllerCounts.platformMaxControllers = 0;
+
+        // An array to hold pointers to the old and new instances of the inputs.
+        GameInput GameInputInstances[2] = {0};
+
+        // We save a copy of what we've written to the inputs (in the old instance variable)
+        // so we can compare last frame's values to this frame's values.
+        GameInput *gameInput        = &GameInputInstances[0];
+        GameInput *gameInputOld     = &GameInputInstances[1];
+
+        // Mouse support
+        GameMouseInput mouse = { 0 };
+
+        // Assign the mouse object to the game input
+        gameInput->mouse = mouse;
+        gameInput->targetFPS = TARGET_FPS;
+
+        // Until we've timed a frame, assume we're hitting our target.
+        gameInput->msPerFrame = linuxFixedFrameRate.gameTargetMSPerFrame;
+        gameInput->fps = (float32)TARGET_FPS;
+
+        // Keyboard support
+        GameControllerInput keyboard = { 0 };
+        keyboard.isConnected = 1;
+
+        // Assign the keyboard object to the game input
+        gameInput->controllers[0] = keyboard; // Assign the first game input controller as the keyboard
+        controllerCounts.connectedControllers = 1; // @TODO(JM) Support for multiple controllers
+
+        // The first frame's deadline is one frame from now.
+        linuxFixedFrameRate.frameDeadline = linuxTimespecAddNS(linuxGetTime(),
+                                                                linuxFixedFrameRate.gameTargetNSPerFrame);
+
+#if defined(HANDMADE_DEBUG_MEMORY)
+        uint32 framesSinceMemoryLog = 0;
+#endif
+
+        // Counts the frames drawn, so each frame buffer's age can be worked
+        // out. Frame buffers drawn into before validFromFrameNumber are out
+        // of date.
+        uint64 frameNumber = 0;
+        uint64 validFromFrameNumber = 0;
+
+        // When presenting from the main loop, the frame number of the frame
+        // on screen
+        uint64 presentedFrameNumber = 0;
+
+        /**
+         * MAIN GAME LOOP
+         */
+        while (running) {
+
+            // Get the current time for profiling FPS
+            struct timespec netFrameTime = linuxGetTime();
+
+            // Get the position of the mouse
+            linuxGetMousePosition(display, window, &gameInput->mouse);
+
+            // Handle the X11 event queue and handle mouse and keyboard input
+            linuxProcessMessages(display, gameInput, *gameInputOld, &linuxState);
+
+            if (paused) {
+                linuxWaitForFrameDeadline(&linuxFixedFrameRate);
+                continue;
+            }
+
+#ifdef HANDMADE_LIVE_LOOP_EDITING
+
+            // Recording/playback
+            if (linuxState.inputRecording) {
+                linuxRecordInput(&linuxState, gameInput);
+            }
+
+            if (linuxState.inputPlayback) {
+               linuxPlaybackInput(&linuxState, gameInput);
+            }
+#endif
+
+            // Create the game's audio buffer
+            uint32 audioSamplesToWrite = audioSamplesPerFrame;
+
+            if (audioOutputStarted) {
+                audioSamplesToWrite = linuxAudioFramesToRequest(&audioOutput, (audioSamplesPerFrame * gameAudioBuffer.minFramesWorthOfAudio));
+            }
+
+            if (gameCode.gameInitAudioBuffer){
+                gameCode.gameInitAudioBuffer(&thread,
+                                                &memory,
+                                                &gameAudioBuffer,
+                                                (audioSamplesToWrite * audioBytesPerSample),
+                                                audioBytesPerSample,
+                                                audioBufferSizeInBytes);
+            }
+
+            // Create the game's frame buffer
+            LinuxFrameBuffer *drawFrameBuffer = (pipelinedPresent ? linuxPresenterDrawBuffer(&presenter) : &linuxFrameBuffer);
+
+            GameFrameBuffer gameFrameBuffer = {0};
+
+            frameNumber++;
+
+            if (linuxState.frameBuffersInvalid) {
+                validFromFrameNumber = frameNumber;
+                linuxState.frameBuffersInvalid = false;
+            }
+
+            if (gameCode.gameInitFrameBuffer){
+                gameCode.gameInitFrameBuffer(&thread,
+                                                &gameFrameBuffer,
+                                                drawFrameBuffer->height,
+                                                drawFrameBuffer->width,
+                                                drawFrameBuffer->bytesPerPixel,
+                                                drawFrameBuffer->byteWidthPerRow,
+                                                drawFrameBuffer->memory);
+            }
+
+            // Lets the game redraw only what's changed since the frame that's
+            // already in the buffer
+            if (drawFrameBuffer->frameNumber && (drawFrameBuffer->frameNumber >= validFromFrameNumber)) {
+                gameFrameBuffer.age = (uint32)(frameNumber - drawFrameBuffer->frameNumber);
+            }
+
+            // Main game code.
+            if (gameCode.gameUpdate){
+                gameCode.gameUpdate(&thread,
+                                    NULL,
+                                    NULL,
+                                    (void *)&linuxState,
+                                    &memory,
+                                    &gameFrameBuffer,
+                                    &gameAudioBuffer,
+                                    GameInputInstances,
+                                    &controllerCounts);
+            }
+
+            drawFrameBuffer->frameNumber = frameNumber;
+            drawFrameBuffer->dirtyRegion = gameFrameBuffer.dirtyRegion;
+
+            // Queue the game's samples for the audio thread
+            if (audioOutputStarted) {
+                linuxSubmitAudio(&audioOutput, gameAudioBuffer.memory, gameAudioBuffer.noOfSamplesToWrite);
+            }
+
+#if defined(HANDMADE_DEBUG_AUDIO)
+            if (audioOutputStarted && (++framesSinceAudioLog >= TARGET_FPS)) {
+                linuxLogAudioOutput(&audioOutput);
+                framesSinceAudioLog = 0;
+            }
+#endif
+
+#ifdef HANDMADE_LIVE_LOOP_EDITING
+            // Swap in new game code if the reload thread has staged some. The
+            // new code may draw differently, so start again from a full frame.
+            void *gameCodeHandle = gameCode.dllHandle;
+
+            linuxSwapStagedGameCode(&gameCodeReloader, &gameCode);
+
+            if (gameCode.dllHandle != gameCodeHandle) {
+                linuxState.frameBuffersInvalid = true;
+                linuxState.windowExposed = true;
+            }
+#endif
+
+#if defined(HANDMADE_DEBUG_MEMORY)
+            if (++framesSinceMemoryLog >= TARGET_FPS) {
+                linuxLogMemoryUsage(&linuxState.gameMemoryReservation);
+                framesSinceMemoryLog = 0;
+            }
+#endif
+
+            // Take a copy of this frame's controller inputs
+            gameInputOld->mouse = gameInput->mouse;
+            gameInputOld->controllers[0] = gameInput->controllers[0];
+
+            // Display the frame buffer. AKA "flip the frame" or "page flip".
+            if (pipelinedPresent) {
+
+                if (linuxState.windowExposed) {
+                    __atomic_store_n(&presenter.presentAll, true, __ATOMIC_RELEASE);
+                    linuxState.windowExposed = false;
+                }
+
+                // The presenter thread puts it on screen whilst we get on
+                // with the next frame
+                linuxSubmitFrameToPresenter(&presenter);
+
+            } else {
+
+                // The window shows the last frame, so only what's changed
+                // since needs copying
+                FrameBufferDirtyRegion *region = NULL;
+
+                if (!linuxState.windowExposed
+                        && presentedFrameNumber
+                        && (linuxFrameBuffer.frameNumber == (presentedFrameNumber + 1))) {
+                    region = &linuxFrameBuffer.dirtyRegion;
+                }
+
+                linuxState.windowExposed = false;
+                presentedFrameNumber = linuxFrameBuffer.frameNumber;
+
+                linuxClientDimensions clientDimensions = linuxGetClientDimensions(display, window);
+
+                linuxDisplayFrameBuffer(display,
+                                        window,
+                                        gc,
+                                        &linuxFrameBuffer,
+                                        region,
+                                        clientDimensions.width,
+                                        clientDimensions.height);
+            }
+
+            // How long did this game loop (frame) take? (E.g. 2ms)
+            float32 millisecondsElapsedForFrame = linuxGetElapsedTimeMS(netFrameTime, linuxGetTime());
+
+#if defined(HANDMADE_LOCAL_BUILD) && defined(HANDMADE_DEBUG_FPS)
+            fprintf(stderr,
+                    "Time for frame to complete: %f milliseconds (target %f)\n",
+                    millisecondsElapsedForFrame,
+                    linuxFixedFrameRate.gameTargetMSPerFrame);
+#endif
+
+            // The time spent working, for the game to pick the next frame's
+            // resolution by
+            gameInput->msWorkPerFrame = millisecondsElapsedForFrame;
+
+            // Cap frame rate to target FPS if we're running ahead.
+            linuxWaitForFrameDeadline(&linuxFixedFrameRate);
+
+            // Calculate the net frame time (E.g. 33.33ms or 16.66ms)
+            millisecondsElapsedForFrame = linuxGetElapsedTimeMS(netFrameTime, linuxGetTime());
+
+            // Set the ms per frame to the game input object so we can regulate movement speed
+            gameInput->msPerFrame = millisecondsElapsedForFrame;
+            gameInput->fps = (1000.0f / gameInput->msPerFrame);
+
+#if defined(HANDMADE_LOCAL_BUILD) && defined(HANDMADE_DEBUG_FPS)
+            fprintf(stderr,
+                    "Net time for frame to complete: %f milliseconds\n\n",
+                    millisecondsElapsedForFrame);
+
+            if (pipelinedPresent) {
+                fprintf(stderr,
+                        "Frames presented: %llu. Dropped: %llu\n",
+                        (unsigned long long)__atomic_load_n(&presenter.framesPresented, __ATOMIC_RELAXED),
+                        (unsigned long long)presenter.framesDropped);
+            }
+#endif
+
+        } // game loop
+
+        if (pipelinedPresent) {
+            linuxStopPresenter(&presenter);
+        }
+
+        if (audioOutputStarted) {
+            linuxStopAudioOutput(&thread, &audioOutput);
+        }
+
+        if (memory.renderQueue) {
+            linuxStopWorkQueue(memory.renderQueue);
+        }
+
+    }else{
+        fprintf(stderr, "Error allocating game memory. Unable to run game\n");
+    }
+
+    XCloseDisplay(display);
+
+    // Close the application.
+    return(0);
+}
+
+/*
+ * Allocates the frame buffer's memory and wraps it in an XImage so it can be
+ * handed to the X server without any copying or conversion on our side.
+ */
+internal_func bool32 linuxInitFrameBuffer(PlatformThreadContext *thread,
+                                            Display *display,
+                                            Visual *visual,
+                                            LinuxFrameBuffer *buffer,
+                                            uint32 width,
+                                            uint32 height)
+{
+    if (buffer->image) {
+        // XDestroyImage frees the data pointer too, which we own.
+        buffer->image->data = NULL;
+        XDestroyImage(buffer->image);
+        buffer->image = NULL;
+    }
+
+    if (buffer->memory != NULL) {
+        platformFreeMemory(thread, buffer->memory);
+        buffer->memory = NULL;
+    }
+
+    buffer->bytesPerPixel   = 4;
+    buffer->width           = width;
+    buffer->height          = height;
+
+    // How many bytes do we need for our bitmap?
+    uint32 bitmapMemorySizeInBytes = ((buffer->width * buffer->height) * buffer->bytesPerPixel);
+
+    buffer->memory = platformAllocateMemory(thread, 0, bitmapMemorySizeInBytes);
+
+    if (!buffer->memory) {
+        return false;
+    }
+
+    // Calculate the width in bytes per row.
+    buffer->byteWidthPerRow = (buffer->width * buffer->bytesPerPixel);
+
+    // Rows are top down, matching the negative biHeight of the Win32 DIB.
+    buffer->image = XCreateImage(display,
+                                    visual,
+                                    24,
+                                    ZPixmap,
+                                    0,
+                                    (char *)buffer->memory,
+                                    buffer->width,
+                                    buffer->height,
+                                    32,
+                                    buffer->byteWidthPerRow);
+
+    return (buffer->image != NULL);
+}
+
+/*
+ * Copies the frame buffer's memory to the window. If the window is smaller
+ * than the frame buffer then the X server simply clips the graphics.
+ */
+internal_func void linuxDisplayFrameBuffer(Display *display,
+                                            Window window,
+                                            GC gc,
+                                            LinuxFrameBuffer *buffer,
+                                            FrameBufferDirtyRegion *region,
+                                            uint32 clientWindowWidth,
+                                            uint32 clientWindowHeight)
+{
+    if (!buffer->image) {
+        return;
+    }
+
+    uint32 destinationWidth = ((buffer->width < clientWindowWidth) ? buffer->width : clientWindowWidth);
+    uint32 destinationHeight = ((buffer->height < clientWindowHeight) ? buffer->height : clientWindowHeight);
+
+    if (!region || region->all) {
+
+        XPutImage(display,
+                    window,
+                    gc,
+                    buffer->image,
+                    0,
+                    0,
+                    0,
+                    0,
+                    destinationWidth,
+                    destinationHeight);
+
+    } else {
+
+        // Only what's changed. Each rectangle is its own request, which is
+        // still far less to send than the whole frame.
+        for (uint32 i = 0; i < region->rectCount; i++) {
+
+            FrameBufferRect *rect = &region->rects[i];
+
+            // The rectangle's from the bottom left but the image's rows are
+            // top down
+            uint32 left = (uint32)rect->minX;
+            uint32 top = (buffer->height - (uint32)rect->maxY);
+            uint32 right = (((uint32)rect->maxX < destinationWidth) ? (uint32)rect->maxX : destinationWidth);
+            uint32 bottom = (buffer->height - (uint32)rect->minY);
+
+            if (bottom > destinationHeight) {
+                bottom = destinationHeight;
+            }
+
+            if ((left >= right) || (top >= bottom)) {
+                continue;
+            }
+
+            XPutImage(display,
+                        window,
+                        gc,
+                        buffer->image,
+                        (int)left,
+                        (int)top,
+                        (int)left,
+                        (int)top,
+                        (right - left),
+                        (bottom - top));
+        }
+    }
+
+    XFlush(display);
+}
+
+internal_func bool32 linuxStartPresenter(PlatformThreadContext *thread,
+                                            LinuxPresenter *presenter,
+                                            Display *display,
+                                            Visual *visual,
+                                            Window window,
+                                            uint32 width,
+                                            uint32 height)
+{
+    presenter->display = XOpenDisplay(DisplayString(display));
+
+    if (!presenter->display) {
+        return false;
+    }
+
+    presenter->window = window;
+    presenter->gc = XCreateGC(presenter->display, window, 0, NULL);
+
+    for (uint32 i = 0; i < LINUX_PRESENT_BUFFER_COUNT; i++) {
+        if (!linuxInitFrameBuffer(thread,
+                                    presenter->display,
+                                    visual,
+                                    &presenter->frameBuffers[i],
+                                    width,
+                                    height)) {
+            XCloseDisplay(presenter->display);
+            return false;
+        }
+    }
+
+    // Each buffer starts out with one owner. Nothing's fresh yet.
+    presenter->drawBuffer = 0;
+    presenter->readyBuffer = 1;
+    presenter->presentBuffer = 2;
+
+    presenter->presentedFrameNumber = 0;
+    presenter->presentAll = true;
+
+    presenter->framesPresented = 0;
+    presenter->framesDropped = 0;
+    presenter->running = true;
+
+    if (0 != sem_init(&presenter->frameReady, 0, 0)) {
+        XCloseDisplay(presenter->display);
+        return false;
+    }
+
+    if (0 != pthread_create(&presenter->thread, NULL, linuxPresenterThread, presenter)) {
+        sem_destroy(&presenter->frameReady);
+        XCloseDisplay(presenter->display);
+        return false;
+    }
+
+    return true;
+}
+
+internal_func void *linuxPresenterThread(void *param)
+{
+    LinuxPresenter *presenter = (LinuxPresenter *)param;
+
+    for (;;) {
+
+        // Blocks until the main loop hands over a frame
+        if (0 != sem_wait(&presenter->frameReady)) {
+            continue; // EINTR
+        }
+
+        if (!__atomic_load_n(&presenter->running, __ATOMIC_ACQUIRE)) {
+            break;
+        }
+
+        // Posts can pile up if we fall behind. Only the newest frame matters.
+        if (!(__atomic_load_n(&presenter->readyBuffer, __ATOMIC_ACQUIRE) & LINUX_PRESENT_BUFFER_FRESH)) {
+            continue;
+        }
+
+        // Take the newest frame and give back the one we presented last
+        uint32 readyBuffer = __atomic_exchange_n(&presenter->readyBuffer,
+                                                    presenter->presentBuffer,
+                                                    __ATOMIC_ACQ_REL);
+
+        presenter->presentBuffer = (readyBuffer & ~LINUX_PRESENT_BUFFER_FRESH);
+
+        LinuxFrameBuffer *presentBuffer = &presenter->frameBuffers[presenter->presentBuffer];
+
+        // Only what's changed can be copied if the window shows the frame
+        // just before this one. Not if frames were dropped in between.
+        FrameBufferDirtyRegion *region = NULL;
+
+        bool32 presentAll = __atomic_exchange_n(&presenter->presentAll, false, __ATOMIC_ACQ_REL);
+
+        if (!presentAll
+                && presenter->presentedFrameNumber
+                && (presentBuffer->frameNumber == (presenter->presentedFrameNumber + 1))) {
+            region = &presentBuffer->dirtyRegion;
+        }
+
+        presenter->presentedFrameNumber = presentBuffer->frameNumber;
+
+        linuxClientDimensions clientDimensions = linuxGetClientDimensions(presenter->display, presenter->window);
+
+        linuxDisplayFrameBuffer(presenter->display,
+                                presenter->window,
+                                presenter->gc,
+                                presentBuffer,
+                                region,
+                                clientDimensions.width,
+                                clientDimensions.height);
+
+        __atomic_add_fetch(&presenter->framesPresented, 1, __ATOMIC_RELAXED);
+    }
+
+    return NULL;
+}
+
+internal_func LinuxFrameBuffer *linuxPresenterDrawBuffer(LinuxPresenter *presenter)
+{
+    return &presenter->frameBuffers[presenter->drawBuffer];
+}
+
+internal_func void linuxSubmitFrameToPresenter(LinuxPresenter *presenter)
+{
+    // Publish the frame we've drawn and take whichever buffer was sitting in
+    // readyBuffer. Either a frame the presenter never got to or the one it
+    // has just finished presenting. Both are free to draw over.
+    uint32 previousBuffer = __atomic_exchange_n(&presenter->readyBuffer,
+                                                (presenter->drawBuffer | LINUX_PRESENT_BUFFER_FRESH),
+                                                __ATOMIC_ACQ_REL);
+
+    if (previousBuffer & LINUX_PRESENT_BUFFER_FRESH) {
+        presenter->framesDropped++;
+    }
+
+    presenter->drawBuffer = (previousBuffer & ~LINUX_PRESENT_BUFFER_FRESH);
+
+    sem_post(&presenter->frameReady);
+}
+
+internal_func void linuxStopPresenter(LinuxPresenter *presenter)
+{
+    __atomic_store_n(&presenter->running, false, __ATOMIC_RELEASE);
+    sem_post(&presenter->frameReady);
+
+    pthread_join(presenter->thread, NULL);
+    sem_destroy(&presenter->frameReady);
+
+    XFreeGC(presenter->display, presenter->gc);
+    XCloseDisplay(presenter->display);
+}
+
+/**
+ * Gets the height and width of the actual window. This changes if the window is
+ * resized, maximised etc
+ */
+internal_func linuxClientDimensions linuxGetClientDimensions(Display *display, Window window)
+{
+    XWindowAttributes attributes = { 0 };
+    XGetWindowAttributes(display, window, &attributes);
+
+    linuxClientDimensions dim = {0};
+
+    dim.width = (uint32)attributes.width;
+    dim.height = (uint32)attributes.height;
+
+    return dim;
+}
+
+internal_func void linuxProcessMessages(Display *display,
+                                        GameInput *gameInput,
+                                        GameInput oldGameInput,
+                                        LinuxState *linuxState)
+{
+    // X11 event loop. Retrieves all events that are queued for the window
+    // without blocking. E.g. clicks and key inputs.
+    while (XPending(display)) {
+
+        XEvent event = { 0 };
+        XNextEvent(display, &event);
+
+        switch (event.type) {
+
+            // The window manager has asked us to close.
+            case ClientMessage: {
+                if ((Atom)event.xclient.data.l[0] == linuxState->wmDeleteWindow) {
+                    running = false;
+                }
+            } break;
+
+            case DestroyNotify: {
+                running = false;
+            } break;
+
+            // Part of the window has been uncovered (or resized)
+            case Expose: {
+                linuxState->windowExposed = true;
+            } break;
+
+            // Mouse left click
+            case ButtonPress:
+            case ButtonRelease: {
+                if (Button1 == event.xbutton.button) {
+                    GameControllerBtnState state = {0};
+                    state.endedDown = (ButtonPress == event.type);
+                    state.wasDown = oldGameInput.mouse.leftClick.endedDown;
+                    gameInput->mouse.leftClick = state;
+                }
+            } break;
+
+            case KeyPress:
+            case KeyRelease: {
+
+                // Which key was pressed?
+                KeySym keySym = XLookupKeysym(&event.xkey, 0);
+
+                // Was the button down or up?
+                bool32 keyDown = (KeyPress == event.type);
+
+                GameControllerBtnState state = { 0 };
+                state.endedDown = keyDown;
+
+                switch (keySym) {
+                    case XK_w: {
+                        state.wasDown = oldGameInput.controllers[0].dPadUp.endedDown;
+                        gameInput->controllers[0].dPadUp = state;
+                    } break;
+                    case XK_a: {
+                        state.wasDown = oldGameInput.controllers[0].dPadLeft.endedDown;
+                        gameInput->controllers[0].dPadLeft = state;
+                    } break;
+                    case XK_s: {
+                        state.wasDown = oldGameInput.controllers[0].dPadDown.endedDown;
+                        gameInput->controllers[0].dPadDown = state;
+                    } break;
+                    case XK_d: {
+                        state.wasDown = oldGameInput.controllers[0].dPadRight.endedDown;
+                        gameInput->controllers[0].dPadRight = state;
+                    } break;
+                    case XK_q: {
+                        state.wasDown = oldGameInput.controllers[0].shoulderL1.endedDown;
+                        gameInput->controllers[0].shoulderL1 = state;
+                    } break;
+                    case XK_e: {
+                        state.wasDown = oldGameInput.controllers[0].shoulderR1.endedDown;
+                        gameInput->controllers[0].shoulderR1 = state;
+                    } break;
+                    case XK_f: {
+                        state.wasDown = oldGameInput.controllers[0].option1.endedDown;
+                        gameInput->controllers[0].option1 = state;
+                    } break;
+                    case XK_Up: {
+                        state.wasDown = oldGameInput.controllers[0].up.endedDown;
+                        gameInput->controllers[0].up = state;
+                    } break;
+                    case XK_Down: {
+                        state.wasDown = oldGameInput.controllers[0].down.endedDown;
+                        gameInput->controllers[0].down = state;
+                    } break;
+
+#ifdef HANDMADE_LIVE_LOOP_EDITING
+                    // Playback recording/looping
+                    case XK_l: {
+                        if (keyDown) {
+                            if (0 == linuxState->inputPlayback){ // Lock the developer into the loop. Have to rebuild to exit.
+                                if (!linuxState->inputRecording) {
+                                    linuxBeginInputRecording(linuxState);
+                                }
+                                else {
+                                    linuxEndInputRecording(linuxState);
+                                    linuxBeginRecordingPlayback(linuxState);
+                                }
+                            }
+                        }
+                    } break;
+#endif
+
+                    case XK_p:{
+                        if (keyDown) {
+                            paused = !paused;
+                        }
+                    } break;
+
+                    case XK_Escape:{
+                        running = false;
+                    } break;
+                }
+            } break;
+
+            default: {
+            } break;
+
+        } // event switch
+
+    } // XPending loop
+}
+
+internal_func void linuxWaitForFrameDeadline(LinuxFixedFrameRate *fixedFrameRate)
+{
+    struct timespec now = linuxGetTime();
+
+    float32 msUntilDeadline = linuxGetElapsedTimeMS(now, fixedFrameRate->frameDeadline);
+
+    if (msUntilDeadline > 0.0f) {
+
+        // Sleep until the absolute deadline. Retry if a signal wakes us early.
+        while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &fixedFrameRate->frameDeadline, NULL) != 0) {
+        }
+
+        fixedFrameRate->frameDeadline = linuxTimespecAddNS(fixedFrameRate->frameDeadline,
+                                                            fixedFrameRate->gameTargetNSPerFrame);
+
+    } else if ((msUntilDeadline * -1.0f) > fixedFrameRate->gameTargetMSPerFrame) {
+
+        // @TODO(JM) Missed target framerate by more than a frame. Log.
+#if defined(HANDMADE_DEBUG_FPS)
+        fprintf(stderr,
+                "======================================MISSED================================ (%f ms late)\n",
+                (msUntilDeadline * -1.0f));
+#endif
+
+        // Don't try and catch up on the missed frames, start again from now.
+        fixedFrameRate->frameDeadline = linuxTimespecAddNS(now, fixedFrameRate->gameTargetNSPerFrame);
+
+    } else {
+
+        // Slightly late. Keep the cadence by moving the deadline on by one
+        // frame without sleeping.
+        fixedFrameRate->frameDeadline = linuxTimespecAddNS(fixedFrameRate->frameDeadline,
+                                                            fixedFrameRate->gameTargetNSPerFrame);
+    }
+}
+
+//=======================================
+// Library loading
+//=======================================
+
+internal_func void linuxLoadGameSOFunctionsFromFile(const char *absPathToSO, GameCode *gameCode)
+{
+    // Load code from Game_copy.so
+    void *libHandle = dlopen(absPathToSO, RTLD_NOW | RTLD_LOCAL);
+
+    bool8 valid = 1;
+
+    if (libHandle) {
+
+        gameCode->dllHandle = libHandle;
+
+        GameUpdate *gameUpdateAddr = (GameUpdate *)dlsym(libHandle, "gameUpdate");
+        GameInitFrameBuffer *gameInitFrameBufferAddr = (GameInitFrameBuffer *)dlsym(libHandle, "gameInitFrameBuffer");
+        GameInitAudioBuffer *gameInitAudioBufferAddr = (GameInitAudioBuffer *)dlsym(libHandle, "gameInitAudioBuffer");
+
+        if (gameUpdateAddr) {
+            gameCode->gameUpdate = gameUpdateAddr;
+        } else {
+            assert(!"unable to find gameUpdate");
+            valid = 0;
+        }
+
+        if (gameInitFrameBufferAddr) {
+            gameCode->gameInitFrameBuffer = gameInitFrameBufferAddr;
+        } else {
+            assert(!"unable to find gameInitFrameBuffer");
+            valid = 0;
+        }
+
+        if (gameInitAudioBufferAddr) {
+            gameCode->gameInitAudioBuffer = gameInitAudioBufferAddr;
+        } else {
+            assert(!"unable to find gameInitAudioBuffer");
+            valid = 0;
+        }
+
+    } else {
+        fprintf(stderr, "Unable to load game code: %s\n", dlerror());
+        valid = 0;
+    }
+
+    if (!valid) {
+
+        gameCode->gameUpdate = &gameUpdateStub;
+        gameCode->gameInitFrameBuffer = &gameInitFrameBufferStub;
+        gameCode->gameInitAudioBuffer = &gameInitAudioBufferStub;
+    }
+}
+
+internal_func void linuxLoadGameSOFunctions(const char *absPath, GameCode *gameCode)
+{
+#if !defined(HANDMADE_LIVE_LOOP_EDITING)
+
+    // Calculate absolute path to the Game.so
+    char gameSOFilePath[GAME_MAX_PATH] = { 0 };
+    snprintf(gameSOFilePath, sizeof(gameSOFilePath), "%s%s", absPath, LINUX_GAME_SO_FILENAME);
+
+    linuxLoadGameSOFunctionsFromFile(gameSOFilePath, gameCode);
+
+#else
+
+    // Load from a copy so the compiler is free to overwrite Game.so. Later
+    // copies are made by the reload thread, alternating between the two slots.
+    char gameSOFilePath[GAME_MAX_PATH] = { 0 };
+    snprintf(gameSOFilePath, sizeof(gameSOFilePath), "%s%s", absPath, LINUX_GAME_SO_FILENAME);
+
+    char gameCopySOFilePath[GAME_MAX_PATH] = { 0 };
+    snprintf(gameCopySOFilePath, sizeof(gameCopySOFilePath), "%s" LINUX_GAME_SO_COPY_FILENAME_FORMAT, absPath, 0);
+
+    if (!linuxCopyFile(gameSOFilePath, gameCopySOFilePath)) {
+        fprintf(stderr, "Unable to copy %s\n", gameSOFilePath);
+    }
+
+    linuxLoadGameSOFunctionsFromFile(gameCopySOFilePath, gameCode);
+
+#endif
+}
+
+#ifdef HANDMADE_LIVE_LOOP_EDITING
+
+internal_func bool32 linuxStartGameCodeReloader(LinuxGameCodeReloader *reloader, const char *absPath)
+{
+    strncpy(reloader->absPath, absPath, (sizeof(reloader->absPath) - 1));
+
+    // linuxLoadGameSOFunctions loaded the running code from slot 0
+    reloader->stagedSlot = 0;
+    reloader->stagedState = LINUX_STAGED_GAME_CODE_NONE;
+    reloader->retiredHandle = NULL;
+
+    reloader->inotifyFD = inotify_init1(IN_CLOEXEC);
+
+    if (-1 == reloader->inotifyFD) {
+        fprintf(stderr, "Unable to watch for game code changes: inotify_init1 failed\n");
+        return false;
+    }
+
+    // Watch the directory rather than Game.so itself. A rebuild usually
+    // replaces the file, which would silently end a watch on the file.
+    if (-1 == inotify_add_watch(reloader->inotifyFD, reloader->absPath, (IN_CLOSE_WRITE | IN_MOVED_TO))) {
+        fprintf(stderr, "Unable to watch for game code changes in %s\n", reloader->absPath);
+        close(reloader->inotifyFD);
+        return false;
+    }
+
+    if (0 != pthread_create(&reloader->thread, NULL, linuxGameCodeReloaderThread, reloader)) {
+        fprintf(stderr, "Unable to start the game code reload thread\n");
+        close(reloader->inotifyFD);
+        return false;
+    }
+
+    return true;
+}
+
+internal_func void *linuxGameCodeReloaderThread(void *param)
+{
+    LinuxGameCodeReloader *reloader = (LinuxGameCodeReloader *)param;
+
+    // Aligned as inotify_event requires
+    char buffer[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+
+    for (;;) {
+
+        // Blocks until something in the directory changes
+        ssize_t bytesRead = read(reloader->inotifyFD, buffer, sizeof(buffer));
+
+        if (bytesRead <= 0) {
+            break;
+        }
+
+        bool32 gameSOChanged = false;
+
+        for (char *ptr = buffer; ptr < (buffer + bytesRead);) {
+
+            struct inotify_event *event = (struct inotify_event *)ptr;
+
+            if ((event->len > 0) && (0 == strcmp(event->name, LINUX_GAME_SO_FILENAME))) {
+                gameSOChanged = true;
+            }
+
+            ptr += (sizeof(struct inotify_event) + event->len);
+        }
+
+        if (gameSOChanged) {
+            linuxStageGameCode(reloader);
+        }
+    }
+
+    return NULL;
+}
+
+internal_func void linuxStageGameCode(LinuxGameCodeReloader *reloader)
+{
+    uint32 slot = 0;
+
+    int32 expected = LINUX_STAGED_GAME_CODE_READY;
+
+    if (__atomic_compare_exchange_n(&reloader->stagedState,
+                                    &expected,
+                                    LINUX_STAGED_GAME_CODE_NONE,
+                                    false,
+                                    __ATOMIC_ACQ_REL,
+                                    __ATOMIC_ACQUIRE)) {
+
+        // The main loop never picked up the last staged code. Discard it and
+        // reuse its slot.
+        dlclose(reloader->staged.dllHandle);
+        slot = reloader->stagedSlot;
+
+    } else {
+
+        // Wait out a swap that's in progress on the main thread
+        while (LINUX_STAGED_GAME_CODE_SWAPPING == __atomic_load_n(&reloader->stagedState, __ATOMIC_ACQUIRE)) {
+            sched_yield();
+        }
+
+        // The main loop is running the last staged code. Use the other slot.
+        slot = (reloader->stagedSlot ^ 1);
+    }
+
+    // Free the code the main loop swapped out. It was loaded from the slot
+    // we're about to overwrite and dlopen would hand us back the old handle
+    // if a library of the same name was still open.
+    void *retiredHandle = __atomic_exchange_n(&reloader->retiredHandle, (void *)NULL, __ATOMIC_ACQ_REL);
+
+    if (retiredHandle) {
+        dlclose(retiredHandle);
+    }
+
+    char gameSOFilePath[GAME_MAX_PATH] = { 0 };
+    int gameSOFilePathLength = snprintf(gameSOFilePath, sizeof(gameSOFilePath), "%s%s", reloader->absPath, LINUX_GAME_SO_FILENAME);
+
+    char gameCopySOFilePath[GAME_MAX_PATH] = { 0 };
+    int gameCopySOFilePathLength = snprintf(gameCopySOFilePath, sizeof(gameCopySOFilePath), "%s" LINUX_GAME_SO_COPY_FILENAME_FORMAT, reloader->absPath, slot);
+
+    // A path that doesn't fit counts as a failed copy
+    bool32 res = ((gameSOFilePathLength >= 0)
+                    && ((sizet)gameSOFilePathLength < sizeof(gameSOFilePath))
+                    && (gameCopySOFilePathLength >= 0)
+                    && ((sizet)gameCopySOFilePathLength < sizeof(gameCopySOFilePath)));
+
+    if (res) {
+        res = linuxCopyFile(gameSOFilePath, gameCopySOFilePath);
+    }
+
+#ifdef HANDMADE_DEBUG_LIVE_LOOP_EDITING
+    fprintf(stderr, (res ? "SO copy succeeded\n" : "SO copy failed\n"));
+#endif
+
+    if (!res) {
+        return;
+    }
+
+    GameCode staged = { 0 };
+    linuxLoadGameSOFunctionsFromFile(gameCopySOFilePath, &staged);
+
+    reloader->staged = staged;
+    reloader->stagedSlot = slot;
+
+    __atomic_store_n(&reloader->stagedState, LINUX_STAGED_GAME_CODE_READY, __ATOMIC_RELEASE);
+}
+
+internal_func void linuxSwapStagedGameCode(LinuxGameCodeReloader *reloader, GameCode *gameCode)
+{
+    // A plain load on the common path. No syscalls and no locked instructions.
+    if (LINUX_STAGED_GAME_CODE_READY != __atomic_load_n(&reloader->stagedState, __ATOMIC_ACQUIRE)) {
+        return;
+    }
+
+    // Claim the staged code so the reload thread can't discard it under us
+    int32 expected = LINUX_STAGED_GAME_CODE_READY;
+
+    if (!__atomic_compare_exchange_n(&reloader->stagedState,
+                                        &expected,
+                                        LINUX_STAGED_GAME_CODE_SWAPPING,
+                                        false,
+                                        __ATOMIC_ACQ_REL,
+                                        __ATOMIC_ACQUIRE)) {
+        return;
+    }
+
+    void *retiredHandle = gameCode->dllHandle;
+
+    *gameCode = reloader->staged;
+
+    __atomic_store_n(&reloader->retiredHandle, retiredHandle, __ATOMIC_RELEASE);
+    __atomic_store_n(&reloader->stagedState, LINUX_STAGED_GAME_CODE_NONE, __ATOMIC_RELEASE);
+}
+
+#endif
+
+internal_func void linuxLogMemoryUsage(LinuxMemoryReservation *reservation)
+{
+    fprintf(stderr,
+            "Game memory: %.2f MiB reserved. %.2f MiB committed (%.2f MiB huge pages). %.2f MiB resident\n",
+            ((float64)reservation->sizeInBytes / (1024.0 * 1024.0)),
+            ((float64)reservation->committedSizeInBytes / (1024.0 * 1024.0)),
+            ((float64)reservation->hugePageSizeInBytes / (1024.0 * 1024.0)),
+            ((float64)linuxGetResidentMemorySize(reservation) / (1024.0 * 1024.0)));
+}
+
+internal_func void linuxGetMousePosition(Display *display, Window window, GameMouseInput *mouseInput)
+{
+    if (paused){
+        return;
+    }
+
+    Window rootReturn;
+    Window childReturn;
+    int rootX = 0;
+    int rootY = 0;
+    int windowX = 0;
+    int windowY = 0;
+    unsigned int mask = 0;
+
+    mouseInput->isConnected = XQueryPointer(display,
+                                            window,
+                                            &rootReturn,
+                                            &childReturn,
+                                            &rootX,
+                                            &rootY,
+                                            &windowX,
+                                            &windowY,
+                                            &mask);
+
+    if (mouseInput->isConnected) {
+        mouseInput->position.x = windowX;
+        mouseInput->position.y = windowY;
+    }
+}
+
+//===========================================
+// Game-required platform layer  functions
+//===========================================
+
+/*
+ * Asks the window manager to toggle the window's fullscreen state via the
+ * EWMH _NET_WM_STATE protocol.
+ */
+PLATFORM_TOGGLE_FULLSCREEN(platformToggleFullscreen)
+{
+    LinuxState *state = (LinuxState *)platformStateLinux;
+    Display *display = state->display;
+    Window window = *state->window;
+
+    Atom wmState = XInternAtom(display, "_NET_WM_STATE", False);
+    Atom wmStateFullscreen = XInternAtom(display, "_NET_WM_STATE_FULLSCREEN", False);
+
+    state->fullscreen = !state->fullscreen;
+
+    XEvent event = { 0 };
+    event.type = ClientMessage;
+    event.xclient.window = window;
+    event.xclient.message_type = wmState;
+    event.xclient.format = 32;
+    event.xclient.data.l[0] = (state->fullscreen ? 1 : 0); // _NET_WM_STATE_ADD : _NET_WM_STATE_REMOVE
+    event.xclient.data.l[1] = (long)wmStateFullscreen;
+    event.xclient.data.l[2] = 0;
+    event.xclient.data.l[3] = 1; // Normal application
+
+    XSendEvent(display,
+                XDefaultRootWindow(display),
+                False,
+                (SubstructureRedirectMask | SubstructureNotifyMask),
+                &event);
+}
+
+PLATFORM_CONTROLLER_VIBRATE(platformControllerVibrate)
+{
+    // @TODO(JM) Gamepad support
+}
+
+#if HANDMADE_LOCAL_BUILD
+
+DEBUG_PLATFORM_LOG(DEBUG_platformLog)
+{
+    va_list args;
+    va_start(args, format);
+
+    int res = vsnprintf(buffer, sizeOfBuffer, format, args);
+
+    va_end(args);
+
+    fputs(buffer, stderr);
+
+    return res;
+}
+
+#endif
+
+#ifdef HANDMADE_LIVE_LOOP_EDITING
+
+internal_func void linuxBeginInputRecording(LinuxState *linuxState)
+{
+    PlatformThreadContext thread = {0};
+
+    char filename[GAME_MAX_PATH] = {0};
+    int filenameLength = snprintf(filename, sizeof(filename), "%s%s", linuxState->absPath, LINUX_LOOP_RECORDING_FILENAME);
+
+    if ((filenameLength < 0) || ((sizet)filenameLength >= sizeof(filename))) {
+        fprintf(stderr, "The loop recording's path is too long\n");
+        return;
+    }
+
+    if (!linuxStartInputRecorder(&thread, &linuxState->loopRecorder, filename)) {
+        return;
+    }
+
+    // Only the committed parts of the game memory can have been written to
+    linuxCopyCommittedMemory(&linuxState->recordedStateReservation, &linuxState->gameMemoryReservation);
+
+    // From here on, note which pages the game writes to so that a loop
+    // restart only has to copy those back
+    linuxBeginWriteTracking(&linuxState->gameMemoryReservation);
+
+    linuxState->inputRecording = 1;
+}
+
+internal_func void linuxEndInputRecording(LinuxState *linuxState)
+{
+    PlatformThreadContext thread = {0};
+
+    if (!linuxStopInputRecorder(&thread, &linuxState->loopRecorder)) {
+        fprintf(stderr, "Not all of the loop recording could be written\n");
+    }
+
+    linuxState->inputRecording = 0;
+}
+
+internal_func void linuxRecordInput(LinuxState *linuxState, GameInput *gameInput)
+{
+    linuxRecordInputFrame(&linuxState->loopRecorder, gameInput);
+}
+
+internal_func void linuxBeginRecordingPlayback(LinuxState *linuxState)
+{
+    if (!linuxState->loopPlayback.mapping) {
+
+        char filename[GAME_MAX_PATH] = {0};
+        int filenameLength = snprintf(filename, sizeof(filename), "%s%s", linuxState->absPath, LINUX_LOOP_RECORDING_FILENAME);
+
+        if ((filenameLength < 0) || ((sizet)filenameLength >= sizeof(filename))) {
+            fprintf(stderr, "The loop recording's path is too long\n");
+            return;
+        }
+
+        if (!linuxOpenInputPlayback(&linuxState->loopPlayback, filename)) {
+            return;
+        }
+    }
+
+    inputRecordingDecoderRewind(&linuxState->loopPlayback.decoder);
+
+    // Put back the pages the game has written to since the recording started
+    // (or since the loop last restarted)
+    sizet restoredSizeInBytes = linuxRestoreDirtyMemory(&linuxState->gameMemoryReservation, &linuxState->recordedStateReservation);
+
+    // The game's idea of what's on screen has gone back with it
+    linuxState->frameBuffersInvalid = true;
+
+#if defined(HANDMADE_DEBUG_MEMORY)
+    fprintf(stderr, "Loop restart restored %.2f KiB of game memory\n", ((float64)restoredSizeInBytes / 1024.0));
+#endif
+
+    linuxState->inputPlayback = 1;
+}
+
+internal_func void linuxEndRecordingPlayback(LinuxState *linuxState)
+{
+    linuxState->inputPlayback = 0;
+}
+
+internal_func void linuxPlaybackInput(LinuxState *linuxState, GameInput *gameInput)
+{
+    if (inputRecordingDecodeFrame(&linuxState->loopPlayback.decoder, gameInput)) {
+        return;
+    }
+
+    // We have read all of the recorded input, loop back to the start...
+    linuxEndRecordingPlayback(linuxState);
+    linuxBeginRecordingPlayback(linuxState);
+
+    if (linuxState->inputPlayback) {
+        inputRecordingDecodeFrame(&linuxState->loopPlayback.decoder, gameInput);
+    }
+}
+#endif
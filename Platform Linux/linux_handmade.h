@@ -0,0 +1,330 @@
+#ifndef HEADER_LINUX
+#define HEADER_LINUX
+
+#define TARGET_FPS 30
+
+// How many samples per second does the audio output run at?
+#define LINUX_AUDIO_SAMPLES_PER_SECOND 48000
+
+// Name of the game's shared object and the copies that we actually load. We
+// load a copy so the compiler is free to overwrite the original whilst the
+// platform layer is running. There are two copies (slots) so that new code can
+// be loaded whilst the old code is still running.
+#define LINUX_GAME_SO_FILENAME "Game.so"
+#define LINUX_GAME_SO_COPY_FILENAME_FORMAT "Game_copy_%u.so"
+
+// Live loop recordings are streamed to this file within the build folder
+#define LINUX_LOOP_RECORDING_FILENAME "loop_recording.hmi"
+
+// Frame buffers used when presenting on the presenter thread. One is being
+// drawn into, one is being presented and one holds the newest finished frame.
+#define LINUX_PRESENT_BUFFER_COUNT 3
+
+// Set in LinuxPresenter.readyBuffer until the presenter has taken the buffer
+#define LINUX_PRESENT_BUFFER_FRESH 0x100
+
+// LinuxGameCodeReloader.stagedState values
+#define LINUX_STAGED_GAME_CODE_NONE     0x0
+#define LINUX_STAGED_GAME_CODE_READY    0x1
+#define LINUX_STAGED_GAME_CODE_SWAPPING 0x2
+
+/**
+ * Struct for the Linux (X11) screen buffer
+ */
+typedef struct LinuxFrameBuffer
+{
+    // The width in pixels of the buffer.
+    uint32 width;
+
+    // The height in pixels of the buffer.
+    uint32 height;
+
+    // 1 byte each for R, G & B and 1 byte for padding to match byte boundries (4)
+    // Therefore our pixels are always 32-bits wide and are in Little Endian
+    // memory order 0xPPRRGGBB
+    uint16 bytesPerPixel;
+
+    // The number of bytes per row. (width * bytesPerPixel)
+    uint32 byteWidthPerRow;
+
+    // X11 image that wraps (but doesn't own) the memory below
+    XImage *image;
+
+    // Pointer to an allocated block of memory to hold the data of the buffer.
+    void *memory;
+
+    // The main loop's frame number when the buffer was last drawn into. 0 if
+    // it never has been.
+    uint64 frameNumber;
+
+    // What the game changed in that frame, for presenting
+    FrameBufferDirtyRegion dirtyRegion;
+} LinuxFrameBuffer;
+
+/**
+ * Presents finished frames on a thread of its own so that the main loop can
+ * get on with the next frame. The frame buffers are handed over as a triple
+ * buffer. Each side swaps the index it's finished with for readyBuffer with
+ * a single atomic exchange, so neither thread ever waits on the other.
+ */
+typedef struct LinuxPresenter
+{
+    // The presenter's own connection to the X server. An Xlib connection
+    // can't be used from two threads without XInitThreads locking.
+    Display *display;
+    Window window;
+    GC gc;
+
+    pthread_t thread;
+
+    // Posted by the main loop each time it hands over a frame
+    sem_t frameReady;
+
+    LinuxFrameBuffer frameBuffers[LINUX_PRESENT_BUFFER_COUNT];
+
+    // The buffer being drawn into. Main loop only.
+    uint32 drawBuffer;
+
+    // The buffer last presented. Presenter thread only.
+    uint32 presentBuffer;
+
+    // The frame number of the frame on screen. Presenter thread only.
+    uint64 presentedFrameNumber;
+
+    // Set by the main loop when the whole window needs presenting again (E.g.
+    // it's been uncovered). Shared between both threads.
+    bool32 presentAll;
+
+    // The newest finished buffer, ORed with LINUX_PRESENT_BUFFER_FRESH until
+    // the presenter has taken it. Shared between both threads.
+    uint32 readyBuffer;
+
+    bool32 running;
+
+    uint64 framesPresented;
+
+    // Frames replaced by a newer frame before the presenter got to them
+    uint64 framesDropped;
+
+} LinuxPresenter;
+
+/**
+ * Helper struct for the X11 window dimensions. @see linuxGetClientDimensions
+ */
+typedef struct linuxClientDimensions
+{
+    uint32 width;
+    uint32 height;
+} linuxClientDimensions;
+
+typedef struct LinuxFixedFrameRate {
+
+    // Target FPS.
+    uint8 gameTargetFPS;
+
+    // Target FPS in milliseconds.
+    float32 gameTargetMSPerFrame;
+
+    // Target FPS in nanoseconds. Used to advance the absolute frame deadline.
+    int64 gameTargetNSPerFrame;
+
+    // The absolute CLOCK_MONOTONIC time at which the current frame should end.
+    // We sleep until this point with clock_nanosleep(TIMER_ABSTIME) so that
+    // any time lost waking up isn't carried into the following frame.
+    struct timespec frameDeadline;
+
+} LinuxFixedFrameRate;
+
+/**
+ * Watches for rebuilds of Game.so with inotify. New code is copied and loaded
+ * on the reload thread, so the main loop only has to swap function pointers.
+ */
+typedef struct LinuxGameCodeReloader
+{
+    char absPath[GAME_MAX_PATH];
+
+    pthread_t thread;
+    int inotifyFD;
+
+    // Code loaded by the reload thread, waiting to be swapped in by the main loop
+    GameCode staged;
+
+    // Which Game_copy_N.so the staged code was loaded from
+    uint32 stagedSlot;
+
+    // NONE, READY or SWAPPING. Shared between the main loop and the reload thread
+    int32 stagedState;
+
+    // Handle swapped out by the main loop, for the reload thread to dlclose
+    void *retiredHandle;
+
+} LinuxGameCodeReloader;
+
+typedef struct LinuxState
+{
+    char absPath[GAME_MAX_PATH];
+
+    uint64 gameMemorySize;
+    void *gameMemory;
+    LinuxMemoryReservation gameMemoryReservation;
+
+    Display *display;
+    Window *window;
+    Atom wmDeleteWindow;
+    bool8 fullscreen;
+
+    // Set when part of the window has been uncovered and needs presenting
+    bool8 windowExposed;
+
+    // Set when what's in the frame buffers can no longer be built upon (E.g.
+    // a loop restart has put back older game memory), so the next frame is
+    // drawn in full
+    bool8 frameBuffersInvalid;
+
+#if HANDMADE_LOCAL_BUILD
+    void *gameMemoryRecordedState;
+    LinuxMemoryReservation recordedStateReservation;
+    LinuxInputRecorder loopRecorder;
+    LinuxInputPlayback loopPlayback;
+    bool8 inputRecording;
+    bool8 inputPlayback;
+#endif
+
+} LinuxState;
+
+/*
+ * Sleeps until the frame's absolute deadline and then moves the deadline on
+ * by one frame. If we've fallen more than a frame behind, the deadline is
+ * re-based on the current time rather than trying to catch up.
+ */
+internal_func void linuxWaitForFrameDeadline(LinuxFixedFrameRate *fixedFrameRate);
+
+internal_func bool32 linuxInitFrameBuffer(PlatformThreadContext *thread,
+                                            Display *display,
+                                            Visual *visual,
+                                            LinuxFrameBuffer *buffer,
+                                            uint32 width,
+                                            uint32 height);
+
+/*
+ * @param display           The X11 display connection
+ * @param window            The window to draw into
+ * @param gc                The window's graphics context
+ * @param buffer            The game's filled frame buffer
+ * @param region            The parts of the buffer to copy, when the window
+ *                          already shows the frame before it. NULL for all of it.
+ */
+internal_func void linuxDisplayFrameBuffer(Display *display,
+                                            Window window,
+                                            GC gc,
+                                            LinuxFrameBuffer *buffer,
+                                            FrameBufferDirtyRegion *region,
+                                            uint32 clientWindowWidth,
+                                            uint32 clientWindowHeight);
+
+internal_func linuxClientDimensions linuxGetClientDimensions(Display *display, Window window);
+
+/**
+ * @brief Opens the presenter's X connection, allocates its frame buffers and
+ * starts the presenter thread
+ *
+ * @return false if any of it fails. The main loop then presents serially.
+*/
+internal_func bool32 linuxStartPresenter(PlatformThreadContext *thread,
+                                            LinuxPresenter *presenter,
+                                            Display *display,
+                                            Visual *visual,
+                                            Window window,
+                                            uint32 width,
+                                            uint32 height);
+
+internal_func void *linuxPresenterThread(void *param);
+
+/**
+ * @brief The frame buffer for the main loop to draw the next frame into
+*/
+internal_func LinuxFrameBuffer *linuxPresenterDrawBuffer(LinuxPresenter *presenter);
+
+/**
+ * @brief Hands the frame drawn into linuxPresenterDrawBuffer over to the
+ * presenter thread and takes back a free buffer for the next frame
+*/
+internal_func void linuxSubmitFrameToPresenter(LinuxPresenter *presenter);
+
+internal_func void linuxStopPresenter(LinuxPresenter *presenter);
+
+/**
+ * @brief Loads game code from the shared object
+ *
+ * @param absPath Absolute path to the folder that contains game's main executeable
+ * @param gameCode
+ * @return void
+*/
+internal_func void linuxLoadGameSOFunctions(const char *absPath, GameCode *gameCode);
+
+#ifdef HANDMADE_LIVE_LOOP_EDITING
+
+/**
+ * @brief Starts the thread that watches for and loads new game code
+ *
+ * @return false if the directory can't be watched. The game keeps running the
+ * code it started with.
+*/
+internal_func bool32 linuxStartGameCodeReloader(LinuxGameCodeReloader *reloader, const char *absPath);
+
+internal_func void *linuxGameCodeReloaderThread(void *param);
+
+/**
+ * @brief Copies Game.so to the free slot and loads it. Runs on the reload thread.
+*/
+internal_func void linuxStageGameCode(LinuxGameCodeReloader *reloader);
+
+/**
+ * @brief Swaps in the staged game code, if there is any. Called once per frame
+ * by the main loop.
+*/
+internal_func void linuxSwapStagedGameCode(LinuxGameCodeReloader *reloader, GameCode *gameCode);
+
+#endif
+
+internal_func void linuxProcessMessages(Display *display,
+                                        GameInput *gameInput,
+                                        GameInput oldGameInput,
+                                        LinuxState *linuxState);
+
+/*
+ * Logs how much of the game's memory is reserved, committed and resident
+ */
+internal_func void linuxLogMemoryUsage(LinuxMemoryReservation *reservation);
+
+internal_func void linuxGetMousePosition(Display *display, Window window, GameMouseInput *mouseInput);
+
+//===========================================
+// Game-required platform layer signatures
+//===========================================
+PLATFORM_TOGGLE_FULLSCREEN(platformToggleFullscreen);
+PLATFORM_CONTROLLER_VIBRATE(platformControllerVibrate);
+
+#if HANDMADE_LOCAL_BUILD
+
+DEBUG_PLATFORM_LOG(DEBUG_platformLog);
+
+#endif
+
+#ifdef HANDMADE_LIVE_LOOP_EDITING
+
+internal_func void linuxBeginInputRecording(LinuxState *linuxState);
+
+internal_func void linuxEndInputRecording(LinuxState *linuxState);
+
+internal_func void linuxRecordInput(LinuxState *linuxState, GameInput *inputNewInstance);
+
+internal_func void linuxBeginRecordingPlayback(LinuxState *linuxState);
+
+internal_func void linuxEndRecordingPlayback(LinuxState *linuxState);
+
+internal_func void linuxPlaybackInput(LinuxState *linuxState, GameInput *inputNewInstance);
+
+#endif
+
+#endif
@@ -0,0 +1,781 @@
+// POSIX/Linux APIs
+#include <dlfcn.h>      // dlopen, dlsym for loading the game code
+#include <errno.h>      // EINTR
+#include <fcntl.h>      // open
+#include <pthread.h>    // Input recorder writer, audio and worker threads
+#include <sched.h>      // sched_yield, pthread_setschedparam
+#include <semaphore.h>  // Waking the audio and worker threads
+#include <signal.h>     // sigaction for tracking writes to game memory
+#include <stdarg.h>     // va_list
+#include <stdio.h>      // fprintf, fopen, vsnprintf
+#include <stdlib.h>     // qsort, strtoul, getenv
+#include <string.h>     // memcpy, strcmp, strtok
+#include <sys/mman.h>   // mmap, munmap
+#include <sys/stat.h>   // stat, fstat
+#include <time.h>       // clock_gettime
+#include <unistd.h>     // read, write, readlink, sysconf
+#include <x86intrin.h>  // __rdtsc
+
+#include "../Game/global.h" // Game layer specific function signatures
+#include "../Game/input_recording.h" // Compressed input recordings
+#include "../Game/audio_ring_buffer.h" // Hands audio to the audio thread
+#include "../Game/work_queue.h" // Shares work out over the worker threads
+#include "linux_common.h" // Platform services shared with the platform layer
+#include "linux_audio.h" // Audio output shared with the platform layer
+#include "linux_work_queue.h" // Worker threads shared with the platform layer
+#include "linux_headless.h" // Headless runner specific function signatures
+
+#include "../Game/global_utility.cpp"
+#include "../Game/input_recording.cpp"
+#include "../Game/audio_ring_buffer.cpp"
+#include "../Game/work_queue.cpp"
+#include "linux_common.cpp"
+#include "linux_audio.cpp"
+#include "linux_work_queue.cpp"
+
+/*
+ * The headless runner calls into the game layer exactly as the platform layer
+ * does, but with no window, no audio device and a fixed frame time, so the
+ * same input always produces the same frames. Input comes from a script, from
+ * a previous --record, or is left idle. The game's audio is discarded unless
+ * --audio-wav is given.
+ *
+ * Usage: handmade_headless [--frames N] [--script file] [--input file]
+ *                          [--record file] [--frames-csv file] [--game file]
+ *                          [--audio-wav file] [--resolution-scale N]
+ *                          [--upscale-nearest] [--full-redraw] [--verbose]
+ */
+
+// Script button names. A step's button bits map to this order.
+global_var const char *headlessScriptButtonNames[] = {
+    "dPadUp",
+    "dPadDown",
+    "dPadLeft",
+    "dPadRight",
+    "up",
+    "down",
+    "shoulderL1",
+    "shoulderR1",
+    "option1",
+};
+
+global_var bool8 headlessVerbose = false;
+
+internal_func int headlessCompareFloat32(const void *a, const void *b)
+{
+    float32 x = *(const float32 *)a;
+    float32 y = *(const float32 *)b;
+    return ((x > y) - (x < y));
+}
+
+internal_func int headlessCompareUint64(const void *a, const void *b)
+{
+    uint64 x = *(const uint64 *)a;
+    uint64 y = *(const uint64 *)b;
+    return ((x > y) - (x < y));
+}
+
+int main(int argc, char **argv)
+{
+    HeadlessOptions options = { 0 };
+
+    if (!headlessParseOptions(argc, argv, &options)) {
+        fprintf(stderr,
+                "Usage: %s [--frames N] [--script file] [--input file] [--record file] [--frames-csv file] [--game file] [--audio-wav file] [--resolution-scale N] [--upscale-nearest] [--full-redraw] [--verbose]\n",
+                argv[0]);
+        return 1;
+    }
+
+    headlessVerbose = options.verbose;
+
+    PlatformThreadContext thread = { 0 };
+
+    char absPath[GAME_MAX_PATH] = { 0 };
+    linuxGetAbsolutePath(absPath);
+
+    char gameSOFilePath[GAME_MAX_PATH] = { 0 };
+    int gameSOFilePathLength;
+    if (options.gameSOPath) {
+        gameSOFilePathLength = snprintf(gameSOFilePath, sizeof(gameSOFilePath), "%s", options.gameSOPath);
+    } else {
+        gameSOFilePathLength = snprintf(gameSOFilePath, sizeof(gameSOFilePath), "%s%s", absPath, HEADLESS_GAME_SO_FILENAME);
+    }
+
+    if ((gameSOFilePathLength < 0) || ((sizet)gameSOFilePathLength >= sizeof(gameSOFilePath))) {
+        fprintf(stderr, "The game code's path is too long\n");
+        return 1;
+    }
+
+    GameCode gameCode = { 0 };
+    if (!headlessLoadGameSOFunctions(gameSOFilePath, &gameCode)) {
+        return 1;
+    }
+
+    /*
+     * Input
+     */
+    HeadlessScript *script = NULL;
+
+    if (options.scriptPath) {
+        script = (HeadlessScript *)platformAllocateMemory(&thread, 0, sizeof(HeadlessScript));
+        if (!script || !headlessLoadScript(options.scriptPath, script)) {
+            return 1;
+        }
+    }
+
+    // Recorded input is a compressed recording (see input_recording.h), as
+    // written by --record or by live loop recording. It's mapped rather than read.
+    LinuxInputPlayback recordedInput = { 0 };
+    uint32 recordedInputFrames = 0;
+
+    if (options.inputPath) {
+
+        if (linuxOpenInputPlayback(&recordedInput, options.inputPath)) {
+            recordedInputFrames = (uint32)inputRecordingCountFrames(&recordedInput.decoder);
+        }
+
+        if (0 == recordedInputFrames) {
+            fprintf(stderr, "No recorded input in %s\n", options.inputPath);
+            return 1;
+        }
+    }
+
+    uint32 frames = options.frames;
+    if (0 == frames) {
+        if (recordedInputFrames) {
+            frames = recordedInputFrames;
+        } else if (script) {
+            frames = script->totalFrames;
+
+            if (0 == frames) {
+                fprintf(stderr, "No frames in script %s\n", options.scriptPath);
+                return 1;
+            }
+        } else {
+            frames = HEADLESS_DEFAULT_FRAMES;
+        }
+    }
+
+    LinuxInputRecorder recorder = { 0 };
+    if (options.recordPath) {
+        if (!linuxStartInputRecorder(&thread, &recorder, options.recordPath)) {
+            return 1;
+        }
+    }
+
+    /*
+     * Game memory
+     */
+#if HANDMADE_LOCAL_BUILD
+    uint64 memoryStartAddress = utilTebibyteToBytes(4);
+#else
+    uint64 memoryStartAddress = 0;
+#endif
+
+    sizet permanentStorageSizeInBytes = utilGibibytesToBytes(1);
+    sizet transientStorageSizeInBytes = utilMebibytesToBytes(64);
+
+    sizet memoryTotalSize = (permanentStorageSizeInBytes + transientStorageSizeInBytes);
+
+    LinuxMemoryReservation gameMemoryReservation = {0};
+
+    void *platformMemory = linuxReserveMemory(&thread, &gameMemoryReservation, memoryStartAddress, memoryTotalSize);
+    linuxGameMemoryReservation = &gameMemoryReservation;
+
+    if (!platformMemory) {
+        fprintf(stderr, "Error allocating game memory. Unable to run game\n");
+        return 1;
+    }
+
+    GameMemory memory = {0};
+
+    memory.permanentStorage.bytes = platformMemory;
+    memory.permanentStorage.sizeInBytes = permanentStorageSizeInBytes;
+    memory.permanentStorage.bytesUsed = 0;
+    memory.permanentStorage.bytesFree = permanentStorageSizeInBytes;
+
+    memory.transientStorage.bytes = ((uint8 *)platformMemory + permanentStorageSizeInBytes);
+    memory.transientStorage.sizeInBytes = transientStorageSizeInBytes;
+    memory.transientStorage.bytesUsed = 0;
+    memory.transientStorage.bytesFree = transientStorageSizeInBytes;
+
+#if defined(HANDMADE_COMMIT_MEMORY_ON_DEMAND)
+    memory.permanentStorage.platformCommitMemory = &platformCommitMemory;
+    memory.transientStorage.platformCommitMemory = &platformCommitMemory;
+#endif
+
+    memory.platformAllocateMemory = &platformAllocateMemory;
+    memory.platformFreeMemory = &platformFreeMemory;
+    memory.platformControllerVibrate = &platformControllerVibrate;
+    memory.platformToggleFullscreen = &platformToggleFullscreen;
+
+    // Frame times vary from run to run, so the resolution is only ever the
+    // one asked for (full by default) and the frames stay repeatable
+    memory.fixedResolutionScale = options.resolutionScale;
+    memory.upscaleNearest = options.upscaleNearest;
+
+    int absPathLength = snprintf(memory.platformAbsPath, sizeof(memory.platformAbsPath), "%s", absPath);
+
+    if ((absPathLength < 0) || ((sizet)absPathLength >= sizeof(memory.platformAbsPath))) {
+        fprintf(stderr, "The executable's path is too long\n");
+        return 1;
+    }
+
+    // Worker threads for the renderer. The main thread works alongside them.
+    PlatformWorkQueue *renderQueue = (PlatformWorkQueue *)platformAllocateMemory(&thread, 0, sizeof(PlatformWorkQueue));
+
+    if (renderQueue && linuxStartWorkQueue(renderQueue, linuxGetWorkerThreadCount())) {
+        memory.renderQueue = renderQueue;
+    } else {
+        fprintf(stderr, "Unable to start the worker threads. Drawing on the main thread\n");
+        platformFreeMemory(&thread, renderQueue);
+    }
+
+    memory.platformAddWorkQueueEntry = &platformAddWorkQueueEntry;
+    memory.platformCompleteAllWork = &platformCompleteAllWork;
+
+#if HANDMADE_LOCAL_BUILD
+    memory.DEBUG_platformLog = &DEBUG_platformLog;
+    memory.DEBUG_platformReadEntireFile = &DEBUG_platformReadEntireFile;
+    memory.DEBUG_platformWriteEntireFile = &DEBUG_platformWriteEntireFile;
+    memory.DEBUG_platformFreeFileMemory = &DEBUG_platformFreeFileMemory;
+#endif
+
+    /*
+     * Audio. Written by the game and discarded, or with --audio-wav, handed
+     * to an audio thread that writes every frame's samples to a WAV file.
+     */
+    uint8 audioBytesPerSample = (sizeof(int16) * 2);
+    uint32 audioBufferSizeInBytes = (HEADLESS_AUDIO_SAMPLES_PER_SECOND * audioBytesPerSample);
+    uint32 audioBytesPerFrame = ((HEADLESS_AUDIO_SAMPLES_PER_SECOND / TARGET_FPS) * audioBytesPerSample);
+
+    GameAudioBuffer gameAudioBuffer = {0};
+    gameAudioBuffer.writeEntireBuffer = false;
+    gameAudioBuffer.minFramesWorthOfAudio = 1;
+
+    LinuxAudioOutput audioOutput = {0};
+
+    // The WAV couldn't be written. The run carries on, but fails.
+    bool32 audioFailed = false;
+
+    if (options.audioWavPath) {
+        if (!linuxStartAudioOutput(&thread, &audioOutput, LINUX_AUDIO_SINK_WAV, options.audioWavPath, HEADLESS_AUDIO_SAMPLES_PER_SECOND)) {
+            fprintf(stderr, "Cannot open %s for writing\n", options.audioWavPath);
+            return 1;
+        }
+    }
+
+    /*
+     * Graphics. An in-memory frame buffer with the same layout as the platform layer's.
+     */
+    uint16 bytesPerPixel = 4;
+    uint32 byteWidthPerRow = (FRAME_BUFFER_PIXEL_WIDTH * bytesPerPixel);
+    void *frameBufferMemory = platformAllocateMemory(&thread, 0, (byteWidthPerRow * FRAME_BUFFER_PIXEL_HEIGHT));
+
+    if (!frameBufferMemory) {
+        fprintf(stderr, "Error allocating the frame buffer. Unable to run game\n");
+        return 1;
+    }
+
+    /*
+     * Controllers. Keyboard only.
+     */
+    ControllerCounts controllerCounts = {0};
+    controllerCounts.gameMaxControllers = MAX_CONTROLLERS;
+    controllerCounts.platformMaxControllers = 0;
+    controllerCounts.connectedControllers = 1;
+
+    GameInput GameInputInstances[2] = {0};
+    GameInput *gameInput        = &GameInputInstances[0];
+    GameInput *gameInputOld     = &GameInputInstances[1];
+
+    /*
+     * Stats
+     */
+    HeadlessFrameStats *stats = (HeadlessFrameStats *)platformAllocateMemory(&thread, 0, (sizeof(HeadlessFrameStats) * frames));
+    float32 *sortedFrameMS = (float32 *)platformAllocateMemory(&thread, 0, (sizeof(float32) * frames));
+    uint64 *sortedCycles = (uint64 *)platformAllocateMemory(&thread, 0, (sizeof(uint64) * frames));
+
+    if (!stats || !sortedFrameMS || !sortedCycles) {
+        fprintf(stderr, "Error allocating memory for frame stats\n");
+        return 1;
+    }
+
+    // Running hash of every frame's hash, so two runs can be compared with one number.
+    uint64 runHash = 0xcbf29ce484222325ULL;
+
+    /**
+     * MAIN LOOP
+     */
+    for (uint32 frameIndex = 0; frameIndex < frames; frameIndex++) {
+
+        if (recordedInputFrames) {
+
+            // Loop the recording if we've been asked for more frames than it holds
+            if (!inputRecordingDecodeFrame(&recordedInput.decoder, gameInput)) {
+                inputRecordingDecoderRewind(&recordedInput.decoder);
+                inputRecordingDecodeFrame(&recordedInput.decoder, gameInput);
+            }
+
+        } else {
+
+            gameInput->controllers[0].isConnected = 1;
+
+            if (script) {
+                headlessApplyScript(script, frameIndex, gameInput, gameInputOld);
+            }
+
+            // A fixed frame time keeps the simulation independent of how long
+            // the frame actually took to run.
+            gameInput->targetFPS = TARGET_FPS;
+            gameInput->fps = (float32)TARGET_FPS;
+            gameInput->msPerFrame = (1000.0f / (float32)TARGET_FPS);
+        }
+
+        if (options.recordPath) {
+            linuxRecordInputFrame(&recorder, gameInput);
+        }
+
+        struct timespec frameStart = linuxGetTime();
+
+        gameCode.gameInitAudioBuffer(&thread,
+                                        &memory,
+                                        &gameAudioBuffer,
+                                        audioBytesPerFrame,
+                                        audioBytesPerSample,
+                                        audioBufferSizeInBytes);
+
+        GameFrameBuffer gameFrameBuffer = {0};
+
+        gameCode.gameInitFrameBuffer(&thread,
+                                        &gameFrameBuffer,
+                                        FRAME_BUFFER_PIXEL_HEIGHT,
+                                        FRAME_BUFFER_PIXEL_WIDTH,
+                                        bytesPerPixel,
+                                        byteWidthPerRow,
+                                        frameBufferMemory);
+
+        // There's only the one frame buffer, so it holds the last frame.
+        // --full-redraw has every frame drawn from scratch, which must hash
+        // the same.
+        if ((frameIndex > 0) && !options.fullRedraw) {
+            gameFrameBuffer.age = 1;
+        }
+
+        // @NOTE(JM) __rdtsc is only for dev and not for relying on for shipped code
+        uint64 cyclesBefore = __rdtsc();
+
+        gameCode.gameUpdate(&thread,
+                            NULL,
+                            NULL,
+                            NULL,
+                            &memory,
+                            &gameFrameBuffer,
+                            &gameAudioBuffer,
+                            GameInputInstances,
+                            &controllerCounts);
+
+        uint64 cyclesAfter = __rdtsc();
+
+        struct timespec frameEnd = linuxGetTime();
+
+        if (options.audioWavPath && !audioFailed) {
+            if (!linuxSubmitAudio(&audioOutput, gameAudioBuffer.memory, gameAudioBuffer.noOfSamplesToWrite)) {
+                fprintf(stderr, "Not all of the audio could be written to %s\n", options.audioWavPath);
+                audioFailed = true;
+            }
+        }
+
+        HeadlessFrameStats *frameStats = &stats[frameIndex];
+        frameStats->frameMS = linuxGetElapsedTimeMS(frameStart, frameEnd);
+        frameStats->gameUpdateCycles = (cyclesAfter - cyclesBefore);
+        frameStats->frameHash = headlessHashFrameBuffer(&gameFrameBuffer);
+        frameStats->dirtyPixels = headlessDirtyPixels(&gameFrameBuffer);
+        frameStats->drawnPixels = ((uint64)gameFrameBuffer.drawnWidthPx * gameFrameBuffer.drawnHeightPx);
+
+        runHash = ((runHash ^ frameStats->frameHash) * 0x100000001b3ULL);
+
+        sortedFrameMS[frameIndex] = frameStats->frameMS;
+        sortedCycles[frameIndex] = frameStats->gameUpdateCycles;
+
+        *gameInputOld = *gameInput;
+    }
+
+    if (options.recordPath) {
+        if (!linuxStopInputRecorder(&thread, &recorder)) {
+            fprintf(stderr, "Not all of the recording could be written to %s\n", options.recordPath);
+        }
+    }
+
+    linuxCloseInputPlayback(&recordedInput);
+
+    if (options.audioWavPath) {
+        linuxStopAudioOutput(&thread, &audioOutput);
+    }
+
+    if (memory.renderQueue) {
+        linuxStopWorkQueue(memory.renderQueue);
+    }
+
+    /*
+     * Report
+     */
+    if (0 == frames) {
+        fprintf(stderr, "No frames were run\n");
+        return 1;
+    }
+
+    if (options.framesCSVPath) {
+
+        FILE *csv = fopen(options.framesCSVPath, "w");
+
+        if (csv) {
+            fprintf(csv, "frame,frame_ms,game_update_cycles,frame_hash,dirty_pixels\n");
+            for (uint32 frameIndex = 0; frameIndex < frames; frameIndex++) {
+                fprintf(csv,
+                        "%u,%.4f,%llu,%016llx,%llu\n",
+                        frameIndex,
+                        stats[frameIndex].frameMS,
+                        (unsigned long long)stats[frameIndex].gameUpdateCycles,
+                        (unsigned long long)stats[frameIndex].frameHash,
+                        (unsigned long long)stats[frameIndex].dirtyPixels);
+            }
+            fclose(csv);
+        } else {
+            fprintf(stderr, "Cannot open %s for writing\n", options.framesCSVPath);
+        }
+    }
+
+    qsort(sortedFrameMS, frames, sizeof(float32), headlessCompareFloat32);
+    qsort(sortedCycles, frames, sizeof(uint64), headlessCompareUint64);
+
+    uint64 totalCycles = 0;
+    uint64 totalDirtyPixels = 0;
+    uint64 totalDrawnPixels = 0;
+    for (uint32 frameIndex = 0; frameIndex < frames; frameIndex++) {
+        totalCycles += sortedCycles[frameIndex];
+        totalDirtyPixels += stats[frameIndex].dirtyPixels;
+        totalDrawnPixels += stats[frameIndex].drawnPixels;
+    }
+
+    // One "key value" pair per line so the output can be diffed or parsed by scripts
+    printf("frames %u\n", frames);
+    printf("frame_ms_p50 %.4f\n", headlessPercentile(sortedFrameMS, frames, 50.0f));
+    printf("frame_ms_p95 %.4f\n", headlessPercentile(sortedFrameMS, frames, 95.0f));
+    printf("frame_ms_p99 %.4f\n", headlessPercentile(sortedFrameMS, frames, 99.0f));
+    printf("frame_ms_max %.4f\n", sortedFrameMS[frames - 1]);
+    printf("game_update_cycles_p50 %llu\n", (unsigned long long)sortedCycles[((frames - 1) / 2)]);
+    printf("game_update_cycles_max %llu\n", (unsigned long long)sortedCycles[frames - 1]);
+    printf("game_update_cycles_mean %llu\n", (unsigned long long)(totalCycles / frames));
+    printf("last_frame_hash %016llx\n", (unsigned long long)stats[frames - 1].frameHash);
+    printf("run_hash %016llx\n", (unsigned long long)runHash);
+    printf("dirty_pixels_mean %llu\n", (unsigned long long)(totalDirtyPixels / frames));
+    printf("drawn_pixels_mean %llu\n", (unsigned long long)(totalDrawnPixels / frames));
+    printf("memory_reserved_bytes %llu\n", (unsigned long long)gameMemoryReservation.sizeInBytes);
+    printf("memory_committed_bytes %llu\n", (unsigned long long)gameMemoryReservation.committedSizeInBytes);
+    printf("memory_huge_page_bytes %llu\n", (unsigned long long)gameMemoryReservation.hugePageSizeInBytes);
+    printf("memory_resident_bytes %llu\n", (unsigned long long)linuxGetResidentMemorySize(&gameMemoryReservation));
+
+    if (options.audioWavPath) {
+        printf("audio_frames_written %llu\n", (unsigned long long)audioOutput.sink.framesWritten);
+        printf("audio_dropped_frames %llu\n", (unsigned long long)audioOutput.ring.droppedFrames);
+    }
+
+    return (audioFailed ? 1 : 0);
+}
+
+internal_func bool32 headlessParseOptions(int argc, char **argv, HeadlessOptions *options)
+{
+    for (int i = 1; i < argc; i++) {
+
+        const char *arg = argv[i];
+        const char *value = ((i + 1) < argc) ? argv[i + 1] : NULL;
+
+        if (0 == strcmp(arg, "--verbose")) {
+            options->verbose = true;
+            continue;
+        }
+
+        if (0 == strcmp(arg, "--full-redraw")) {
+            options->fullRedraw = true;
+            continue;
+        }
+
+        if (0 == strcmp(arg, "--upscale-nearest")) {
+            options->upscaleNearest = true;
+            continue;
+        }
+
+        if (!value) {
+            return false;
+        }
+
+        if (0 == strcmp(arg, "--frames")) {
+            char *end = NULL;
+            options->frames = (uint32)strtoul(value, &end, 10);
+
+            // Only digits
+            if ((value[0] < '0') || (value[0] > '9') || (*end != '\0')) {
+                return false;
+            }
+        } else if (0 == strcmp(arg, "--script")) {
+            options->scriptPath = value;
+        } else if (0 == strcmp(arg, "--input")) {
+            options->inputPath = value;
+        } else if (0 == strcmp(arg, "--record")) {
+            options->recordPath = value;
+        } else if (0 == strcmp(arg, "--frames-csv")) {
+            options->framesCSVPath = value;
+        } else if (0 == strcmp(arg, "--game")) {
+            options->gameSOPath = value;
+        } else if (0 == strcmp(arg, "--audio-wav")) {
+            options->audioWavPath = value;
+        } else if (0 == strcmp(arg, "--resolution-scale")) {
+            options->resolutionScale = (uint32)strtoul(value, NULL, 10);
+        } else {
+            return false;
+        }
+
+        i++;
+    }
+
+    // Script and recorded input are mutually exclusive
+    if (options->scriptPath && options->inputPath) {
+        return false;
+    }
+
+    return true;
+}
+
+internal_func bool32 headlessLoadGameSOFunctions(const char *absPathToSO, GameCode *gameCode)
+{
+    void *libHandle = dlopen(absPathToSO, RTLD_NOW | RTLD_LOCAL);
+
+    if (!libHandle) {
+        fprintf(stderr, "Unable to load game code: %s\n", dlerror());
+        return false;
+    }
+
+    gameCode->dllHandle = libHandle;
+    gameCode->gameUpdate = (GameUpdate *)dlsym(libHandle, "gameUpdate");
+    gameCode->gameInitFrameBuffer = (GameInitFrameBuffer *)dlsym(libHandle, "gameInitFrameBuffer");
+    gameCode->gameInitAudioBuffer = (GameInitAudioBuffer *)dlsym(libHandle, "gameInitAudioBuffer");
+
+    if (!gameCode->gameUpdate || !gameCode->gameInitFrameBuffer || !gameCode->gameInitAudioBuffer) {
+        fprintf(stderr, "Game code is missing exported functions\n");
+        return false;
+    }
+
+    return true;
+}
+
+internal_func bool32 headlessLoadScript(const char *filename, HeadlessScript *script)
+{
+    FILE *file = fopen(filename, "r");
+
+    if (!file) {
+        fprintf(stderr, "Cannot read script %s\n", filename);
+        return false;
+    }
+
+    script->stepCount = 0;
+    script->totalFrames = 0;
+
+    char line[512];
+    uint32 lineNumber = 0;
+
+    while (fgets(line, sizeof(line), file)) {
+
+        lineNumber++;
+
+        char *token = strtok(line, " \t\r\n");
+
+        // Blank line or comment
+        if (!token || (token[0] == '#')) {
+            continue;
+        }
+
+        if (script->stepCount >= HEADLESS_MAX_SCRIPT_STEPS) {
+            fprintf(stderr, "Script %s has more than %u steps\n", filename, HEADLESS_MAX_SCRIPT_STEPS);
+            fclose(file);
+            return false;
+        }
+
+        HeadlessScriptStep *step = &script->steps[script->stepCount];
+        step->frames = (uint32)strtoul(token, NULL, 10);
+        step->buttons = 0;
+
+        while ((token = strtok(NULL, " \t\r\n"))) {
+
+            uint32 buttonIndex = 0;
+            uint32 buttonCount = (sizeof(headlessScriptButtonNames) / sizeof(headlessScriptButtonNames[0]));
+
+            for (; buttonIndex < buttonCount; buttonIndex++) {
+                if (0 == strcmp(token, headlessScriptButtonNames[buttonIndex])) {
+                    break;
+                }
+            }
+
+            if (buttonIndex == buttonCount) {
+                fprintf(stderr, "%s:%u: unknown button %s\n", filename, lineNumber, token);
+                fclose(file);
+                return false;
+            }
+
+            step->buttons |= (1 << buttonIndex);
+        }
+
+        script->totalFrames += step->frames;
+        script->stepCount++;
+    }
+
+    fclose(file);
+
+    return true;
+}
+
+internal_func void headlessApplyScript(HeadlessScript *script,
+                                        uint32 frameIndex,
+                                        GameInput *gameInput,
+                                        GameInput *oldGameInput)
+{
+    // Which step are we on? Past the end of the script all buttons are released.
+    uint32 buttons = 0;
+    uint32 stepStartFrame = 0;
+
+    for (uint32 i = 0; i < script->stepCount; i++) {
+        if (frameIndex < (stepStartFrame + script->steps[i].frames)) {
+            buttons = script->steps[i].buttons;
+            break;
+        }
+        stepStartFrame += script->steps[i].frames;
+    }
+
+    GameControllerInput *controller = &gameInput->controllers[0];
+    GameControllerInput *oldController = &oldGameInput->controllers[0];
+
+    // Same order as headlessScriptButtonNames
+    GameControllerBtnState *states[] = {
+        &controller->dPadUp,
+        &controller->dPadDown,
+        &controller->dPadLeft,
+        &controller->dPadRight,
+        &controller->up,
+        &controller->down,
+        &controller->shoulderL1,
+        &controller->shoulderR1,
+        &controller->option1,
+    };
+
+    GameControllerBtnState *oldStates[] = {
+        &oldController->dPadUp,
+        &oldController->dPadDown,
+        &oldController->dPadLeft,
+        &oldController->dPadRight,
+        &oldController->up,
+        &oldController->down,
+        &oldController->shoulderL1,
+        &oldController->shoulderR1,
+        &oldController->option1,
+    };
+
+    for (uint32 i = 0; i < (sizeof(states) / sizeof(states[0])); i++) {
+        states[i]->wasDown = oldStates[i]->endedDown;
+        states[i]->endedDown = ((buttons >> i) & 1);
+    }
+}
+
+internal_func uint64 headlessHashFrameBuffer(GameFrameBuffer *frameBuffer)
+{
+    uint64 hash = 0xcbf29ce484222325ULL;
+
+    for (uint32 row = 0; row < frameBuffer->heightPx; row++) {
+
+        uint8 *rowStart = ((uint8 *)frameBuffer->memory + (row * frameBuffer->byteWidthPerRow));
+        uint32 rowBytes = (frameBuffer->widthPx * frameBuffer->bytesPerPixel);
+
+        // Rows are always a multiple of 8 bytes wide with 4 byte pixels and
+        // an even width. Any remaining bytes are hashed one at a time.
+        uint64 *words = (uint64 *)rowStart;
+        uint32 wordCount = (rowBytes / sizeof(uint64));
+
+        for (uint32 i = 0; i < wordCount; i++) {
+            hash = ((hash ^ words[i]) * 0x100000001b3ULL);
+        }
+
+        for (uint32 i = (wordCount * sizeof(uint64)); i < rowBytes; i++) {
+            hash = ((hash ^ rowStart[i]) * 0x100000001b3ULL);
+        }
+    }
+
+    return hash;
+}
+
+internal_func uint64 headlessDirtyPixels(GameFrameBuffer *frameBuffer)
+{
+    FrameBufferDirtyRegion *region = &frameBuffer->dirtyRegion;
+
+    if (region->all) {
+        return ((uint64)frameBuffer->widthPx * frameBuffer->heightPx);
+    }
+
+    uint64 pixels = 0;
+
+    for (uint32 i = 0; i < region->rectCount; i++) {
+        FrameBufferRect *rect = &region->rects[i];
+        pixels += ((uint64)(rect->maxX - rect->minX) * (uint64)(rect->maxY - rect->minY));
+    }
+
+    return pixels;
+}
+
+internal_func float32 headlessPercentile(float32 *sortedValues, uint32 count, float32 percentile)
+{
+    // Nearest-rank: the smallest value that at least percentile% of values are <= to
+    uint32 rank = (uint32)((percentile / 100.0f) * (float32)count + 0.999999f);
+
+    if (rank < 1) {
+        rank = 1;
+    }
+
+    if (rank > count) {
+        rank = count;
+    }
+
+    return sortedValues[rank - 1];
+}
+
+//===========================================
+// Game-required platform layer  functions
+//===========================================
+
+PLATFORM_TOGGLE_FULLSCREEN(platformToggleFullscreen)
+{
+    // No window to toggle
+}
+
+PLATFORM_CONTROLLER_VIBRATE(platformControllerVibrate)
+{
+    // No controllers to vibrate
+}
+
+#if HANDMADE_LOCAL_BUILD
+
+DEBUG_PLATFORM_LOG(DEBUG_platformLog)
+{
+    va_list args;
+    va_start(args, format);
+
+    int res = vsnprintf(buffer, sizeOfBuffer, format, args);
+
+    va_end(args);
+
+    // The game logs every frame. Keep the report readable unless asked.
+    if (headlessVerbose) {
+        fputs(buffer, stderr);
+    }
+
+    return res;
+}
+
+#endif
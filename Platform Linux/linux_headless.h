@@ -0,0 +1,125 @@
+#ifndef HEADER_LINUX_HEADLESS
+#define HEADER_LINUX_HEADLESS
+
+#define TARGET_FPS 30
+
+#define HEADLESS_AUDIO_SAMPLES_PER_SECOND 48000
+
+#define HEADLESS_GAME_SO_FILENAME "Game.so"
+
+// How many frames are run when no frame count or recording is given
+#define HEADLESS_DEFAULT_FRAMES 600
+
+// Maximum number of lines within an input script
+#define HEADLESS_MAX_SCRIPT_STEPS 1024
+
+/**
+ * A single line of an input script. Holds the given buttons down for a number
+ * of frames. Button bits map to the order of headlessScriptButtonNames.
+ */
+typedef struct HeadlessScriptStep
+{
+    uint32 frames;
+    uint32 buttons;
+} HeadlessScriptStep;
+
+typedef struct HeadlessScript
+{
+    HeadlessScriptStep steps[HEADLESS_MAX_SCRIPT_STEPS];
+    uint32 stepCount;
+    uint32 totalFrames;
+} HeadlessScript;
+
+/**
+ * Everything we measured for a single frame.
+ */
+typedef struct HeadlessFrameStats
+{
+    // Wall time for gameInitAudioBuffer + gameInitFrameBuffer + gameUpdate
+    float32 frameMS;
+
+    // Processor clock cycles spent inside gameUpdate only
+    uint64 gameUpdateCycles;
+
+    // Hash of the frame buffer's pixels once gameUpdate has returned
+    uint64 frameHash;
+
+    // Pixels the game reported as changed (what a window would present)
+    uint64 dirtyPixels;
+
+    // Pixels the frame was drawn at before being scaled up to fill the frame
+    // buffer
+    uint64 drawnPixels;
+} HeadlessFrameStats;
+
+typedef struct HeadlessOptions
+{
+    uint32 frames;
+    const char *gameSOPath;
+    const char *scriptPath;
+    const char *inputPath;
+    const char *recordPath;
+    const char *framesCSVPath;
+    const char *audioWavPath;
+    uint32 resolutionScale;
+    bool8 upscaleNearest;
+    bool8 fullRedraw;
+    bool8 verbose;
+} HeadlessOptions;
+
+internal_func bool32 headlessParseOptions(int argc, char **argv, HeadlessOptions *options);
+
+internal_func bool32 headlessLoadGameSOFunctions(const char *absPathToSO, GameCode *gameCode);
+
+/**
+ * @brief Parses an input script into steps.
+ *
+ * One step per line in the format "<frames> [button ...]". Lines starting
+ * with # are comments. E.g.
+ *
+ * # walk right for a second, then up and right for half a second
+ * 30 dPadRight
+ * 15 dPadRight dPadUp
+ * 10
+ *
+ * @return false if the file couldn't be read or contains an unknown button
+ */
+internal_func bool32 headlessLoadScript(const char *filename, HeadlessScript *script);
+
+/**
+ * @brief Sets the keyboard controller's button states for the given frame of
+ * a script. wasDown is carried over from the previous frame's input.
+ */
+internal_func void headlessApplyScript(HeadlessScript *script,
+                                        uint32 frameIndex,
+                                        GameInput *gameInput,
+                                        GameInput *oldGameInput);
+
+/**
+ * @brief Hashes a frame buffer's pixels (FNV-1a over 64-bit words)
+ */
+internal_func uint64 headlessHashFrameBuffer(GameFrameBuffer *frameBuffer);
+
+/**
+ * @brief Pixels in the frame buffer's dirty region
+ */
+internal_func uint64 headlessDirtyPixels(GameFrameBuffer *frameBuffer);
+
+/**
+ * @brief Nearest-rank percentile of an already sorted array
+ */
+internal_func float32 headlessPercentile(float32 *sortedValues, uint32 count, float32 percentile);
+
+//===========================================
+// Game-required platform layer signatures
+//===========================================
+PLATFORM_TOGGLE_FULLSCREEN(platformToggleFullscreen);
+PLATFORM_CONTROLLER_VIBRATE(platformControllerVibrate);
+
+#if HANDMADE_LOCAL_BUILD
+
+DEBUG_PLATFORM_LOG(DEBUG_platformLog);
+
+#endif
+
+#endif
@@ -0,0 +1,127 @@
+// Worker threads shared by the Linux platform layer, the headless runner and
+// the benchmark runner. This file is included directly into each executable's
+// translation unit (after linux_work_queue.h), in the same way
+// linux_common.cpp is.
+
+internal_func uint32 linuxGetWorkerThreadCount()
+{
+    const char *workerThreads = getenv(LINUX_WORKER_THREADS_VARIABLE);
+
+    int64 count = 0;
+
+    if (workerThreads) {
+        count = (int64)strtoul(workerThreads, NULL, 10);
+    } else {
+        count = ((int64)sysconf(_SC_NPROCESSORS_ONLN) - 1);
+    }
+
+    if (count < 0) {
+        count = 0;
+    }
+
+    if (count > LINUX_MAX_WORKER_THREADS) {
+        count = LINUX_MAX_WORKER_THREADS;
+    }
+
+    return (uint32)count;
+}
+
+internal_func bool32 linuxStartWorkQueue(PlatformWorkQueue *queue, uint32 workerCount)
+{
+    assert(workerCount <= LINUX_MAX_WORKER_THREADS);
+
+    // The thread that adds entries takes from the queue too
+    workQueueInit(&queue->work, (workerCount + 1));
+
+    queue->running = true;
+    queue->workerCount = 0;
+
+    if (0 != sem_init(&queue->wake, 0, 0)) {
+        return false;
+    }
+
+    for (uint32 i = 0; i < workerCount; i++) {
+
+        LinuxWorkerThread *worker = &queue->workers[i];
+
+        worker->queue = queue;
+        worker->context.threadIndex = (i + 1);
+
+        if (0 != pthread_create(&worker->thread, NULL, linuxWorkerThread, worker)) {
+            linuxStopWorkQueue(queue);
+            return false;
+        }
+
+        queue->workerCount++;
+    }
+
+    return true;
+}
+
+internal_func void linuxStopWorkQueue(PlatformWorkQueue *queue)
+{
+    __atomic_store_n(&queue->running, false, __ATOMIC_RELEASE);
+
+    for (uint32 i = 0; i < queue->workerCount; i++) {
+        sem_post(&queue->wake);
+    }
+
+    for (uint32 i = 0; i < queue->workerCount; i++) {
+        pthread_join(queue->workers[i].thread, NULL);
+    }
+
+    queue->workerCount = 0;
+
+    sem_destroy(&queue->wake);
+}
+
+internal_func void *linuxWorkerThread(void *param)
+{
+    LinuxWorkerThread *worker = (LinuxWorkerThread *)param;
+    PlatformWorkQueue *queue = worker->queue;
+
+    for (;;) {
+
+        if (workQueueRunNextEntry(&queue->work, &worker->context)) {
+            continue;
+        }
+
+        if (!__atomic_load_n(&queue->running, __ATOMIC_ACQUIRE)) {
+            break;
+        }
+
+        // Anything added since we last looked has posted, so this won't sleep
+        // through it. Posts for entries someone else ran just cost a wasted
+        // look.
+        sem_wait(&queue->wake);
+    }
+
+    return NULL;
+}
+
+PLATFORM_ADD_WORK_QUEUE_ENTRY(platformAddWorkQueueEntry)
+{
+    if (!workQueueAdd(&queue->work, callback, data)) {
+
+        // The deque is full. Only the thread that calls into the game adds
+        // entries, so run it here rather than lose it.
+        PlatformThreadContext thread = {0};
+        callback(&thread, data);
+        return;
+    }
+
+    if (queue->workerCount) {
+        sem_post(&queue->wake);
+    }
+}
+
+PLATFORM_COMPLETE_ALL_WORK(platformCompleteAllWork)
+{
+    while (!workQueueIsComplete(&queue->work)) {
+
+        // Nothing left to take, but workers are still finishing theirs
+        if (!workQueueRunNextEntry(&queue->work, thread)) {
+            sched_yield();
+        }
+    }
+}
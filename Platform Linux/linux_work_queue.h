@@ -0,0 +1,69 @@
+#ifndef HEADER_LINUX_WORK_QUEUE
+#define HEADER_LINUX_WORK_QUEUE
+
+//
+// Worker threads. Shared by the platform layer, the headless runner and the
+// benchmark runner
+// ============================================================================
+//
+// The threads behind PlatformWorkQueue. Which entry each thread runs is down
+// to the game's WorkQueue (Game/work_queue.h). This just starts the workers
+// and puts them to sleep on a semaphore when there's nothing left to take.
+
+// Set to the number of worker threads to start. Otherwise one fewer than the
+// number of CPUs, as the thread that calls into the game works too.
+#define LINUX_WORKER_THREADS_VARIABLE "HANDMADE_WORKER_THREADS"
+
+#define LINUX_MAX_WORKER_THREADS (WORK_QUEUE_MAX_THREADS - 1)
+
+typedef struct LinuxWorkerThread
+{
+    PlatformWorkQueue *queue;
+
+    // threadIndex is 1 onwards
+    PlatformThreadContext context;
+
+    pthread_t thread;
+
+} LinuxWorkerThread;
+
+struct PlatformWorkQueue
+{
+    WorkQueue work;
+
+    // Posted once per entry added, and once per worker to stop them
+    sem_t wake;
+
+    volatile bool32 running;
+
+    uint32 workerCount;
+    LinuxWorkerThread workers[LINUX_MAX_WORKER_THREADS];
+};
+
+/*
+ * How many worker threads to start: LINUX_WORKER_THREADS_VARIABLE if it's set,
+ * otherwise one per CPU other than the caller's
+ */
+internal_func uint32 linuxGetWorkerThreadCount();
+
+/*
+ * Starts workerCount threads. With none, every entry runs on the thread that
+ * waits for the queue. Returns false if the threads couldn't be started, in
+ * which case any that were have been stopped again.
+ */
+internal_func bool32 linuxStartWorkQueue(PlatformWorkQueue *queue, uint32 workerCount);
+
+/*
+ * Stops the workers once they've finished whatever they're running
+ */
+internal_func void linuxStopWorkQueue(PlatformWorkQueue *queue);
+
+internal_func void *linuxWorkerThread(void *param);
+
+//===========================================
+// Game-required platform layer signatures
+//===========================================
+PLATFORM_ADD_WORK_QUEUE_ENTRY(platformAddWorkQueueEntry);
+PLATFORM_COMPLETE_ALL_WORK(platformCompleteAllWork);
+
+#endif
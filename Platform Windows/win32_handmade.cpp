@@ -4,11 +4,18 @@
 #include <strsafe.h> // sprintf_s support
 #include <dsound.h>  // Direct Sound for audio output.
 #include <xinput.h>  // Xinput for receiving controller input.
+#include <psapi.h>   // GetProcessMemoryInfo for the memory usage report.
 
 #include "..\Game\global.h" // Game layer specific function signatures
+#include "..\Game\input_recording.h" // Compressed input recordings
+#include "..\Game\audio_ring_buffer.h" // Hands audio to the audio thread
+#include "..\Game\work_queue.h" // Shares work out over the worker threads
 #include "win32_handmade.h" // Platform layer specific function signatures
 
 #include "..\Game\global_utility.cpp"
+#include "..\Game\input_recording.cpp"
+#include "..\Game\audio_ring_buffer.cpp"
+#include "..\Game\work_queue.cpp"
 
 // Function stubs for functions provided by external DLL
 GAME_INIT_AUDIO_BUFFER(gameInitAudioBufferStub) { return 0; }
@@ -23,6 +30,10 @@ global_var bool8 paused = FALSE;
 // @TOOD(JM) move this out of the global scope
 global_var Win32FrameBuffer win32FrameBuffer = { 0 };
 
+// Set whilst frames are presented on the presenter thread. WM_PAINT then
+// leaves the drawing to it.
+global_var Win32Presenter *win32Presenter = NULL;
+
 // XInput support
 typedef DWORD WINAPI XInputGetStateDT(_In_ DWORD dwUserIndex, _Out_ XINPUT_STATE *pState);
 typedef DWORD WINAPI XInputSetStateDT(_In_ DWORD dwUserIndex, _In_ XINPUT_VIBRATION *pVibration);
@@ -43,6 +54,10 @@ global_var int64 globalQPCFrequency;
 // For full screen toggle functionality
 global_var WINDOWPLACEMENT globalWindowPosition = { sizeof(globalWindowPosition) };
 
+// The reservation that the game's memory regions live within. Used to look up
+// the chunk states when the game asks for memory to be committed.
+global_var Win32MemoryReservation *win32GameMemoryReservation = NULL;
+
 /*
  * The entry point for this graphical Windows-based application.
  * 
@@ -123,7 +138,7 @@ int APIENTRY wWinMain(_In_ HINSTANCE instance,
     // and use it forever.
     HDC deviceHandleForWindow = GetDC(window);
 
-    // Get the thread's content (@TODO JM)
+    // The main thread's context. The worker threads are numbered from 1.
     PlatformThreadContext thread = { 0 };
 
     // Create a Win32 state object to hold persistent data for the platform layer.
@@ -144,6 +159,12 @@ int APIENTRY wWinMain(_In_ HINSTANCE instance,
     GameCode gameCode = { 0 };
     win32LoadGameDLLFunctions(win32State.absPath, &gameCode);
 
+#ifdef HANDMADE_LIVE_LOOP_EDITING
+    // Watch for rebuilds of the game code on a background thread
+    Win32GameCodeReloader gameCodeReloader = { 0 };
+    win32StartGameCodeReloader(&gameCodeReloader, win32State.absPath);
+#endif
+
     /*
      * Game memory
      */
@@ -153,13 +174,25 @@ int APIENTRY wWinMain(_In_ HINSTANCE instance,
     uint64 memoryStartAddress = 0;
 #endif
 
-    // Allocate all required memory for the game from within our platform layer
+    // Reserve all required memory for the game from within our platform layer
     sizet permanentStorageSizeInBytes = utilGibibytesToBytes(1);
     sizet transientStorageSizeInBytes = utilMebibytesToBytes(64);
 
     sizet memoryTotalSize = (permanentStorageSizeInBytes + transientStorageSizeInBytes);
 
-    void *platformMemory = platformAllocateMemory(&thread, memoryStartAddress, memoryTotalSize);
+#ifdef HANDMADE_LIVE_LOOP_EDITING
+    // Live loop recording restores just the pages written to since the loop started
+    bool32 watchGameMemoryWrites = true;
+#else
+    bool32 watchGameMemoryWrites = false;
+#endif
+
+    void *platformMemory = win32ReserveMemory(&thread,
+                                                &win32State.gameMemoryReservation,
+                                                memoryStartAddress,
+                                                memoryTotalSize,
+                                                watchGameMemoryWrites);
+    win32GameMemoryReservation = &win32State.gameMemoryReservation;
 
     // Init game memory
     GameMemory memory = {0};
@@ -178,11 +211,31 @@ int APIENTRY wWinMain(_In_ HINSTANCE instance,
     memory.transientStorage.bytesUsed = 0;
     memory.transientStorage.bytesFree = transientStorageSizeInBytes;
 
+#if defined(HANDMADE_COMMIT_MEMORY_ON_DEMAND)
+    // Only the address range is reserved. The game's memory blocks commit
+    // pages as they grow.
+    memory.permanentStorage.platformCommitMemory = &platformCommitMemory;
+    memory.transientStorage.platformCommitMemory = &platformCommitMemory;
+#endif
+
     memory.platformAllocateMemory = &platformAllocateMemory;
     memory.platformFreeMemory = &platformFreeMemory;
     memory.platformControllerVibrate = &platformControllerVibrate;
     memory.platformToggleFullscreen = &platformToggleFullscreen;
 
+    // Worker threads for the renderer. The main thread works alongside them.
+    PlatformWorkQueue *renderQueue = (PlatformWorkQueue *)platformAllocateMemory(&thread, 0, sizeof(PlatformWorkQueue));
+
+    if (renderQueue && win32StartWorkQueue(renderQueue, win32GetWorkerThreadCount())) {
+        memory.renderQueue = renderQueue;
+    } else {
+        OutputDebugStringA("Unable to start the worker threads. Drawing on the main thread\n");
+        platformFreeMemory(&thread, renderQueue);
+    }
+
+    memory.platformAddWorkQueueEntry = &platformAddWorkQueueEntry;
+    memory.platformCompleteAllWork = &platformCompleteAllWork;
+
     size_t len;
     if (wcstombs_s(&len, memory.platformAbsPath, sizeof(memory.platformAbsPath), absPath, wcslen(absPath)) != 0) {
         assert(!"Error converting absPath string\n");
@@ -201,11 +254,17 @@ int APIENTRY wWinMain(_In_ HINSTANCE instance,
         win32State.gameMemory = memory.permanentStorage.bytes;
 
 #ifdef HANDMADE_LIVE_LOOP_EDITING
-        memory.recordingStorageGameState   = platformAllocateMemory(&thread, (memoryStartAddress + memoryTotalSize), memoryTotalSize);
-        memory.recordingStorageInput       = platformAllocateMemory(&thread, (memoryStartAddress + (memoryTotalSize * 2)), memoryTotalSize);
+        // Reserved alongside the game memory. Pages are committed as they're
+        // snapshotted into.
+        uint64 reservationSize = win32State.gameMemoryReservation.sizeInBytes;
+
+        memory.recordingStorageGameState   = win32ReserveMemory(&thread,
+                                                                &win32State.recordedStateReservation,
+                                                                (memoryStartAddress ? (memoryStartAddress + reservationSize) : 0),
+                                                                memoryTotalSize,
+                                                                false);
 
         win32State.gameMemoryRecordedState = memory.recordingStorageGameState;
-        win32State.gameMemoryRecordedInput = memory.recordingStorageInput;
 #endif
 
         /*
@@ -270,17 +329,50 @@ int APIENTRY wWinMain(_In_ HINSTANCE instance,
         // Create the game audio buffer.
         GameAudioBuffer gameAudioBuffer = {0};
         gameAudioBuffer.writeEntireBuffer = FALSE;
-        gameAudioBuffer.minFramesWorthOfAudio = 4;
+        gameAudioBuffer.minFramesWorthOfAudio = 2;
+
+        uint32 audioSamplesPerFrame = (win32AudioBuffer.samplesPerSecond / win32FixedFrameRate.gameTargetFPS);
+
+        // The game's samples are handed to an audio thread, which copies them
+        // into the secondary buffer a few milliseconds at a time
+        Win32AudioOutput audioOutput = {0};
+        bool32 audioOutputStarted = win32StartAudioOutput(&thread, &audioOutput, &win32AudioBuffer);
+
+#if defined(HANDMADE_DEBUG_AUDIO)
+        uint32 framesSinceAudioLog = 0;
+#endif
 
         /*
          * Graphics
          */
 
+        // Presenting on its own thread means the main loop draws into the
+        // presenter's frame buffers. Otherwise there's just the one.
+        Win32Presenter presenter = {0};
+        bool32 pipelinedPresent = FALSE;
+
+#if defined(HANDMADE_PIPELINED_PRESENT)
+        pipelinedPresent = win32StartPresenter(&thread,
+                                                &presenter,
+                                                window,
+                                                deviceHandleForWindow,
+                                                FRAME_BUFFER_PIXEL_WIDTH,
+                                                FRAME_BUFFER_PIXEL_HEIGHT);
+
+        if (pipelinedPresent) {
+            win32Presenter = &presenter;
+        } else {
+            OutputDebugStringA("Unable to start the presenter thread. Presenting from the main loop\n");
+        }
+#endif
+
         // Create the Windows frame buffer
-        win32InitFrameBuffer(&thread,
-                                &win32FrameBuffer,
-                                FRAME_BUFFER_PIXEL_WIDTH,
-                                FRAME_BUFFER_PIXEL_HEIGHT);
+        if (!pipelinedPresent) {
+            win32InitFrameBuffer(&thread,
+                                    &win32FrameBuffer,
+                                    FRAME_BUFFER_PIXEL_WIDTH,
+                                    FRAME_BUFFER_PIXEL_HEIGHT);
+        }
 
         /*
          * Controllers
@@ -321,6 +413,17 @@ int APIENTRY wWinMain(_In_ HINSTANCE instance,
 
         PostMessage(window, WM_HANDMADE_HERO_READY, 0, 0);
 
+#if defined(HANDMADE_DEBUG_MEMORY)
+        uint32 framesSinceMemoryLog = 0;
+#endif
+
+        // Counts the frames drawn, so each frame buffer's age can be worked
+        // out. Frame buffers drawn into before validFromFrameNumber are out
+        // of date. Frames are still presented in full, as StretchDIBits
+        // scales them to the window.
+        uint64 frameNumber = 0;
+        uint64 validFromFrameNumber = 0;
+
         /**
          * MAIN GAME LOOP
          */
@@ -460,113 +563,19 @@ int APIENTRY wWinMain(_In_ HINSTANCE instance,
 
             } // controller loop
 
-            // Size, in bytes, of the portion of the buffer to write.
-            DWORD lockSizeInBytes = 0;
-
-            // Offset, in bytes, from the start of the buffer to the point where the lock begins.
-            // We Mod the result by the total number of bytes so that the value wraps.
-            // Result will look like this: 0, 4, 8, 12, 16, 24 etc...
-            DWORD lockOffsetInBytes = 0;
-
-            // Start playing sound. (Write a dummy wave sound)
-            // Each single "sample" is a 16-bit value. 8 bits for the left channel, and 8 bits for the right channel.
-            // They both go together.
-            // Each individual sample gets output at a time, thus outputting to both the left and right channels
-            // at the same time. The sound buffer (win32AudioBuffer.buffer) contains all of these 16-bit audio samples.
+            // Top the audio thread's queue up to minFramesWorthOfAudio frames'
+            // worth. The audio thread copies it into the secondary buffer.
+            uint32 audioSamplesToWrite = 0;
 
-            // The IDirectSoundBuffer8::GetCurrentPosition method retrieves 
-            // the position of the play and write cursors in the sound buffer.
-            if (win32AudioBuffer.bufferSuccessfulyCreated) {
-
-                DWORD playCursorOffsetInBytes   = NULL; // Offset, in bytes, of the play cursor
-                DWORD writeCursorOffsetInBytes  = NULL; // Offset, in bytes, of the write cursor
-                DWORD writePlayDifference       = 0; // Difference in bytes between the play and the write cursors.
-
-                struct AuidioLatency {
-                    uint32 samplesLatent;
-                    float32 samplesLatentAsPercentageOfBuffer;
-                    float32 latencyInMS;
-                } audioLatency = {0};
-
-                HRESULT res = win32AudioBuffer.buffer->GetCurrentPosition(&playCursorOffsetInBytes, &writeCursorOffsetInBytes);
-
-                if ((DS_OK == res) && (win32AudioBuffer.bufferSizeInBytes > 0)) {
-
-                    // IDirectSoundBuffer8::Lock Readies all or part of the buffer for a data 
-                    // write and returns pointers to which data can be written
-
-                    lockOffsetInBytes = (writeCursorOffsetInBytes % win32AudioBuffer.bufferSizeInBytes);
-
-                    // Is the current lock offset ahead of the current play cursor? If yes, we'll get back 
-                    // two chucks of data from IDirectSoundBuffer8::Lock, otherwise we'll only get back
-                    // one chuck of data.
-                    if (writeCursorOffsetInBytes > playCursorOffsetInBytes) {
-                        lockSizeInBytes = (win32AudioBuffer.bufferSizeInBytes - (writeCursorOffsetInBytes - playCursorOffsetInBytes));
-                        writePlayDifference = (writeCursorOffsetInBytes - playCursorOffsetInBytes);
-                    } else if (writeCursorOffsetInBytes < playCursorOffsetInBytes) {
-                        lockSizeInBytes = ((win32AudioBuffer.bufferSizeInBytes - (win32AudioBuffer.bufferSizeInBytes - playCursorOffsetInBytes)) - writeCursorOffsetInBytes);
-                        writePlayDifference = ((win32AudioBuffer.bufferSizeInBytes - playCursorOffsetInBytes) + writeCursorOffsetInBytes);
-                    }
-
-                    audioLatency.samplesLatent = (writePlayDifference / win32AudioBuffer.bytesPerSample);
-                    audioLatency.samplesLatentAsPercentageOfBuffer = ((((float32)audioLatency.samplesLatent * 100.0f) / ((float32)win32AudioBuffer.samplesPerSecond * (float32)win32AudioBuffer.secondsWorthOfAudio)) / 100.0f);
-                    audioLatency.latencyInMS = ((1000.f * win32AudioBuffer.secondsWorthOfAudio) * audioLatency.samplesLatentAsPercentageOfBuffer);
-                   
-                    // If we're opting to *not* write the entire audio buffer, calculate how much to write here...
-                    if ((!gameAudioBuffer.writeEntireBuffer) && (gameAudioBuffer.minFramesWorthOfAudio >= 1)) {
-
-                        // How many samples do we need to write? (number of samples in MS)
-                        // Write at least the audio latency (in ms)
-                        float32 msToWrite = audioLatency.latencyInMS;
-
-                        // If the game's target frame rate (in ms) is larger than the audio latency (in ms)
-                        // then set that as our minimum latency.
-                        if (win32FixedFrameRate.gameTargetMSPerFrame > audioLatency.latencyInMS) {
-                            msToWrite = win32FixedFrameRate.gameTargetMSPerFrame;
-                        }
-                        // Now add up to the margin of safety
-                        float32 marginTotalInMS = (win32FixedFrameRate.gameTargetMSPerFrame * (float32)gameAudioBuffer.minFramesWorthOfAudio);
-                        if (marginTotalInMS > msToWrite) {
-                            msToWrite = (msToWrite + (marginTotalInMS - msToWrite));
-                        }
-
-                        float32 samplesToWrite = ((float32)win32AudioBuffer.samplesPerSecond * (((msToWrite * 100.0f) / 1000.0f) / 100));
-                        uint32 noOfBytesToWrite = (uint32)(samplesToWrite * win32AudioBuffer.bytesPerSample);
-
-                        if (noOfBytesToWrite > win32AudioBuffer.bufferSizeInBytes) {
-                            // We've somehow ended up with a calculation that's bigger than
-                            // the audio buffer available. Don't overwrite the lockSizeInBytes
-                            assert(!"noOfBytesToWrite calculation is > win32AudioBuffer.bufferSizeInBytes");
-                        } else {
-                            // Overwrite the lockSizeInBytes to match our smaller lock size.
-                            lockSizeInBytes = noOfBytesToWrite;
-                        }
-                    }
-                    
+            if (audioOutputStarted) {
+                audioSamplesToWrite = win32AudioFramesToRequest(&audioOutput, (audioSamplesPerFrame * gameAudioBuffer.minFramesWorthOfAudio));
 
 #if defined(HANDMADE_DEBUG_AUDIO)
-
-                    gameAudioBuffer.playCursorPosition = playCursorOffsetInBytes;
-                    gameAudioBuffer.writeCursorPosition = writeCursorOffsetInBytes;
-                    gameAudioBuffer.lockSizeInBytes = lockSizeInBytes;
-
-                    // @TODO(JM) Make audio latency match a single frame
-                    if (win32AudioBuffer.bufferSizeInBytes > 0) {
-                        char buff[200] = { 0 };
-                        sprintf_s(buff,
-                            sizeof(buff),
-                            "Audio latency: %.2fms (%.2f frames)\n",
-                            audioLatency.latencyInMS,
-                            (audioLatency.latencyInMS / win32FixedFrameRate.gameTargetMSPerFrame));
-                        OutputDebugStringA(buff);
-                    }
-
+                gameAudioBuffer.playCursorPosition = (unsigned long)audioOutput.playCursorOffsetInBytes;
+                gameAudioBuffer.writeCursorPosition = (unsigned long)audioOutput.writeCursorOffsetInBytes;
+                gameAudioBuffer.lockSizeInBytes = (audioSamplesToWrite * win32AudioBuffer.bytesPerSample);
 #endif
-                } else {
-                    OutputDebugStringA("Could not get the position of the play and write cursors in the secondary sound buffer");
-                }
-
-            } // Audio buffer created.
+            }
 
 #ifdef HANDMADE_LIVE_LOOP_EDITING
 
@@ -585,22 +594,37 @@ int APIENTRY wWinMain(_In_ HINSTANCE instance,
                 gameCode.gameInitAudioBuffer(&thread,
                                                 &memory,
                                                 &gameAudioBuffer,
-                                                lockSizeInBytes,
+                                                (audioSamplesToWrite * win32AudioBuffer.bytesPerSample),
                                                 win32AudioBuffer.bytesPerSample,
                                                 win32AudioBuffer.bufferSizeInBytes);
             }
             
             // Create the game's frame buffer
+            Win32FrameBuffer *drawFrameBuffer = (pipelinedPresent ? win32PresenterDrawBuffer(&presenter) : &win32FrameBuffer);
+
             GameFrameBuffer gameFrameBuffer = {0};
+
+            frameNumber++;
+
+            if (win32State.frameBuffersInvalid) {
+                validFromFrameNumber = frameNumber;
+                win32State.frameBuffersInvalid = false;
+            }
             
             if (gameCode.gameInitFrameBuffer){ // C6011 NULL pointer warning
                 gameCode.gameInitFrameBuffer(&thread,
                                                 &gameFrameBuffer,
-                                                win32FrameBuffer.height,
-                                                win32FrameBuffer.width,
-                                                win32FrameBuffer.bytesPerPixel,
-                                                win32FrameBuffer.byteWidthPerRow,
-                                                win32FrameBuffer.memory);
+                                                drawFrameBuffer->height,
+                                                drawFrameBuffer->width,
+                                                drawFrameBuffer->bytesPerPixel,
+                                                drawFrameBuffer->byteWidthPerRow,
+                                                drawFrameBuffer->memory);
+            }
+
+            // Lets the game redraw only what's changed since the frame that's
+            // already in the buffer
+            if (drawFrameBuffer->frameNumber && (drawFrameBuffer->frameNumber >= validFromFrameNumber)) {
+                gameFrameBuffer.age = (uint32)(frameNumber - drawFrameBuffer->frameNumber);
             }
             
 
@@ -617,34 +641,84 @@ int APIENTRY wWinMain(_In_ HINSTANCE instance,
                                     &controllerCounts);
             }
 
+            drawFrameBuffer->frameNumber = frameNumber;
 
 #ifdef HANDMADE_LIVE_LOOP_EDITING
-            win32LoadGameDLLFunctions(win32State.absPath, &gameCode);
+            // Swap in new game code if the reload thread has staged some. The
+            // new code may draw differently, so start again from a full frame.
+            void *gameCodeHandle = gameCode.dllHandle;
+
+            win32SwapStagedGameCode(&gameCodeReloader, &gameCode);
+
+            if (gameCode.dllHandle != gameCodeHandle) {
+                win32State.frameBuffersInvalid = true;
+            }
 #endif
 
-            // Output the audio buffer in Windows.
-            win32WriteAudioBuffer(&win32AudioBuffer, lockOffsetInBytes, lockSizeInBytes, &gameAudioBuffer);
+            // Queue the game's samples for the audio thread
+            if (audioOutputStarted) {
+                win32SubmitAudio(&audioOutput, gameAudioBuffer.memory, gameAudioBuffer.noOfSamplesToWrite);
+            }
+
+#if defined(HANDMADE_DEBUG_AUDIO)
+            if (audioOutputStarted && (++framesSinceAudioLog >= TARGET_FPS)) {
+
+                float32 msPerSample = (1000.0f / (float32)win32AudioBuffer.samplesPerSecond);
+
+                char buff[200] = { 0 };
+                sprintf_s(buff,
+                    sizeof(buff),
+                    "Audio latency: %.2fms (max %.2fms). Underruns %llu (%llu samples). Dropped %llu samples\n",
+                    ((float32)audioOutput.latencyFrames * msPerSample),
+                    ((float32)audioOutput.maxLatencyFrames * msPerSample),
+                    audioOutput.ring.underruns,
+                    audioOutput.ring.underrunFrames,
+                    audioOutput.ring.droppedFrames);
+                OutputDebugStringA(buff);
+
+                framesSinceAudioLog = 0;
+            }
+#endif
+
+#if defined(HANDMADE_DEBUG_MEMORY)
+            if (++framesSinceMemoryLog >= TARGET_FPS) {
+                win32LogMemoryUsage(&win32State.gameMemoryReservation);
+                framesSinceMemoryLog = 0;
+            }
+#endif
 
             // Take a copy of this frame's controller inputs
             gameInputOld->mouse = gameInput->mouse;
             gameInputOld->controllers[0] = gameInput->controllers[0];
 
             // Display the frame buffer in Windows. AKA "flip the frame" or "page flip".
+            if (pipelinedPresent) {
 
-            // Get the window's height and width
-            win32ClientDimensions clientDimensions = win32GetClientDimensions(window);
+                // The presenter thread puts it on screen whilst we get on
+                // with the next frame
+                win32SubmitFrameToPresenter(&presenter);
 
-            // Display the buffer to the screen
-            win32DisplayFrameBuffer(deviceHandleForWindow,
-                                    win32FrameBuffer,
-                                    clientDimensions.width,
-                                    clientDimensions.height);
+            } else {
+
+                // Get the window's height and width
+                win32ClientDimensions clientDimensions = win32GetClientDimensions(window);
+
+                // Display the buffer to the screen
+                win32DisplayFrameBuffer(deviceHandleForWindow,
+                                        win32FrameBuffer,
+                                        clientDimensions.width,
+                                        clientDimensions.height);
+            }
 
             // How long did this game loop (frame) take? (E.g. 2ms)
             LARGE_INTEGER gameLoopTime = win32GetTime();
 
             float32 millisecondsElapsedForFrame = win32GetElapsedTimeMS(netFrameTime, gameLoopTime, globalQPCFrequency);
 
+            // The time spent working, for the game to pick the next frame's
+            // resolution by
+            gameInput->msWorkPerFrame = millisecondsElapsedForFrame;
+
 #if defined(HANDMADE_LOCAL_BUILD) && defined(HANDMADE_DEBUG_FPS)
 
             {
@@ -749,6 +823,16 @@ int APIENTRY wWinMain(_In_ HINSTANCE instance,
 
                     OutputDebugStringA(output);
                 }
+
+                if (pipelinedPresent) {
+                    char output[100] = { 0 };
+                    sprintf_s(output, sizeof(output),
+                                "Frames presented: %lld. Dropped: %llu\n",
+                                InterlockedCompareExchange64(&presenter.framesPresented, 0, 0),
+                                presenter.framesDropped);
+
+                    OutputDebugStringA(output);
+                }
             #endif
 
             #if defined(HANDMADE_DEBUG_CLOCKCYCLES)
@@ -780,6 +864,19 @@ int APIENTRY wWinMain(_In_ HINSTANCE instance,
 
         } // game loop
 
+        if (pipelinedPresent) {
+            win32Presenter = NULL;
+            win32StopPresenter(&presenter);
+        }
+
+        if (audioOutputStarted) {
+            win32StopAudioOutput(&thread, &audioOutput);
+        }
+
+        if (memory.renderQueue) {
+            win32StopWorkQueue(memory.renderQueue);
+        }
+
         if (win32FixedFrameRate.capMode == FRAME_RATE_CAP_MODE_SLEEP) {
             if (TIMERR_NOERROR == win32FixedFrameRate.timeOutIntervalSet) {
                 timeEndPeriod(win32FixedFrameRate.timeOutIntervalMS);
@@ -853,6 +950,14 @@ internal_func LRESULT CALLBACK win32MainWindowCallback(HWND window,
         // Request to paint a portion of an application's window.
         case WM_PAINT: {
 
+            // The presenter thread owns the window's DC. Mark the window as
+            // painted and have the presenter redraw it.
+            if (win32Presenter) {
+                ValidateRect(window, NULL);
+                win32RepaintPresenter(win32Presenter);
+                break;
+            }
+
             // Prepare the window for painting.
 
             // The PAINTSTRUCT var contains the area that needs to be repainted, 
@@ -959,6 +1064,9 @@ internal_func void win32InitFrameBuffer(PlatformThreadContext *thread,
 
     // Calculate the width in bytes per row.
     buffer->byteWidthPerRow = (buffer->width * buffer->bytesPerPixel);
+
+    // Nothing's been drawn into the new memory yet
+    buffer->frameNumber = 0;
 }
 
 /*
@@ -1195,97 +1303,188 @@ internal_func void win32AudioBufferToggleStop(Win32AudioBuffer *win32AudioBuffer
     }
 }
 
-internal_func void win32WriteAudioBuffer(Win32AudioBuffer *win32AudioBuffer,
-                                            DWORD lockOffsetInBytes,
-                                            DWORD lockSizeInBytes,
-                                            GameAudioBuffer *gameAudioBuffer)
+internal_func bool32 win32StartAudioOutput(PlatformThreadContext *thread,
+                                            Win32AudioOutput *output,
+                                            Win32AudioBuffer *audioBuffer)
 {
-    if (!win32AudioBuffer->bufferSuccessfulyCreated) {
-        return;
+    if (!audioBuffer->bufferSuccessfulyCreated) {
+        return FALSE;
     }
 
-    // Ensure we have at least once sample to write
-    if (lockSizeInBytes < win32AudioBuffer->bytesPerSample) {
-        return;
+    output->audioBuffer = audioBuffer;
+
+    void *ringMemory = platformAllocateMemory(thread, 0, (WIN32_AUDIO_RING_FRAMES * AUDIO_RING_BUFFER_BYTES_PER_FRAME));
+
+    if (!ringMemory) {
+        return FALSE;
     }
 
-    HRESULT res;
+    audioRingBufferInit(&output->ring, ringMemory, WIN32_AUDIO_RING_FRAMES);
+
+    output->writeOffsetInBytes = 0;
+    output->writeOffsetSet = FALSE;
+    output->latencyFrames = 0;
+    output->maxLatencyFrames = 0;
+
+    // Manual reset. Once set the thread stops for good.
+    output->stopEvent = CreateEventW(NULL, TRUE, FALSE, NULL);
+
+    if (!output->stopEvent) {
+        platformFreeMemory(thread, ringMemory);
+        return FALSE;
+    }
+
+    output->thread = CreateThread(NULL, 0, win32AudioThread, output, 0, NULL);
 
-    void *chunkOnePtr; // Receives a pointer to the first locked part of the buffer.
-    DWORD chunkOneBytes; // Receives the number of bytes in the block at chunkOnePtr
+    if (!output->thread) {
+        CloseHandle(output->stopEvent);
+        platformFreeMemory(thread, ringMemory);
+        return FALSE;
+    }
+
+    return TRUE;
+}
 
-    void *chunkTwoPtr; // Receives a pointer to the second locked part of the buffer.
-    DWORD chunkTwoBytes; // Receives the number of bytes in the block at chunkTwoPtr
+internal_func DWORD WINAPI win32AudioThread(LPVOID param)
+{
+    Win32AudioOutput *output = (Win32AudioOutput *)param;
+
+    // The secondary buffer has to be topped up every few milliseconds
+    // whatever the rest of the game is doing
+    SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_TIME_CRITICAL);
 
-    res = win32AudioBuffer->buffer->Lock(lockOffsetInBytes,
-                                            lockSizeInBytes,
-                                            &chunkOnePtr,
-                                            &chunkOneBytes,
-                                            &chunkTwoPtr,
-                                            &chunkTwoBytes,
-                                            0);
+    while (WAIT_TIMEOUT == WaitForSingleObject(output->stopEvent, WIN32_AUDIO_THREAD_WAKE_MS)) {
+        win32FillAudioBuffer(output);
+    }
 
+    return 0;
+}
 
-    if (SUCCEEDED(res)) {
+internal_func void win32FillAudioBuffer(Win32AudioOutput *output)
+{
+    Win32AudioBuffer *audioBuffer = output->audioBuffer;
 
-        // Calculate the total number of 4-byte audio sample groups (2-bytes/16 bits for the left channel, 2-bytes/16 bits for the right channel) 
-        // that we have within the first block of memory IDirectSoundBuffer8::Lock has told us we can write to.
-        uint64 audioSampleGroupsChunkOne = (chunkOneBytes / win32AudioBuffer->bytesPerSample);
+    DWORD playCursorOffsetInBytes = 0;
+    DWORD writeCursorOffsetInBytes = 0;
 
-        // Grab the first 4-bytes of the first audio sample grouping from the first block of memory 
-        uint32 *audioSample = (uint32 *)chunkOnePtr;
+    if (FAILED(audioBuffer->buffer->GetCurrentPosition(&playCursorOffsetInBytes, &writeCursorOffsetInBytes))) {
+        return;
+    }
 
-        // Create a pointer to the game audio buffer with the same 4-byte single audio sample grouping range.
-        uint32 *buffer = (uint32 *)gameAudioBuffer->memory;
+    InterlockedExchange(&output->playCursorOffsetInBytes, (LONG)playCursorOffsetInBytes);
+    InterlockedExchange(&output->writeCursorOffsetInBytes, (LONG)writeCursorOffsetInBytes);
 
-        // Advance the game audio buffer pointer to match the same as the lock offset.
-        //buffer = (buffer + (lockOffsetInBytes / win32AudioBuffer->bytesPerSample));
+    DWORD bufferSizeInBytes = audioBuffer->bufferSizeInBytes;
 
-        // Iterate over each individual audio sample grouping (2-bytes for the left channel, 2-bytes for the right channel)
-        // and write the same data for both...
-        for (size_t i = 0; i < audioSampleGroupsChunkOne; i++) {
+    if (!output->writeOffsetSet) {
+        output->writeOffsetInBytes = writeCursorOffsetInBytes;
+        output->writeOffsetSet = TRUE;
+    }
 
-            // Left + right channel (4-bytes)
-            *audioSample = *buffer;
+    // Everything from the play cursor up to the write cursor is committed to
+    // the sound card. Everything from the write cursor up to our write offset
+    // can still be changed.
+    DWORD committedBytes = (((writeCursorOffsetInBytes + bufferSizeInBytes) - playCursorOffsetInBytes) % bufferSizeInBytes);
+    DWORD writtenBytes = (((output->writeOffsetInBytes + bufferSizeInBytes) - playCursorOffsetInBytes) % bufferSizeInBytes);
+
+    // The write cursor has overtaken us, so the sound card has played
+    // whatever was left in the buffer from last time round. Start again from
+    // the write cursor.
+    if (writtenBytes < committedBytes) {
+        output->ring.underruns++;
+        output->ring.underrunFrames += ((committedBytes - writtenBytes) / audioBuffer->bytesPerSample);
+        output->writeOffsetInBytes = writeCursorOffsetInBytes;
+        writtenBytes = committedBytes;
+    }
 
-            // Move cursor to the start of the next audio sample grouping.
-            audioSample++;
-            buffer++;
-        }
+    DWORD targetBytes = (committedBytes + (WIN32_AUDIO_FRAMES_AHEAD_OF_WRITE_CURSOR * audioBuffer->bytesPerSample));
 
-        // Calculate how many samples we need to write to in our second block of memory.
-        uint64 audioSampleGroupsChunkTwo = (chunkTwoBytes / win32AudioBuffer->bytesPerSample);
+    if (writtenBytes < targetBytes) {
 
-        // Grab the first 4-bytes of the first audio sample grouping from the second block of memory 
-        uint32 *audioTwoSample = (uint32*)chunkTwoPtr;
+        DWORD lockSizeInBytes = (targetBytes - writtenBytes);
 
-        // Set the audio buffer pointer back to the start of the memory block as the
-        // second block of memory always starts from the beginning
-        buffer = (uint32 *)gameAudioBuffer->memory;
+        void *chunkOnePtr; // Receives a pointer to the first locked part of the buffer.
+        DWORD chunkOneBytes; // Receives the number of bytes in the block at chunkOnePtr
 
-        for (size_t i = 0; i < audioSampleGroupsChunkTwo; i++) {
+        void *chunkTwoPtr; // Receives a pointer to the second locked part of the buffer.
+        DWORD chunkTwoBytes; // Receives the number of bytes in the block at chunkTwoPtr
 
-            // Left + right channel (4-bytes)
-            *audioTwoSample = *buffer;
+        HRESULT res = audioBuffer->buffer->Lock(output->writeOffsetInBytes,
+                                                lockSizeInBytes,
+                                                &chunkOnePtr,
+                                                &chunkOneBytes,
+                                                &chunkTwoPtr,
+                                                &chunkTwoBytes,
+                                                0);
 
-            // Move cursor to the start of the next audio sample grouping.
-            audioTwoSample++;
-            buffer++;
-        }
+        if (SUCCEEDED(res)) {
 
-        res = win32AudioBuffer->buffer->Unlock(chunkOnePtr, chunkOneBytes, chunkTwoPtr, chunkTwoBytes);
+            // The second chunk is only there if the lock wrapped around the
+            // end of the buffer. Anything the game hasn't produced yet is
+            // written as silence.
+            audioRingBufferReadPadded(&output->ring, chunkOnePtr, (chunkOneBytes / audioBuffer->bytesPerSample));
 
-        if (FAILED(res)) {
-            OutputDebugStringA("Could not unlock sound buffer");
+            if (chunkTwoPtr) {
+                audioRingBufferReadPadded(&output->ring, chunkTwoPtr, (chunkTwoBytes / audioBuffer->bytesPerSample));
+            }
+
+            audioBuffer->buffer->Unlock(chunkOnePtr, chunkOneBytes, chunkTwoPtr, chunkTwoBytes);
+
+            output->writeOffsetInBytes = ((output->writeOffsetInBytes + lockSizeInBytes) % bufferSizeInBytes);
+            writtenBytes = targetBytes;
+
+        } else {
+            OutputDebugStringA("Could not lock secondary sound buffer");
         }
+    }
 
-    } else {
-        OutputDebugStringA("Could not lock secondary sound buffer");
+    uint32 latencyFrames = (audioRingBufferFramesQueued(&output->ring) + (writtenBytes / audioBuffer->bytesPerSample));
+
+    InterlockedExchange(&output->latencyFrames, (LONG)latencyFrames);
+
+    if (latencyFrames > output->maxLatencyFrames) {
+        output->maxLatencyFrames = latencyFrames;
     }
+}
 
-    return;
+internal_func uint32 win32AudioFramesToRequest(Win32AudioOutput *output, uint32 targetFrames)
+{
+    uint32 framesQueued = audioRingBufferFramesQueued(&output->ring);
+
+    if (framesQueued >= targetFrames) {
+        return 0;
+    }
+
+    uint32 framesToRequest = (targetFrames - framesQueued);
+    uint32 framesFree = (output->ring.capacityFrames - framesQueued);
+
+    return ((framesToRequest < framesFree) ? framesToRequest : framesFree);
 }
 
+internal_func void win32SubmitAudio(Win32AudioOutput *output, const void *frames, uint32 frameCount)
+{
+    if (!frameCount) {
+        return;
+    }
+
+    // Never wait on the audio thread. If the ring is somehow full the extra
+    // frames are dropped (and counted).
+    audioRingBufferWrite(&output->ring, frames, frameCount);
+}
+
+internal_func void win32StopAudioOutput(PlatformThreadContext *thread, Win32AudioOutput *output)
+{
+    SetEvent(output->stopEvent);
+    WaitForSingleObject(output->thread, INFINITE);
+
+    CloseHandle(output->thread);
+    CloseHandle(output->stopEvent);
+
+    platformFreeMemory(thread, output->ring.frames);
+    output->ring.frames = NULL;
+}
+
+
 /**
  * Gets the height and width of the actual window. This changes if the window is
  * resized, maximised etc
@@ -1303,113 +1502,374 @@ internal_func win32ClientDimensions win32GetClientDimensions(HWND window)
     return dim;
 }
 
-internal_func void win32ProcessMessages(HWND window,
-                                        GameInput *gameInput,
-                                        GameInput oldGameInput,
-                                        Win32State *win32State)
+internal_func bool32 win32StartPresenter(PlatformThreadContext *thread,
+                                            Win32Presenter *presenter,
+                                            HWND window,
+                                            HDC deviceHandleForWindow,
+                                            uint32 width,
+                                            int32 height)
 {
-    MSG message = {0};
+    presenter->window = window;
+    presenter->deviceHandleForWindow = deviceHandleForWindow;
 
-    // Win32 Message loop. Retrieves all messages (from the calling thread's message queue)
-    // that are sent to the window. E.g. clicks and key inputs.
-    while (PeekMessage(&message, window, 0, 0, PM_REMOVE)) {
+    for (uint32 i = 0; i < WIN32_PRESENT_BUFFER_COUNT; i++) {
 
-        switch (message.message) {
+        win32InitFrameBuffer(thread, &presenter->frameBuffers[i], width, height);
 
-            // If the message received was a quit message, then toggle our
-            // running flag to false to break out of this loop on the next
-            // iteration.
-            case WM_QUIT: {
-                running = false;
-            } break;
+        if (!presenter->frameBuffers[i].memory) {
+            return FALSE;
+        }
+    }
 
-            // Mouse left click
-            case WM_LBUTTONDOWN:
-            {
-                GameControllerBtnState state = {0};
-                state.endedDown = TRUE;
-                gameInput->mouse.leftClick = state;
-            } break;
+    // Each buffer starts out with one owner. Nothing's fresh yet.
+    presenter->drawBuffer = 0;
+    presenter->readyBuffer = 1;
+    presenter->presentBuffer = 2;
 
-            case WM_LBUTTONUP:
-            {
-                GameControllerBtnState state = {0};
-                state.endedDown = FALSE;
-                gameInput->mouse.leftClick = state;
-            } break;
+    presenter->repaint = FALSE;
+    presenter->framesPresented = 0;
+    presenter->framesDropped = 0;
+    presenter->running = TRUE;
 
-            case WM_RBUTTONDOWN:
-            case WM_RBUTTONUP: {
-            } break;
+    // Auto-reset. Wakes the presenter once however many frames are handed
+    // over before it gets to run.
+    presenter->wakeEvent = CreateEventW(NULL, FALSE, FALSE, NULL);
 
-            case WM_KEYDOWN:
-            case WM_SYSKEYDOWN:
-            case WM_KEYUP:
-            case WM_SYSKEYUP:{
+    if (!presenter->wakeEvent) {
+        return FALSE;
+    }
 
-                /*
-                 * lParam bitmask. Written from right to left
-                 *
-                 * @see https://docs.microsoft.com/en-us/windows/win32/inputdev/wm-keydown
-                 *
-                 *  First two bytes              Second two bytes
-                 * |-------------------------|  |----------------|
-                 * 31 30 29 28-25 24 23-16      15-0
-                 * 0  0  0  0000  1  01001011   00000000 00000001
-                */
+    presenter->thread = CreateThread(NULL, 0, win32PresenterThread, presenter, 0, NULL);
 
-                // Which key was pressed?
-                WPARAM vkCode = message.wParam;
+    if (!presenter->thread) {
+        CloseHandle(presenter->wakeEvent);
+        return FALSE;
+    }
 
-                // Was the button down or up?
-                BOOL keyDown = FALSE;
+    return TRUE;
+}
 
-                if (0 == (message.lParam & ((uint64)1 << 31))){
-                    keyDown = TRUE;
-                }
+internal_func DWORD WINAPI win32PresenterThread(LPVOID param)
+{
+    Win32Presenter *presenter = (Win32Presenter *)param;
 
-                GameControllerBtnState state = { 0 };
+    for (;;) {
 
-                if (keyDown) {
-                    state.endedDown = TRUE;
-                } else {
-                    state.endedDown = FALSE;
-                }
+        // Blocks until the main loop hands over a frame
+        WaitForSingleObject(presenter->wakeEvent, INFINITE);
 
-                switch (vkCode) {
-                    case 'W': {
-                        state.wasDown = oldGameInput.controllers[0].dPadUp.endedDown;
-                        gameInput->controllers[0].dPadUp = state;
-                    } break;
-                    case 'A': {
-                        state.wasDown = oldGameInput.controllers[0].dPadLeft.endedDown;
-                        gameInput->controllers[0].dPadLeft = state;
-                    } break;
-                    case 'S': {
-                        state.wasDown = oldGameInput.controllers[0].dPadDown.endedDown;
-                        gameInput->controllers[0].dPadDown = state;
-                    } break;
-                    case 'D': {
-                        state.wasDown = oldGameInput.controllers[0].dPadRight.endedDown;
-                        gameInput->controllers[0].dPadRight = state;
-                    } break;
-                    case 'Q': {
-                        state.wasDown = oldGameInput.controllers[0].shoulderL1.endedDown;
-                        gameInput->controllers[0].shoulderL1 = state;
-                    } break;
-                    case 'E': {
-                        state.wasDown = oldGameInput.controllers[0].shoulderR1.endedDown;
-                        gameInput->controllers[0].shoulderR1 = state;
-                    } break;
-                    case 'F': {
-                        state.wasDown = oldGameInput.controllers[0].option1.endedDown;
-                        gameInput->controllers[0].option1 = state;
-                    } break;
-                    case VK_UP: {
-                        state.wasDown = oldGameInput.controllers[0].up.endedDown;
-                        gameInput->controllers[0].up = state;
-                    } break;
-                    case VK_DOWN: {
+        if (!InterlockedCompareExchange(&presenter->running, 0, 0)) {
+            break;
+        }
+
+        bool32 repaint = (bool32)InterlockedExchange(&presenter->repaint, FALSE);
+
+        // Take the newest frame (if there is one) and give back the one we
+        // presented last
+        if (InterlockedCompareExchange(&presenter->readyBuffer, 0, 0) & WIN32_PRESENT_BUFFER_FRESH) {
+
+            LONG readyBuffer = InterlockedExchange(&presenter->readyBuffer, (LONG)presenter->presentBuffer);
+
+            presenter->presentBuffer = (uint32)(readyBuffer & ~WIN32_PRESENT_BUFFER_FRESH);
+
+        } else if (!repaint) {
+            continue;
+        }
+
+        // Get the window's height and width
+        win32ClientDimensions clientDimensions = win32GetClientDimensions(presenter->window);
+
+        // Paint the whole screen black (stops the artifacts around the frame buffer)
+        if (repaint) {
+            PatBlt(presenter->deviceHandleForWindow,
+                    0, 0,
+                    clientDimensions.width,
+                    clientDimensions.height,
+                    BLACKNESS);
+        }
+
+        win32DisplayFrameBuffer(presenter->deviceHandleForWindow,
+                                presenter->frameBuffers[presenter->presentBuffer],
+                                clientDimensions.width,
+                                clientDimensions.height);
+
+        InterlockedIncrement64(&presenter->framesPresented);
+    }
+
+    return 0;
+}
+
+internal_func Win32FrameBuffer *win32PresenterDrawBuffer(Win32Presenter *presenter)
+{
+    return &presenter->frameBuffers[presenter->drawBuffer];
+}
+
+internal_func void win32SubmitFrameToPresenter(Win32Presenter *presenter)
+{
+    // Publish the frame we've drawn and take whichever buffer was sitting in
+    // readyBuffer. Either a frame the presenter never got to or the one it
+    // has just finished presenting. Both are free to draw over.
+    LONG previousBuffer = InterlockedExchange(&presenter->readyBuffer,
+                                                (LONG)(presenter->drawBuffer | WIN32_PRESENT_BUFFER_FRESH));
+
+    if (previousBuffer & WIN32_PRESENT_BUFFER_FRESH) {
+        presenter->framesDropped++;
+    }
+
+    presenter->drawBuffer = (uint32)(previousBuffer & ~WIN32_PRESENT_BUFFER_FRESH);
+
+    SetEvent(presenter->wakeEvent);
+}
+
+internal_func void win32RepaintPresenter(Win32Presenter *presenter)
+{
+    InterlockedExchange(&presenter->repaint, TRUE);
+    SetEvent(presenter->wakeEvent);
+}
+
+internal_func void win32StopPresenter(Win32Presenter *presenter)
+{
+    InterlockedExchange(&presenter->running, FALSE);
+    SetEvent(presenter->wakeEvent);
+
+    WaitForSingleObject(presenter->thread, INFINITE);
+    CloseHandle(presenter->thread);
+    CloseHandle(presenter->wakeEvent);
+}
+
+internal_func uint32 win32GetWorkerThreadCount()
+{
+    char workerThreads[16] = { 0 };
+
+    int64 count = 0;
+
+    if (GetEnvironmentVariableA(WIN32_WORKER_THREADS_VARIABLE, workerThreads, sizeof(workerThreads))) {
+        count = (int64)strtoul(workerThreads, NULL, 10);
+    } else {
+        SYSTEM_INFO systemInfo;
+        GetSystemInfo(&systemInfo);
+        count = ((int64)systemInfo.dwNumberOfProcessors - 1);
+    }
+
+    if (count < 0) {
+        count = 0;
+    }
+
+    if (count > WIN32_MAX_WORKER_THREADS) {
+        count = WIN32_MAX_WORKER_THREADS;
+    }
+
+    return (uint32)count;
+}
+
+internal_func bool32 win32StartWorkQueue(PlatformWorkQueue *queue, uint32 workerCount)
+{
+    assert(workerCount <= WIN32_MAX_WORKER_THREADS);
+
+    // The thread that adds entries takes from the queue too
+    workQueueInit(&queue->work, (workerCount + 1));
+
+    queue->running = TRUE;
+    queue->workerCount = 0;
+
+    queue->wakeSemaphore = CreateSemaphoreW(NULL, 0, MAXLONG, NULL);
+
+    if (!queue->wakeSemaphore) {
+        return FALSE;
+    }
+
+    for (uint32 i = 0; i < workerCount; i++) {
+
+        Win32WorkerThread *worker = &queue->workers[i];
+
+        worker->queue = queue;
+        worker->context.threadIndex = (i + 1);
+        worker->thread = CreateThread(NULL, 0, win32WorkerThread, worker, 0, NULL);
+
+        if (!worker->thread) {
+            win32StopWorkQueue(queue);
+            return FALSE;
+        }
+
+        queue->workerCount++;
+    }
+
+    return TRUE;
+}
+
+internal_func void win32StopWorkQueue(PlatformWorkQueue *queue)
+{
+    InterlockedExchange(&queue->running, FALSE);
+
+    ReleaseSemaphore(queue->wakeSemaphore, (LONG)queue->workerCount, NULL);
+
+    for (uint32 i = 0; i < queue->workerCount; i++) {
+        WaitForSingleObject(queue->workers[i].thread, INFINITE);
+        CloseHandle(queue->workers[i].thread);
+    }
+
+    queue->workerCount = 0;
+
+    CloseHandle(queue->wakeSemaphore);
+}
+
+internal_func DWORD WINAPI win32WorkerThread(LPVOID param)
+{
+    Win32WorkerThread *worker = (Win32WorkerThread *)param;
+    PlatformWorkQueue *queue = worker->queue;
+
+    for (;;) {
+
+        if (workQueueRunNextEntry(&queue->work, &worker->context)) {
+            continue;
+        }
+
+        if (!InterlockedCompareExchange(&queue->running, 0, 0)) {
+            break;
+        }
+
+        // Anything added since we last looked has released, so this won't
+        // sleep through it
+        WaitForSingleObject(queue->wakeSemaphore, INFINITE);
+    }
+
+    return 0;
+}
+
+PLATFORM_ADD_WORK_QUEUE_ENTRY(platformAddWorkQueueEntry)
+{
+    if (!workQueueAdd(&queue->work, callback, data)) {
+
+        // The deque is full. Only the main thread adds entries, so run it
+        // here rather than lose it.
+        PlatformThreadContext thread = { 0 };
+        callback(&thread, data);
+        return;
+    }
+
+    if (queue->workerCount) {
+        ReleaseSemaphore(queue->wakeSemaphore, 1, NULL);
+    }
+}
+
+PLATFORM_COMPLETE_ALL_WORK(platformCompleteAllWork)
+{
+    while (!workQueueIsComplete(&queue->work)) {
+
+        // Nothing left to take, but workers are still finishing theirs
+        if (!workQueueRunNextEntry(&queue->work, thread)) {
+            SwitchToThread();
+        }
+    }
+}
+
+internal_func void win32ProcessMessages(HWND window,
+                                        GameInput *gameInput,
+                                        GameInput oldGameInput,
+                                        Win32State *win32State)
+{
+    MSG message = {0};
+
+    // Win32 Message loop. Retrieves all messages (from the calling thread's message queue)
+    // that are sent to the window. E.g. clicks and key inputs.
+    while (PeekMessage(&message, window, 0, 0, PM_REMOVE)) {
+
+        switch (message.message) {
+
+            // If the message received was a quit message, then toggle our
+            // running flag to false to break out of this loop on the next
+            // iteration.
+            case WM_QUIT: {
+                running = false;
+            } break;
+
+            // Mouse left click
+            case WM_LBUTTONDOWN:
+            {
+                GameControllerBtnState state = {0};
+                state.endedDown = TRUE;
+                gameInput->mouse.leftClick = state;
+            } break;
+
+            case WM_LBUTTONUP:
+            {
+                GameControllerBtnState state = {0};
+                state.endedDown = FALSE;
+                gameInput->mouse.leftClick = state;
+            } break;
+
+            case WM_RBUTTONDOWN:
+            case WM_RBUTTONUP: {
+            } break;
+
+            case WM_KEYDOWN:
+            case WM_SYSKEYDOWN:
+            case WM_KEYUP:
+            case WM_SYSKEYUP:{
+
+                /*
+                 * lParam bitmask. Written from right to left
+                 *
+                 * @see https://docs.microsoft.com/en-us/windows/win32/inputdev/wm-keydown
+                 *
+                 *  First two bytes              Second two bytes
+                 * |-------------------------|  |----------------|
+                 * 31 30 29 28-25 24 23-16      15-0
+                 * 0  0  0  0000  1  01001011   00000000 00000001
+                */
+
+                // Which key was pressed?
+                WPARAM vkCode = message.wParam;
+
+                // Was the button down or up?
+                BOOL keyDown = FALSE;
+
+                if (0 == (message.lParam & ((uint64)1 << 31))){
+                    keyDown = TRUE;
+                }
+
+                GameControllerBtnState state = { 0 };
+
+                if (keyDown) {
+                    state.endedDown = TRUE;
+                } else {
+                    state.endedDown = FALSE;
+                }
+
+                switch (vkCode) {
+                    case 'W': {
+                        state.wasDown = oldGameInput.controllers[0].dPadUp.endedDown;
+                        gameInput->controllers[0].dPadUp = state;
+                    } break;
+                    case 'A': {
+                        state.wasDown = oldGameInput.controllers[0].dPadLeft.endedDown;
+                        gameInput->controllers[0].dPadLeft = state;
+                    } break;
+                    case 'S': {
+                        state.wasDown = oldGameInput.controllers[0].dPadDown.endedDown;
+                        gameInput->controllers[0].dPadDown = state;
+                    } break;
+                    case 'D': {
+                        state.wasDown = oldGameInput.controllers[0].dPadRight.endedDown;
+                        gameInput->controllers[0].dPadRight = state;
+                    } break;
+                    case 'Q': {
+                        state.wasDown = oldGameInput.controllers[0].shoulderL1.endedDown;
+                        gameInput->controllers[0].shoulderL1 = state;
+                    } break;
+                    case 'E': {
+                        state.wasDown = oldGameInput.controllers[0].shoulderR1.endedDown;
+                        gameInput->controllers[0].shoulderR1 = state;
+                    } break;
+                    case 'F': {
+                        state.wasDown = oldGameInput.controllers[0].option1.endedDown;
+                        gameInput->controllers[0].option1 = state;
+                    } break;
+                    case VK_UP: {
+                        state.wasDown = oldGameInput.controllers[0].up.endedDown;
+                        gameInput->controllers[0].up = state;
+                    } break;
+                    case VK_DOWN: {
                         state.wasDown = oldGameInput.controllers[0].down.endedDown;
                         gameInput->controllers[0].down = state;
                     } break;
@@ -1585,100 +2045,235 @@ internal_func void win32LoadGameDLLFunctions(wchar_t *absPath, GameCode *gameCod
     // Calculate absolute path to the Game.dll
     wchar_t gameDLLFilePath[MAX_PATH] = { 0 };
     wcscat_s(gameDLLFilePath, countArray(gameDLLFilePath), absPath);
-    wcscat_s(gameDLLFilePath, countArray(gameDLLFilePath), L"Game.dll");
-
-    // Calculate absolute path to the Game_copy.dll
-    wchar_t gameCopyDLLFilePath[MAX_PATH] = {0};
-    wcscat_s(gameCopyDLLFilePath, countArray(gameCopyDLLFilePath), absPath);
-    wcscat_s(gameCopyDLLFilePath, countArray(gameCopyDLLFilePath), L"Game_copy.dll");
-
+    wcscat_s(gameDLLFilePath, countArray(gameDLLFilePath), WIN32_GAME_DLL_FILENAME);
 
 #if !defined(HANDMADE_LIVE_LOOP_EDITING)
     win32LoadGameDLLFunctionsFromFile(gameDLLFilePath, gameCode);
     return;
+#else
+
+    // Load from a copy so the compiler is free to overwrite Game.dll. Later
+    // copies are made by the reload thread, alternating between the two slots.
+    wchar_t gameCopyDLLFilePath[MAX_PATH] = {0};
+    swprintf_s(gameCopyDLLFilePath, countArray(gameCopyDLLFilePath), WIN32_GAME_DLL_COPY_FILENAME_FORMAT, absPath, 0);
+
+    BOOL res = CopyFile(gameDLLFilePath, gameCopyDLLFilePath, false);
+
+    if (!res) {
+#if defined(HANDMADE_DEBUG_LIVE_LOOP_EDITING)
+        wchar_t buff[500] = { 0 };
+        swprintf_s(buff, 500, L"Could not copy Game.dll: 0x%X\n", GetLastError()); // 0x7E == The specified module could not be found.
+        OutputDebugString(buff);
+#endif
+        assert(!"Game code can not be loaded");
+    }
+
+    win32LoadGameDLLFunctionsFromFile(gameCopyDLLFilePath, gameCode);
+
 #endif
+}
+
+#ifdef HANDMADE_LIVE_LOOP_EDITING
+
+internal_func bool32 win32StartGameCodeReloader(Win32GameCodeReloader *reloader, wchar_t *absPath)
+{
+    wcscpy_s(reloader->absPath, countArray(reloader->absPath), absPath);
+
+    // win32LoadGameDLLFunctions loaded the running code from slot 0
+    reloader->stagedSlot = 0;
+    reloader->stagedState = WIN32_STAGED_GAME_CODE_NONE;
+    reloader->retiredHandle = NULL;
+
+    reloader->thread = CreateThread(NULL, 0, win32GameCodeReloaderThread, reloader, 0, NULL);
+
+    if (NULL == reloader->thread) {
+        OutputDebugStringA("Unable to start the game code reload thread\n");
+        return false;
+    }
+
+    return true;
+}
+
+internal_func DWORD WINAPI win32GameCodeReloaderThread(LPVOID param)
+{
+    Win32GameCodeReloader *reloader = (Win32GameCodeReloader *)param;
+
+    // Watch the directory rather than Game.dll itself, as the linker
+    // replaces the file rather than writing into it.
+    HANDLE directory = CreateFile(reloader->absPath,
+                                    FILE_LIST_DIRECTORY,
+                                    (FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE),
+                                    NULL,
+                                    OPEN_EXISTING,
+                                    FILE_FLAG_BACKUP_SEMANTICS,
+                                    NULL);
+
+    if (INVALID_HANDLE_VALUE == directory) {
+        OutputDebugStringA("Unable to watch for game code changes\n");
+        return 1;
+    }
+
+    // DWORD aligned, as ReadDirectoryChangesW requires
+    DWORD buffer[2048];
+
+    // Length in bytes of the file name, which isn't null terminated in
+    // FILE_NOTIFY_INFORMATION
+    DWORD gameDLLFilenameLength = (sizeof(WIN32_GAME_DLL_FILENAME) - sizeof(wchar_t));
+
+    for (;;) {
+
+        DWORD bytesReturned = 0;
+
+        // Blocks until something in the directory changes
+        BOOL res = ReadDirectoryChangesW(directory,
+                                            buffer,
+                                            sizeof(buffer),
+                                            FALSE,
+                                            (FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_LAST_WRITE),
+                                            &bytesReturned,
+                                            NULL,
+                                            NULL);
+
+        if (!res) {
+            break;
+        }
+
+        // Zero bytes means the change list overflowed. Assume Game.dll changed.
+        bool32 gameDLLChanged = (0 == bytesReturned);
+
+        if (bytesReturned) {
+
+            FILE_NOTIFY_INFORMATION *info = (FILE_NOTIFY_INFORMATION *)buffer;
+
+            for (;;) {
+
+                if ((info->FileNameLength == gameDLLFilenameLength)
+                        && (0 == _wcsnicmp(info->FileName, WIN32_GAME_DLL_FILENAME, (gameDLLFilenameLength / sizeof(wchar_t))))) {
+                    gameDLLChanged = true;
+                }
+
+                if (0 == info->NextEntryOffset) {
+                    break;
+                }
+
+                info = (FILE_NOTIFY_INFORMATION *)((uint8 *)info + info->NextEntryOffset);
+            }
+        }
+
+        if (gameDLLChanged) {
+            win32StageGameCode(reloader);
+        }
+    }
+
+    CloseHandle(directory);
 
-    BOOL loadGameCode = false;
+    return 0;
+}
 
-    // Does the copy yet exist?
-    DWORD dwAttrib = GetFileAttributes(gameCopyDLLFilePath);
+internal_func void win32StageGameCode(Win32GameCodeReloader *reloader)
+{
+    // The linker writes the DLL in more than one pass. Give it a moment to
+    // finish before we try and copy it.
+    Sleep(WIN32_GAME_DLL_RELOAD_SETTLE_MS);
 
-    if (!(dwAttrib != INVALID_FILE_ATTRIBUTES && !(dwAttrib & FILE_ATTRIBUTE_DIRECTORY))) {
+    uint32 slot = 0;
 
-#if defined(HANDMADE_DEBUG_LIVE_LOOP_EDITING)
-        wchar_t buff[500] = { 0 };
-        swprintf_s(buff, 500, L"Game_copy.dll doesnt exist, going to copy...\n");
-        OutputDebugString(buff);
-#endif
+    if (WIN32_STAGED_GAME_CODE_READY == InterlockedCompareExchange(&reloader->stagedState,
+                                                                    WIN32_STAGED_GAME_CODE_NONE,
+                                                                    WIN32_STAGED_GAME_CODE_READY)) {
 
-        BOOL res = CopyFile(gameDLLFilePath, gameCopyDLLFilePath, false);
+        // The main loop never picked up the last staged code. Discard it and
+        // reuse its slot.
+        FreeLibrary((HMODULE)reloader->staged.dllHandle);
+        slot = reloader->stagedSlot;
 
-        if (!res) {
-            #if defined(HANDMADE_DEBUG_LIVE_LOOP_EDITING)
-                wchar_t buff[500] = { 0 };
-                swprintf_s(buff, 500, L"Game_copy.dll doesnt exist, but could not copy: 0x%X\n", GetLastError()); // 0x7E == The specified module could not be found.
-                OutputDebugString(buff);
-                assert(!"Game code can not be loaded");
-            #endif
+    } else {
+
+        // Wait out a swap that's in progress on the main thread
+        while (WIN32_STAGED_GAME_CODE_SWAPPING == InterlockedCompareExchange(&reloader->stagedState, 0, 0)) {
+            YieldProcessor();
         }
 
-        loadGameCode = true;
+        // The main loop is running the last staged code. Use the other slot.
+        slot = (reloader->stagedSlot ^ 1);
+    }
 
-    } else {
+    // Free the code the main loop swapped out. It was loaded from the slot
+    // we're about to overwrite, and Windows won't let us overwrite a loaded DLL.
+    void *retiredHandle = InterlockedExchangePointer(&reloader->retiredHandle, NULL);
 
-        // File already exists...
+    if (retiredHandle) {
+        FreeLibrary((HMODULE)retiredHandle);
+    }
 
-        // Check to see if we actually need to do the copy.
-        FILETIME lastWriteTimeGame = {};
-        lastWriteTimeGame = win32GetFileLastWriteDate(gameDLLFilePath);
-        FILETIME lastWriteTimeGameCopy = {};
-        lastWriteTimeGameCopy = win32GetFileLastWriteDate(gameCopyDLLFilePath);
+    wchar_t gameDLLFilePath[MAX_PATH] = { 0 };
+    wcscat_s(gameDLLFilePath, countArray(gameDLLFilePath), reloader->absPath);
+    wcscat_s(gameDLLFilePath, countArray(gameDLLFilePath), WIN32_GAME_DLL_FILENAME);
 
-        if (CompareFileTime(&lastWriteTimeGame, &lastWriteTimeGameCopy) != 0) {
+    wchar_t gameCopyDLLFilePath[MAX_PATH] = { 0 };
+    swprintf_s(gameCopyDLLFilePath, countArray(gameCopyDLLFilePath), WIN32_GAME_DLL_COPY_FILENAME_FORMAT, reloader->absPath, slot);
 
-            // Free a lock if there is one...
-            if (gameCode->dllHandle != 0x0) {
-                BOOL res = FreeLibrary((HMODULE)gameCode->dllHandle);
+    // The linker may still have the file open. Keep trying for a while.
+    BOOL res = false;
 
-                if (!res) {
-                #if defined(HANDMADE_DEBUG_LIVE_LOOP_EDITING)
-                        wchar_t buff[500] = { 0 };
-                        swprintf_s(buff, 500, L"Could not free DLL handle lock: 0x%X\n", GetLastError()); // 0x7E == The specified module could not be found.
-                        OutputDebugString(buff);
-                    #endif
-                }
+    for (uint32 attempt = 0; ((attempt < WIN32_GAME_DLL_RELOAD_ATTEMPTS) && !res); attempt++) {
 
-            }
+        res = CopyFile(gameDLLFilePath, gameCopyDLLFilePath, false);
 
-            // Copy file contents from Game.dll to Game_copy.dll
-            BOOL res = CopyFile(gameDLLFilePath, gameCopyDLLFilePath, false);
+        if (!res) {
+            Sleep(WIN32_GAME_DLL_RELOAD_SETTLE_MS);
+        }
+    }
 
 #ifdef HANDMADE_DEBUG_LIVE_LOOP_EDITING
-            if (!res) {
-                wchar_t buff[500] = { 0 };
-                swprintf_s(buff, 500, L"DLL copy failed: 0x%X\n", GetLastError()); // 0x20 = The process cannot access the file because it is being used by another process.
-                OutputDebugString(buff);
-            }else {
-                wchar_t buff[500] = { 0 };
-                swprintf_s(buff, 500, L"DLL copy succeeded\n");
-                OutputDebugString(buff);
-            }
+    if (!res) {
+        wchar_t buff[500] = { 0 };
+        swprintf_s(buff, 500, L"DLL copy failed: 0x%X\n", GetLastError()); // 0x20 = The process cannot access the file because it is being used by another process.
+        OutputDebugString(buff);
+    }else {
+        wchar_t buff[500] = { 0 };
+        swprintf_s(buff, 500, L"DLL copy succeeded\n");
+        OutputDebugString(buff);
+    }
 #endif
-            loadGameCode = true;
 
-        } else {
+    if (!res) {
+        return;
+    }
 
-            if (gameCode->dllHandle == 0x0) {
-                loadGameCode = true;
-            }
-        }
+    GameCode staged = { 0 };
+    win32LoadGameDLLFunctionsFromFile(gameCopyDLLFilePath, &staged);
+
+    reloader->staged = staged;
+    reloader->stagedSlot = slot;
+
+    InterlockedExchange(&reloader->stagedState, WIN32_STAGED_GAME_CODE_READY);
+}
+
+internal_func void win32SwapStagedGameCode(Win32GameCodeReloader *reloader, GameCode *gameCode)
+{
+    // A plain read on the common path. No system calls and no locked instructions.
+    if (WIN32_STAGED_GAME_CODE_READY != reloader->stagedState) {
+        return;
     }
 
-    if (loadGameCode) {
-        win32LoadGameDLLFunctionsFromFile(gameCopyDLLFilePath, gameCode);
+    // Claim the staged code so the reload thread can't discard it under us
+    if (WIN32_STAGED_GAME_CODE_READY != InterlockedCompareExchange(&reloader->stagedState,
+                                                                    WIN32_STAGED_GAME_CODE_SWAPPING,
+                                                                    WIN32_STAGED_GAME_CODE_READY)) {
+        return;
     }
+
+    void *retiredHandle = gameCode->dllHandle;
+
+    *gameCode = reloader->staged;
+
+    InterlockedExchangePointer(&reloader->retiredHandle, retiredHandle);
+    InterlockedExchange(&reloader->stagedState, WIN32_STAGED_GAME_CODE_NONE);
 }
 
+#endif
+
 internal_func void win32GetAbsolutePath(wchar_t *path)
 {
     // Get the module path for the running exe
@@ -1717,19 +2312,6 @@ internal_func void win32GetAbsolutePath(wchar_t *path)
     */
 }
 
-internal_func FILETIME win32GetFileLastWriteDate(const wchar_t *filename)
-{
-    WIN32_FILE_ATTRIBUTE_DATA fileData = { 0 };
-
-    BOOL res = GetFileAttributesExW(filename, GetFileExInfoStandard, &fileData);
-
-    if (!res) {
-        assert(!"Cannot get file data");
-    }
-
-    return fileData.ftLastWriteTime;
-}
-
 internal_func void win32GetMousePosition(HWND window, GameMouseInput *mouseInput)
 {
     if (paused){
@@ -1766,6 +2348,181 @@ PLATFORM_ALLOCATE_MEMORY(platformAllocateMemory)
     return VirtualAlloc(startAddress, memorySizeInBytes, MEM_RESERVE|MEM_COMMIT, PAGE_READWRITE);
 }
 
+internal_func void *win32ReserveMemory(PlatformThreadContext *thread,
+                                        Win32MemoryReservation *reservation,
+                                        uint64 startAddress,
+                                        sizet sizeInBytes,
+                                        bool32 watchWrites)
+{
+    sizet chunkCount = ((sizeInBytes + (WIN32_MEMORY_COMMIT_CHUNK_SIZE - 1)) / WIN32_MEMORY_COMMIT_CHUNK_SIZE);
+    sizet reservedSizeInBytes = (chunkCount * WIN32_MEMORY_COMMIT_CHUNK_SIZE);
+
+    DWORD allocationType = (watchWrites ? (MEM_RESERVE | MEM_WRITE_WATCH) : MEM_RESERVE);
+
+    void *base = VirtualAlloc((LPVOID)startAddress, reservedSizeInBytes, allocationType, PAGE_NOACCESS);
+
+    if (!base) {
+        return NULL;
+    }
+
+    reservation->base = (uint8 *)base;
+    reservation->sizeInBytes = reservedSizeInBytes;
+    reservation->chunkCount = chunkCount;
+    reservation->committedSizeInBytes = 0;
+    reservation->chunkStates = (uint8 *)platformAllocateMemory(thread, 0, chunkCount);
+
+    if (!reservation->chunkStates) {
+        return NULL;
+    }
+
+    reservation->watchWrites = watchWrites;
+
+    if (watchWrites) {
+        // Enough room for every page to have been written to
+        SYSTEM_INFO systemInfo = { 0 };
+        GetSystemInfo(&systemInfo);
+
+        reservation->writtenPagesCapacity = (reservedSizeInBytes / systemInfo.dwPageSize);
+        reservation->writtenPages = (void **)platformAllocateMemory(thread, 0, (reservation->writtenPagesCapacity * sizeof(void *)));
+
+        if (!reservation->writtenPages) {
+            return NULL;
+        }
+    }
+
+#if !defined(HANDMADE_COMMIT_MEMORY_ON_DEMAND)
+    if (!win32CommitMemory(reservation, base, reservedSizeInBytes)) {
+        return NULL;
+    }
+#endif
+
+    return base;
+}
+
+internal_func bool32 win32CommitMemory(Win32MemoryReservation *reservation, void *address, sizet sizeInBytes)
+{
+    if (0 == sizeInBytes) {
+        return true;
+    }
+
+    sizet startOffset = (sizet)((uint8 *)address - reservation->base);
+    sizet endOffset = (startOffset + sizeInBytes);
+
+    if ((uint8 *)address < reservation->base || endOffset > reservation->sizeInBytes) {
+        return false;
+    }
+
+    sizet firstChunk = (startOffset / WIN32_MEMORY_COMMIT_CHUNK_SIZE);
+    sizet lastChunk = ((endOffset - 1) / WIN32_MEMORY_COMMIT_CHUNK_SIZE);
+
+    for (sizet chunk = firstChunk; chunk <= lastChunk; chunk++) {
+
+        if (WIN32_MEMORY_CHUNK_RESERVED != reservation->chunkStates[chunk]) {
+            continue;
+        }
+
+        uint8 *chunkAddress = (reservation->base + (chunk * WIN32_MEMORY_COMMIT_CHUNK_SIZE));
+
+        if (!VirtualAlloc(chunkAddress, WIN32_MEMORY_COMMIT_CHUNK_SIZE, MEM_COMMIT, PAGE_READWRITE)) {
+            return false;
+        }
+
+        reservation->chunkStates[chunk] = WIN32_MEMORY_CHUNK_COMMITTED;
+        reservation->committedSizeInBytes += WIN32_MEMORY_COMMIT_CHUNK_SIZE;
+    }
+
+    return true;
+}
+
+internal_func void win32CopyCommittedMemory(Win32MemoryReservation *destination, Win32MemoryReservation *source)
+{
+    assert(destination->sizeInBytes == source->sizeInBytes);
+
+    for (sizet chunk = 0; chunk < source->chunkCount; chunk++) {
+
+        if (WIN32_MEMORY_CHUNK_RESERVED == source->chunkStates[chunk]) {
+            continue;
+        }
+
+        sizet offset = (chunk * WIN32_MEMORY_COMMIT_CHUNK_SIZE);
+
+        if (!win32CommitMemory(destination, (destination->base + offset), WIN32_MEMORY_COMMIT_CHUNK_SIZE)) {
+            assert(!"Could not commit memory to copy into");
+            return;
+        }
+
+        CopyMemory((destination->base + offset), (source->base + offset), WIN32_MEMORY_COMMIT_CHUNK_SIZE);
+    }
+}
+
+internal_func void win32BeginWriteTracking(Win32MemoryReservation *reservation)
+{
+    assert(reservation->watchWrites);
+    ResetWriteWatch(reservation->base, reservation->sizeInBytes);
+}
+
+internal_func sizet win32RestoreWrittenMemory(Win32MemoryReservation *reservation, Win32MemoryReservation *snapshot)
+{
+    assert(reservation->watchWrites);
+    assert(reservation->sizeInBytes == snapshot->sizeInBytes);
+
+    ULONG_PTR writtenPageCount = reservation->writtenPagesCapacity;
+    ULONG pageSize = 0;
+
+    // Don't reset here. Restoring the pages writes to them, so the watch is
+    // reset once they've all been copied back.
+    if (0 != GetWriteWatch(0,
+                            reservation->base,
+                            reservation->sizeInBytes,
+                            reservation->writtenPages,
+                            &writtenPageCount,
+                            &pageSize)) {
+        assert(!"GetWriteWatch failed");
+        return 0;
+    }
+
+    for (ULONG_PTR i = 0; i < writtenPageCount; i++) {
+
+        uint8 *page = (uint8 *)reservation->writtenPages[i];
+        sizet offset = (sizet)(page - reservation->base);
+
+        if (WIN32_MEMORY_CHUNK_RESERVED == snapshot->chunkStates[offset / WIN32_MEMORY_COMMIT_CHUNK_SIZE]) {
+            ZeroMemory(page, pageSize);
+        } else {
+            CopyMemory(page, (snapshot->base + offset), pageSize);
+        }
+    }
+
+    ResetWriteWatch(reservation->base, reservation->sizeInBytes);
+
+    return (writtenPageCount * pageSize);
+}
+
+internal_func void win32LogMemoryUsage(Win32MemoryReservation *reservation)
+{
+    PROCESS_MEMORY_COUNTERS counters = { 0 };
+    GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters));
+
+    char output[200] = { 0 };
+    sprintf_s(output, sizeof(output),
+                "Game memory: %.2f MiB reserved. %.2f MiB committed. Process working set: %.2f MiB\n",
+                ((float64)reservation->sizeInBytes / (1024.0 * 1024.0)),
+                ((float64)reservation->committedSizeInBytes / (1024.0 * 1024.0)),
+                ((float64)counters.WorkingSetSize / (1024.0 * 1024.0)));
+    OutputDebugStringA(output);
+}
+
+/**
+ * @NOTE(JM) Windows can't commit large pages into an existing reservation.
+ * MEM_LARGE_PAGES has to be passed with MEM_RESERVE|MEM_COMMIT in a single call
+ * and needs SeLockMemoryPrivilege, so largePages is ignored here and hot blocks
+ * get regular pages.
+ */
+PLATFORM_COMMIT_MEMORY(platformCommitMemory)
+{
+    return win32CommitMemory(win32GameMemoryReservation, address, sizeInBytes);
+}
+
 PLATFORM_FREE_MEMORY(platformFreeMemory)
 {
     VirtualFree(address, 0, MEM_RELEASE);
@@ -1930,55 +2687,303 @@ DEBUG_PLATFORM_WRITE_ENTIRE_FILE(DEBUG_platformWriteEntireFile)
 
 #endif
 
+/*
+ * Hands the block being filled to the writer thread. Waits if the writer
+ * thread has fallen so far behind that there's no free block to fill next.
+ */
+internal_func void win32SubmitInputRecorderBlock(Win32InputRecorder *recorder)
+{
+    recorder->framesSinceSubmit = 0;
+
+    if (0 == recorder->currentBlockSize) {
+        return;
+    }
+
+    EnterCriticalSection(&recorder->lock);
+
+    recorder->blockSizes[recorder->blocksSubmitted % WIN32_INPUT_RECORDER_BLOCK_COUNT] = recorder->currentBlockSize;
+    recorder->blocksSubmitted++;
+
+    WakeAllConditionVariable(&recorder->condition);
+
+    while ((recorder->blocksSubmitted - recorder->blocksWritten) >= WIN32_INPUT_RECORDER_BLOCK_COUNT) {
+        SleepConditionVariableCS(&recorder->condition, &recorder->lock, INFINITE);
+    }
+
+    LeaveCriticalSection(&recorder->lock);
+
+    recorder->currentBlockSize = 0;
+}
+
+internal_func uint8 *win32InputRecorderCurrentBlock(Win32InputRecorder *recorder)
+{
+    uint32 blockIndex = (recorder->blocksSubmitted % WIN32_INPUT_RECORDER_BLOCK_COUNT);
+    return (recorder->blocks + (blockIndex * WIN32_INPUT_RECORDER_BLOCK_SIZE) + recorder->currentBlockSize);
+}
+
+internal_func bool32 win32StartInputRecorder(PlatformThreadContext *thread, Win32InputRecorder *recorder, const wchar_t *filename)
+{
+    *recorder = { 0 };
+
+    recorder->blocks = (uint8 *)platformAllocateMemory(thread, 0, (WIN32_INPUT_RECORDER_BLOCK_SIZE * WIN32_INPUT_RECORDER_BLOCK_COUNT));
+
+    if (!recorder->blocks) {
+        return false;
+    }
+
+    recorder->fileHandle = CreateFileW(filename, GENERIC_WRITE, 0, 0, CREATE_ALWAYS, 0, 0);
+
+    if (INVALID_HANDLE_VALUE == recorder->fileHandle) {
+        OutputDebugStringA("Cannot open the input recording for writing\n");
+        platformFreeMemory(thread, recorder->blocks);
+        return false;
+    }
+
+    InitializeCriticalSection(&recorder->lock);
+    InitializeConditionVariable(&recorder->condition);
+
+    recorder->thread = CreateThread(NULL, 0, win32InputRecorderThread, recorder, 0, NULL);
+
+    if (!recorder->thread) {
+        CloseHandle(recorder->fileHandle);
+        DeleteCriticalSection(&recorder->lock);
+        platformFreeMemory(thread, recorder->blocks);
+        return false;
+    }
+
+    recorder->currentBlockSize += inputRecordingWriteHeader(&recorder->encoder, win32InputRecorderCurrentBlock(recorder));
+
+    return true;
+}
+
+internal_func void win32RecordInputFrame(Win32InputRecorder *recorder, GameInput *input)
+{
+    inputRecordingQuantise(input);
+
+    // Room for a repeat record and a frame record
+    if ((recorder->currentBlockSize + (INPUT_RECORDING_MAX_RECORD_BYTES * 2)) > WIN32_INPUT_RECORDER_BLOCK_SIZE) {
+        win32SubmitInputRecorderBlock(recorder);
+    }
+
+    recorder->currentBlockSize += inputRecordingEncodeFrame(&recorder->encoder, input, win32InputRecorderCurrentBlock(recorder));
+
+    recorder->framesSinceSubmit++;
+
+    if (recorder->framesSinceSubmit >= WIN32_INPUT_RECORDER_SUBMIT_FRAMES) {
+        win32SubmitInputRecorderBlock(recorder);
+    }
+}
+
+internal_func bool32 win32StopInputRecorder(PlatformThreadContext *thread, Win32InputRecorder *recorder)
+{
+    if ((recorder->currentBlockSize + INPUT_RECORDING_MAX_RECORD_BYTES) > WIN32_INPUT_RECORDER_BLOCK_SIZE) {
+        win32SubmitInputRecorderBlock(recorder);
+    }
+
+    recorder->currentBlockSize += inputRecordingEncodeFlush(&recorder->encoder, win32InputRecorderCurrentBlock(recorder));
+
+    win32SubmitInputRecorderBlock(recorder);
+
+    EnterCriticalSection(&recorder->lock);
+    recorder->stopping = true;
+    WakeAllConditionVariable(&recorder->condition);
+    LeaveCriticalSection(&recorder->lock);
+
+    WaitForSingleObject(recorder->thread, INFINITE);
+    CloseHandle(recorder->thread);
+
+    DeleteCriticalSection(&recorder->lock);
+
+    CloseHandle(recorder->fileHandle);
+    recorder->fileHandle = INVALID_HANDLE_VALUE;
+
+    platformFreeMemory(thread, recorder->blocks);
+    recorder->blocks = NULL;
+
+    return !recorder->writeFailed;
+}
+
+internal_func DWORD WINAPI win32InputRecorderThread(LPVOID param)
+{
+    Win32InputRecorder *recorder = (Win32InputRecorder *)param;
+
+    EnterCriticalSection(&recorder->lock);
+
+    for (;;) {
+
+        while ((recorder->blocksWritten == recorder->blocksSubmitted) && !recorder->stopping) {
+            SleepConditionVariableCS(&recorder->condition, &recorder->lock, INFINITE);
+        }
+
+        if (recorder->blocksWritten == recorder->blocksSubmitted) {
+            // Stopping and everything has been written
+            break;
+        }
+
+        uint32 blockIndex = (recorder->blocksWritten % WIN32_INPUT_RECORDER_BLOCK_COUNT);
+        uint8 *block = (recorder->blocks + (blockIndex * WIN32_INPUT_RECORDER_BLOCK_SIZE));
+        DWORD blockSize = (DWORD)recorder->blockSizes[blockIndex];
+
+        // The main thread doesn't touch a submitted block until it's been
+        // written, so write it without holding the lock
+        LeaveCriticalSection(&recorder->lock);
+
+        DWORD bytesWritten = 0;
+
+        if (!WriteFile(recorder->fileHandle, block, blockSize, &bytesWritten, 0) || (bytesWritten != blockSize)) {
+            recorder->writeFailed = true;
+        }
+
+        EnterCriticalSection(&recorder->lock);
+
+        recorder->blocksWritten++;
+        WakeAllConditionVariable(&recorder->condition);
+    }
+
+    LeaveCriticalSection(&recorder->lock);
+
+    return 0;
+}
+
+internal_func bool32 win32OpenInputPlayback(Win32InputPlayback *playback, const wchar_t *filename)
+{
+    *playback = { 0 };
+
+    HANDLE fileHandle = CreateFileW(filename, GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING, 0, 0);
+
+    if (INVALID_HANDLE_VALUE == fileHandle) {
+        OutputDebugStringA("Cannot read the input recording\n");
+        return false;
+    }
+
+    LARGE_INTEGER fileSize;
+
+    if (!GetFileSizeEx(fileHandle, &fileSize) || (0 == fileSize.QuadPart)) {
+        CloseHandle(fileHandle);
+        return false;
+    }
+
+    playback->mappingHandle = CreateFileMappingW(fileHandle, 0, PAGE_READONLY, 0, 0, 0);
+
+    // The mapping keeps the file alive
+    CloseHandle(fileHandle);
+
+    if (!playback->mappingHandle) {
+        return false;
+    }
+
+    playback->mapping = (uint8 *)MapViewOfFile(playback->mappingHandle, FILE_MAP_READ, 0, 0, 0);
+    playback->sizeInBytes = (sizet)fileSize.QuadPart;
+
+    if (!playback->mapping
+            || !inputRecordingDecoderInit(&playback->decoder, playback->mapping, playback->sizeInBytes)) {
+        OutputDebugStringA("The input recording wasn't made with this build\n");
+        win32CloseInputPlayback(playback);
+        return false;
+    }
+
+    return true;
+}
+
+internal_func void win32CloseInputPlayback(Win32InputPlayback *playback)
+{
+    if (playback->mapping) {
+        UnmapViewOfFile(playback->mapping);
+    }
+
+    if (playback->mappingHandle) {
+        CloseHandle(playback->mappingHandle);
+    }
+
+    *playback = { 0 };
+}
+
 #ifdef HANDMADE_LIVE_LOOP_EDITING
 
 internal_func void win32BeginInputRecording(Win32State *win32State)
 {
-    CopyMemory(win32State->gameMemoryRecordedState, win32State->gameMemory, win32State->gameMemorySize);
+    PlatformThreadContext thread = { 0 };
+
+    wchar_t filename[MAX_PATH] = { 0 };
+    swprintf_s(filename, MAX_PATH, L"%ls%ls", win32State->absPath, WIN32_LOOP_RECORDING_FILENAME);
+
+    if (!win32StartInputRecorder(&thread, &win32State->loopRecorder, filename)) {
+        return;
+    }
+
+    // Only the committed parts of the game memory can have been written to
+    win32CopyCommittedMemory(&win32State->recordedStateReservation, &win32State->gameMemoryReservation);
+
+    // From here on, note which pages the game writes to so that a loop
+    // restart only has to copy those back
+    win32BeginWriteTracking(&win32State->gameMemoryReservation);
     win32State->inputRecording = 1;
 }
 
 internal_func void win32EndInputRecording(Win32State *win32State)
 {
+    PlatformThreadContext thread = { 0 };
+
+    if (!win32StopInputRecorder(&thread, &win32State->loopRecorder)) {
+        OutputDebugStringA("Not all of the loop recording could be written\n");
+    }
+
     win32State->inputRecording = 0;
 }
 
 internal_func void win32RecordInput(Win32State *win32State, GameInput *gameInput)
 {
-    uint64 offset = 0;
-    if (win32State->recordingWriteFrameIndex >= 1) {
-        offset = ((sizeof(*gameInput)) * win32State->recordingWriteFrameIndex);
-    }
-    CopyMemory(((CHAR*)win32State->gameMemoryRecordedInput + offset), gameInput, sizeof(*gameInput));
-    win32State->recordingWriteFrameIndex += 1;
+    win32RecordInputFrame(&win32State->loopRecorder, gameInput);
 }
 
 internal_func void win32BeginRecordingPlayback(Win32State *win32State)
 {
-    // Read out the copy of the game's memory from the recorded memory block.
-    CopyMemory(win32State->gameMemory, win32State->gameMemoryRecordedState, win32State->gameMemorySize);
+    if (!win32State->loopPlayback.mapping) {
+
+        wchar_t filename[MAX_PATH] = { 0 };
+        swprintf_s(filename, MAX_PATH, L"%ls%ls", win32State->absPath, WIN32_LOOP_RECORDING_FILENAME);
+
+        if (!win32OpenInputPlayback(&win32State->loopPlayback, filename)) {
+            return;
+        }
+    }
+
+    inputRecordingDecoderRewind(&win32State->loopPlayback.decoder);
+
+    // Put back the pages the game has written to since the recording started
+    // (or since the loop last restarted)
+    sizet restoredSizeInBytes = win32RestoreWrittenMemory(&win32State->gameMemoryReservation, &win32State->recordedStateReservation);
+
+    // The game's idea of what's on screen has gone back with it
+    win32State->frameBuffersInvalid = true;
+
+#if defined(HANDMADE_DEBUG_MEMORY)
+    char output[100] = { 0 };
+    sprintf_s(output, sizeof(output),
+                "Loop restart restored %.2f KiB of game memory\n",
+                ((float64)restoredSizeInBytes / 1024.0));
+    OutputDebugStringA(output);
+#endif
     win32State->inputPlayback = 1;
 }
 
 internal_func void win32EndRecordingPlayback(Win32State *win32State)
 {
-    win32State->recordingReadFrameIndex = 0;
     win32State->inputPlayback = 0;
 }
 
 internal_func void win32PlaybackInput(Win32State *win32State, GameInput *gameInput)
 {
-    uint64 offset = 0;
-    if (win32State->recordingReadFrameIndex >= 1) {
-        offset = ((sizeof(*gameInput)) * win32State->recordingReadFrameIndex);
+    if (inputRecordingDecodeFrame(&win32State->loopPlayback.decoder, gameInput)) {
+        return;
     }
-    CopyMemory(gameInput, ((CHAR*)win32State->gameMemoryRecordedInput + offset), sizeof(*gameInput));
-    win32State->recordingReadFrameIndex += 1;
 
-    if (win32State->recordingReadFrameIndex == win32State->recordingWriteFrameIndex) {
-        // We have read all the bytes from the recorded input, loop back to the start...
-        win32EndRecordingPlayback(win32State);
-        win32BeginRecordingPlayback(win32State);
+    // We have read all of the recorded input, loop back to the start...
+    win32EndRecordingPlayback(win32State);
+    win32BeginRecordingPlayback(win32State);
+
+    if (win32State->inputPlayback) {
+        inputRecordingDecodeFrame(&win32State->loopPlayback.decoder, gameInput);
     }
 }
 #endif
\ No newline at end of file
@@ -10,6 +10,57 @@
 // the app ready.
 #define WM_HANDMADE_HERO_READY (WM_APP + 1)
 
+// Name of the game's DLL and the copies that we actually load. There are two
+// copies (slots) so that new code can be loaded whilst the old code is still
+// running.
+#define WIN32_GAME_DLL_FILENAME L"Game.dll"
+#define WIN32_GAME_DLL_COPY_FILENAME_FORMAT L"%lsGame_copy_%u.dll"
+
+// How long to wait for the linker to finish with Game.dll, and how many times
+#define WIN32_GAME_DLL_RELOAD_SETTLE_MS 100
+#define WIN32_GAME_DLL_RELOAD_ATTEMPTS  20
+
+// Reserved game memory is committed in chunks of this size
+#define WIN32_MEMORY_COMMIT_CHUNK_SIZE (2 * 1024 * 1024)
+
+// Win32MemoryReservation.chunkStates values
+#define WIN32_MEMORY_CHUNK_RESERVED     0x0
+#define WIN32_MEMORY_CHUNK_COMMITTED    0x1
+
+// Live loop recordings are streamed to this file within the build folder
+#define WIN32_LOOP_RECORDING_FILENAME L"loop_recording.hmi"
+
+// Encoded input is handed to the recorder's writer thread in blocks
+#define WIN32_INPUT_RECORDER_BLOCK_SIZE     (64 * 1024)
+#define WIN32_INPUT_RECORDER_BLOCK_COUNT    8
+
+// Hand over a partly filled block at least this often (in frames) so that
+// little is lost if the process dies
+#define WIN32_INPUT_RECORDER_SUBMIT_FRAMES  300
+
+// Frame buffers used when presenting on the presenter thread. One is being
+// drawn into, one is being presented and one holds the newest finished frame.
+#define WIN32_PRESENT_BUFFER_COUNT 3
+
+// Set in Win32Presenter.readyBuffer until the presenter has taken the buffer
+#define WIN32_PRESENT_BUFFER_FRESH 0x100
+
+// How many frames the ring buffer between the main loop and the audio thread
+// can hold. A power of two. ~340ms at 48kHz.
+#define WIN32_AUDIO_RING_FRAMES 16384
+
+// How often the audio thread tops up the secondary buffer
+#define WIN32_AUDIO_THREAD_WAKE_MS 2
+
+// How far past DirectSound's write cursor the audio thread keeps the
+// secondary buffer filled (10ms at 48kHz)
+#define WIN32_AUDIO_FRAMES_AHEAD_OF_WRITE_CURSOR 480
+
+// Win32GameCodeReloader.stagedState values
+#define WIN32_STAGED_GAME_CODE_NONE     0x0
+#define WIN32_STAGED_GAME_CODE_READY    0x1
+#define WIN32_STAGED_GAME_CODE_SWAPPING 0x2
+
 /**
  * Struct for the Win32 screen buffer
  */
@@ -34,8 +85,57 @@ typedef struct Win32FrameBuffer
 
     // Pointer to an allocated block of heap memory to hold the data of the buffer.
     void *memory;
+
+    // The main loop's frame number when the buffer was last drawn into. 0 if
+    // it never has been.
+    uint64 frameNumber;
 } Win32FrameBuffer;
 
+/**
+ * Presents finished frames on a thread of its own so that the main loop can
+ * get on with the next frame. The frame buffers are handed over as a triple
+ * buffer. Each side swaps the index it's finished with for readyBuffer with
+ * a single InterlockedExchange, so neither thread ever waits on the other.
+ */
+typedef struct Win32Presenter
+{
+    HWND window;
+
+    // The window's own DC (CS_OWNDC). Only the presenter thread draws with it
+    // once the presenter is running.
+    HDC deviceHandleForWindow;
+
+    HANDLE thread;
+
+    // Set by the main loop each time it hands over a frame (or the window
+    // needs repainting)
+    HANDLE wakeEvent;
+
+    Win32FrameBuffer frameBuffers[WIN32_PRESENT_BUFFER_COUNT];
+
+    // The buffer being drawn into. Main loop only.
+    uint32 drawBuffer;
+
+    // The buffer last presented. Presenter thread only.
+    uint32 presentBuffer;
+
+    // The newest finished buffer, ORed with WIN32_PRESENT_BUFFER_FRESH until
+    // the presenter has taken it. Shared between both threads.
+    volatile LONG readyBuffer;
+
+    // Set by WM_PAINT. The presenter clears the window and presents the last
+    // frame again.
+    volatile LONG repaint;
+
+    volatile LONG running;
+
+    volatile LONG64 framesPresented;
+
+    // Frames replaced by a newer frame before the presenter got to them
+    uint64 framesDropped;
+
+} Win32Presenter;
+
 /**
  * Helper struct for the Win32 screen dimensions. @see win32GetClientDimensions
  */
@@ -80,6 +180,39 @@ typedef struct Win32AudioBuffer
 
 } Win32AudioBuffer;
 
+/**
+ * Feeds the secondary sound buffer from a thread of its own. The main loop
+ * hands the game's samples over through an AudioRingBuffer. The audio thread
+ * wakes every WIN32_AUDIO_THREAD_WAKE_MS and keeps the secondary buffer
+ * filled just past the write cursor, playing silence if the game falls behind.
+ */
+typedef struct Win32AudioOutput
+{
+    Win32AudioBuffer *audioBuffer;
+
+    AudioRingBuffer ring;
+
+    HANDLE thread;
+
+    // Set to stop the audio thread
+    HANDLE stopEvent;
+
+    // Audio thread only. Where in the secondary buffer to write next.
+    DWORD writeOffsetInBytes;
+    bool32 writeOffsetSet;
+
+    // Written by the audio thread. End to end latency: frames waiting in the
+    // ring plus frames written ahead of the play cursor, as of the last top
+    // up. And the worst seen.
+    volatile LONG latencyFrames;
+    uint32 maxLatencyFrames;
+
+    // Written by the audio thread. The cursors as of the last top up.
+    volatile LONG playCursorOffsetInBytes;
+    volatile LONG writeCursorOffsetInBytes;
+
+} Win32AudioOutput;
+
 typedef struct Win32FixedFrameRate {
 
     // Sleep or spin lock.
@@ -108,23 +241,118 @@ typedef struct Win32GameInputRecording
     GameInput *gameInput;
 } Win32GameInputRecording;
 
+/**
+ * Watches for rebuilds of Game.dll with ReadDirectoryChangesW. New code is
+ * copied and loaded on the reload thread, so the main loop only has to swap
+ * function pointers.
+ */
+typedef struct Win32GameCodeReloader
+{
+    wchar_t absPath[MAX_PATH];
+
+    HANDLE thread;
+
+    // Code loaded by the reload thread, waiting to be swapped in by the main loop
+    GameCode staged;
+
+    // Which Game_copy_N.dll the staged code was loaded from
+    uint32 stagedSlot;
+
+    // NONE, READY or SWAPPING. Shared between the main loop and the reload thread
+    volatile LONG stagedState;
+
+    // Handle swapped out by the main loop, for the reload thread to free
+    void * volatile retiredHandle;
+
+} Win32GameCodeReloader;
+
+/**
+ * A range of address space that's reserved up front and committed in
+ * WIN32_MEMORY_COMMIT_CHUNK_SIZE chunks as it's used.
+ */
+typedef struct Win32MemoryReservation
+{
+    uint8 *base;
+    sizet sizeInBytes;
+
+    // One WIN32_MEMORY_CHUNK_* state per chunk
+    uint8 *chunkStates;
+    sizet chunkCount;
+
+    sizet committedSizeInBytes;
+
+    // Set if reserved with MEM_WRITE_WATCH, so that the pages written to
+    // can be fetched with GetWriteWatch. writtenPages receives their addresses.
+    bool32 watchWrites;
+    void **writtenPages;
+    ULONG_PTR writtenPagesCapacity;
+} Win32MemoryReservation;
+
+/**
+ * Streams a compressed input recording (see input_recording.h) to a file.
+ * The main thread only encodes. A writer thread does the file I/O.
+ */
+typedef struct Win32InputRecorder
+{
+    HANDLE fileHandle;
+
+    InputRecordingEncoder encoder;
+
+    // WIN32_INPUT_RECORDER_BLOCK_COUNT blocks. The main thread fills them in
+    // turn and the writer thread writes them out in the same order.
+    uint8 *blocks;
+    sizet blockSizes[WIN32_INPUT_RECORDER_BLOCK_COUNT];
+
+    // How many blocks have been handed to and written by the writer thread.
+    // Only ever go up. Guarded by lock.
+    uint32 blocksSubmitted;
+    uint32 blocksWritten;
+
+    // Bytes in the block being filled (blocksSubmitted % BLOCK_COUNT)
+    sizet currentBlockSize;
+    uint32 framesSinceSubmit;
+
+    HANDLE thread;
+    CRITICAL_SECTION lock;
+    CONDITION_VARIABLE condition;
+    bool32 stopping;
+    bool32 writeFailed;
+} Win32InputRecorder;
+
+/**
+ * A recording mapped into memory for playback
+ */
+typedef struct Win32InputPlayback
+{
+    HANDLE mappingHandle;
+    uint8 *mapping;
+    sizet sizeInBytes;
+    InputRecordingDecoder decoder;
+} Win32InputPlayback;
+
 typedef struct Win32State
 {
     wchar_t absPath[MAX_PATH];
 
     uint64 gameMemorySize;
     void *gameMemory;
+    Win32MemoryReservation gameMemoryReservation;
 
     HWND *window;
 
     xyuint monitorDims;
     xyuint monitorAspectRatio;
 
+    // Set when what's in the frame buffers can no longer be built upon (E.g.
+    // a loop restart has put back older game memory), so the next frame is
+    // drawn in full
+    bool8 frameBuffersInvalid;
+
 #if HANDMADE_LOCAL_BUILD
     void *gameMemoryRecordedState;
-    void *gameMemoryRecordedInput;
-    uint64 recordingWriteFrameIndex;
-    uint64 recordingReadFrameIndex;
+    Win32MemoryReservation recordedStateReservation;
+    Win32InputRecorder loopRecorder;
+    Win32InputPlayback loopPlayback;
     bool8 inputRecording;
     bool8 inputPlayback;
 #endif
@@ -170,6 +398,95 @@ void win32DisplayFrameBuffer(HDC deviceHandleForWindow,
 
 internal_func win32ClientDimensions win32GetClientDimensions(HWND window);
 
+/**
+ * @brief Allocates the presenter's frame buffers and starts the presenter thread
+ *
+ * @return false if either fails. The main loop then presents serially.
+*/
+internal_func bool32 win32StartPresenter(PlatformThreadContext *thread,
+                                            Win32Presenter *presenter,
+                                            HWND window,
+                                            HDC deviceHandleForWindow,
+                                            uint32 width,
+                                            int32 height);
+
+internal_func DWORD WINAPI win32PresenterThread(LPVOID param);
+
+/**
+ * @brief The frame buffer for the main loop to draw the next frame into
+*/
+internal_func Win32FrameBuffer *win32PresenterDrawBuffer(Win32Presenter *presenter);
+
+/**
+ * @brief Hands the frame drawn into win32PresenterDrawBuffer over to the
+ * presenter thread and takes back a free buffer for the next frame
+*/
+internal_func void win32SubmitFrameToPresenter(Win32Presenter *presenter);
+
+/**
+ * @brief Asks the presenter thread to clear the window and present the last
+ * frame again. Called for WM_PAINT.
+*/
+internal_func void win32RepaintPresenter(Win32Presenter *presenter);
+
+internal_func void win32StopPresenter(Win32Presenter *presenter);
+
+// Set to the number of worker threads to start. Otherwise one fewer than the
+// number of logical processors, as the main thread works too.
+#define WIN32_WORKER_THREADS_VARIABLE "HANDMADE_WORKER_THREADS"
+
+#define WIN32_MAX_WORKER_THREADS (WORK_QUEUE_MAX_THREADS - 1)
+
+typedef struct Win32WorkerThread
+{
+    PlatformWorkQueue *queue;
+
+    // threadIndex is 1 onwards
+    PlatformThreadContext context;
+
+    HANDLE thread;
+
+} Win32WorkerThread;
+
+/**
+ * The threads behind PlatformWorkQueue. Which entry each thread runs is down
+ * to the game's WorkQueue (Game/work_queue.h).
+ */
+struct PlatformWorkQueue
+{
+    WorkQueue work;
+
+    // Released once per entry added, and once per worker to stop them
+    HANDLE wakeSemaphore;
+
+    volatile LONG running;
+
+    uint32 workerCount;
+    Win32WorkerThread workers[WIN32_MAX_WORKER_THREADS];
+};
+
+/**
+ * @brief How many worker threads to start. WIN32_WORKER_THREADS_VARIABLE if
+ * it's set, otherwise one per logical processor other than the main thread's.
+*/
+internal_func uint32 win32GetWorkerThreadCount();
+
+/**
+ * @brief Starts workerCount threads. With none, every entry runs on the thread
+ * that waits for the queue.
+ *
+ * @return false if the threads couldn't be started. Any that were have been
+ * stopped again.
+*/
+internal_func bool32 win32StartWorkQueue(PlatformWorkQueue *queue, uint32 workerCount);
+
+/**
+ * @brief Stops the workers once they've finished whatever they're running
+*/
+internal_func void win32StopWorkQueue(PlatformWorkQueue *queue);
+
+internal_func DWORD WINAPI win32WorkerThread(LPVOID param);
+
 internal_func DWORD WINAPI XInputGetStateStub(DWORD dwUserIndex, XINPUT_STATE *pState);
 
 internal_func DWORD WINAPI XInputSetStateStub(DWORD dwUserIndex, XINPUT_VIBRATION *pVibration);
@@ -184,6 +501,57 @@ internal_func void win32LoadXInputDLLFunctions(void);
  * @return void
 */
 internal_func void win32LoadGameDLLFunctions(wchar_t *absPath, GameCode *gameCode);
+
+#ifdef HANDMADE_LIVE_LOOP_EDITING
+
+/**
+ * @brief Starts the thread that watches for and loads new game code
+ *
+ * @return false if the thread can't be started. The game keeps running the
+ * code it started with.
+*/
+internal_func bool32 win32StartGameCodeReloader(Win32GameCodeReloader *reloader, wchar_t *absPath);
+
+internal_func DWORD WINAPI win32GameCodeReloaderThread(LPVOID param);
+
+/*
+ * Creates the file and starts the writer thread
+ */
+internal_func bool32 win32StartInputRecorder(PlatformThreadContext *thread, Win32InputRecorder *recorder, const wchar_t *filename);
+
+/*
+ * Quantises the input in place (so the game sees exactly what playback will
+ * give it) and appends it to the recording
+ */
+internal_func void win32RecordInputFrame(Win32InputRecorder *recorder, GameInput *input);
+
+/*
+ * Writes out everything still buffered, stops the writer thread and closes
+ * the file. Returns false if any of the recording couldn't be written.
+ */
+internal_func bool32 win32StopInputRecorder(PlatformThreadContext *thread, Win32InputRecorder *recorder);
+
+internal_func DWORD WINAPI win32InputRecorderThread(LPVOID param);
+
+/*
+ * Maps a recording into memory and checks its header
+ */
+internal_func bool32 win32OpenInputPlayback(Win32InputPlayback *playback, const wchar_t *filename);
+
+internal_func void win32CloseInputPlayback(Win32InputPlayback *playback);
+
+/**
+ * @brief Copies Game.dll to the free slot and loads it. Runs on the reload thread.
+*/
+internal_func void win32StageGameCode(Win32GameCodeReloader *reloader);
+
+/**
+ * @brief Swaps in the staged game code, if there is any. Called once per frame
+ * by the main loop.
+*/
+internal_func void win32SwapStagedGameCode(Win32GameCodeReloader *reloader, GameCode *gameCode);
+
+#endif
 internal_func void win32GetAbsolutePath(wchar_t *path);
 
 internal_func void win32InitAudioBuffer(HWND window, Win32AudioBuffer *win32AudioBuffer);
@@ -191,10 +559,35 @@ internal_func void win32InitAudioBuffer(HWND window, Win32AudioBuffer *win32Audi
 internal_func void win32AudioBufferTogglePlay(Win32AudioBuffer *win32AudioBuffer);
 internal_func void win32AudioBufferToggleStop(Win32AudioBuffer *win32AudioBuffer);
 
-internal_func void win32WriteAudioBuffer(Win32AudioBuffer *win32AudioBuffer,
-                                            DWORD lockOffsetInBytes,
-                                            DWORD lockSizeInBytes,
-                                            GameAudioBuffer *audioBuffer);
+/**
+ * @brief Allocates the ring buffer and starts the audio thread
+ *
+ * @return false if the secondary buffer wasn't created or either fails
+*/
+internal_func bool32 win32StartAudioOutput(PlatformThreadContext *thread,
+                                            Win32AudioOutput *output,
+                                            Win32AudioBuffer *audioBuffer);
+
+internal_func DWORD WINAPI win32AudioThread(LPVOID param);
+
+/**
+ * @brief Copies from the ring buffer into the secondary buffer up to
+ * WIN32_AUDIO_FRAMES_AHEAD_OF_WRITE_CURSOR past the write cursor. Audio thread only.
+*/
+internal_func void win32FillAudioBuffer(Win32AudioOutput *output);
+
+/**
+ * @brief How many frames the game should write this frame to keep
+ * targetFrames of audio queued for the audio thread
+*/
+internal_func uint32 win32AudioFramesToRequest(Win32AudioOutput *output, uint32 targetFrames);
+
+/**
+ * @brief Queues the game's frames for the audio thread. Main loop only.
+*/
+internal_func void win32SubmitAudio(Win32AudioOutput *output, const void *frames, uint32 frameCount);
+
+internal_func void win32StopAudioOutput(PlatformThreadContext *thread, Win32AudioOutput *output);
 
 internal_func void win32ProcessXInputControllerButton(GameControllerBtnState *currentState,
                                                         XINPUT_GAMEPAD *gamepad,
@@ -209,17 +602,62 @@ internal_func void win32ProcessMessages(HWND window, GameInput *gameInput, GameI
  */
 internal_func uint32 win32TruncateToUint32Safe(uint64 value);
 
-internal_func FILETIME win32GetFileLastWriteDate(const wchar_t *filename);
-
 internal_func void win32GetMousePosition(HWND window, GameMouseInput* mouseInput);
 
+/*
+ * Reserves (but doesn't commit, unless HANDMADE_COMMIT_MEMORY_ON_DEMAND is off)
+ * an address range. Returns the base address or NULL on failure. Pass
+ * watchWrites to be able to restore snapshots of the range with
+ * win32RestoreWrittenMemory.
+ */
+internal_func void *win32ReserveMemory(PlatformThreadContext *thread,
+                                        Win32MemoryReservation *reservation,
+                                        uint64 startAddress,
+                                        sizet sizeInBytes,
+                                        bool32 watchWrites);
+
+/*
+ * Commits every chunk the given range touches. Already committed chunks are
+ * skipped.
+ */
+internal_func bool32 win32CommitMemory(Win32MemoryReservation *reservation, void *address, sizet sizeInBytes);
+
+/*
+ * Copies only the committed chunks of one reservation into another of the
+ * same size, committing the destination chunks as needed.
+ */
+internal_func void win32CopyCommittedMemory(Win32MemoryReservation *destination, Win32MemoryReservation *source);
+
+/*
+ * Forgets which pages have been written to. Call once a snapshot of the
+ * reservation has been taken.
+ */
+internal_func void win32BeginWriteTracking(Win32MemoryReservation *reservation);
+
+/*
+ * Puts every page written to since tracking began (or since the last restore)
+ * back to how it is in snapshot. Pages whose chunk isn't committed in snapshot
+ * are zeroed, as they were before being committed. Returns the number of bytes
+ * restored.
+ */
+internal_func sizet win32RestoreWrittenMemory(Win32MemoryReservation *reservation, Win32MemoryReservation *snapshot);
+
+/*
+ * Logs how much of the game's memory is reserved, committed and in the
+ * process's working set
+ */
+internal_func void win32LogMemoryUsage(Win32MemoryReservation *reservation);
+
 //===========================================
 // Game-required platform layer signatures
 //===========================================
 PLATFORM_ALLOCATE_MEMORY(platformAllocateMemory);
 PLATFORM_FREE_MEMORY(platformFreeMemory);
+PLATFORM_COMMIT_MEMORY(platformCommitMemory);
 PLATFORM_TOGGLE_FULLSCREEN(platformToggleFullscreen);
 PLATFORM_CONTROLLER_VIBRATE(platformControllerVibrate);
+PLATFORM_ADD_WORK_QUEUE_ENTRY(platformAddWorkQueueEntry);
+PLATFORM_COMPLETE_ALL_WORK(platformCompleteAllWork);
 
 #if HANDMADE_LOCAL_BUILD
 